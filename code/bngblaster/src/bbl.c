@@ -110,7 +110,7 @@ global_traffic_enable(bool status)
 /*
  * Command line options.
  */
-const char *optstring = "vhC:T:l:L:u:p:P:j:J:c:g:s:r:z:S:Ibf";
+const char *optstring = "vhC:T:l:L:u:p:P:j:J:E:c:g:s:r:z:S:Ibf";
 static struct option long_options[] = {
     { "version",                no_argument,        NULL, 'v' },
     { "help",                   no_argument,        NULL, 'h' },
@@ -123,6 +123,7 @@ static struct option long_options[] = {
     { "pcap-capture",           required_argument,  NULL, 'P' },
     { "json-report-content",    required_argument,  NULL, 'j' },
     { "json-report-file",       required_argument,  NULL, 'J' },
+    { "stream-export-file",     required_argument,  NULL, 'E' },
     { "session-count",          required_argument,  NULL, 'c' },
     { "mc-group",               required_argument,  NULL, 'g' },
     { "mc-source",              required_argument,  NULL, 's' },
@@ -195,11 +196,12 @@ bbl_print_version (void)
         printf("  REF: %s\n", GIT_REF);
         printf("  SHA: %s\n", GIT_SHA);
     }
-    printf("IO Modes: packet_mmap_raw (default), packet_mmap, raw");
+    printf("IO Modes: packet_mmap_raw (default), packet_mmap, raw, af_xdp");
 #ifdef BNGBLASTER_DPDK
     printf(", dpdk");
 #endif
     printf("\n");
+    printf("Checksum: %s\n", checksum_impl_name(checksum_impl_get()));
 }
 
 static void
@@ -441,6 +443,9 @@ main(int argc, char *argv[])
             case 'J':
                 g_ctx->config.json_report_filename = optarg;
                 break;
+            case 'E':
+                g_ctx->config.stream_export_filename = optarg;
+                break;
             case 'C':
                 config_file = optarg;
                 break;
@@ -560,6 +565,15 @@ main(int argc, char *argv[])
     /* Init TCP. */
     bbl_tcp_init();
 
+    /* Setup timerfd/epoll based event loop before
+     * interfaces, which register their RX sockets. */
+    if(g_ctx->config.event_loop) {
+        if(!timer_event_init(&g_ctx->timer_root)) {
+            fprintf(stderr, "Error: Failed to init event loop\n");
+            goto CLEANUP;
+        }
+    }
+
     /* Init interfaces. */
     if(!bbl_interface_init()) {
         fprintf(stderr, "Error: Failed to init interfaces\n");
@@ -595,6 +609,11 @@ main(int argc, char *argv[])
         goto CLEANUP;
     }
 
+    if(!bbl_rfc2544_init()) {
+        fprintf(stderr, "Error: Failed to init RFC 2544 benchmark\n");
+        goto CLEANUP;
+    }
+
     /* Setup control job. */
     timer_add_periodic(&g_ctx->timer_root, &g_ctx->control_timer, "Control Timer", 
                        1, 0, g_ctx, &bbl_ctrl_job);
@@ -624,6 +643,12 @@ main(int argc, char *argv[])
     /* Start threads. */
     io_thread_start_all();
 
+    /* Start stream rebalancing job. */
+    if(g_ctx->config.stream_rebalance_interval) {
+        timer_add_periodic(&g_ctx->timer_root, &g_ctx->stream_rebalance_timer, "Stream Rebalancing",
+                           g_ctx->config.stream_rebalance_interval, 0, g_ctx, &io_stream_rebalance_job);
+    }
+
     /* Smear all buckets. */
     timer_smear_all_buckets(&g_ctx->timer_root);
 
@@ -676,6 +701,7 @@ main(int argc, char *argv[])
     bbl_stats_generate(&stats);
     bbl_stats_stdout(&stats);
     bbl_stats_json(&stats);
+    bbl_stream_export_final();
     exit_status = 0;
 
     /* Cleanup resources. */
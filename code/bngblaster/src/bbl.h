@@ -33,6 +33,8 @@
 
 #include "bbl_ctrl.h"
 #include "bbl_stats.h"
+#include "bbl_histogram.h"
+#include "bbl_arena.h"
 #include "bbl_access_line.h"
 #include "bbl_config.h"
 #include "bbl_l2tp.h"
@@ -54,6 +56,7 @@
 #include "bbl_http_client.h"
 #include "bbl_http_server.h"
 #include "bbl_fragment.h"
+#include "bbl_rfc2544.h"
 
 #include "io/io.h"
 #include "bgp/bgp.h"
@@ -63,6 +63,7 @@ typedef struct bbl_a10nsp_interface_
         bbl_rate_s rate_session_ipv6pd_rx;
         bbl_rate_s rate_stream_tx;
         bbl_rate_s rate_stream_rx;
+        bbl_histogram_s *stream_delay; /* Stream RX delay histogram (usec) */
     } stats;
 
     struct timer_ *rate_job;
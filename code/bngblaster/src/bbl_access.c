@@ -1999,7 +1999,8 @@ bbl_access_rx_handler(bbl_access_interface_s *interface,
 static json_t *
 bbl_access_interface_json(bbl_access_interface_s *interface)
 {
-    return json_pack("{ss si ss sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI}",
+    json_t *root;
+    root = json_pack("{ss si ss sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI}",
                      "name", interface->name,
                      "ifindex", interface->ifindex,
                      "type", "Access",
@@ -2035,6 +2036,8 @@ bbl_access_interface_json(bbl_access_interface_s *interface)
                      "rx-pps-streams", interface->stats.rate_stream_rx.avg,
                      "rx-loss-packets-streams", interface->stats.stream_loss
                     );
+    bbl_histogram_json(interface->stats.stream_delay, root, "rx-delay-us-streams");
+    return root;
 }
 
 /* Control Socket Commands */
@@ -0,0 +1,81 @@
+/*
+ * BNG Blaster (BBL) - Arena Allocator
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bbl.h"
+
+/**
+ * bbl_arena_alloc
+ *
+ * Allocate zeroed memory from arena. This function
+ * is not thread-safe and should be called from the
+ * main thread only.
+ *
+ * @param arena arena
+ * @param size size in bytes
+ * @param align alignment (power of two)
+ * @return pointer to memory or NULL
+ */
+void *
+bbl_arena_alloc(bbl_arena_s *arena, size_t size, size_t align)
+{
+    bbl_arena_chunk_s *chunk = arena->chunk;
+    uintptr_t ptr;
+    size_t chunk_size;
+
+    if(align < sizeof(void*)) align = sizeof(void*);
+
+    if(chunk) {
+        ptr = ((uintptr_t)(chunk->data + chunk->used) + (align - 1)) & ~(uintptr_t)(align - 1);
+        if(ptr + size <= (uintptr_t)(chunk->data + chunk->size)) {
+            chunk->used = (ptr + size) - (uintptr_t)chunk->data;
+            arena->allocations++;
+            arena->bytes_used += size;
+            return (void*)ptr;
+        }
+    }
+
+    /* Add new chunk, where the remaining memory
+     * of the previous chunk is left unused. */
+    chunk_size = BBL_ARENA_CHUNK_SIZE;
+    if(size + align > chunk_size) {
+        chunk_size = size + align;
+    }
+    chunk = calloc(1, sizeof(bbl_arena_chunk_s) + chunk_size);
+    if(!chunk) {
+        return NULL;
+    }
+    chunk->size = chunk_size;
+    chunk->next = arena->chunk;
+    arena->chunk = chunk;
+    arena->bytes_reserved += sizeof(bbl_arena_chunk_s) + chunk_size;
+
+    ptr = ((uintptr_t)chunk->data + (align - 1)) & ~(uintptr_t)(align - 1);
+    chunk->used = (ptr + size) - (uintptr_t)chunk->data;
+    arena->allocations++;
+    arena->bytes_used += size;
+    return (void*)ptr;
+}
+
+/**
+ * bbl_arena_free
+ *
+ * Free all memory allocated from arena.
+ *
+ * @param arena arena
+ */
+void
+bbl_arena_free(bbl_arena_s *arena)
+{
+    bbl_arena_chunk_s *chunk = arena->chunk;
+    bbl_arena_chunk_s *next;
+
+    while(chunk) {
+        next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    memset(arena, 0x0, sizeof(bbl_arena_s));
+}
@@ -0,0 +1,39 @@
+/*
+ * BNG Blaster (BBL) - Arena Allocator
+ *
+ * Simple bump allocator used for objects which are
+ * allocated once and kept until the program exits
+ * (e.g. traffic streams and their packet templates).
+ * All memory is released at once with bbl_arena_free.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_ARENA_H__
+#define __BBL_ARENA_H__
+
+#define BBL_ARENA_CHUNK_SIZE (4 * 1024 * 1024)
+
+typedef struct bbl_arena_chunk_
+{
+    struct bbl_arena_chunk_ *next;
+    size_t size;
+    size_t used;
+    uint8_t data[];
+} bbl_arena_chunk_s;
+
+typedef struct bbl_arena_
+{
+    bbl_arena_chunk_s *chunk; /* current chunk */
+    uint64_t allocations;
+    uint64_t bytes_used; /* requested bytes */
+    uint64_t bytes_reserved; /* chunk memory */
+} bbl_arena_s;
+
+void *
+bbl_arena_alloc(bbl_arena_s *arena, size_t size, size_t align);
+
+void
+bbl_arena_free(bbl_arena_s *arena);
+
+#endif
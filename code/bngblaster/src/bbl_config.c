@@ -473,6 +473,11 @@ link_add(char *interface_name)
     link_config->io_slots_rx = g_ctx->config.io_slots;
     link_config->io_slots_tx = g_ctx->config.io_slots;
     link_config->qdisc_bypass = g_ctx->config.qdisc_bypass;
+    link_config->xdp_flags = g_ctx->config.xdp_flags;
+    link_config->tx_mbuf_template = g_ctx->config.tx_mbuf_template;
+    link_config->rx_tpacket_v3 = g_ctx->config.rx_tpacket_v3;
+    link_config->rx_block_size = g_ctx->config.rx_block_size;
+    link_config->rx_block_timeout = g_ctx->config.rx_block_timeout;
     link_config->tx_interval = g_ctx->config.tx_interval;
     link_config->rx_interval = g_ctx->config.rx_interval;
     link_config->tx_threads = g_ctx->config.tx_threads;
@@ -492,7 +497,8 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
         "interface", "description", "mac",
         "io-mode", "io-slots", "io-burst", 
         "io-slots-tx", "io-slots-rx", 
-        "qdisc-bypass", 
+        "qdisc-bypass", "xdp-mode", "tx-mbuf-template",
+        "rx-tpacket-v3", "rx-block-size", "rx-block-timeout",
         "tx-interval","rx-interval", 
         "tx-threads", "rx-threads",
         "rx-cpuset", "tx-cpuset", 
@@ -538,6 +544,9 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
             io_packet_mmap_set_max_stream_len();
         } else if(strcmp(s, "raw") == 0) {
             link_config->io_mode = IO_MODE_RAW;
+        } else if(strcmp(s, "af_xdp") == 0) {
+            link_config->io_mode = IO_MODE_AF_XDP;
+            io_af_xdp_set_max_stream_len();
 #if BNGBLASTER_DPDK
         } else if(strcmp(s, "dpdk") == 0) {
             link_config->io_mode = IO_MODE_DPDK;
@@ -578,6 +587,44 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
     } else {
         link_config->qdisc_bypass = g_ctx->config.qdisc_bypass;
     }
+    if(json_unpack(link, "{s:s}", "xdp-mode", &s) == 0) {
+        if(strcmp(s, "auto") == 0) {
+            link_config->xdp_flags = 0;
+        } else if(strcmp(s, "generic") == 0) {
+            link_config->xdp_flags = XDP_FLAGS_SKB_MODE;
+        } else if(strcmp(s, "native") == 0) {
+            link_config->xdp_flags = XDP_FLAGS_DRV_MODE;
+        } else {
+            fprintf(stderr, "JSON config error: Invalid value for links->xdp-mode\n");
+            return false;
+        }
+    } else {
+        link_config->xdp_flags = g_ctx->config.xdp_flags;
+    }
+    JSON_OBJ_GET_BOOL(link, value, "links", "tx-mbuf-template");
+    if(value) {
+        link_config->tx_mbuf_template = json_boolean_value(value);
+    } else {
+        link_config->tx_mbuf_template = g_ctx->config.tx_mbuf_template;
+    }
+    JSON_OBJ_GET_BOOL(link, value, "links", "rx-tpacket-v3");
+    if(value) {
+        link_config->rx_tpacket_v3 = json_boolean_value(value);
+    } else {
+        link_config->rx_tpacket_v3 = g_ctx->config.rx_tpacket_v3;
+    }
+    JSON_OBJ_GET_NUMBER(link, value, "links", "rx-block-size", 4096, 134217728);
+    if(value) {
+        link_config->rx_block_size = json_number_value(value);
+    } else {
+        link_config->rx_block_size = g_ctx->config.rx_block_size;
+    }
+    JSON_OBJ_GET_NUMBER(link, value, "links", "rx-block-timeout", 1, 1000);
+    if(value) {
+        link_config->rx_block_timeout = json_number_value(value);
+    } else {
+        link_config->rx_block_timeout = g_ctx->config.rx_block_timeout;
+    }
 
     value = json_object_get(link, "tx-interval");
     if(json_is_number(value)) {
@@ -1410,6 +1457,175 @@ bgp_afi_safi(const char *s)
     }
 }
 
+static bool
+json_parse_bgp_generator_config(json_t *generator, bgp_generator_config_s *config)
+{
+    json_t *value, *sub = NULL;
+    const char *s = NULL;
+    int i, size;
+    ipv4_prefix ipv4;
+    ipv6_prefix ipv6;
+    ipv4addr_t ipv4_next_hop;
+    uint8_t last[IPV6_ADDR_LEN];
+
+    const char *schema[] = {
+        "prefix-base", "prefix-num",
+        "next-hop-base", "next-hop-num",
+        "label-base", "label-num",
+        "asn", "local-pref", "message-size",
+        "withdraw", "end-of-rib"
+    };
+    if(!schema_validate(generator, "update-generator", schema, 
+    sizeof(schema)/sizeof(schema[0]))) {
+        return false;
+    }
+
+    if(json_unpack(generator, "{s:s}", "prefix-base", &s) == 0) {
+        if(strchr(s, ':')) {
+            if(!scan_ipv6_prefix(s, &ipv6)) {
+                fprintf(stderr, "JSON config error: Invalid value for bgp->update-generator->prefix-base\n");
+                return false;
+            }
+            config->afi = IANA_AFI_IPV6;
+            config->prefix_len = ipv6.len;
+            config->prefix_addr_len = IPV6_ADDR_LEN;
+            memcpy(config->prefix, ipv6.address, IPV6_ADDR_LEN);
+        } else {
+            if(!scan_ipv4_prefix(s, &ipv4)) {
+                fprintf(stderr, "JSON config error: Invalid value for bgp->update-generator->prefix-base\n");
+                return false;
+            }
+            config->afi = IANA_AFI_IPV4;
+            config->prefix_len = ipv4.len;
+            config->prefix_addr_len = IPV4_ADDR_LEN;
+            memcpy(config->prefix, &ipv4.address, IPV4_ADDR_LEN);
+        }
+        /* Clear host bits. */
+        for(i = 0; i < config->prefix_addr_len; i++) {
+            if(i * 8 >= config->prefix_len) {
+                config->prefix[i] = 0;
+            } else if((i + 1) * 8 > config->prefix_len) {
+                config->prefix[i] &= (uint8_t)(0xff << (8 - (config->prefix_len % 8)));
+            }
+        }
+    } else {
+        fprintf(stderr, "JSON config error: Missing value for bgp->update-generator->prefix-base\n");
+        return false;
+    }
+
+    JSON_OBJ_GET_NUMBER(generator, value, "bgp->update-generator", "prefix-num", 1, 4294967295);
+    if(value) {
+        config->prefix_num = json_number_value(value);
+    } else {
+        config->prefix_num = 1;
+    }
+    memcpy(last, config->prefix, config->prefix_addr_len);
+    if(!bgp_generator_add(last, config->prefix_addr_len, config->prefix_num - 1, 
+                          config->prefix_addr_len * 8 - config->prefix_len)) {
+        fprintf(stderr, "JSON config error: Invalid value for bgp->update-generator->prefix-num (address range exceeded)\n");
+        return false;
+    }
+
+    if(json_unpack(generator, "{s:s}", "next-hop-base", &s) == 0) {
+        if(inet_pton(AF_INET, s, &ipv4_next_hop)) {
+            if(config->afi == IANA_AFI_IPV6) {
+                /* IPv4-mapped IPv6 address ::FFFF:<IPv4> */
+                config->next_hop_len = IPV6_ADDR_LEN;
+                config->next_hop[10] = 0xff;
+                config->next_hop[11] = 0xff;
+                memcpy(config->next_hop+12, &ipv4_next_hop, IPV4_ADDR_LEN);
+            } else {
+                config->next_hop_len = IPV4_ADDR_LEN;
+                memcpy(config->next_hop, &ipv4_next_hop, IPV4_ADDR_LEN);
+            }
+        } else if(inet_pton(AF_INET6, s, config->next_hop)) {
+            if(config->afi == IANA_AFI_IPV4) {
+                fprintf(stderr, "JSON config error: Invalid value for bgp->update-generator->next-hop-base (IPv6 next-hop for IPv4 prefixes)\n");
+                return false;
+            }
+            config->next_hop_len = IPV6_ADDR_LEN;
+        } else {
+            fprintf(stderr, "JSON config error: Invalid value for bgp->update-generator->next-hop-base\n");
+            return false;
+        }
+    } else {
+        fprintf(stderr, "JSON config error: Missing value for bgp->update-generator->next-hop-base\n");
+        return false;
+    }
+
+    JSON_OBJ_GET_NUMBER(generator, value, "bgp->update-generator", "next-hop-num", 1, 65535);
+    if(value) {
+        config->next_hop_num = json_number_value(value);
+    } else {
+        config->next_hop_num = 1;
+    }
+
+    JSON_OBJ_GET_NUMBER(generator, value, "bgp->update-generator", "label-base", 1, 1048575);
+    if(value) {
+        config->label_base = json_number_value(value);
+        config->safi = 4; /* labeled unicast */
+    } else {
+        config->safi = 1; /* unicast */
+    }
+
+    JSON_OBJ_GET_NUMBER(generator, value, "bgp->update-generator", "label-num", 1, 1048575);
+    if(value) {
+        config->label_num = json_number_value(value);
+    } else {
+        config->label_num = 1;
+    }
+    if(config->label_base) {
+        config->label_num = bgp_generator_label_num(config->label_base, config->label_num);
+    }
+
+    value = json_object_get(generator, "asn");
+    if(value) {
+        if(!json_is_array(value)) {
+            fprintf(stderr, "JSON config error: Invalid value for bgp->update-generator->asn (array of numbers expected)\n");
+            return false;
+        }
+        size = json_array_size(value);
+        if(size > BGP_GENERATOR_ASN_MAX) {
+            fprintf(stderr, "JSON config error: Invalid value for bgp->update-generator->asn (max %u)\n", BGP_GENERATOR_ASN_MAX);
+            return false;
+        }
+        for(i = 0; i < size; i++) {
+            sub = json_array_get(value, i);
+            if(!json_is_number(sub)) {
+                fprintf(stderr, "JSON config error: Invalid value for bgp->update-generator->asn (array of numbers expected)\n");
+                return false;
+            }
+            config->asn[config->asn_count++] = json_number_value(sub);
+        }
+    }
+
+    JSON_OBJ_GET_NUMBER(generator, value, "bgp->update-generator", "local-pref", 0, 4294967295);
+    if(value) {
+        config->local_pref = json_number_value(value);
+        config->local_pref_enabled = true;
+    }
+
+    JSON_OBJ_GET_NUMBER(generator, value, "bgp->update-generator", "message-size", 256, 65535);
+    if(value) {
+        config->message_size = json_number_value(value);
+    } else {
+        config->message_size = BGP_MAX_MESSAGE_SIZE;
+    }
+
+    JSON_OBJ_GET_BOOL(generator, value, "bgp->update-generator", "withdraw");
+    if(value) {
+        config->withdraw = json_boolean_value(value);
+    }
+
+    JSON_OBJ_GET_BOOL(generator, value, "bgp->update-generator", "end-of-rib");
+    if(value) {
+        config->end_of_rib = json_boolean_value(value);
+    } else {
+        config->end_of_rib = true;
+    }
+    return true;
+}
+
 static bool
 json_parse_bgp_config(json_t *bgp, bgp_config_s *bgp_config)
 {
@@ -1428,7 +1644,8 @@ json_parse_bgp_config(json_t *bgp, bgp_config_s *bgp_config)
         "local-as", "peer-as", "hold-time", "tos", "ttl",
         "id", "reconnect", "start-traffic",
         "teardown-time", "raw-update-file",
-        "family", "extended-nexthop"
+        "family", "extended-nexthop", "adj-rib-in",
+        "extended-message", "update-generator"
     };
     if(!schema_validate(bgp, "bgp", schema, 
     sizeof(schema)/sizeof(schema[0]))) {
@@ -1541,6 +1758,18 @@ json_parse_bgp_config(json_t *bgp, bgp_config_s *bgp_config)
         bgp_config->start_traffic = false;
     }
 
+    JSON_OBJ_GET_BOOL(bgp, value, "bgp", "extended-message");
+    if(value) {
+        bgp_config->extended_message = json_boolean_value(value);
+    }
+
+    JSON_OBJ_GET_BOOL(bgp, value, "bgp", "adj-rib-in");
+    if(value) {
+        bgp_config->adj_rib_in = json_boolean_value(value);
+    } else {
+        bgp_config->adj_rib_in = true;
+    }
+
     JSON_OBJ_GET_NUMBER(bgp, value, "bgp", "teardown-time", 0, 65535);
     if(value) {
         bgp_config->teardown_time = json_number_value(value);
@@ -1550,7 +1779,19 @@ json_parse_bgp_config(json_t *bgp, bgp_config_s *bgp_config)
 
     if(json_unpack(bgp, "{s:s}", "raw-update-file", &s) == 0) {
         bgp_config->raw_update_file = strdup(s);
-        if(!bgp_raw_update_load(bgp_config->raw_update_file, true)) {
+        if(!bgp_raw_update_load(bgp_config->raw_update_file)) {
+            return false;
+        }
+    }
+
+    value = json_object_get(bgp, "update-generator");
+    if(value) {
+        if(bgp_config->raw_update_file) {
+            fprintf(stderr, "JSON config error: bgp->update-generator and bgp->raw-update-file are mutually exclusive\n");
+            return false;
+        }
+        bgp_config->generator = calloc(1, sizeof(bgp_generator_config_s));
+        if(!json_parse_bgp_generator_config(value, bgp_config->generator)) {
             return false;
         }
     }
@@ -2319,7 +2560,7 @@ json_parse_ldp_config(json_t *ldp, ldp_config_s *ldp_config)
 
     if(json_unpack(ldp, "{s:s}", "raw-update-file", &s) == 0) {
         ldp_config->raw_update_file = strdup(s);
-        if(!ldp_raw_update_load(ldp_config->raw_update_file, true)) {
+        if(!ldp_raw_update_load(ldp_config->raw_update_file)) {
             return false;
         }
     }
@@ -2959,6 +3200,103 @@ json_parse_icmp_client_config(json_t *icmp, bbl_icmp_client_config_s *icmp_clien
     return true;
 }
 
+static bool
+json_parse_rfc2544_config(json_t *rfc2544, bbl_rfc2544_config_s *rfc2544_config)
+{
+    json_t *value = NULL;
+    json_t *sub = NULL;
+    const char *s = NULL;
+    uint16_t frame_size;
+    int i, size;
+
+    const char *schema[] = {
+        "autostart", "stream", "frame-sizes",
+        "trial-duration", "settle-time", "start-delay",
+        "loss-tolerance", "resolution", "rate-max"
+    };
+    if(!schema_validate(rfc2544, "rfc2544", schema, 
+       sizeof(schema)/sizeof(schema[0]))) {
+        return false;
+    }
+
+    JSON_OBJ_GET_BOOL(rfc2544, value, "rfc2544", "autostart");
+    if(value) {
+        rfc2544_config->autostart = json_boolean_value(value);
+    } else {
+        rfc2544_config->autostart = true;
+    }
+    if(json_unpack(rfc2544, "{s:s}", "stream", &s) == 0) {
+        rfc2544_config->stream = strdup(s);
+    }
+    sub = json_object_get(rfc2544, "frame-sizes");
+    if(sub) {
+        if(!json_is_array(sub)) {
+            fprintf(stderr, "JSON config error: List expected in rfc2544->frame-sizes\n");
+            return false;
+        }
+        size = json_array_size(sub);
+        if(size < 1 || size > BBL_RFC2544_FRAME_SIZES_MAX) {
+            fprintf(stderr, "JSON config error: Invalid number of rfc2544->frame-sizes (1 - %u)\n", BBL_RFC2544_FRAME_SIZES_MAX);
+            return false;
+        }
+        for(i = 0; i < size; i++) {
+            value = json_array_get(sub, i);
+            if(!(json_is_number(value) && json_number_value(value) >= 76 && 
+                 json_number_value(value) <= g_ctx->config.io_max_stream_len)) {
+                fprintf(stderr, "JSON config error: Invalid value for rfc2544->frame-sizes (must be between 76 and %u)\n", g_ctx->config.io_max_stream_len);
+                return false;
+            }
+            rfc2544_config->frame_sizes[rfc2544_config->frame_sizes_count++] = json_number_value(value);
+        }
+    } else {
+        const uint16_t frame_sizes[] = {128, 256, 512, 1024, 1280, 1500};
+        for(i = 0; i < (int)(sizeof(frame_sizes)/sizeof(frame_sizes[0])); i++) {
+            rfc2544_config->frame_sizes[rfc2544_config->frame_sizes_count++] = frame_sizes[i];
+        }
+    }
+    for(i = 0; i < rfc2544_config->frame_sizes_count; i++) {
+        frame_size = rfc2544_config->frame_sizes[i];
+        if(frame_size > rfc2544_config->frame_size_max) {
+            rfc2544_config->frame_size_max = frame_size;
+        }
+    }
+    JSON_OBJ_GET_NUMBER(rfc2544, value, "rfc2544", "trial-duration", 1, 3600);
+    if(value) {
+        rfc2544_config->trial_duration = json_number_value(value);
+    } else {
+        rfc2544_config->trial_duration = 60;
+    }
+    JSON_OBJ_GET_NUMBER(rfc2544, value, "rfc2544", "settle-time", 0, 60);
+    if(value) {
+        rfc2544_config->settle_time = json_number_value(value);
+    } else {
+        rfc2544_config->settle_time = 2;
+    }
+    JSON_OBJ_GET_NUMBER(rfc2544, value, "rfc2544", "start-delay", 1, 3600);
+    if(value) {
+        rfc2544_config->start_delay = json_number_value(value);
+    } else {
+        rfc2544_config->start_delay = 10;
+    }
+    JSON_OBJ_GET_NUMBER(rfc2544, value, "rfc2544", "loss-tolerance", 0, 100);
+    if(value) {
+        rfc2544_config->loss_tolerance = json_number_value(value);
+    }
+    JSON_OBJ_GET_NUMBER(rfc2544, value, "rfc2544", "resolution", 0.01, 50);
+    if(value) {
+        rfc2544_config->resolution = json_number_value(value);
+    } else {
+        rfc2544_config->resolution = 0.5;
+    }
+    JSON_OBJ_GET_NUMBER(rfc2544, value, "rfc2544", "rate-max", 1, 100);
+    if(value) {
+        rfc2544_config->rate_max = json_number_value(value);
+    } else {
+        rfc2544_config->rate_max = 100;
+    }
+    return true;
+}
+
 
 static bool
 json_parse_http_client_config(json_t *http, bbl_http_client_config_s *http_client_config)
@@ -3138,7 +3476,7 @@ json_parse_config(json_t *root)
         "ldp", "ldp-raw-update-files",
         "l2tp-server", "icmp-client",
         "http-client", "http-server",
-        "arp-client"
+        "arp-client", "rfc2544"
     };
     if(!schema_validate(root, "root", root_schema, 
        sizeof(root_schema)/sizeof(root_schema[0]))) {
@@ -3150,7 +3488,7 @@ json_parse_config(json_t *root)
     if(json_is_object(section)) {
 
         const char *sessions_schema[] = {
-            "count", "max-outstanding", "start-rate", "stop-rate", 
+            "count", "id-offset", "max-outstanding", "start-rate", "stop-rate", 
             "iterate-vlan-outer", "start-delay", "autostart", 
             "reconnect", "monkey-autostart"
         };
@@ -3162,6 +3500,10 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.sessions = json_number_value(value);
         }
+        JSON_OBJ_GET_NUMBER(section, value, "sessions", "id-offset", 0, 16777214);
+        if(value) {
+            g_ctx->config.sessions_id_offset = json_number_value(value);
+        }
         JSON_OBJ_GET_NUMBER(section, value, "sessions", "max-outstanding", 1, 10000000);
         if(value) {
             g_ctx->config.sessions_max_outstanding = json_number_value(value);
@@ -3745,7 +4087,13 @@ json_parse_config(json_t *root)
             "stream-autostart",
             "stream-rate-calculation",
             "stream-delay-calculation",
+            "stream-delay-histogram",
+            "stream-loss-calculation",
             "stream-burst-ms",
+            "stream-rebalance-interval",
+            "stream-rebalance-lag-ms",
+            "stream-pacing",
+            "stream-export-directory",
             "reassemble-fragments",
             "multicast-autostart",
             "udp-checksum"
@@ -3775,10 +4123,33 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.stream_delay_calc = json_boolean_value(value);
         }
+        JSON_OBJ_GET_BOOL(section, value, "traffic", "stream-delay-histogram");
+        if(value) {
+            g_ctx->config.stream_delay_histogram = json_boolean_value(value);
+        }
+        JSON_OBJ_GET_BOOL(section, value, "traffic", "stream-loss-calculation");
+        if(value) {
+            g_ctx->config.stream_loss_calc = json_boolean_value(value);
+        }
         JSON_OBJ_GET_NUMBER(section, value, "traffic", "stream-burst-ms", 1, 1000);
         if(value) {
             g_ctx->config.stream_burst_ms = json_number_value(value) * MSEC;
         }
+        JSON_OBJ_GET_NUMBER(section, value, "traffic", "stream-rebalance-interval", 0, 3600);
+        if(value) {
+            g_ctx->config.stream_rebalance_interval = json_number_value(value);
+        }
+        JSON_OBJ_GET_NUMBER(section, value, "traffic", "stream-rebalance-lag-ms", 1, 1000);
+        if(value) {
+            g_ctx->config.stream_rebalance_lag = json_number_value(value) * MSEC;
+        }
+        JSON_OBJ_GET_BOOL(section, value, "traffic", "stream-pacing");
+        if(value) {
+            g_ctx->config.stream_pacing = json_boolean_value(value);
+        }
+        if(json_unpack(section, "{s:s}", "stream-export-directory", &s) == 0) {
+            g_ctx->config.stream_export_directory = strdup(s);
+        }
         JSON_OBJ_GET_BOOL(section, value, "traffic", "reassemble-fragments");
         if(value) {
             g_ctx->config.traffic_reassemble_fragments = json_boolean_value(value);
@@ -3881,7 +4252,7 @@ json_parse_config(json_t *root)
         for(i = 0; i < size; i++) {
             s = json_string_value(json_array_get(sub, i));
             if(s) {
-                if(!bgp_raw_update_load(s, true)) {
+                if(!bgp_raw_update_load(s)) {
                     return false;
                 }
             }
@@ -3979,7 +4350,7 @@ json_parse_config(json_t *root)
         for(i = 0; i < size; i++) {
             s = json_string_value(json_array_get(sub, i));
             if(s) {
-                if(!ldp_raw_update_load(s, true)) {
+                if(!ldp_raw_update_load(s)) {
                     return false;
                 }
             }
@@ -3991,9 +4362,11 @@ json_parse_config(json_t *root)
     if(json_is_object(section)) {
 
         const char *schema[] = {
-            "io-mode", "io-slots", "io-burst", "qdisc-bypass",
+            "io-mode", "io-slots", "io-burst", "qdisc-bypass", "xdp-mode",
+            "tx-mbuf-template", "rx-tpacket-v3", "rx-block-size", "rx-block-timeout",
             "tx-interval", "rx-interval", "tx-threads",
-            "rx-threads", "capture-include-streams", "mac-modifier",
+            "rx-threads", "event-loop", "rx-busy-poll", "timestamping", "txtime",
+            "capture-include-streams", "mac-modifier",
             "lag", "network", "access", "a10nsp", "links"
         };
         if(!schema_validate(section, "interfaces", schema, 
@@ -4010,6 +4383,9 @@ json_parse_config(json_t *root)
                 io_packet_mmap_set_max_stream_len();
             } else if(strcmp(s, "raw") == 0) {
                 g_ctx->config.io_mode = IO_MODE_RAW;
+            } else if(strcmp(s, "af_xdp") == 0) {
+                g_ctx->config.io_mode = IO_MODE_AF_XDP;
+                io_af_xdp_set_max_stream_len();
 #if BNGBLASTER_DPDK
             } else if(strcmp(s, "dpdk") == 0) {
                 g_ctx->config.io_mode = IO_MODE_DPDK;
@@ -4037,6 +4413,34 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.qdisc_bypass = json_boolean_value(value);
         }
+        if(json_unpack(section, "{s:s}", "xdp-mode", &s) == 0) {
+            if(strcmp(s, "auto") == 0) {
+                g_ctx->config.xdp_flags = 0;
+            } else if(strcmp(s, "generic") == 0) {
+                g_ctx->config.xdp_flags = XDP_FLAGS_SKB_MODE;
+            } else if(strcmp(s, "native") == 0) {
+                g_ctx->config.xdp_flags = XDP_FLAGS_DRV_MODE;
+            } else {
+                fprintf(stderr, "JSON config error: Invalid value for interfaces->xdp-mode\n");
+                return false;
+            }
+        }
+        JSON_OBJ_GET_BOOL(section, value, "interfaces", "tx-mbuf-template");
+        if(value) {
+            g_ctx->config.tx_mbuf_template = json_boolean_value(value);
+        }
+        JSON_OBJ_GET_BOOL(section, value, "interfaces", "rx-tpacket-v3");
+        if(value) {
+            g_ctx->config.rx_tpacket_v3 = json_boolean_value(value);
+        }
+        JSON_OBJ_GET_NUMBER(section, value, "interfaces", "rx-block-size", 4096, 134217728);
+        if(value) {
+            g_ctx->config.rx_block_size = json_number_value(value);
+        }
+        JSON_OBJ_GET_NUMBER(section, value, "interfaces", "rx-block-timeout", 1, 1000);
+        if(value) {
+            g_ctx->config.rx_block_timeout = json_number_value(value);
+        }
         value = json_object_get(section, "tx-interval");
         if(json_is_number(value)) {
             g_ctx->config.tx_interval = json_number_value(value) * MSEC;
@@ -4053,6 +4457,38 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.rx_threads = json_number_value(value);
         }
+        JSON_OBJ_GET_BOOL(section, value, "interfaces", "event-loop");
+        if(value) {
+            g_ctx->config.event_loop = json_boolean_value(value);
+        }
+        JSON_OBJ_GET_NUMBER(section, value, "interfaces", "rx-busy-poll", 0, 65535);
+        if(value) {
+            g_ctx->config.rx_busy_poll = json_number_value(value);
+        }
+        if(json_unpack(section, "{s:s}", "timestamping", &s) == 0) {
+            if(strcmp(s, "none") == 0) {
+                g_ctx->config.io_timestamping = IO_TIMESTAMPING_NONE;
+            } else if(strcmp(s, "software") == 0) {
+                g_ctx->config.io_timestamping = IO_TIMESTAMPING_SOFTWARE;
+            } else if(strcmp(s, "hardware") == 0) {
+                g_ctx->config.io_timestamping = IO_TIMESTAMPING_HARDWARE;
+            } else {
+                fprintf(stderr, "JSON config error: Invalid value for interfaces->timestamping\n");
+                return false;
+            }
+        }
+        if(json_unpack(section, "{s:s}", "txtime", &s) == 0) {
+            if(strcmp(s, "none") == 0) {
+                g_ctx->config.io_txtime = IO_TXTIME_NONE;
+            } else if(strcmp(s, "fq") == 0) {
+                g_ctx->config.io_txtime = IO_TXTIME_FQ;
+            } else if(strcmp(s, "etf") == 0) {
+                g_ctx->config.io_txtime = IO_TXTIME_ETF;
+            } else {
+                fprintf(stderr, "JSON config error: Invalid value for interfaces->txtime\n");
+                return false;
+            }
+        }
         JSON_OBJ_GET_BOOL(section, value, "interfaces", "capture-include-streams");
         if(value) {
             g_ctx->pcap.include_streams = json_boolean_value(value);
@@ -4437,6 +4873,15 @@ json_parse_config(json_t *root)
     if(!json_parse_config_streams(root)) {
         return false;
     }
+
+    /* RFC 2544 Configuration */
+    sub = json_object_get(root, "rfc2544");
+    if(json_is_object(sub)) {
+        g_ctx->config.rfc2544 = calloc(1, sizeof(bbl_rfc2544_config_s));
+        if(!json_parse_rfc2544_config(sub, g_ctx->config.rfc2544)) {
+            return false;
+        }
+    }
     return true;
 }
 
@@ -4510,6 +4955,9 @@ bbl_config_init_defaults()
     g_ctx->config.rx_interval = 0.1 * MSEC;
     g_ctx->config.io_slots = 4096;
     g_ctx->config.io_burst = 256;
+    g_ctx->config.rx_block_size = 1 << 20;
+    g_ctx->config.rx_block_timeout = 1;
+    g_ctx->config.rx_busy_poll = 1024;
     g_ctx->config.io_max_stream_len = 9000;
     g_ctx->config.qdisc_bypass = true;
     g_ctx->config.sessions = 1;
@@ -4567,7 +5015,9 @@ bbl_config_init_defaults()
     g_ctx->config.stream_autostart = true;
     g_ctx->config.stream_rate_calc = true;
     g_ctx->config.stream_delay_calc = true;
+    g_ctx->config.stream_loss_calc = true;
     g_ctx->config.stream_burst_ms = 100 * MSEC;
+    g_ctx->config.stream_rebalance_lag = 10 * MSEC;
     g_ctx->config.multicast_traffic_autostart = true;
     g_ctx->config.session_traffic_autostart = true;
 }
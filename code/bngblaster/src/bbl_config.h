@@ -188,6 +188,12 @@ typedef struct bbl_link_config_
     uint16_t io_burst;
 
     bool qdisc_bypass;
+    uint32_t xdp_flags; /* AF_XDP attach mode */
+    bool tx_mbuf_template; /* DPDK TX stream template mbufs */
+
+    bool rx_tpacket_v3;
+    uint32_t rx_block_size; /* TPACKET_V3 block size in bytes */
+    uint16_t rx_block_timeout; /* TPACKET_V3 block retire timeout in msec */
 
     uint64_t tx_interval; /* TX interval in nsec */
     uint64_t rx_interval; /* RX interval in nsec */
@@ -17,6 +17,9 @@
 #include <signal.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <ctype.h>
+#include <stdarg.h>
 
 #include "bbl.h"
 #include "bbl_ctrl.h"
@@ -43,7 +46,7 @@ const char *schema_all_args[] = {
     "disconnect-direction", "disconnect-message",
     "ldp-instance-id", "tcp-flags", "debug", "detail",
     "verified-only", "bidirectional-verified-only",
-    "network-interface",
+    "network-interface", "counters", "interval",
     NULL
 };
 
@@ -196,6 +199,237 @@ struct action {
     bool thread_safe;
 };
 
+static void
+bbl_ctrl_subscription_free(bbl_ctrl_connection_s *connection)
+{
+    bbl_ctrl_subscription_s *subscription = connection->subscription;
+    if(subscription) {
+        json_decref(subscription->request_id);
+        free(subscription->last.counters);
+        free(subscription->current.counters);
+        free(subscription);
+        connection->subscription = NULL;
+    }
+}
+
+/**
+ * Add counter to telemetry snapshot.
+ */
+static bbl_ctrl_counter_s *
+bbl_ctrl_counter_add(bbl_ctrl_snapshot_s *snapshot, const char *fmt, va_list ap)
+{
+    bbl_ctrl_counter_s *counter;
+    uint32_t size;
+
+    if(snapshot->count == snapshot->size) {
+        size = snapshot->size ? snapshot->size * 2 : 64;
+        counter = realloc(snapshot->counters, size * sizeof(bbl_ctrl_counter_s));
+        if(!counter) {
+            return NULL;
+        }
+        snapshot->counters = counter;
+        snapshot->size = size;
+    }
+    counter = &snapshot->counters[snapshot->count++];
+    vsnprintf(counter->key, sizeof(counter->key), fmt, ap);
+    return counter;
+}
+
+static void
+bbl_ctrl_counter(bbl_ctrl_snapshot_s *snapshot, uint64_t value, const char *fmt, ...)
+{
+    bbl_ctrl_counter_s *counter;
+    va_list ap;
+
+    va_start(ap, fmt);
+    counter = bbl_ctrl_counter_add(snapshot, fmt, ap);
+    va_end(ap);
+    if(counter) {
+        counter->real = false;
+        counter->value.u64 = value;
+    }
+}
+
+static void
+bbl_ctrl_counter_real(bbl_ctrl_snapshot_s *snapshot, double value, const char *fmt, ...)
+{
+    bbl_ctrl_counter_s *counter;
+    va_list ap;
+
+    va_start(ap, fmt);
+    counter = bbl_ctrl_counter_add(snapshot, fmt, ap);
+    va_end(ap);
+    if(counter) {
+        counter->real = true;
+        counter->value.real = value;
+    }
+}
+
+static void
+bbl_ctrl_counters_session(bbl_ctrl_snapshot_s *s)
+{
+    bbl_ctrl_counter(s, g_ctx->config.sessions, "session-counters.sessions");
+    bbl_ctrl_counter(s, g_ctx->sessions_pppoe, "session-counters.sessions-pppoe");
+    bbl_ctrl_counter(s, g_ctx->sessions_ipoe, "session-counters.sessions-ipoe");
+    bbl_ctrl_counter(s, g_ctx->sessions_established, "session-counters.sessions-established");
+    bbl_ctrl_counter(s, g_ctx->sessions_established_max, "session-counters.sessions-established-max");
+    bbl_ctrl_counter(s, g_ctx->sessions_outstanding, "session-counters.sessions-outstanding");
+    bbl_ctrl_counter(s, g_ctx->sessions_terminated, "session-counters.sessions-terminated");
+    bbl_ctrl_counter(s, g_ctx->sessions_flapped, "session-counters.sessions-flapped");
+    bbl_ctrl_counter(s, g_ctx->dhcp_requested, "session-counters.dhcp-sessions");
+    bbl_ctrl_counter(s, g_ctx->dhcp_established, "session-counters.dhcp-sessions-established");
+    bbl_ctrl_counter(s, g_ctx->dhcp_established_max, "session-counters.dhcp-sessions-established-max");
+    bbl_ctrl_counter(s, g_ctx->dhcpv6_requested, "session-counters.dhcpv6-sessions");
+    bbl_ctrl_counter(s, g_ctx->dhcpv6_established, "session-counters.dhcpv6-sessions-established");
+    bbl_ctrl_counter(s, g_ctx->dhcpv6_established_max, "session-counters.dhcpv6-sessions-established-max");
+    bbl_ctrl_counter(s, g_ctx->stats.setup_time, "session-counters.setup-time");
+    bbl_ctrl_counter_real(s, g_ctx->stats.cps, "session-counters.setup-rate");
+    bbl_ctrl_counter_real(s, g_ctx->stats.cps_min, "session-counters.setup-rate-min");
+    bbl_ctrl_counter_real(s, g_ctx->stats.cps_avg, "session-counters.setup-rate-avg");
+    bbl_ctrl_counter_real(s, g_ctx->stats.cps_max, "session-counters.setup-rate-max");
+    bbl_ctrl_counter(s, g_ctx->stats.session_traffic_flows, "session-counters.session-traffic-flows");
+    bbl_ctrl_counter(s, g_ctx->stats.session_traffic_flows_verified, "session-counters.session-traffic-flows-verified");
+    bbl_ctrl_counter(s, g_ctx->stats.stream_traffic_flows, "session-counters.stream-traffic-flows");
+    bbl_ctrl_counter(s, g_ctx->stats.stream_traffic_flows_verified, "session-counters.stream-traffic-flows-verified");
+}
+
+static void
+bbl_ctrl_counters_stream_stats(bbl_ctrl_snapshot_s *s)
+{
+    bbl_ctrl_counter(s, g_ctx->stats.stream_traffic_flows, "stream-stats.total-flows");
+    bbl_ctrl_counter(s, g_ctx->stats.stream_traffic_flows_verified, "stream-stats.verified-flows");
+}
+
+static void
+bbl_ctrl_counters_interfaces(bbl_ctrl_snapshot_s *s)
+{
+    bbl_interface_s *interface;
+    io_handle_s *io;
+
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+
+    CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+        tx_packets = 0;
+        tx_bytes = 0;
+        for(io = interface->io.tx; io; io = io->next) {
+            tx_packets += io->stats.packets;
+            tx_bytes += io->stats.bytes;
+        }
+        rx_packets = 0;
+        rx_bytes = 0;
+        for(io = interface->io.rx; io; io = io->next) {
+            rx_packets += io->stats.packets;
+            rx_bytes += io->stats.bytes;
+        }
+        bbl_ctrl_counter(s, interface->state_transitions, "interfaces.%s.state-transitions", interface->name);
+        bbl_ctrl_counter(s, tx_packets, "interfaces.%s.tx-packets", interface->name);
+        bbl_ctrl_counter(s, tx_bytes, "interfaces.%s.tx-bytes", interface->name);
+        bbl_ctrl_counter(s, rx_packets, "interfaces.%s.rx-packets", interface->name);
+        bbl_ctrl_counter(s, rx_bytes, "interfaces.%s.rx-bytes", interface->name);
+    }
+}
+
+static void
+bbl_ctrl_counters_streams(bbl_ctrl_snapshot_s *s)
+{
+    bbl_stream_s *stream = g_ctx->stream_head;
+
+    while(stream) {
+        bbl_ctrl_counter(s, stream->tx_packets, "streams.%lu.tx-packets", stream->flow_id);
+        bbl_ctrl_counter(s, stream->rx_packets, "streams.%lu.rx-packets", stream->flow_id);
+        bbl_ctrl_counter(s, stream->rx_loss, "streams.%lu.rx-loss", stream->flow_id);
+        bbl_ctrl_counter(s, stream->rx_min_delay_us, "streams.%lu.rx-min-delay-us", stream->flow_id);
+        bbl_ctrl_counter(s, stream->rx_max_delay_us, "streams.%lu.rx-max-delay-us", stream->flow_id);
+        stream = stream->next;
+    }
+}
+
+/**
+ * Counters which can be subscribed. 
+ * 
+ * Those are read directly from the stats and stream
+ * structures by the ctrl thread, so only read-only 
+ * counters must be added here. 
+ */
+static const struct {
+    const char *name;
+    void (*fn)(bbl_ctrl_snapshot_s *snapshot);
+} subscription_counters[] = {
+    {"session-counters", bbl_ctrl_counters_session},
+    {"stream-stats", bbl_ctrl_counters_stream_stats},
+    {"interfaces", bbl_ctrl_counters_interfaces},
+    {"streams", bbl_ctrl_counters_streams},
+    {NULL, NULL}
+};
+
+int
+bbl_ctrl_subscribe(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
+{
+    bbl_ctrl_thread_s *ctrl = g_ctx->ctrl_thread;
+    bbl_ctrl_connection_s *connection;
+    bbl_ctrl_subscription_s *subscription;
+    json_t *counters = NULL;
+    json_t *value;
+    uint32_t groups = 0;
+    int interval = 1000;
+    size_t i, c;
+
+    connection = ctrl->current;
+    if(!(connection && connection->persistent)) {
+        return bbl_ctrl_status(fd, "error", 400, "persistent connection required");
+    }
+    if(json_unpack(arguments, "{s:o}", "counters", &counters) != 0 || 
+       !json_is_array(counters) || json_array_size(counters) == 0) {
+        return bbl_ctrl_status(fd, "error", 400, "missing counters");
+    }
+    json_array_foreach(counters, i, value) {
+        if(!json_is_string(value)) {
+            return bbl_ctrl_status(fd, "error", 400, "invalid counters");
+        }
+        /* Only read-only counters can be subscribed. */
+        for(c = 0; subscription_counters[c].name; c++) {
+            if(strcmp(json_string_value(value), subscription_counters[c].name) == 0) {
+                groups |= 1 << c;
+                break;
+            }
+        }
+        if(!subscription_counters[c].name) {
+            return bbl_ctrl_status(fd, "error", 400, "invalid counters");
+        }
+    }
+    json_unpack(arguments, "{s:i}", "interval", &interval);
+    if(interval < BBL_CTRL_SUBSCRIPTION_INTERVAL_MIN) {
+        return bbl_ctrl_status(fd, "error", 400, "invalid interval");
+    }
+
+    bbl_ctrl_subscription_free(connection);
+    subscription = calloc(1, sizeof(bbl_ctrl_subscription_s));
+    if(!subscription) {
+        return bbl_ctrl_status(fd, "error", 500, "out of memory");
+    }
+    subscription->request_id = connection->request_id ? json_incref(connection->request_id) : json_null();
+    subscription->counters = groups;
+    subscription->interval = interval;
+    clock_gettime(CLOCK_MONOTONIC, &subscription->next);
+    connection->subscription = subscription;
+    return bbl_ctrl_status(fd, "ok", 200, NULL);
+}
+
+int
+bbl_ctrl_unsubscribe(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
+{
+    bbl_ctrl_connection_s *connection = g_ctx->ctrl_thread->current;
+
+    if(!(connection && connection->subscription)) {
+        return bbl_ctrl_status(fd, "warning", 404, "subscription not found");
+    }
+    bbl_ctrl_subscription_free(connection);
+    return bbl_ctrl_status(fd, "ok", 200, NULL);
+}
+
 struct action actions[] = {
     {"test-info", bbl_ctrl_test_info, schema_no_args, true},
     {"test-stop", bbl_ctrl_test_stop, schema_no_args, true},
@@ -214,6 +448,7 @@ struct action actions[] = {
     {"stream-stats", bbl_stream_ctrl_stats, schema_all_args, true},
     {"stream-reset", bbl_stream_ctrl_reset, schema_all_args, false},
     {"stream-summary", bbl_stream_ctrl_summary, schema_all_args, true},
+    {"stream-export", bbl_stream_ctrl_export, schema_all_args, true},
     {"streams-pending", bbl_stream_ctrl_pending, schema_no_args, true},
     {"session-traffic", bbl_session_ctrl_traffic_stats, schema_all_args, true},
     {"session-traffic-reset", bbl_session_ctrl_traffic_reset, schema_all_args, false},
@@ -268,6 +503,7 @@ struct action actions[] = {
     {"bgp-teardown", bgp_ctrl_teardown, schema_all_args, true},
     {"bgp-raw-update-list", bgp_ctrl_raw_update_list, schema_all_args, true},
     {"bgp-raw-update", bgp_ctrl_raw_update, schema_all_args, false},
+    {"bgp-raw-update-unload", bgp_ctrl_raw_update_unload, schema_all_args, false},
     {"ldp-adjacencies", ldp_ctrl_adjacencies, schema_all_args, true},
     {"ldp-sessions", ldp_ctrl_sessions, schema_all_args, true},
     {"ldp-database", ldb_ctrl_database, schema_all_args, true},
@@ -275,12 +511,16 @@ struct action actions[] = {
     {"ldp-teardown", ldp_ctrl_teardown, schema_all_args, true},
     {"ldp-raw-update-list", ldp_ctrl_raw_update_list, schema_all_args, true},
     {"ldp-raw-update", ldp_ctrl_raw_update, schema_all_args, false},
+    {"ldp-raw-update-unload", ldp_ctrl_raw_update_unload, schema_all_args, false},
     {"monkey-start", bbl_ctrl_monkey_start, schema_all_args, false},
     {"monkey-stop", bbl_ctrl_monkey_stop, schema_all_args, false},
     {"lag-info", bbl_lag_ctrl_info, schema_all_args, true},
     {"icmp-clients", bbl_icmp_client_ctrl, schema_all_args, true},
     {"icmp-clients-start", bbl_icmp_client_ctrl_start, schema_all_args, false},
     {"icmp-clients-stop", bbl_icmp_client_ctrl_stop, schema_all_args, false},
+    {"rfc2544-info", bbl_rfc2544_ctrl_info, schema_no_args, false},
+    {"rfc2544-start", bbl_rfc2544_ctrl_start, schema_no_args, false},
+    {"rfc2544-stop", bbl_rfc2544_ctrl_stop, schema_no_args, false},
     {"http-clients", bbl_http_client_ctrl, schema_all_args, true},
     {"http-clients-start", bbl_http_client_ctrl_start, schema_all_args, false},
     {"http-clients-stop", bbl_http_client_ctrl_stop, schema_all_args, false},
@@ -299,6 +539,8 @@ struct action actions[] = {
     {"stream-traffic-start", bbl_stream_ctrl_start, schema_all_args, true},
     {"stream-traffic-disabled", bbl_stream_ctrl_stop, schema_all_args, true},
     {"stream-traffic-stop", bbl_stream_ctrl_stop, schema_all_args, true},
+    {"subscribe", bbl_ctrl_subscribe, schema_all_args, true},
+    {"unsubscribe", bbl_ctrl_unsubscribe, schema_no_args, true},
     /* END */
     {NULL, NULL, NULL, false},
 };
@@ -324,171 +566,641 @@ bbl_ctrl_socket_main_job(timer_s *timer)
     bbl_ctrl_socket_main(timer->data);
 }
 
-void *
-bbl_ctrl_socket_thread(void *thread_data)
+void
+bbl_ctrl_socket_main_event(timer_event_s *event)
 {
-    bbl_ctrl_thread_s *ctrl = thread_data;
+    uint64_t value;
+    if(read(event->fd, &value, sizeof(value)) < 0) {
+        return;
+    }
+    bbl_ctrl_socket_main(event->data);
+}
 
-    size_t i;
-    size_t flags = JSON_DISABLE_EOF_CHECK;
-    json_error_t error;
-    json_t *root = NULL;
+/**
+ * Execute a single control socket request.
+ *
+ * @param ctrl control socket thread
+ * @param fd client file descriptor
+ * @param root JSON request
+ */
+static void
+bbl_ctrl_request(bbl_ctrl_thread_s *ctrl, int fd, json_t *root)
+{
+    struct action *action;
     json_t* arguments = NULL;
     json_t* value = NULL;
     const char *command = NULL;
     uint32_t session_id = 0;
 
-    fd_set read_fds;
-
     bbl_access_interface_s *access_interface;
 
     vlan_session_key_t key = {0};
     bbl_session_s *session;
     void **search;
 
-    /* ToDo: Add connection manager!
-     * This is just a temporary workaround! Finally we need
-     * to create a connection manager. */
-    static int fd = 0;
+    uint64_t event = 1;
 
-    // Set timeout for 1s
-    struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
+    /* Each command request should be formatted as shown in the example below
+     * with a mandatory command element and optional arguments.
+     * {
+     *    "command": "session-info",
+     *    "arguments": {
+     *        "outer-vlan": 1,
+     *        "inner-vlan": 2
+     *    }
+     * }
+     */
+    if(json_unpack(root, "{s:s, s?o}", "command", &command, "arguments", &arguments) != 0) {
+        LOG_NOARG(ERROR, "Invalid command via ctrl socket\n");
+        bbl_ctrl_status(fd, "error", 400, "invalid request");
+        return;
+    }
+    if(arguments) {
+        value = json_object_get(arguments, "session-id");
+        if(value) {
+            if(json_is_number(value)) {
+                session_id = json_number_value(value);
+            } else {
+                bbl_ctrl_status(fd, "error", 400, "invalid session-id");
+                return;
+            }
+        } else {
+            /* Deprecated!
+             * For backward compatibility with version 0.4.X, we still
+             * support per session commands using VLAN index instead of
+             * new session-id. */
+            value = json_object_get(arguments, "ifindex");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.ifindex = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid ifindex");
+                    return;
+                }
+            } else {
+                value = json_object_get(arguments, "interface");
+                if(value && json_is_string(value)) {
+                    access_interface = bbl_access_interface_get((char*)json_string_value(value));
+                } else {
+                    /* Use first interface as default. */
+                    access_interface = bbl_access_interface_get(NULL);
+                }
+                if(access_interface) {
+                    key.ifindex = access_interface->ifindex;
+                }
+            }
+            value = json_object_get(arguments, "outer-vlan");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.outer_vlan_id = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid outer-vlan");
+                    return;
+                }
+            }
+            value = json_object_get(arguments, "inner-vlan");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.inner_vlan_id = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid inner-vlan");
+                    return;
+                }
+            }
+            if(key.outer_vlan_id) {
+                search = dict_search(g_ctx->vlan_session_dict, &key);
+                if(search && *search) {
+                    session = *search;
+                    session_id = session->session_id;
+                } else {
+                    bbl_ctrl_status(fd, "warning", 404, "session not found");
+                    return;
+                }
+            }
+        }
+    }
+
+    search = dict_search(ctrl->action_dict, command);
+    if(!(search && *search)) {
+        bbl_ctrl_status(fd, "error", 400, "unknown command");
+        return;
+    }
+    action = *search;
+    if(action->schema && !bbl_ctrl_schema(arguments, action->schema)) {
+        bbl_ctrl_status(fd, "error", 400, "invalid argument");
+        return;
+    }
+    if(action->thread_safe) {
+        action->fn(fd, session_id, arguments);
+    } else {
+        pthread_mutex_lock(&ctrl->mutex);
+        ctrl->main.fd = fd;
+        ctrl->main.action = action - actions;
+        ctrl->main.session_id = session_id;
+        ctrl->main.arguments = (void*)arguments;
+        if(ctrl->event_fd > 0) {
+            /* Wake up main thread event loop. */
+            if(write(ctrl->event_fd, &event, sizeof(event)) < 0) {
+                LOG(ERROR, "Failed to wake up main thread (error %d)\n", errno);
+            }
+        }
+        pthread_cond_wait(&ctrl->cond, &ctrl->mutex);
+        pthread_mutex_unlock(&ctrl->mutex);
+    }
+}
 
-    struct timespec sleep, rem;
-    sleep.tv_sec = 0;
-    sleep.tv_nsec = 10 * MSEC;
+static void
+bbl_ctrl_connection_close(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    bbl_ctrl_subscription_free(connection);
+    close(connection->fd);
+    free(connection->buf);
+    free(connection->out);
+    memset(connection, 0x0, sizeof(bbl_ctrl_connection_s));
+    connection->fd = -1;
+    ctrl->connections--;
+}
+
+/**
+ * Reserve len bytes at the end of the send buffer.
+ *
+ * @return pointer to reserved bytes or NULL
+ */
+static char *
+bbl_ctrl_connection_reserve(bbl_ctrl_connection_s *connection, size_t len)
+{
+    char *out;
+    size_t size;
+
+    if(connection->out_pos) {
+        connection->out_len -= connection->out_pos;
+        memmove(connection->out, connection->out + connection->out_pos, connection->out_len);
+        connection->out_pos = 0;
+    }
+    if(connection->out_len + len > BBL_CTRL_RESPONSE_MAX_LEN) {
+        LOG_NOARG(ERROR, "Response via ctrl socket exceeds max length\n");
+        return NULL;
+    }
+    if(connection->out_len + len > connection->out_size) {
+        size = connection->out_size ? connection->out_size : BBL_CTRL_BUFFER_LEN;
+        while(size < connection->out_len + len) {
+            size *= 2;
+        }
+        out = realloc(connection->out, size);
+        if(!out) {
+            return NULL;
+        }
+        connection->out = out;
+        connection->out_size = size;
+    }
+    return connection->out + connection->out_len;
+}
+
+/**
+ * Send buffered data without blocking the control
+ * thread. Remaining data is sent as soon as the socket
+ * becomes writable again. 
+ * 
+ * One-shot connections are shut down for writing after 
+ * the response is sent and closed after the client has 
+ * closed or the linger timeout has expired, to prevent 
+ * the client from losing the response if the connection
+ * is closed with unread data.
+ *
+ * @return false if connection was closed
+ */
+static bool
+bbl_ctrl_connection_flush(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    ssize_t len;
+
+    while(connection->out_pos < connection->out_len) {
+        len = send(connection->fd, connection->out + connection->out_pos, 
+                   connection->out_len - connection->out_pos, MSG_DONTWAIT|MSG_NOSIGNAL);
+        if(len < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            bbl_ctrl_connection_close(ctrl, connection);
+            return false;
+        }
+        connection->out_pos += len;
+        clock_gettime(CLOCK_MONOTONIC, &connection->out_progress);
+    }
+    connection->out_pos = 0;
+    connection->out_len = 0;
+    if(connection->done && !connection->linger.tv_sec) {
+        shutdown(connection->fd, SHUT_WR);
+        clock_gettime(CLOCK_MONOTONIC, &connection->linger);
+        connection->len = 0;
+    }
+    return true;
+}
+
+/**
+ * Move the response written by commands into the
+ * memory file to the send buffer of the connection. 
+ *
+ * @return false if connection was closed
+ */
+static bool
+bbl_ctrl_connection_output(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    off_t len = lseek(ctrl->memfd, 0, SEEK_CUR);
+    char *out;
+    bool result = true;
+
+    if(len > 0) {
+        out = bbl_ctrl_connection_reserve(connection, len);
+        if(out && pread(ctrl->memfd, out, len, 0) == len) {
+            if(connection->out_pos == connection->out_len) {
+                clock_gettime(CLOCK_MONOTONIC, &connection->out_progress);
+            }
+            connection->out_len += len;
+        } else {
+            result = false;
+        }
+    }
+    if(ftruncate(ctrl->memfd, 0) != 0 || lseek(ctrl->memfd, 0, SEEK_SET) != 0) {
+        result = false;
+    }
+    if(!result) {
+        bbl_ctrl_connection_close(ctrl, connection);
+        return false;
+    }
+    return bbl_ctrl_connection_flush(ctrl, connection);
+}
+
+static json_t *
+bbl_ctrl_counter_json(bbl_ctrl_counter_s *counter)
+{
+    if(counter->real) {
+        return json_real(counter->value.real);
+    }
+    return json_integer(counter->value.u64);
+}
+
+/**
+ * Send telemetry update for subscribed counters.
+ * 
+ * A snapshot of all subscribed counters is compared 
+ * with the snapshot of the last update. Only counters 
+ * changed since the last update are sent, where removed 
+ * counters are sent with value null. 
+ * {"request-id": 1, "update": {"session-counters.sessions-established": 10}}
+ * 
+ * Both snapshots are compared by index as long as the 
+ * counters are the same (e.g. no streams added), 
+ * otherwise all counters are sent again.
+ */
+static void
+bbl_ctrl_subscription_update(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    bbl_ctrl_subscription_s *subscription = connection->subscription;
+    bbl_ctrl_snapshot_s *current = &subscription->current;
+    bbl_ctrl_snapshot_s *last = &subscription->last;
+    bbl_ctrl_snapshot_s swap;
+    bbl_ctrl_counter_s *counter;
+    bbl_ctrl_counter_s *prev;
+    json_t *delta;
+    json_t *update;
+    json_t *keys;
+    char *line;
+    char *out;
+    size_t len;
+    bool aligned;
+    uint32_t i;
+
+    current->count = 0;
+    for(i = 0; subscription_counters[i].name; i++) {
+        if(subscription->counters & (1 << i)) {
+            subscription_counters[i].fn(current);
+        }
+    }
+
+    delta = json_object();
+    aligned = current->count == last->count;
+    for(i = 0; i < current->count; i++) {
+        counter = &current->counters[i];
+        if(aligned) {
+            prev = &last->counters[i];
+            if(strcmp(counter->key, prev->key) != 0) {
+                aligned = false;
+            } else if(counter->real == prev->real && 
+                      counter->value.u64 == prev->value.u64) {
+                continue;
+            }
+        }
+        json_object_set_new(delta, counter->key, bbl_ctrl_counter_json(counter));
+    }
+    if(!aligned && last->count) {
+        keys = json_object();
+        for(i = 0; i < current->count; i++) {
+            json_object_set_new(keys, current->counters[i].key, json_true());
+        }
+        for(i = 0; i < last->count; i++) {
+            if(!json_object_get(keys, last->counters[i].key)) {
+                json_object_set_new(delta, last->counters[i].key, json_null());
+            }
+        }
+        json_decref(keys);
+    }
+    swap = *last;
+    *last = *current;
+    *current = swap;
+
+    if(json_object_size(delta)) {
+        update = json_pack("{sOso}", "request-id", subscription->request_id, "update", delta);
+        if(update) {
+            line = json_dumps(update, JSON_COMPACT);
+            if(line) {
+                len = strlen(line);
+                out = bbl_ctrl_connection_reserve(connection, len + 1);
+                if(out) {
+                    memcpy(out, line, len);
+                    out[len] = '\n';
+                    connection->out_len += len + 1;
+                    clock_gettime(CLOCK_MONOTONIC, &connection->out_progress);
+                }
+                free(line);
+            }
+            json_decref(update);
+        }
+        bbl_ctrl_connection_flush(ctrl, connection);
+    } else {
+        json_decref(delta);
+    }
+}
+
+/**
+ * Send response for a persistent connection.
+ * 
+ * Responses on persistent connections are wrapped 
+ * into an object with the request-id of the request,
+ * terminated by a newline.
+ * {"request-id": 1, "response": {"status": "ok", "code": 200}}
+ */
+static void
+bbl_ctrl_request_persistent(bbl_ctrl_thread_s *ctrl, int fd, json_t *root, json_t *request_id)
+{
+    char *id = json_dumps(request_id ? request_id : json_null(), JSON_ENCODE_ANY);
+    if(!id) {
+        return;
+    }
+    dprintf(fd, "{\"request-id\": %s, \"response\": ", id);
+    bbl_ctrl_request(ctrl, fd, root);
+    dprintf(fd, "}\n");
+    free(id);
+}
+
+/**
+ * Process all complete requests received on a connection.
+ * 
+ * A connection is one-shot (answered and closed) unless
+ * the request contains a request-id, which turns the connection
+ * into a persistent connection accepting pipelined requests. 
+ */
+static void
+bbl_ctrl_connection_process(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    json_error_t error;
+    json_t *root;
+    json_t *request_id;
+    size_t skip;
+
+    while(connection->len) {
+        /* Skip whitespace and newlines between requests. */
+        skip = 0;
+        while(skip < connection->len && isspace((unsigned char)connection->buf[skip])) {
+            skip++;
+        }
+        if(skip) {
+            connection->len -= skip;
+            memmove(connection->buf, connection->buf + skip, connection->len);
+            continue;
+        }
+
+        root = json_loadb(connection->buf, connection->len, JSON_DISABLE_EOF_CHECK, &error);
+        if(!root) {
+            if(json_error_code(&error) == json_error_premature_end_of_input) {
+                /* Wait for the remaining request. */
+                return;
+            }
+            LOG(ERROR, "Invalid json via ctrl socket: line %d: %s\n", error.line, error.text);
+            if(connection->persistent) {
+                dprintf(ctrl->memfd, "{\"request-id\": null, \"response\": ");
+                bbl_ctrl_status(ctrl->memfd, "error", 400, "invalid json");
+                dprintf(ctrl->memfd, "}\n");
+                connection->len = 0;
+            } else {
+                bbl_ctrl_status(ctrl->memfd, "error", 400, "invalid json");
+                connection->done = true;
+            }
+            bbl_ctrl_connection_output(ctrl, connection);
+            return;
+        }
+
+        /* Remove request from buffer. */
+        if((size_t)error.position < connection->len) {
+            connection->len -= error.position;
+            memmove(connection->buf, connection->buf + error.position, connection->len);
+        } else {
+            connection->len = 0;
+        }
+
+        request_id = json_object_get(root, "request-id");
+        if(request_id) {
+            connection->persistent = true;
+        }
+        ctrl->current = connection;
+        if(connection->persistent) {
+            connection->request_id = request_id;
+            bbl_ctrl_request_persistent(ctrl, ctrl->memfd, root, request_id);
+            connection->request_id = NULL;
+            json_decref(root);
+        } else {
+            bbl_ctrl_request(ctrl, ctrl->memfd, root);
+            json_decref(root);
+            connection->done = true;
+        }
+        ctrl->current = NULL;
+        if(!bbl_ctrl_connection_output(ctrl, connection) || connection->done) {
+            return;
+        }
+    }
+}
+
+static void
+bbl_ctrl_connection_recv(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    char *buf;
+    ssize_t len;
+
+    if(connection->len == connection->size) {
+        if(connection->size >= BBL_CTRL_REQUEST_MAX_LEN) {
+            LOG_NOARG(ERROR, "Request via ctrl socket exceeds max length\n");
+            bbl_ctrl_connection_close(ctrl, connection);
+            return;
+        }
+        buf = realloc(connection->buf, connection->size ? connection->size * 2 : BBL_CTRL_BUFFER_LEN);
+        if(!buf) {
+            bbl_ctrl_connection_close(ctrl, connection);
+            return;
+        }
+        connection->buf = buf;
+        connection->size = connection->size ? connection->size * 2 : BBL_CTRL_BUFFER_LEN;
+    }
+
+    len = recv(connection->fd, connection->buf + connection->len, 
+               connection->size - connection->len, MSG_DONTWAIT);
+    if(len < 0) {
+        if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return;
+        }
+        bbl_ctrl_connection_close(ctrl, connection);
+        return;
+    }
+    if(len == 0) {
+        /* Connection closed by client. */
+        bbl_ctrl_connection_close(ctrl, connection);
+        return;
+    }
+    if(connection->done) {
+        /* Ignore everything received after 
+         * response on one-shot connections. */
+        return;
+    }
+    connection->len += len;
+    bbl_ctrl_connection_process(ctrl, connection);
+}
+
+static void
+bbl_ctrl_connection_accept(bbl_ctrl_thread_s *ctrl)
+{
+    bbl_ctrl_connection_s *connection;
+    int fd;
+    int i;
+
+    while(ctrl->connections < BBL_CTRL_CONNECTIONS_MAX) {
+        fd = accept4(ctrl->socket, NULL, NULL, SOCK_NONBLOCK|SOCK_CLOEXEC);
+        if(fd < 0) {
+            return;
+        }
+        for(i = 0; i < BBL_CTRL_CONNECTIONS_MAX; i++) {
+            connection = &ctrl->connection[i];
+            if(connection->fd < 0) {
+                connection->fd = fd;
+                ctrl->connections++;
+                break;
+            }
+        }
+    }
+}
+
+void *
+bbl_ctrl_socket_thread(void *thread_data)
+{
+    bbl_ctrl_thread_s *ctrl = thread_data;
+    bbl_ctrl_connection_s *connection;
+    bbl_ctrl_subscription_s *subscription;
+
+    struct pollfd pollset[BBL_CTRL_CONNECTIONS_MAX+1];
+    bbl_ctrl_connection_s *pollcon[BBL_CTRL_CONNECTIONS_MAX+1];
+    struct timespec now;
+    struct timespec interval;
+    nfds_t nfds;
+    nfds_t n;
+    int i;
+
+    for(i = 0; i < BBL_CTRL_CONNECTIONS_MAX; i++) {
+        ctrl->connection[i].fd = -1;
+    }
 
     ctrl->active = true;
     while(ctrl->active) {
-        fd = accept(ctrl->socket, 0, 0);
-        if(fd > 0) {
-            /* New connection. */
-            FD_ZERO(&read_fds);
-            FD_SET(fd, &read_fds);
-            root = json_loadfd(fd, flags, &error);
-            if(!root) {
-                LOG(ERROR, "Invalid json via ctrl socket: line %d: %s\n", error.line, error.text);
-                bbl_ctrl_status(fd, "error", 400, "invalid json");
-            } else {
-                    /* Each command request should be formatted as shown in the example below
-                    * with a mandatory command element and optional arguments.
-                    * {
-                    *    "command": "session-info",
-                    *    "arguments": {
-                    *        "outer-vlan": 1,
-                    *        "inner-vlan": 2
-                    *    }
-                    * }
-                    */
-                command = NULL;
-                arguments = NULL;
-                session_id = 0;
-                key.ifindex = 0;
-                key.inner_vlan_id = 0;
-                key.outer_vlan_id = 0;
-                if(json_unpack(root, "{s:s, s?o}", "command", &command, "arguments", &arguments) != 0) {
-                    LOG_NOARG(ERROR, "Invalid command via ctrl socket\n");
-                    bbl_ctrl_status(fd, "error", 400, "invalid request");
-                } else {
-                    if(arguments) {
-                        value = json_object_get(arguments, "session-id");
-                        if(value) {
-                            if(json_is_number(value)) {
-                                session_id = json_number_value(value);
-                            } else {
-                                bbl_ctrl_status(fd, "error", 400, "invalid session-id");
-                                goto CLOSE;
-                            }
-                        } else {
-                            /* Deprecated!
-                             * For backward compatibility with version 0.4.X, we still
-                             * support per session commands using VLAN index instead of
-                             * new session-id. */
-                            value = json_object_get(arguments, "ifindex");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.ifindex = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid ifindex");
-                                    goto CLOSE;
-                                }
-                            } else {
-                                value = json_object_get(arguments, "interface");
-                                if(value && json_is_string(value)) {
-                                    access_interface = bbl_access_interface_get((char*)json_string_value(value));
-                                } else {
-                                    /* Use first interface as default. */
-                                    access_interface = bbl_access_interface_get(NULL);
-                                }
-                                if(access_interface) {
-                                    key.ifindex = access_interface->ifindex;
-                                }
-                            }
-                            value = json_object_get(arguments, "outer-vlan");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.outer_vlan_id = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid outer-vlan");
-                                    goto CLOSE;
-                                }
-                            }
-                            value = json_object_get(arguments, "inner-vlan");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.inner_vlan_id = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid inner-vlan");
-                                    goto CLOSE;
-                                }
-                            }
-                            if(key.outer_vlan_id) {
-                                search = dict_search(g_ctx->vlan_session_dict, &key);
-                                if(search && *search) {
-                                    session = *search;
-                                    session_id = session->session_id;
-                                } else {
-                                    bbl_ctrl_status(fd, "warning", 404, "session not found");
-                                    goto CLOSE;
-                                }
-                            }
-                        }
-                    }
-                    for(i = 0; true; i++) {
-                        if(actions[i].name == NULL) {
-                            bbl_ctrl_status(fd, "error", 400, "unknown command");
-                            break;
-                        } else if(strcmp(actions[i].name, command) == 0) {
-                            if(actions[i].schema && !bbl_ctrl_schema(arguments, actions[i].schema)) {
-                                bbl_ctrl_status(fd, "error", 400, "invalid argument");
-                                break;
-                            }
-                            if(actions[i].thread_safe) {
-                                actions[i].fn(fd, session_id, arguments);
-                            } else {
-                                pthread_mutex_lock(&ctrl->mutex);
-                                ctrl->main.fd = fd;
-                                ctrl->main.action = i;
-                                ctrl->main.session_id = session_id;
-                                ctrl->main.arguments = (void*)arguments;
-                                pthread_cond_wait(&ctrl->cond, &ctrl->mutex);
-                                pthread_mutex_unlock(&ctrl->mutex);
-                            }
-                            break;
-                        }
-                    }
+        /* Stop accepting new connections 
+         * if max connections are reached. */
+        pollset[0].fd = ctrl->socket;
+        pollset[0].events = ctrl->connections < BBL_CTRL_CONNECTIONS_MAX ? POLLIN : 0;
+        pollset[0].revents = 0;
+        nfds = 1;
+        for(i = 0; i < BBL_CTRL_CONNECTIONS_MAX; i++) {
+            connection = &ctrl->connection[i];
+            if(connection->fd < 0) {
+                continue;
+            }
+            pollset[nfds].fd = connection->fd;
+            pollset[nfds].events = POLLIN;
+            if(connection->out_len) {
+                pollset[nfds].events |= POLLOUT;
+            }
+            pollset[nfds].revents = 0;
+            pollcon[nfds++] = connection;
+        }
+
+        /* Wait for new connections or requests, but wake up 
+         * regularly to check if thread is still active. */
+        if(poll(pollset, nfds, 100) < 0) {
+            continue;
+        }
+        for(n = 1; n < nfds; n++) {
+            if(pollset[n].revents & POLLOUT) {
+                if(!bbl_ctrl_connection_flush(ctrl, pollcon[n])) {
+                    continue;
+                }
+            }
+            if(pollset[n].revents & ~POLLOUT) {
+                bbl_ctrl_connection_recv(ctrl, pollcon[n]);
+            }
+        }
+        if(pollset[0].revents & POLLIN) {
+            bbl_ctrl_connection_accept(ctrl);
+        }
+
+        /* Close one-shot connections after linger timeout,
+         * close connections not reading their responses
+         * and send updates for subscriptions. */
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for(i = 0; i < BBL_CTRL_CONNECTIONS_MAX; i++) {
+            connection = &ctrl->connection[i];
+            if(connection->fd < 0) {
+                continue;
+            }
+            if(connection->linger.tv_sec &&
+               now.tv_sec - connection->linger.tv_sec >= BBL_CTRL_LINGER) {
+                bbl_ctrl_connection_close(ctrl, connection);
+                continue;
+            }
+            if(connection->out_len &&
+               now.tv_sec - connection->out_progress.tv_sec >= BBL_CTRL_SEND_TIMEOUT) {
+                LOG_NOARG(ERROR, "Ctrl socket client stalled, close connection\n");
+                bbl_ctrl_connection_close(ctrl, connection);
+                continue;
+            }
+            subscription = connection->subscription;
+            if(subscription &&
+               (now.tv_sec > subscription->next.tv_sec || 
+                (now.tv_sec == subscription->next.tv_sec && 
+                 now.tv_nsec >= subscription->next.tv_nsec))) {
+                interval.tv_sec = subscription->interval / 1000;
+                interval.tv_nsec = (subscription->interval % 1000) * MSEC;
+                timespec_add(&subscription->next, &now, &interval);
+                /* Skip updates while the last one is not sent,
+                 * the next update includes all changes. */
+                if(!connection->out_len) {
+                    bbl_ctrl_subscription_update(ctrl, connection);
                 }
-CLOSE:
-                json_decref(root);
-                root = NULL;
             }
-            shutdown(fd, SHUT_WR);
-            select(fd + 1, &read_fds, NULL, NULL, &timeout);
-            close(fd);
-        } else {
-            nanosleep(&sleep, &rem);
+        }
+    }
+
+    for(i = 0; i < BBL_CTRL_CONNECTIONS_MAX; i++) {
+        connection = &ctrl->connection[i];
+        if(connection->fd >= 0) {
+            bbl_ctrl_connection_close(ctrl, connection);
         }
     }
     return NULL;
@@ -499,6 +1211,8 @@ bbl_ctrl_socket_init()
 {
     bbl_ctrl_thread_s *ctrl;
     struct sockaddr_un addr = {0};
+    dict_insert_result result;
+    size_t i;
 
     if(!g_ctx->ctrl_socket_path) {
         return true;
@@ -511,6 +1225,19 @@ bbl_ctrl_socket_init()
     }
     g_ctx->ctrl_thread = ctrl;
 
+    /* Build action lookup table. */
+    ctrl->action_dict = hashtable_dict_new((dict_compare_func)strcmp, dict_str_hash, BBL_CTRL_ACTION_HASHTABLE_SIZE);
+    if(!ctrl->action_dict) {
+        fprintf(stderr, "Error: Failed to init ctrl action table\n");
+        return false;
+    }
+    for(i = 0; actions[i].name; i++) {
+        result = dict_insert(ctrl->action_dict, actions[i].name);
+        if(result.inserted) {
+            *result.datum_ptr = &actions[i];
+        }
+    }
+
     ctrl->socket = socket(AF_UNIX, SOCK_STREAM, 0);
     if(ctrl->socket < 0) {
         fprintf(stderr, "Error: Failed to create ctrl socket\n");
@@ -531,6 +1258,15 @@ bbl_ctrl_socket_init()
     /* Change socket to non-blocking */
     fcntl(ctrl->socket, F_SETFL, O_NONBLOCK);
 
+    /* Responses are written by the commands into a memory file
+     * and moved to the send buffer of the connection, which 
+     * prevents a slow client from blocking the ctrl thread. */
+    ctrl->memfd = memfd_create("bbl-ctrl", MFD_CLOEXEC);
+    if(ctrl->memfd < 0) {
+        fprintf(stderr, "Error: Failed to create ctrl response buffer (error %d)\n", errno);
+        return false;
+    }
+
     /* Create ctrl thread */
     if(pthread_mutex_init(&ctrl->mutex, NULL) != 0) {
         LOG_NOARG(ERROR, "Failed to init ctrl mutex\n");
@@ -547,6 +1283,14 @@ bbl_ctrl_socket_init()
 
     /* Start ctrl main job */
     timer_add_periodic(&g_ctx->timer_root, &ctrl->main.timer, "CTRL Socket Main Timer", 0, 1000 * MSEC, ctrl, &bbl_ctrl_socket_main_job);
+    if(g_ctx->timer_root.event) {
+        ctrl->event_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+        if(ctrl->event_fd < 0 || 
+           !timer_event_add(&g_ctx->timer_root, ctrl->event_fd, ctrl, &bbl_ctrl_socket_main_event)) {
+            LOG_NOARG(ERROR, "Failed to init ctrl event\n");
+            return false;
+        }
+    }
 
     LOG(INFO, "Opened control socket %s\n", g_ctx->ctrl_socket_path);
 
@@ -571,7 +1315,16 @@ bbl_ctrl_socket_close()
         if(ctrl->socket) {
             close(ctrl->socket);
         }
+        if(ctrl->event_fd > 0) {
+            close(ctrl->event_fd);
+        }
+        if(ctrl->memfd > 0) {
+            close(ctrl->memfd);
+        }
         unlink(g_ctx->ctrl_socket_path);
+        if(ctrl->action_dict) {
+            dict_free(ctrl->action_dict, NULL);
+        }
         free(g_ctx->ctrl_thread);
         g_ctx->ctrl_thread = NULL;
     }
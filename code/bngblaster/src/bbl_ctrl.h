@@ -10,8 +10,76 @@
 #ifndef __BBL_CTRL_H__
 #define __BBL_CTRL_H__
 
+#define BBL_CTRL_CONNECTIONS_MAX    32
+#define BBL_CTRL_BUFFER_LEN         4096
+#define BBL_CTRL_REQUEST_MAX_LEN    16777216
+#define BBL_CTRL_RESPONSE_MAX_LEN   268435456
+#define BBL_CTRL_LINGER             1 /* seconds */
+#define BBL_CTRL_SEND_TIMEOUT       30 /* seconds */
+#define BBL_CTRL_ACTION_HASHTABLE_SIZE 256
+#define BBL_CTRL_SUBSCRIPTION_INTERVAL_MIN 100 /* msec */
+#define BBL_CTRL_COUNTER_KEY_LEN    128
+
+/** Single counter of a telemetry snapshot */
+typedef struct bbl_ctrl_counter_ {
+    char key[BBL_CTRL_COUNTER_KEY_LEN];
+    bool real;
+    union {
+        uint64_t u64;
+        double real;
+    } value;
+} bbl_ctrl_counter_s;
+
+/** Telemetry snapshot of all subscribed counters */
+typedef struct bbl_ctrl_snapshot_ {
+    bbl_ctrl_counter_s *counters;
+    uint32_t count;
+    uint32_t size;
+} bbl_ctrl_snapshot_s;
+
+/** Telemetry subscription of a persistent connection */
+typedef struct bbl_ctrl_subscription_ {
+    json_t *request_id; /* request-id of subscribe request */
+    uint32_t counters; /* subscribed counter groups (bitmask) */
+    bbl_ctrl_snapshot_s last; /* snapshot of last update */
+    bbl_ctrl_snapshot_s current;
+    uint32_t interval; /* update interval in msec */
+    struct timespec next; /* next update */
+} bbl_ctrl_subscription_s;
+
+/** Control socket client connection */
+typedef struct bbl_ctrl_connection_ {
+    int fd;
+    bool persistent; /* keep open after response */
+    bool done; /* one-shot response queued */
+    struct timespec linger; /* one-shot response sent */
+
+    json_t *request_id; /* request-id of current request */
+    bbl_ctrl_subscription_s *subscription;
+
+    /* Receive buffer */
+    char *buf;
+    size_t len;
+    size_t size;
+
+    /* Send buffer, flushed if socket becomes writable */
+    char *out;
+    size_t out_pos;
+    size_t out_len;
+    size_t out_size;
+    struct timespec out_progress; /* last data sent */
+} bbl_ctrl_connection_s;
+
 typedef struct bbl_ctrl_thread_ {
     int socket;
+    int event_fd; /* wakes up main thread event loop */
+    int memfd; /* buffer for responses and subscription updates */
+
+    dict *action_dict;
+
+    bbl_ctrl_connection_s connection[BBL_CTRL_CONNECTIONS_MAX];
+    bbl_ctrl_connection_s *current; /* connection of current request */
+    uint16_t connections;
 
     pthread_t thread;
     pthread_mutex_t mutex;
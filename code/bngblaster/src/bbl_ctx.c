@@ -121,6 +121,8 @@ bbl_ctx_del() {
 
     if(g_ctx->session_list) free(g_ctx->session_list);
     if(g_ctx->stream_index) free(g_ctx->stream_index);
+    bbl_arena_free(&g_ctx->stream_arena);
+    bbl_arena_free(&g_ctx->packet_arena);
 
     /* Free hash table dictionaries. */
     dict_free(g_ctx->vlan_session_dict, NULL);
@@ -17,6 +17,7 @@ typedef struct bbl_ctx_
     struct timer_root_ timer_root; /* Root for our timers */
     struct timer_ *control_timer;
     struct timer_ *smear_timer;
+    struct timer_ *stream_rebalance_timer;
     struct timer_ *stats_timer;
     struct timer_ *keyboard_timer;
 
@@ -75,6 +76,9 @@ typedef struct bbl_ctx_
 
     bbl_stream_group_s *stream_groups;
 
+    bbl_arena_s stream_arena; /* streams and per-stream RX state */
+    bbl_arena_s packet_arena; /* stream packet templates */
+
     uint16_t next_tunnel_id;
 
     uint64_t flow_id;
@@ -89,6 +93,7 @@ typedef struct bbl_ctx_
 
     bbl_arp_client_s *arp_clients;
     bbl_icmp_client_s *icmp_clients;
+    bbl_rfc2544_s *rfc2544;
     bgp_session_s *bgp_sessions;
     bgp_raw_update_s *bgp_raw_updates;
     isis_instance_s *isis_instances;
@@ -130,6 +135,7 @@ typedef struct bbl_ctx_
         uint32_t multicast_traffic_flows;
         uint32_t multicast_traffic_flows_verified;
         uint32_t raw_traffic_flows;
+        bbl_histogram_s *stream_delay; /* Stream RX delay histogram (usec) */
     } stats;
 
     endpoint_state_t multicast_endpoint;
@@ -149,6 +155,12 @@ typedef struct bbl_ctx_
         uint16_t io_max_stream_len;
 
         bool qdisc_bypass;
+        uint32_t xdp_flags; /* AF_XDP attach mode */
+        bool tx_mbuf_template; /* DPDK TX stream template mbufs */
+
+        bool rx_tpacket_v3;
+        uint32_t rx_block_size; /* TPACKET_V3 block size in bytes */
+        uint16_t rx_block_timeout; /* TPACKET_V3 block retire timeout in msec */
 
         uint64_t tx_interval; /* TX interval in nsec */
         uint64_t rx_interval; /* RX interval in nsec */
@@ -156,7 +168,14 @@ typedef struct bbl_ctx_
         uint8_t tx_threads;
         uint8_t rx_threads;
 
+        bool event_loop; /* timerfd/epoll based main loop */
+        uint16_t rx_busy_poll; /* empty RX polls before RX threads block */
+        io_timestamping_t io_timestamping; /* kernel/NIC RX timestamps */
+        io_txtime_t io_txtime; /* SO_TXTIME launch times for stream pacing */
+
         char *json_report_filename;
+        char *stream_export_filename; /* binary stream export */
+        char *stream_export_directory; /* binary stream export via ctrl socket */
         bool json_report_sessions; /* Include sessions */
         bool json_report_streams; /* Include streams */
 
@@ -206,12 +225,16 @@ typedef struct bbl_ctx_
         /* ICMP Client Instances */
         bbl_icmp_client_config_s *icmp_client_config;
 
+        /* RFC 2544 Benchmark */
+        bbl_rfc2544_config_s *rfc2544;
+
         /* HTTP Client/Server Instances */
         bbl_http_client_config_s *http_client_config;
         bbl_http_server_config_s *http_server_config;
 
         /* Global Session Settings */
         uint32_t sessions;
+        uint32_t sessions_id_offset; /* offset for global session identifiers */
         uint32_t sessions_max_outstanding;
         uint16_t sessions_start_rate;
         uint16_t sessions_stop_rate;
@@ -347,8 +370,13 @@ typedef struct bbl_ctx_
         bool stream_autostart;
         bool stream_rate_calc; /* Enable/disable stream rate calculation */
         bool stream_delay_calc; /* Enable/disable stream delay calculation */
+        bool stream_delay_histogram; /* Enable/disable per stream latency histograms */
+        bool stream_loss_calc; /* Enable/disable stream loss burst and history tracking */
         bool stream_udp_checksum; /* Enable/disable stream UDP checksum calculation */
         uint64_t stream_burst_ms; /* Max bust size per stream in milliseconds */
+        bool stream_pacing; /* Per packet pacing in TX threads */
+        uint16_t stream_rebalance_interval; /* Stream rebalancing interval in seconds */
+        uint64_t stream_rebalance_lag; /* TX lag in nsec to trigger stream rebalancing */
 
         /* Session Traffic */
         bool session_traffic_autostart;
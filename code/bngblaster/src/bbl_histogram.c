@@ -0,0 +1,218 @@
+/*
+ * BNG Blaster (BBL) - Histogram
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "bbl_histogram.h"
+
+static const struct {
+    const char *name;
+    double percentile;
+} g_percentiles[] = {
+    { "p50", 50.0 },
+    { "p90", 90.0 },
+    { "p99", 99.0 },
+    { "p999", 99.9 },
+};
+
+/**
+ * bbl_histogram_lowest
+ *
+ * @param index bucket index
+ * @return lowest value recorded in bucket
+ */
+uint64_t
+bbl_histogram_lowest(uint16_t index)
+{
+    uint8_t shift;
+    if(index < (BBL_HISTOGRAM_SUB_HALF << 1)) {
+        return index;
+    }
+    shift = (index / BBL_HISTOGRAM_SUB_HALF) - 1;
+    return (uint64_t)(index - (shift * BBL_HISTOGRAM_SUB_HALF)) << shift;
+}
+
+/**
+ * bbl_histogram_highest
+ *
+ * @param index bucket index
+ * @return highest value recorded in bucket
+ */
+uint64_t
+bbl_histogram_highest(uint16_t index)
+{
+    uint8_t shift;
+    if(index < (BBL_HISTOGRAM_SUB_HALF << 1)) {
+        return index;
+    }
+    shift = (index / BBL_HISTOGRAM_SUB_HALF) - 1;
+    return bbl_histogram_lowest(index) + (1ULL << shift) - 1;
+}
+
+/**
+ * bbl_histogram_init
+ *
+ * @return new empty histogram or NULL
+ */
+bbl_histogram_s *
+bbl_histogram_init()
+{
+    return calloc(1, sizeof(bbl_histogram_s));
+}
+
+/**
+ * bbl_histogram_record
+ *
+ * @param histogram histogram
+ * @param value value
+ * @param count number of times value is recorded
+ */
+void
+bbl_histogram_record(bbl_histogram_s *histogram, uint64_t value, uint64_t count)
+{
+    histogram->buckets[bbl_histogram_index(value)] += count;
+    histogram->count += count;
+}
+
+/**
+ * bbl_histogram_merge
+ *
+ * @param histogram target histogram
+ * @param source source histogram
+ */
+void
+bbl_histogram_merge(bbl_histogram_s *histogram, bbl_histogram_s *source)
+{
+    for(uint16_t i = 0; i < BBL_HISTOGRAM_BUCKETS; i++) {
+        histogram->buckets[i] += source->buckets[i];
+    }
+    histogram->count += source->count;
+}
+
+/**
+ * bbl_histogram_flow_sync
+ *
+ * Add all values recorded in the flow histogram since
+ * last sync to the given histograms. Only the bucket range
+ * first to last is checked, which allows to skip the buckets
+ * outside of the min/max values recorded for this flow.
+ *
+ * @param flow flow histogram
+ * @param first first bucket index
+ * @param last last bucket index
+ * @param histogram1 optional target histogram
+ * @param histogram2 optional target histogram
+ */
+void
+bbl_histogram_flow_sync(bbl_histogram_flow_s *flow, uint16_t first, uint16_t last,
+                        bbl_histogram_s *histogram1, bbl_histogram_s *histogram2)
+{
+    uint32_t value;
+    uint32_t delta;
+
+    if(last >= BBL_HISTOGRAM_BUCKETS || last < first) {
+        first = 0;
+        last = BBL_HISTOGRAM_BUCKETS - 1;
+    }
+    for(uint16_t i = first; i <= last; i++) {
+        value = flow->buckets[i];
+        delta = value - flow->sync[i];
+        if(delta) {
+            flow->sync[i] = value;
+            if(histogram1) {
+                histogram1->buckets[i] += delta;
+                histogram1->count += delta;
+            }
+            if(histogram2) {
+                histogram2->buckets[i] += delta;
+                histogram2->count += delta;
+            }
+        }
+    }
+}
+
+/**
+ * bbl_histogram_flow_copy
+ *
+ * @param flow flow histogram
+ * @param histogram target histogram (overwritten)
+ */
+void
+bbl_histogram_flow_copy(bbl_histogram_flow_s *flow, bbl_histogram_s *histogram)
+{
+    histogram->count = 0;
+    for(uint16_t i = 0; i < BBL_HISTOGRAM_BUCKETS; i++) {
+        histogram->buckets[i] = flow->buckets[i];
+        histogram->count += flow->buckets[i];
+    }
+}
+
+/**
+ * bbl_histogram_flow_reset
+ *
+ * @param flow flow histogram
+ */
+void
+bbl_histogram_flow_reset(bbl_histogram_flow_s *flow)
+{
+    memset(flow, 0x0, sizeof(bbl_histogram_flow_s));
+}
+
+/**
+ * bbl_histogram_percentile
+ *
+ * @param histogram histogram
+ * @param percentile percentile (0-100)
+ * @return highest value equivalent to the given
+ *         percentile or zero if histogram is empty
+ */
+uint64_t
+bbl_histogram_percentile(bbl_histogram_s *histogram, double percentile)
+{
+    uint64_t rank;
+    uint64_t sum = 0;
+
+    if(!(histogram && histogram->count)) {
+        return 0;
+    }
+    if(percentile > 100.0) percentile = 100.0;
+    rank = ceil((percentile / 100.0) * histogram->count);
+    if(rank < 1) rank = 1;
+
+    for(uint16_t i = 0; i < BBL_HISTOGRAM_BUCKETS; i++) {
+        sum += histogram->buckets[i];
+        if(sum >= rank) {
+            return bbl_histogram_highest(i);
+        }
+    }
+    return BBL_HISTOGRAM_VALUE_MAX;
+}
+
+/**
+ * bbl_histogram_json
+ *
+ * Add percentiles to JSON object using the
+ * following key format: <prefix>-p50.
+ *
+ * @param histogram histogram
+ * @param root JSON object
+ * @param prefix key prefix
+ */
+void
+bbl_histogram_json(bbl_histogram_s *histogram, json_t *root, const char *prefix)
+{
+    char key[64];
+
+    if(!(histogram && root)) {
+        return;
+    }
+    for(size_t i = 0; i < sizeof(g_percentiles)/sizeof(g_percentiles[0]); i++) {
+        snprintf(key, sizeof(key), "%s-%s", prefix, g_percentiles[i].name);
+        json_object_set_new(root, key, json_integer(bbl_histogram_percentile(histogram, g_percentiles[i].percentile)));
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * BNG Blaster (BBL) - Histogram
+ *
+ * HDR style log-linear histogram used to record
+ * latency values (usec) with constant relative error,
+ * kept free of other dependencies to allow unit testing.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_HISTOGRAM_H__
+#define __BBL_HISTOGRAM_H__
+
+#include <stdint.h>
+#include <jansson.h>
+
+/* Each power of two range is split into 16 linear
+ * buckets, which results in a max relative error
+ * of 1/16 (6.25%). Values up to 31 are exact. */
+#define BBL_HISTOGRAM_SUB_BITS      5
+#define BBL_HISTOGRAM_SUB_HALF      (1 << (BBL_HISTOGRAM_SUB_BITS - 1))
+/* Values of 2^24 usec (~16.7s) and above are
+ * recorded in the last bucket. */
+#define BBL_HISTOGRAM_VALUE_BITS    24
+#define BBL_HISTOGRAM_VALUE_MAX     ((1ULL << BBL_HISTOGRAM_VALUE_BITS) - 1)
+#define BBL_HISTOGRAM_BUCKETS       ((BBL_HISTOGRAM_VALUE_BITS - BBL_HISTOGRAM_SUB_BITS + 2) * BBL_HISTOGRAM_SUB_HALF)
+
+typedef struct bbl_histogram_
+{
+    uint64_t count;
+    uint64_t buckets[BBL_HISTOGRAM_BUCKETS];
+} bbl_histogram_s;
+
+/**
+ * The flow histogram is split into two parts,
+ * where buckets is written by the RX thread only
+ * and sync by the main thread only. The difference
+ * between both is the number of values recorded
+ * since last sync (see bbl_histogram_flow_sync).
+ */
+typedef struct bbl_histogram_flow_
+{
+    uint32_t buckets[BBL_HISTOGRAM_BUCKETS];
+    uint32_t sync[BBL_HISTOGRAM_BUCKETS];
+} bbl_histogram_flow_s;
+
+/**
+ * bbl_histogram_index
+ *
+ * @param value value
+ * @return bucket index
+ */
+static inline uint16_t
+bbl_histogram_index(uint64_t value)
+{
+    uint8_t shift;
+    if(value < BBL_HISTOGRAM_SUB_HALF) {
+        return value;
+    }
+    if(value > BBL_HISTOGRAM_VALUE_MAX) {
+        return BBL_HISTOGRAM_BUCKETS - 1;
+    }
+    shift = (63 - __builtin_clzll(value)) - (BBL_HISTOGRAM_SUB_BITS - 1);
+    return (shift * BBL_HISTOGRAM_SUB_HALF) + (value >> shift);
+}
+
+/**
+ * bbl_histogram_flow_record
+ *
+ * Record value in flow histogram. This function
+ * is called from the RX thread for every packet
+ * and must therefore not allocate memory.
+ *
+ * @param flow flow histogram
+ * @param value value
+ */
+static inline void
+bbl_histogram_flow_record(bbl_histogram_flow_s *flow, uint64_t value)
+{
+    flow->buckets[bbl_histogram_index(value)]++;
+}
+
+uint64_t
+bbl_histogram_lowest(uint16_t index);
+
+uint64_t
+bbl_histogram_highest(uint16_t index);
+
+bbl_histogram_s *
+bbl_histogram_init();
+
+void
+bbl_histogram_record(bbl_histogram_s *histogram, uint64_t value, uint64_t count);
+
+void
+bbl_histogram_merge(bbl_histogram_s *histogram, bbl_histogram_s *source);
+
+void
+bbl_histogram_flow_sync(bbl_histogram_flow_s *flow, uint16_t first, uint16_t last,
+                        bbl_histogram_s *histogram1, bbl_histogram_s *histogram2);
+
+void
+bbl_histogram_flow_copy(bbl_histogram_flow_s *flow, bbl_histogram_s *histogram);
+
+void
+bbl_histogram_flow_reset(bbl_histogram_flow_s *flow);
+
+uint64_t
+bbl_histogram_percentile(bbl_histogram_s *histogram, double percentile);
+
+void
+bbl_histogram_json(bbl_histogram_s *histogram, json_t *root, const char *prefix);
+
+#endif
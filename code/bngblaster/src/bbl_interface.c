@@ -281,12 +281,13 @@ bbl_interface_ctrl(int fd, uint32_t session_id __attribute__((unused)), json_t *
     bbl_interface_s *interface;
 
     io_handle_s *io;
-    json_t *root, *jobj, *jobj_array;
+    json_t *root, *jobj, *jobj_array, *jobj_threads;
 
     jobj_array = json_array();
 
     uint64_t tx_packets;
     uint64_t tx_bytes;
+    uint64_t tx_migrations;
     uint64_t rx_packets;
     uint64_t rx_bytes;
 
@@ -295,9 +296,24 @@ bbl_interface_ctrl(int fd, uint32_t session_id __attribute__((unused)), json_t *
         io = interface->io.tx;
         tx_packets = 0;
         tx_bytes = 0;
+        tx_migrations = 0;
+        jobj_threads = NULL;
         while(io) {
             tx_packets += io->stats.packets;
             tx_bytes += io->stats.bytes;
+            tx_migrations += io->stats.streams_migrated_in;
+            if(io->thread) {
+                if(!jobj_threads) jobj_threads = json_array();
+                json_array_append_new(jobj_threads, json_pack("{si si sf sI sI sI sb sI}",
+                    "id", io->id,
+                    "streams", io->stream_count,
+                    "streams-pps", io->stream_pps,
+                    "lag-us", (json_int_t)(io->tx_lag / 1000),
+                    "streams-migrated-in", io->stats.streams_migrated_in,
+                    "streams-migrated-out", io->stats.streams_migrated_out,
+                    "pacing", io->pacing.enabled,
+                    "pacing-late", io->stats.pacing_late));
+            }
             io = io->next;
         }
         io = interface->io.rx;
@@ -309,7 +325,7 @@ bbl_interface_ctrl(int fd, uint32_t session_id __attribute__((unused)), json_t *
             io = io->next;
         }
 
-        jobj = json_pack("{ss si si ss* ss* si sI sI sI sI }",
+        jobj = json_pack("{ss si si ss* ss* si sI sI sI sI sI so*}",
             "name", interface->name,
             "ifindex", interface->ifindex,
             "ifindex-kernel", interface->kernel_index,
@@ -318,8 +334,10 @@ bbl_interface_ctrl(int fd, uint32_t session_id __attribute__((unused)), json_t *
             "state-transitions", interface->state_transitions,
             "tx-packets", tx_packets,
             "tx-bytes", tx_bytes,
+            "tx-stream-migrations", tx_migrations,
             "rx-packets", rx_packets,
-            "rx-bytes", rx_bytes);
+            "rx-bytes", rx_bytes,
+            "tx-threads", jobj_threads);
         if(jobj) {
             json_array_append_new(jobj_array, jobj);
         }
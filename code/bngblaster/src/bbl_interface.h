@@ -19,6 +19,8 @@ typedef struct bbl_interface_
     uint32_t ifindex; /* internal interface index */
     uint32_t kernel_index; /* kernel interface index  */
     uint16_t port_id; /* DPDK port identifier */
+    bool tx_udp_checksum_offload; /* DPDK TX UDP checksum offload */
+    bool tx_mbuf_template; /* DPDK TX stream template mbufs */
 
     bbl_link_config_s *config;
 
@@ -41,6 +43,9 @@ typedef struct bbl_interface_
         struct timer_ *tx_job;
         io_handle_s *rx;
         io_handle_s *tx;
+        io_xsk_umem_s *xsk_umem; /* AF_XDP UMEM (per queue) */
+        int xdp_map_fd; /* AF_XDP socket map */
+        int xdp_link_fd; /* AF_XDP program link */
     } io;
 } bbl_interface_s;
 
@@ -539,7 +539,8 @@ bbl_network_rx_handler(bbl_network_interface_s *interface,
 static json_t *
 bbl_network_interface_json(bbl_network_interface_s *interface)
 {
-    return json_pack("{ss si ss sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI}",
+    json_t *root;
+    root = json_pack("{ss si ss sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI sI}",
                      "name", interface->name,
                      "ifindex", interface->ifindex,
                      "type", "Network",
@@ -574,6 +575,8 @@ bbl_network_interface_json(bbl_network_interface_s *interface)
                      "rx-pps-streams", interface->stats.rate_stream_rx.avg,
                      "rx-loss-packets-streams", interface->stats.stream_loss
                     );
+    bbl_histogram_json(interface->stats.stream_delay, root, "rx-delay-us-streams");
+    return root;
 }
 
 /* Control Socket Commands */
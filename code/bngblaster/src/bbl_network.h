@@ -150,6 +150,7 @@ typedef struct bbl_network_interface_
         bbl_rate_s rate_session_ipv6pd_rx;
         bbl_rate_s rate_stream_tx;
         bbl_rate_s rate_stream_rx;
+        bbl_histogram_s *stream_delay; /* Stream RX delay histogram (usec) */
         bbl_rate_s rate_l2tp_data_rx;
         bbl_rate_s rate_l2tp_data_tx;
         bbl_rate_s rate_li_rx;
@@ -7,6 +7,7 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "bbl_def.h"
+#include <checksum.h>
 #include "bbl_protocols.h"
 #include "bbl_access_line.h"
 #include "isis/isis_def.h"
@@ -44,17 +45,10 @@ packet_is_bbl(uint8_t *buf, uint16_t len)
 static uint32_t
 _checksum(void *buf, ssize_t len)
 {
-    uint32_t result = 0;
-    uint16_t *cur = buf;
-    while (len > 1) {
-        result += *cur++;
-        len -= 2;
+    if(len <= 0) {
+        return 0;
     }
-    /*  Add left-over byte, if any */
-    if(len) {
-        result += *(uint8_t*)cur;
-    }
-    return result;
+    return calculate_internet_sum(buf, len);
 }
 
 static uint32_t
@@ -72,6 +66,33 @@ bbl_checksum(uint8_t *buf, uint16_t len)
     return ~_fold(_checksum(buf, len));
 }
 
+/**
+ * bbl_checksum_update
+ *
+ * Incremental checksum update (RFC 1624 eqn. 3) 
+ * for a changed area of the checksummed data.
+ * 
+ * HC' = ~(~HC + ~m + m')
+ *
+ * The changed area must start at an even offset 
+ * relative to the begin of the checksummed data. 
+ *
+ * @param checksum current checksum (HC)
+ * @param old_buf old data (m)
+ * @param new_buf new data (m')
+ * @param len length of changed area
+ * @return updated checksum (HC')
+ */
+uint16_t
+bbl_checksum_update(uint16_t checksum, uint8_t *old_buf, uint8_t *new_buf, uint16_t len)
+{
+    uint32_t result;
+    result  = (uint16_t)~checksum;
+    result += (uint16_t)~_fold(_checksum(old_buf, len));
+    result += _fold(_checksum(new_buf, len));
+    return ~_fold(result);
+}
+
 uint16_t
 bbl_ipv4_udp_checksum(uint32_t src, uint32_t dst, uint8_t *udp, uint16_t udp_len)
 {
@@ -650,6 +650,7 @@ typedef struct bbl_ethernet_header_ {
 
     uint16_t raw_len; /* raw packet */
     struct timespec timestamp; /* receive timestamp */
+    struct timespec rx_timestamp; /* kernel/NIC receive timestamp (stream delay only) */
 } bbl_ethernet_header_s;
 
 /*
@@ -1041,6 +1042,9 @@ packet_is_bbl(uint8_t *buf, uint16_t len);
 uint16_t
 bbl_checksum(uint8_t *buf, uint16_t len);
 
+uint16_t
+bbl_checksum_update(uint16_t checksum, uint8_t *old_buf, uint8_t *new_buf, uint16_t len);
+
 uint16_t
 bbl_ipv4_udp_checksum(uint32_t src, uint32_t dst, uint8_t *udp, uint16_t udp_len);
 
@@ -0,0 +1,468 @@
+/*
+ * BNG Blaster (BBL) - RFC 2544 Benchmarking
+ *
+ * The throughput of all selected traffic streams is searched
+ * per frame size using a binary search over the stream rate,
+ * where every trial sends traffic with a fixed rate for the
+ * configured trial duration. The trial has passed if the loss
+ * measured after the settle time is within the loss tolerance.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bbl.h"
+
+static const char *
+rfc2544_state_string(rfc2544_state_t state)
+{
+    switch(state) {
+        case RFC2544_IDLE: return "idle";
+        case RFC2544_WAIT: return "wait";
+        case RFC2544_TRIAL: return "trial";
+        case RFC2544_SETTLE: return "settle";
+        case RFC2544_FINISHED: return "finished";
+        case RFC2544_ERROR: return "error";
+        default: return "unknown";
+    }
+}
+
+static void
+bbl_rfc2544_stream_pps(bbl_stream_s *stream, double pps)
+{
+    if(stream->pps != pps) {
+        bbl_stream_update_pps(stream, pps);
+    }
+}
+
+static void
+bbl_rfc2544_stream_length(bbl_stream_s *stream, uint16_t length)
+{
+    /* The stream length is shared by all streams of 
+     * the same config, the packet is rebuilt by the
+     * TX thread with the next packet sent. */
+    stream->config->length = length;
+    stream->tx_ready = false;
+}
+
+/**
+ * bbl_rfc2544_streams
+ *
+ * Collect all unicast streams (excluding session traffic)
+ * matching the optional stream name and store their
+ * configured rate, length and state.
+ */
+static bool
+bbl_rfc2544_streams(bbl_rfc2544_s *rfc2544)
+{
+    bbl_rfc2544_config_s *config = g_ctx->config.rfc2544;
+    bbl_rfc2544_stream_s *entry;
+    bbl_stream_s *stream;
+    uint32_t count = 0;
+
+    stream = g_ctx->stream_head;
+    while(stream) {
+        if(stream->type == BBL_TYPE_UNICAST && !stream->session_traffic &&
+           !(config->stream && strcmp(config->stream, stream->config->name))) {
+            count++;
+        }
+        stream = stream->next;
+    }
+    if(!count) return false;
+
+    free(rfc2544->streams);
+    rfc2544->streams = calloc(count, sizeof(bbl_rfc2544_stream_s));
+    if(!rfc2544->streams) return false;
+    rfc2544->stream_count = 0;
+    rfc2544->pps = 0;
+
+    stream = g_ctx->stream_head;
+    while(stream) {
+        if(stream->type == BBL_TYPE_UNICAST && !stream->session_traffic &&
+           !(config->stream && strcmp(config->stream, stream->config->name))) {
+            entry = &rfc2544->streams[rfc2544->stream_count++];
+            entry->stream = stream;
+            entry->pps = stream->pps;
+            entry->length = stream->config->length;
+            entry->enabled = stream->enabled;
+            rfc2544->pps += stream->pps;
+        }
+        stream = stream->next;
+    }
+    return true;
+}
+
+static void
+bbl_rfc2544_enable(bbl_rfc2544_s *rfc2544, bool enabled)
+{
+    for(uint32_t i = 0; i < rfc2544->stream_count; i++) {
+        rfc2544->streams[i].stream->enabled = enabled;
+    }
+}
+
+/**
+ * bbl_rfc2544_restore
+ *
+ * Restore configured rate, length and
+ * state of all streams.
+ */
+static void
+bbl_rfc2544_restore(bbl_rfc2544_s *rfc2544)
+{
+    bbl_rfc2544_stream_s *entry;
+
+    for(uint32_t i = 0; i < rfc2544->stream_count; i++) {
+        entry = &rfc2544->streams[i];
+        entry->stream->enabled = false;
+        bbl_rfc2544_stream_pps(entry->stream, entry->pps);
+        bbl_rfc2544_stream_length(entry->stream, entry->length);
+        entry->stream->enabled = entry->enabled;
+    }
+}
+
+static void
+bbl_rfc2544_stop(bbl_rfc2544_s *rfc2544, rfc2544_state_t state)
+{
+    timer_del(rfc2544->timer);
+    bbl_rfc2544_restore(rfc2544);
+    rfc2544->state = state;
+    clock_gettime(CLOCK_MONOTONIC, &rfc2544->timestamp_stop);
+}
+
+static void
+bbl_rfc2544_finish(bbl_rfc2544_s *rfc2544)
+{
+    bbl_rfc2544_result_s *result;
+
+    bbl_rfc2544_stop(rfc2544, RFC2544_FINISHED);
+
+    for(uint8_t i = 0; i < rfc2544->frame_index; i++) {
+        result = &rfc2544->results[i];
+        LOG(INFO, "RFC2544 frame size %u throughput %.2lf%% (%.2lf PPS) after %u trials\n",
+            result->frame_size, result->rate, result->pps, result->trials);
+    }
+    LOG_NOARG(INFO, "RFC2544 FINISHED\n");
+}
+
+static void
+bbl_rfc2544_trial_start(bbl_rfc2544_s *rfc2544);
+
+/**
+ * bbl_rfc2544_trial_result
+ *
+ * Evaluate the trial after all in-flight packets are
+ * received and select the rate of the next trial.
+ */
+static void
+bbl_rfc2544_trial_result(timer_s *timer)
+{
+    bbl_rfc2544_s *rfc2544 = timer->data;
+    bbl_rfc2544_config_s *config = g_ctx->config.rfc2544;
+    bbl_rfc2544_result_s *result = &rfc2544->results[rfc2544->frame_index];
+    bbl_rfc2544_stream_s *entry;
+    bbl_stream_s *stream;
+
+    uint64_t tx_packets = 0;
+    uint64_t rx_packets = 0;
+    uint64_t loss = 0;
+    uint64_t delay_us_min = 0;
+    uint64_t delay_us_max = 0;
+    bool passed = false;
+
+    for(uint32_t i = 0; i < rfc2544->stream_count; i++) {
+        entry = &rfc2544->streams[i];
+        stream = entry->stream;
+        tx_packets += stream->tx_packets - entry->tx_packets;
+        rx_packets += stream->rx_packets - entry->rx_packets;
+        if(stream->rx_reset) {
+            /* No packet received since trial start. */
+            continue;
+        }
+        if(stream->rx_max_delay_us > delay_us_max) {
+            delay_us_max = stream->rx_max_delay_us;
+        }
+        if(stream->rx_min_delay_us &&
+           (!delay_us_min || stream->rx_min_delay_us < delay_us_min)) {
+            delay_us_min = stream->rx_min_delay_us;
+        }
+    }
+    if(!tx_packets) {
+        /* A trial without traffic says nothing about 
+         * the throughput, e.g. if streams are not 
+         * ready or the interfaces are down. */
+        LOG(ERROR, "RFC2544 ABORTED (frame size %u trial with rate %.2lf%% sent no packets)\n",
+            result->frame_size, rfc2544->rate);
+        bbl_rfc2544_stop(rfc2544, RFC2544_ERROR);
+        return;
+    }
+    if(tx_packets > rx_packets) {
+        loss = tx_packets - rx_packets;
+    }
+    if(((double)loss * 100.0) / tx_packets <= config->loss_tolerance) {
+        passed = true;
+    }
+    result->trials++;
+
+    LOG(DEBUG, "RFC2544 frame size %u trial %u with rate %.2lf%% %s (tx %lu rx %lu loss %lu)\n",
+        result->frame_size, result->trials, rfc2544->rate,
+        passed ? "passed" : "failed", tx_packets, rx_packets, loss);
+
+    if(passed) {
+        rfc2544->rate_low = rfc2544->rate;
+        result->rate = rfc2544->rate;
+        result->pps = (double)tx_packets / config->trial_duration;
+        result->tx_packets = tx_packets;
+        result->rx_packets = rx_packets;
+        result->loss = loss;
+        result->delay_us_min = delay_us_min;
+        result->delay_us_max = delay_us_max;
+    } else {
+        rfc2544->rate_high = rfc2544->rate;
+    }
+
+    if((passed && rfc2544->rate >= config->rate_max) ||
+       (rfc2544->rate_high - rfc2544->rate_low) <= config->resolution) {
+        /* Next frame size */
+        rfc2544->frame_index++;
+        if(rfc2544->frame_index >= config->frame_sizes_count) {
+            bbl_rfc2544_finish(rfc2544);
+            return;
+        }
+        rfc2544->rate = 0;
+    } else {
+        rfc2544->rate = (rfc2544->rate_low + rfc2544->rate_high) / 2;
+    }
+    bbl_rfc2544_trial_start(rfc2544);
+}
+
+static void
+bbl_rfc2544_trial_stop(timer_s *timer)
+{
+    bbl_rfc2544_s *rfc2544 = timer->data;
+
+    /* Stop all streams and wait for in-flight packets. */
+    bbl_rfc2544_enable(rfc2544, false);
+    rfc2544->state = RFC2544_SETTLE;
+    timer_add(&g_ctx->timer_root, &rfc2544->timer, "RFC2544",
+              g_ctx->config.rfc2544->settle_time, 0, rfc2544, &bbl_rfc2544_trial_result);
+}
+
+/**
+ * bbl_rfc2544_trial_start
+ *
+ * Start the next trial with the current rate, where
+ * a rate of zero starts the search for the next frame
+ * size with the max rate. The streams are stopped at
+ * this point, such that packets can be rebuilt.
+ */
+static void
+bbl_rfc2544_trial_start(bbl_rfc2544_s *rfc2544)
+{
+    bbl_rfc2544_config_s *config = g_ctx->config.rfc2544;
+    bbl_rfc2544_result_s *result = &rfc2544->results[rfc2544->frame_index];
+    bbl_rfc2544_stream_s *entry;
+    bbl_stream_s *stream;
+
+    if(rfc2544->rate == 0) {
+        result->frame_size = config->frame_sizes[rfc2544->frame_index];
+        rfc2544->rate = config->rate_max;
+        rfc2544->rate_low = 0;
+        rfc2544->rate_high = config->rate_max;
+        for(uint32_t i = 0; i < rfc2544->stream_count; i++) {
+            bbl_rfc2544_stream_length(rfc2544->streams[i].stream, result->frame_size);
+        }
+    }
+    for(uint32_t i = 0; i < rfc2544->stream_count; i++) {
+        entry = &rfc2544->streams[i];
+        stream = entry->stream;
+        bbl_rfc2544_stream_pps(stream, entry->pps * rfc2544->rate / 100.0);
+        entry->tx_packets = stream->tx_packets;
+        entry->rx_packets = stream->rx_packets;
+        /* Delay is reset by the RX path with the next packet. */
+        stream->rx_reset = true;
+    }
+    global_traffic_enable(true);
+    bbl_rfc2544_enable(rfc2544, true);
+    rfc2544->state = RFC2544_TRIAL;
+    timer_add(&g_ctx->timer_root, &rfc2544->timer, "RFC2544",
+              config->trial_duration, 0, rfc2544, &bbl_rfc2544_trial_stop);
+}
+
+static void
+bbl_rfc2544_first_trial(timer_s *timer)
+{
+    bbl_rfc2544_trial_start(timer->data);
+}
+
+static bool
+bbl_rfc2544_start(bbl_rfc2544_s *rfc2544)
+{
+    if(!bbl_rfc2544_streams(rfc2544)) {
+        LOG_NOARG(ERROR, "RFC2544 failed to start (no streams found)\n");
+        return false;
+    }
+    LOG(INFO, "RFC2544 started with %u streams and %.2lf PPS\n",
+        rfc2544->stream_count, rfc2544->pps);
+
+    memset(rfc2544->results, 0x0, sizeof(rfc2544->results));
+    rfc2544->frame_index = 0;
+    rfc2544->rate = 0;
+    clock_gettime(CLOCK_MONOTONIC, &rfc2544->timestamp_start);
+    rfc2544->timestamp_stop.tv_sec = 0;
+    rfc2544->timestamp_stop.tv_nsec = 0;
+
+    /* Stop all streams during start delay. */
+    bbl_rfc2544_enable(rfc2544, false);
+    rfc2544->state = RFC2544_WAIT;
+    timer_add(&g_ctx->timer_root, &rfc2544->timer, "RFC2544",
+              g_ctx->config.rfc2544->start_delay, 0, rfc2544, &bbl_rfc2544_first_trial);
+    return true;
+}
+
+static void
+bbl_rfc2544_autostart(timer_s *timer)
+{
+    bbl_rfc2544_start(timer->data);
+}
+
+bool
+bbl_rfc2544_init()
+{
+    bbl_rfc2544_s *rfc2544;
+
+    if(!g_ctx->config.rfc2544) {
+        return true;
+    }
+    rfc2544 = calloc(1, sizeof(bbl_rfc2544_s));
+    if(!rfc2544) {
+        return false;
+    }
+    g_ctx->rfc2544 = rfc2544;
+    if(g_ctx->config.rfc2544->autostart) {
+        /* Session streams are added later, therefore
+         * streams are collected with autostart after 
+         * one second (before the start delay). */
+        timer_add(&g_ctx->timer_root, &rfc2544->timer, "RFC2544",
+                  1, 0, rfc2544, &bbl_rfc2544_autostart);
+    }
+    return true;
+}
+
+json_t *
+bbl_rfc2544_json()
+{
+    bbl_rfc2544_s *rfc2544 = g_ctx->rfc2544;
+    bbl_rfc2544_config_s *config = g_ctx->config.rfc2544;
+    bbl_rfc2544_result_s *result;
+    struct timespec now;
+    struct timespec duration;
+
+    json_t *root, *results;
+
+    if(!rfc2544) return NULL;
+
+    results = json_array();
+    for(uint8_t i = 0; i < config->frame_sizes_count; i++) {
+        result = &rfc2544->results[i];
+        if(!result->trials) break;
+        json_array_append_new(results, json_pack("{si si sf sf sI sI sI sI sI sb}",
+            "frame-size", result->frame_size,
+            "trials", result->trials,
+            "throughput-percent", result->rate,
+            "throughput-pps", result->pps,
+            "tx-packets", result->tx_packets,
+            "rx-packets", result->rx_packets,
+            "loss-packets", result->loss,
+            "delay-us-min", result->delay_us_min,
+            "delay-us-max", result->delay_us_max,
+            "finished", i < rfc2544->frame_index));
+    }
+
+    duration.tv_sec = 0;
+    if(rfc2544->timestamp_start.tv_sec) {
+        if(rfc2544->timestamp_stop.tv_sec) {
+            timespec_sub(&duration, &rfc2544->timestamp_stop, &rfc2544->timestamp_start);
+        } else {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            timespec_sub(&duration, &now, &rfc2544->timestamp_start);
+        }
+    }
+
+    root = json_pack("{ss si sf sI si si sf sf so*}",
+        "state", rfc2544_state_string(rfc2544->state),
+        "streams", rfc2544->stream_count,
+        "streams-pps", rfc2544->pps,
+        "duration-sec", (json_int_t)duration.tv_sec,
+        "trial-duration", config->trial_duration,
+        "settle-time", config->settle_time,
+        "loss-tolerance-percent", config->loss_tolerance,
+        "rate-percent", rfc2544->state == RFC2544_TRIAL || rfc2544->state == RFC2544_SETTLE ? rfc2544->rate : 0.0,
+        "results", results);
+    return root;
+}
+
+int
+bbl_rfc2544_ctrl_info(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
+{
+    int result = 0;
+    json_t *root;
+    json_t *rfc2544;
+
+    if(!g_ctx->rfc2544) {
+        return bbl_ctrl_status(fd, "warning", 404, "rfc2544 not configured");
+    }
+    rfc2544 = bbl_rfc2544_json();
+    root = json_pack("{ss si so*}",
+                     "status", "ok",
+                     "code", 200,
+                     "rfc2544", rfc2544);
+    if(root) {
+        result = json_dumpfd(root, fd, 0);
+        json_decref(root);
+    } else {
+        result = bbl_ctrl_status(fd, "error", 500, "internal error");
+        json_decref(rfc2544);
+    }
+    return result;
+}
+
+int
+bbl_rfc2544_ctrl_start(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
+{
+    bbl_rfc2544_s *rfc2544 = g_ctx->rfc2544;
+
+    if(!rfc2544) {
+        return bbl_ctrl_status(fd, "warning", 404, "rfc2544 not configured");
+    }
+    if(rfc2544->state != RFC2544_IDLE && rfc2544->state != RFC2544_FINISHED && 
+       rfc2544->state != RFC2544_ERROR) {
+        return bbl_ctrl_status(fd, "warning", 409, "rfc2544 already running");
+    }
+    if(!bbl_rfc2544_start(rfc2544)) {
+        return bbl_ctrl_status(fd, "error", 500, "no streams found");
+    }
+    return bbl_ctrl_status(fd, "ok", 200, NULL);
+}
+
+int
+bbl_rfc2544_ctrl_stop(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
+{
+    bbl_rfc2544_s *rfc2544 = g_ctx->rfc2544;
+
+    if(!rfc2544) {
+        return bbl_ctrl_status(fd, "warning", 404, "rfc2544 not configured");
+    }
+    switch(rfc2544->state) {
+        case RFC2544_WAIT:
+        case RFC2544_TRIAL:
+        case RFC2544_SETTLE:
+            bbl_rfc2544_finish(rfc2544);
+            break;
+        case RFC2544_IDLE:
+            /* Cancel autostart. */
+            timer_del(rfc2544->timer);
+            break;
+        default:
+            break;
+    }
+    return bbl_ctrl_status(fd, "ok", 200, NULL);
+}
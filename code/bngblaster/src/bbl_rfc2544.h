@@ -0,0 +1,101 @@
+/*
+ * BNG Blaster (BBL) - RFC 2544 Benchmarking
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_RFC2544_H__
+#define __BBL_RFC2544_H__
+
+#define BBL_RFC2544_FRAME_SIZES_MAX 16
+
+typedef enum {
+    RFC2544_IDLE = 0,
+    RFC2544_WAIT,       /* wait for first trial */
+    RFC2544_TRIAL,      /* trial running */
+    RFC2544_SETTLE,     /* wait for in-flight packets */
+    RFC2544_FINISHED,
+    RFC2544_ERROR       /* aborted */
+} __attribute__ ((__packed__)) rfc2544_state_t;
+
+typedef struct bbl_rfc2544_config_
+{
+    char *stream; /* stream name (all streams if not set) */
+
+    uint16_t frame_sizes[BBL_RFC2544_FRAME_SIZES_MAX];
+    uint8_t frame_sizes_count;
+    uint16_t frame_size_max;
+
+    uint16_t trial_duration; /* seconds */
+    uint16_t settle_time; /* seconds */
+    uint16_t start_delay; /* seconds */
+
+    double loss_tolerance; /* percent */
+    double resolution; /* percent */
+    double rate_max; /* percent of stream PPS */
+
+    bool autostart;
+} bbl_rfc2544_config_s;
+
+typedef struct bbl_rfc2544_stream_
+{
+    bbl_stream_s *stream;
+    double pps; /* configured PPS */
+    uint16_t length; /* configured length */
+    bool enabled;
+
+    uint64_t tx_packets; /* TX packets at trial start */
+    uint64_t rx_packets; /* RX packets at trial start */
+} bbl_rfc2544_stream_s;
+
+typedef struct bbl_rfc2544_result_
+{
+    uint16_t frame_size;
+    uint16_t trials;
+    double rate; /* throughput in percent of stream PPS */
+    double pps; /* throughput of all streams */
+
+    /* Trial with highest rate passed */
+    uint64_t tx_packets;
+    uint64_t rx_packets;
+    uint64_t loss;
+    uint64_t delay_us_min;
+    uint64_t delay_us_max;
+} bbl_rfc2544_result_s;
+
+typedef struct bbl_rfc2544_
+{
+    rfc2544_state_t state;
+
+    bbl_rfc2544_stream_s *streams;
+    uint32_t stream_count;
+    double pps; /* PPS of all streams */
+
+    uint8_t frame_index;
+    double rate;
+    double rate_low;
+    double rate_high;
+
+    struct timer_ *timer;
+    struct timespec timestamp_start;
+    struct timespec timestamp_stop;
+
+    bbl_rfc2544_result_s results[BBL_RFC2544_FRAME_SIZES_MAX];
+} bbl_rfc2544_s;
+
+bool
+bbl_rfc2544_init();
+
+json_t *
+bbl_rfc2544_json();
+
+int
+bbl_rfc2544_ctrl_info(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)));
+
+int
+bbl_rfc2544_ctrl_start(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)));
+
+int
+bbl_rfc2544_ctrl_stop(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)));
+
+#endif
@@ -763,7 +763,7 @@ update_strings(char **target, const char *source, uint32_t *i, bbl_access_config
 
     if(i && access_config) {
         /* Init iterator */
-        snprintf(snum1, sizeof(snum1), "%d", *i);
+        snprintf(snum1, sizeof(snum1), "%u", *i + g_ctx->config.sessions_id_offset);
         snprintf(snum2, sizeof(snum2), "%d", access_config->sessions);
         snprintf(si1, sizeof(si1), "%d", access_config->i1);
         access_config->i1 += access_config->i1_step;
@@ -801,6 +801,14 @@ bbl_sessions_init()
      * that all VLAN ranges are exhausted. */
     int t = 0;
 
+    /* The global session identifier is encoded 
+     * in the last three bytes of the client MAC. */
+    if((uint64_t)g_ctx->config.sessions_id_offset + g_ctx->config.sessions > 0xFFFFFF) {
+        LOG(ERROR, "Failed to init sessions (session id-offset %u + count %u exceeds 16777215)\n",
+            g_ctx->config.sessions_id_offset, g_ctx->config.sessions);
+        return false;
+    }
+
     /* Init list of sessions */
     g_ctx->session_list = calloc(g_ctx->config.sessions, sizeof(bbl_session_s));
     access_config = g_ctx->config.access_config;
@@ -882,10 +890,10 @@ bbl_sessions_init()
         session->client_mac[0] = 0x02;
         session->client_mac[1] = 0x00;
         session->client_mac[2] = g_ctx->config.mac_modifier;
-        /* Use session identifier for remaining bytes */
-        session->client_mac[3] = i>>16;
-        session->client_mac[4] = i>>8;
-        session->client_mac[5] = i;
+        /* Use global session identifier for remaining bytes */
+        session->client_mac[3] = (i + g_ctx->config.sessions_id_offset)>>16;
+        session->client_mac[4] = (i + g_ctx->config.sessions_id_offset)>>8;
+        session->client_mac[5] = (i + g_ctx->config.sessions_id_offset);
 
         /* Derive IP6CP interface identifier from MAC (EUI-64) */
         ((uint8_t *)&session->ip6cp_ipv6_identifier)[0] = session->client_mac[0];
@@ -65,6 +65,7 @@ bbl_stats_generate_interface(io_handle_s *io, bbl_interface_stats_s *stats)
         stats->to_long += io->stats.to_long;
         stats->no_buffer += io->stats.no_buffer;
         stats->polled += io->stats.polled;
+        stats->batches += io->stats.batches;
         io = io->next;
     }
 }
@@ -462,6 +463,9 @@ bbl_stats_stdout(bbl_stats_s *stats) {
             printf("  TX:                %10lu packets %16lu bytes\n", 
                 interface_stats_tx.packets, interface_stats_tx.bytes);
             printf("  TX Polled:         %10lu\n", interface_stats_tx.polled);
+            if(interface_stats_tx.batches) {
+                printf("  TX Batches:        %10lu\n", interface_stats_tx.batches);
+            }
             if(interface_stats_tx.io_errors) {
                 printf("  TX IO Error:       %10lu\n", interface_stats_tx.io_errors);
             }
@@ -476,6 +480,9 @@ bbl_stats_stdout(bbl_stats_s *stats) {
             printf("  RX Protocol Error: %10lu packets\n", interface_stats_rx.protocol_errors);
             printf("  RX Unknown:        %10lu packets\n", interface_stats_rx.unknown);
             printf("  RX Polled:         %10lu\n", interface_stats_rx.polled);
+            if(interface_stats_rx.batches) {
+                printf("  RX Batches:        %10lu\n", interface_stats_rx.batches);
+            }
             if(interface_stats_rx.io_errors) {
                 printf("  RX IO Error:       %10lu\n", interface_stats_rx.io_errors);
             }
@@ -747,6 +754,12 @@ bbl_stats_stdout(bbl_stats_s *stats) {
             stats->min_stream_loss, stats->max_stream_loss);
         printf("  Flow Receive Delay (usec)       MIN: %8lu MAX: %8lu\n",
             stats->min_stream_delay_us, stats->max_stream_delay_us);
+        if(g_ctx->stats.stream_delay) {
+            printf("  Flow Receive Delay (usec)       P50: %8lu P99: %8lu P99.9: %8lu\n",
+                bbl_histogram_percentile(g_ctx->stats.stream_delay, 50.0),
+                bbl_histogram_percentile(g_ctx->stats.stream_delay, 99.0),
+                bbl_histogram_percentile(g_ctx->stats.stream_delay, 99.9));
+        }
     }
 
     if(g_ctx->config.igmp_group_count > 1) {
@@ -868,6 +881,7 @@ bbl_stats_json(bbl_stats_s * stats)
             json_object_set_new(jobj_sub, "tx-packets", json_integer(interface_stats_tx.packets));
             json_object_set_new(jobj_sub, "tx-bytes", json_integer(interface_stats_tx.bytes));
             json_object_set_new(jobj_sub, "tx-polled", json_integer(interface_stats_tx.polled));
+            json_object_set_new(jobj_sub, "tx-batches", json_integer(interface_stats_tx.batches));
             json_object_set_new(jobj_sub, "tx-io-error", json_integer(interface_stats_tx.io_errors));
             json_object_set_new(jobj_sub, "tx-to-long", json_integer(interface_stats_tx.to_long));
             json_object_set_new(jobj_sub, "tx-no-buffer", json_integer(interface_stats_tx.no_buffer));
@@ -877,6 +891,7 @@ bbl_stats_json(bbl_stats_s * stats)
             json_object_set_new(jobj_sub, "rx-protocol-error", json_integer(interface_stats_rx.protocol_errors));
             json_object_set_new(jobj_sub, "rx-unknown", json_integer(interface_stats_rx.unknown));
             json_object_set_new(jobj_sub, "rx-polled", json_integer(interface_stats_rx.bytes));
+            json_object_set_new(jobj_sub, "rx-batches", json_integer(interface_stats_rx.batches));
             json_object_set_new(jobj_sub, "rx-io-error", json_integer(interface_stats_rx.io_errors));
             json_object_set_new(jobj_sub, "rx-no-buffer", json_integer(interface_stats_rx.no_buffer));
         }
@@ -907,6 +922,7 @@ bbl_stats_json(bbl_stats_s * stats)
                 json_object_set_new(jobj_sub, "tx-stream-packets", json_integer(network_interface->stats.stream_tx));
                 json_object_set_new(jobj_sub, "rx-stream-packets", json_integer(network_interface->stats.stream_rx));
                 json_object_set_new(jobj_sub, "rx-stream-packets-loss", json_integer(network_interface->stats.stream_loss));
+                bbl_histogram_json(network_interface->stats.stream_delay, jobj_sub, "rx-stream-delay-us");
             }
             if(g_ctx->stats.session_traffic_flows) {
                 json_object_set_new(jobj_sub, "tx-session-packets-ipv4", json_integer(network_interface->stats.session_ipv4_tx));
@@ -951,6 +967,7 @@ bbl_stats_json(bbl_stats_s * stats)
                 json_object_set_new(jobj_sub, "tx-stream-packets", json_integer(access_interface->stats.stream_tx));
                 json_object_set_new(jobj_sub, "rx-stream-packets", json_integer(access_interface->stats.stream_rx));
                 json_object_set_new(jobj_sub, "rx-stream-packets-loss", json_integer(access_interface->stats.stream_loss));
+                bbl_histogram_json(access_interface->stats.stream_delay, jobj_sub, "rx-stream-delay-us");
             }
             if(g_ctx->stats.session_traffic_flows) {
                 json_object_set_new(jobj_sub, "tx-session-packets-ipv4", json_integer(access_interface->stats.session_ipv4_tx));
@@ -1035,6 +1052,7 @@ bbl_stats_json(bbl_stats_s * stats)
                 json_object_set_new(jobj_sub, "tx-stream-packets", json_integer(a10nsp_interface->stats.stream_tx));
                 json_object_set_new(jobj_sub, "rx-stream-packets", json_integer(a10nsp_interface->stats.stream_rx));
                 json_object_set_new(jobj_sub, "rx-stream-packets-loss", json_integer(a10nsp_interface->stats.stream_loss));
+                bbl_histogram_json(a10nsp_interface->stats.stream_delay, jobj_sub, "rx-stream-delay-us");
             }
             if(g_ctx->stats.session_traffic_flows) {
                 json_object_set_new(jobj_sub, "tx-session-packets-ipv4", json_integer(a10nsp_interface->stats.session_ipv4_tx));
@@ -1152,6 +1170,7 @@ bbl_stats_json(bbl_stats_s * stats)
         json_object_set_new(jobj_sub, "flow-rx-packet-loss-max", json_integer(stats->max_stream_loss));
         json_object_set_new(jobj_sub, "flow-rx-delay-us-min", json_integer(stats->min_stream_delay_us));
         json_object_set_new(jobj_sub, "flow-rx-delay-us-max", json_integer(stats->max_stream_delay_us));
+        bbl_histogram_json(g_ctx->stats.stream_delay, jobj_sub, "flow-rx-delay-us");
         json_object_set_new(jobj, "traffic-streams", jobj_sub);
     }
 
@@ -1187,6 +1206,10 @@ bbl_stats_json(bbl_stats_s * stats)
         json_object_set_new(jobj, "multicast", jobj_sub);
     }
 
+    if(g_ctx->rfc2544) {
+        json_object_set_new(jobj, "rfc2544", bbl_rfc2544_json());
+    }
+
     if(g_ctx->config.json_report_sessions) {
         jobj_array = json_array();
         for(i = 0; i < g_ctx->sessions; i++) {
@@ -153,6 +153,7 @@ typedef struct bbl_interface_stats_ {
     uint64_t to_long;
     uint64_t no_buffer;
     uint64_t polled;
+    uint64_t batches;
 } bbl_interface_stats_s;
 
 void 
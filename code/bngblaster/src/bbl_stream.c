@@ -11,6 +11,9 @@
 #include "bbl_stream.h"
 #include "bbl_stats.h"
 
+/* Max bytes changed per packet (BBL header sequence and timestamp). */
+#define BBL_STREAM_UPDATE_WINDOW 17
+
 extern volatile bool g_teardown;
 extern bool g_init_phase;
 extern bool g_traffic;
@@ -64,7 +67,10 @@ bbl_stream_delay(bbl_stream_s *stream, struct timespec *rx_timestamp, struct tim
     struct timespec delay;
     uint64_t delay_us;
     timespec_sub(&delay, rx_timestamp, bbl_timestamp);
-    
+
+    bbl_stream_jitter(&stream->rx_jitter, &stream->rx_last_transit, 
+                      (delay.tv_sec * 1000000000LL) + delay.tv_nsec);
+
     delay_us = (delay.tv_sec * 1000000) + (delay.tv_nsec / 1000);
     if(delay_us == 0) delay_us = 1;
 
@@ -78,6 +84,45 @@ bbl_stream_delay(bbl_stream_s *stream, struct timespec *rx_timestamp, struct tim
     } else {
         stream->rx_min_delay_us = delay_us;
     }
+    if(stream->rx_delay_histogram) {
+        bbl_histogram_flow_record(stream->rx_delay_histogram, delay_us);
+    }
+}
+
+static bbl_histogram_s *
+bbl_stream_delay_histogram_get(bbl_histogram_s **histogram)
+{
+    if(!*histogram) {
+        *histogram = bbl_histogram_init();
+    }
+    return *histogram;
+}
+
+/**
+ * bbl_stream_delay_sync
+ *
+ * Merge the delay values received since last sync
+ * into the RX interface and global delay histograms.
+ *
+ * @param stream stream
+ */
+static void
+bbl_stream_delay_sync(bbl_stream_s *stream)
+{
+    bbl_histogram_s *histogram = NULL;
+
+    if(stream->rx_access_interface) {
+        histogram = bbl_stream_delay_histogram_get(&stream->rx_access_interface->stats.stream_delay);
+    } else if(stream->rx_network_interface) {
+        histogram = bbl_stream_delay_histogram_get(&stream->rx_network_interface->stats.stream_delay);
+    } else if(stream->rx_a10nsp_interface) {
+        histogram = bbl_stream_delay_histogram_get(&stream->rx_a10nsp_interface->stats.stream_delay);
+    }
+    bbl_histogram_flow_sync(stream->rx_delay_histogram, 
+                            bbl_histogram_index(stream->rx_min_delay_us),
+                            bbl_histogram_index(stream->rx_max_delay_us),
+                            histogram, 
+                            bbl_stream_delay_histogram_get(&g_ctx->stats.stream_delay));
 }
 
 static bool
@@ -86,7 +131,6 @@ bbl_stream_build_access_pppoe_packet(bbl_stream_s *stream)
     bbl_session_s *session = stream->session;
     bbl_stream_config_s *config = stream->config;
 
-    uint16_t buf_len = 0;
     uint16_t tx_len = 0;
 
     bbl_ethernet_header_s eth = {0};
@@ -214,20 +258,16 @@ bbl_stream_build_access_pppoe_packet(bbl_stream_s *stream)
             return false;
     }
 
-    buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
-    if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
     stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
     if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
         return false;
     }
     stream->tx_len = tx_len;
+    stream->tx_ready = true;
     return true;
 }
 
@@ -239,7 +279,6 @@ bbl_stream_build_a10nsp_pppoe_packet(bbl_stream_s *stream)
     bbl_a10nsp_interface_s *a10nsp_interface;
     bbl_stream_config_s *config = stream->config;
 
-    uint16_t buf_len = 0;
     uint16_t tx_len = 0;
 
     bbl_ethernet_header_s eth = {0};
@@ -353,20 +392,16 @@ bbl_stream_build_a10nsp_pppoe_packet(bbl_stream_s *stream)
             return false;
     }
 
-    buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
-    if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
     stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
     if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
         return false;
     }
     stream->tx_len = tx_len;
+    stream->tx_ready = true;
     return true;
 }
 
@@ -378,7 +413,6 @@ bbl_stream_build_a10nsp_ipoe_packet(bbl_stream_s *stream)
     bbl_a10nsp_interface_s *a10nsp_interface;
     bbl_stream_config_s *config = stream->config;
 
-    uint16_t buf_len = 0;
     uint16_t tx_len = 0;
 
     bbl_ethernet_header_s eth = {0};
@@ -488,20 +522,16 @@ bbl_stream_build_a10nsp_ipoe_packet(bbl_stream_s *stream)
             return false;
     }
 
-    buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
-    if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
     stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
     if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
         return false;
     }
     stream->tx_len = tx_len;
+    stream->tx_ready = true;
     return true;
 }
 
@@ -511,7 +541,6 @@ bbl_stream_build_access_ipoe_packet(bbl_stream_s *stream)
     bbl_session_s *session = stream->session;
     bbl_stream_config_s *config = stream->config;
 
-    uint16_t buf_len = 0;
     uint16_t tx_len = 0;
 
     bbl_ethernet_header_s eth = {0};
@@ -634,20 +663,16 @@ bbl_stream_build_access_ipoe_packet(bbl_stream_s *stream)
             return false;
     }
 
-    buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
-    if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
     stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
     if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
         return false;
     }
     stream->tx_len = tx_len;
+    stream->tx_ready = true;
     return true;
 }
 
@@ -657,7 +682,6 @@ bbl_stream_build_network_packet(bbl_stream_s *stream)
     bbl_session_s *session = stream->session;
     bbl_stream_config_s *config = stream->config;
 
-    uint16_t buf_len = 0;
     uint16_t tx_len = 0;
 
     bbl_ethernet_header_s eth = {0};
@@ -812,20 +836,16 @@ bbl_stream_build_network_packet(bbl_stream_s *stream)
             return false;
     }
 
-    buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
-    if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
     stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
     if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
         return false;
     }
     stream->tx_len = tx_len;
+    stream->tx_ready = true;
     return true;
 }
 
@@ -840,7 +860,6 @@ bbl_stream_build_l2tp_packet(bbl_stream_s *stream)
 
     bbl_network_interface_s *network_interface = l2tp_tunnel->interface;
 
-    uint16_t buf_len = 0;
     uint16_t tx_len = 0;
 
     bbl_ethernet_header_s eth = {0};
@@ -912,18 +931,14 @@ bbl_stream_build_l2tp_packet(bbl_stream_s *stream)
     if(config->length > 76) {
         bbl.padding = config->length - 76;
     }
-    buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
-    if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
     stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
         return false;
     }
     stream->tx_len = tx_len;
+    stream->tx_ready = true;
     return true;
 }
 
@@ -1264,6 +1279,9 @@ bbl_stream_ctrl(bbl_stream_s *stream)
         if(unlikely(stream->rx_wrong_session)) {
             bbl_stream_rx_wrong_session(stream);
         }
+        if(stream->rx_delay_histogram) {
+            bbl_stream_delay_sync(stream);
+        }
         if(unlikely(!stream->verified)) {
             if(stream->rx_first_seq) {
                 if(stream->session_traffic) {
@@ -1327,11 +1345,8 @@ bbl_stream_ldp_lookup(bbl_stream_s *stream)
     }
     if(stream->ldp_entry->version != stream->ldp_entry_version) {
         stream->ldp_entry_version = stream->ldp_entry->version;
-        /* Free packet if LDP entry has changed. */
-        if(stream->tx_buf) {
-            free(stream->tx_buf);
-            stream->tx_buf = NULL;
-        }
+        /* Rebuild packet if LDP entry has changed. */
+        stream->tx_ready = false;
     }
     return true;
 }
@@ -1356,20 +1371,44 @@ bbl_stream_can_send(bbl_stream_s *stream)
         }
     }
 
-    /* Free packet if not ready to send. */
-    if(stream->tx_buf) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
-    }
+    /* Rebuild packet if ready to send again. */
+    stream->tx_ready = false;
     return false;
 }
 
+/**
+ * The BBL header fields updated with every packet are 
+ * located in the last 16 bytes of the packet. The incremental
+ * checksum update must start at an even offset relative to 
+ * the L4 header, so the last 17 bytes are used for odd L4 length. 
+ */
+static inline uint8_t *
+bbl_stream_update_window(uint8_t *old, uint16_t l4_len, uint16_t *window)
+{
+    *window = l4_len - ((l4_len - 16) & ~1);
+    return old + (BBL_STREAM_UPDATE_WINDOW - *window);
+}
+
 static void
-bbl_stream_update_tcp(bbl_stream_s *stream)
+bbl_stream_update_tcp(bbl_stream_s *stream, uint8_t *old)
 {
     uint16_t  tcp_len = stream->tx_bbl_hdr_len + TCP_HDR_LEN_MIN;
     uint8_t  *tcp_buf = (uint8_t*)(stream->tx_buf + (stream->tx_len - tcp_len));
     uint16_t *checksum = (uint16_t*)(tcp_buf+16);
+    uint16_t  flags;
+    uint16_t  window;
+
+    if(old) {
+        /* Incremental update of the changed fields only. */
+        if(stream->tcp_flags) {
+            flags = *(uint16_t*)(tcp_buf+12);
+            *(tcp_buf+13) = stream->tcp_flags & 0x3f;
+            *checksum = bbl_checksum_update(*checksum, (uint8_t*)&flags, tcp_buf+12, sizeof(flags));
+        }
+        old = bbl_stream_update_window(old, tcp_len, &window);
+        *checksum = bbl_checksum_update(*checksum, old, tcp_buf+(tcp_len-window), window);
+        return;
+    }
 
     if(stream->tcp_flags) {
         *(tcp_buf+13) = stream->tcp_flags & 0x3f;
@@ -1384,11 +1423,19 @@ bbl_stream_update_tcp(bbl_stream_s *stream)
 }
 
 static void
-bbl_stream_update_udp(bbl_stream_s *stream)
+bbl_stream_update_udp(bbl_stream_s *stream, uint8_t *old)
 {
     uint16_t  udp_len = stream->tx_bbl_hdr_len + UDP_HDR_LEN;
     uint8_t  *udp_buf = (uint8_t*)(stream->tx_buf + (stream->tx_len - udp_len));
     uint16_t *checksum = (uint16_t*)(udp_buf+6);
+    uint16_t  window;
+
+    if(old) {
+        /* Incremental update of the changed fields only. */
+        old = bbl_stream_update_window(old, udp_len, &window);
+        *checksum = bbl_checksum_update(*checksum, old, udp_buf+(udp_len-window), window);
+        return;
+    }
 
     *checksum = 0;
     if(stream->ipv6_src && stream->ipv6_dst) {
@@ -1402,9 +1449,12 @@ static protocol_error_t
 bbl_stream_io_send(bbl_stream_s *stream)
 {
     struct timespec time_elapsed;
+    struct timespec timestamp;
     bbl_session_s *session;
     io_handle_s *io = stream->io;
     uint8_t *ptr;
+    uint8_t update[BBL_STREAM_UPDATE_WINDOW];
+    uint8_t *old = update;
 
     if(unlikely(stream->reset)) {
         stream->reset = false;
@@ -1464,29 +1514,48 @@ bbl_stream_io_send(bbl_stream_s *stream)
     
     session = stream->session;
     if(session && session->version != stream->session_version) {
-        if(stream->tx_buf) {
-            free(stream->tx_buf);
-            stream->tx_buf = NULL;
-        }
+        stream->tx_ready = false;
         stream->session_version = session->version;
     }
+    if(stream->tx_l4_offload && !io->interface->tx_udp_checksum_offload) {
+        /* Stream moved to an interface without UDP checksum offload. */
+        stream->tx_ready = false;
+    }
 
-    if(!stream->tx_buf) {
+    if(!stream->tx_ready) {
         if(!bbl_stream_build_packet(stream)) {
             LOG(ERROR, "Failed to build packet for stream %s\n", stream->config->name);
             return ENCODE_ERROR;
         }
+        /* The L4 checksum of a new packet is calculated 
+         * completely, all further updates are incremental. 
+         * IO specific state like TX checksum offload or 
+         * template mbufs must be prepared again. */
+        old = NULL;
+        stream->tx_changed = true;
+        stream->tx_l4_offload = false;
+    } else if(stream->tcp || (g_ctx->config.stream_udp_checksum && !stream->tx_l4_offload)) {
+        memcpy(update, stream->tx_buf + stream->tx_len - BBL_STREAM_UPDATE_WINDOW, BBL_STREAM_UPDATE_WINDOW);
     }
 
     /* Update BBL header fields */
+    if(g_ctx->config.io_timestamping) {
+        /* Per packet TX timestamp using the same clock 
+         * as kernel software or NIC hardware RX timestamps 
+         * instead of the burst start time. */
+        clock_gettime(CLOCK_REALTIME, &timestamp);
+    } else {
+        timestamp.tv_sec = io->timestamp.tv_sec;
+        timestamp.tv_nsec = io->timestamp.tv_nsec;
+    }
     ptr = stream->tx_buf + stream->tx_len - 16;
     *(uint64_t*)ptr = stream->flow_seq; ptr += sizeof(uint64_t);
-    *(uint32_t*)ptr = io->timestamp.tv_sec; ptr += sizeof(uint32_t);
-    *(uint32_t*)ptr = io->timestamp.tv_nsec;
+    *(uint32_t*)ptr = timestamp.tv_sec; ptr += sizeof(uint32_t);
+    *(uint32_t*)ptr = timestamp.tv_nsec;
     if(stream->tcp) {
-        bbl_stream_update_tcp(stream);
-    } else if(g_ctx->config.stream_udp_checksum) {
-        bbl_stream_update_udp(stream);
+        bbl_stream_update_tcp(stream, old);
+    } else if(g_ctx->config.stream_udp_checksum && !stream->tx_l4_offload) {
+        bbl_stream_update_udp(stream, old);
     }
     if(stream->flow_seq == 1) {
         stream->tx_first_epoch = io->timestamp.tv_sec;
@@ -1505,9 +1574,10 @@ bbl_stream_io_stop(io_handle_s *io)
     io_bucket_s *io_bucket = io->bucket_head;
     while(io_bucket) {
         io_bucket->base = 0;
-        io_bucket->stream_cur = NULL;
+        io_bucket->slot_cur = NULL;
         io_bucket = io_bucket->next;
     }
+    io->pacing.next = 0;
 }
 
 /**
@@ -1521,15 +1591,16 @@ bbl_stream_s *
 bbl_stream_io_send_iter(io_handle_s *io, uint64_t now)
 {
     io_bucket_s *io_bucket = io->bucket_cur;
-    bbl_stream_s *stream;
+    io_stream_slot_s *slot;
+    io_stream_slot_s *end;
     uint64_t min = now - g_ctx->config.stream_burst_ms;
     uint64_t expired;
     while(io_bucket) {
-        if(io_bucket->stream_cur) {
-            stream = io_bucket->stream_cur;
+        if(io_bucket->slot_cur) {
+            slot = io_bucket->slot_cur;
         } else {
-            stream = io_bucket->stream_head;
-            io_bucket->stream_cur = stream;
+            slot = io_bucket->slots;
+            io_bucket->slot_cur = slot;
             if(io_bucket->base) {
                 io_bucket->base += io_bucket->nsec;
                 if(io_bucket->base < min) {
@@ -1538,6 +1609,13 @@ bbl_stream_io_send_iter(io_handle_s *io, uint64_t now)
             } else {
                 io_bucket->base = now;
             }
+            /* Scheduling lag moving average (1/8 weight)
+             * used by the stream rebalancer. */
+            if(io_bucket->base < now) {
+                io->tx_lag += ((int64_t)(now - io_bucket->base) - io->tx_lag) / 8;
+            } else {
+                io->tx_lag -= io->tx_lag / 8;
+            }
         }
         if(io_bucket->base >= now) {
             /* next bucket */
@@ -1547,25 +1625,26 @@ bbl_stream_io_send_iter(io_handle_s *io, uint64_t now)
             continue;
         }
         expired = now - io_bucket->base;
-        while(stream) {
-            if(stream->expired > expired) {
-                io_bucket->stream_cur = stream;
+        end = io_bucket->slots + io_bucket->stream_count;
+        while(slot < end) {
+            if(slot->expired > expired) {
+                io_bucket->slot_cur = slot;
                 break;
             }
-            if (bbl_stream_io_send(stream) == PROTOCOL_SUCCESS) {
-                io_bucket->stream_cur = stream->io_next;
+            if (bbl_stream_io_send(slot->stream) == PROTOCOL_SUCCESS) {
+                io_bucket->slot_cur = slot + 1 < end ? slot + 1 : NULL;
                 io->bucket_cur = io_bucket;
-                return stream;
+                return slot->stream;
             }
-            stream = stream->io_next;
+            slot++;
         }
-        if(!stream) {
-            if(io_bucket->stream_cur == io_bucket->stream_head) {
+        if(slot == end) {
+            if(io_bucket->slot_cur == io_bucket->slots) {
                 /* We can reset bucket base if none of the streams 
                  * in the bucket is active. */
                 io_bucket->base = 0;
             }
-            io_bucket->stream_cur = NULL;
+            io_bucket->slot_cur = NULL;
         }
         /* next bucket */
         io_bucket = io_bucket->next;
@@ -1677,9 +1756,77 @@ bbl_stream_select_io(bbl_stream_s *stream)
     io_stream_add(io, stream);
 }
 
-static void
+/**
+ * bbl_stream_new
+ *
+ * Allocate new stream from stream arena, which
+ * ensures cache line alignment of the per-thread
+ * sections and keeps streams dense in memory.
+ *
+ * @return new stream
+ */
+static bbl_stream_s *
+bbl_stream_new()
+{
+    return bbl_arena_alloc(&g_ctx->stream_arena, sizeof(bbl_stream_s), CACHE_LINE_SIZE);
+}
+
+/**
+ * bbl_stream_tx_buf_alloc
+ *
+ * Allocate packet template from packet arena. The template
+ * is allocated once and reused if the packet is rebuilt.
+ * Templates are cache line aligned, to prevent false
+ * sharing between streams sent from different threads.
+ *
+ * @param len required length
+ * @return packet template buffer
+ */
+static uint8_t *
+bbl_stream_tx_buf_alloc(uint16_t len)
+{
+    if(len < 256) len = 256;
+    return bbl_arena_alloc(&g_ctx->packet_arena, len, CACHE_LINE_SIZE);
+}
+
+/**
+ * bbl_stream_add
+ *
+ * All per-stream memory is allocated before the 
+ * stream is added to groups and IO handles, so that 
+ * no partially initialized stream is ever sent.
+ *
+ * @param stream stream
+ * @return false if memory allocation failed
+ */
+static bool
 bbl_stream_add(bbl_stream_s *stream)
 {
+    uint16_t tx_buf_len;
+
+    tx_buf_len = stream->config->length;
+    if(g_ctx->config.rfc2544 && g_ctx->config.rfc2544->frame_size_max > tx_buf_len) {
+        /* RFC 2544 trials change the stream length. */
+        tx_buf_len = g_ctx->config.rfc2544->frame_size_max;
+    }
+    stream->tx_buf = bbl_stream_tx_buf_alloc(tx_buf_len + BBL_MAX_STREAM_OVERHEAD);
+    if(!stream->tx_buf) {
+        goto NOMEM;
+    }
+    if(g_ctx->config.stream_delay_calc && g_ctx->config.stream_delay_histogram && 
+       stream->type == BBL_TYPE_UNICAST) {
+        stream->rx_delay_histogram = bbl_arena_alloc(&g_ctx->stream_arena, sizeof(bbl_histogram_flow_s), CACHE_LINE_SIZE);
+        if(!stream->rx_delay_histogram) {
+            goto NOMEM;
+        }
+    }
+    if(g_ctx->config.stream_loss_calc && stream->type == BBL_TYPE_UNICAST) {
+        stream->rx_loss_history = bbl_arena_alloc(&g_ctx->stream_arena, sizeof(bbl_stream_loss_s), CACHE_LINE_SIZE);
+        if(!stream->rx_loss_history) {
+            goto NOMEM;
+        }
+    }
+
     bbl_stream_add_group(stream);
     if(stream->tx_interface->type == LAG_INTERFACE) {
         bbl_stream_select_io_lag(stream);
@@ -1698,6 +1845,11 @@ bbl_stream_add(bbl_stream_s *stream)
     g_ctx->stream_tail = stream;
     g_ctx->streams++;
     g_ctx->total_pps += stream->pps;
+    return true;
+
+NOMEM:
+    LOG(ERROR, "Failed to add stream %s because of memory allocation failure\n", stream->config->name);
+    return false;
 }
 
 static bool 
@@ -1758,7 +1910,11 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
                 return false;
             }
         }
-        stream_up = calloc(1, sizeof(bbl_stream_s));
+        stream_up = bbl_stream_new();
+        if(!stream_up) {
+            LOG(ERROR, "Failed to add stream %s because of memory allocation failure\n", config->name);
+            return false;
+        }
         stream_up->enabled = config->autostart;
         stream_up->endpoint = &g_endpoint;
         stream_up->flow_id = g_ctx->flow_id++;
@@ -1789,9 +1945,11 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
         }
         stream_up->tx_access_interface = access_interface;
         stream_up->tx_interface = access_interface->interface;
+        if(!bbl_stream_add(stream_up)) {
+            return false;
+        }
         stream_up->session_next = session->streams.head;
         session->streams.head = stream_up;
-        bbl_stream_add(stream_up);
         if(stream_up->session_traffic) {
             g_ctx->stats.session_traffic_flows++;
             session->session_traffic.flows++;
@@ -1804,7 +1962,11 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
         }
     }
     if(config->direction & BBL_DIRECTION_DOWN) {
-        stream_down = calloc(1, sizeof(bbl_stream_s));
+        stream_down = bbl_stream_new();
+        if(!stream_down) {
+            LOG(ERROR, "Failed to add stream %s because of memory allocation failure\n", config->name);
+            return false;
+        }
         stream_down->enabled = config->autostart;
         stream_down->endpoint = &g_endpoint;
         stream_down->flow_id = g_ctx->flow_id++;
@@ -1833,8 +1995,6 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
             stream_down->tcp = true;
         }
         stream_down->session_traffic = config->session_traffic;
-        stream_down->session_next = session->streams.head;
-        session->streams.head = stream_down;
         if(network_interface) {
             stream_down->tx_network_interface = network_interface;
             stream_down->tx_interface = network_interface->interface;
@@ -1843,7 +2003,9 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
                 *(uint64_t*)stream_down->config->ipv6_ldp_lookup_address)) {
                 stream_down->ldp_lookup = true;
             }
-            bbl_stream_add(stream_down);
+            if(!bbl_stream_add(stream_down)) {
+                return false;
+            }
             if(stream_down->session_traffic) {
                 g_ctx->stats.session_traffic_flows++;
                 session->session_traffic.flows++;
@@ -1857,7 +2019,9 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
         } else if(a10nsp_interface) {
             stream_down->tx_a10nsp_interface = a10nsp_interface;
             stream_down->tx_interface = a10nsp_interface->interface;
-            bbl_stream_add(stream_down);
+            if(!bbl_stream_add(stream_down)) {
+                return false;
+            }
             if(stream_down->session_traffic) {
                 g_ctx->stats.session_traffic_flows++;
                 session->session_traffic.flows++;
@@ -1872,6 +2036,8 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
             LOG(ERROR, "Failed to add stream %s (downstream) because of missing interface\n", config->name);
             return false;
         }
+        stream_down->session_next = session->streams.head;
+        session->streams.head = stream_down;
         if(stream_up && stream_down) {
             stream_up->reverse = stream_down;
             stream_down->reverse = stream_up;
@@ -1962,7 +2128,11 @@ bbl_stream_init() {
             }
 
             if(config->direction & BBL_DIRECTION_DOWN) {
-                stream = calloc(1, sizeof(bbl_stream_s));
+                stream = bbl_stream_new();
+                if(!stream) {
+                    LOG(ERROR, "Failed to add RAW stream %s because of memory allocation failure\n", config->name);
+                    return false;
+                }
                 stream->enabled = config->autostart;
                 stream->endpoint = &g_endpoint;
                 stream->flow_id = g_ctx->flow_id++;
@@ -1990,7 +2160,9 @@ bbl_stream_init() {
                 if(config->raw_tcp) {
                     stream->tcp = true;
                 }
-                bbl_stream_add(stream);
+                if(!bbl_stream_add(stream)) {
+                    return false;
+                }
                 if(stream->type == BBL_TYPE_MULTICAST) {
                     LOG(DEBUG, "RAW multicast traffic stream %s added to %s with %0.2lf PPS\n", 
                         config->name, network_interface->name, stream->pps);
@@ -2040,7 +2212,11 @@ bbl_stream_init() {
             config->ipv4_destination_address = group;
             config->ipv4_network_address = source;
 
-            stream = calloc(1, sizeof(bbl_stream_s));
+            stream = bbl_stream_new();
+            if(!stream) {
+                LOG_NOARG(ERROR, "Failed to add autogenerated multicast stream because of memory allocation failure\n");
+                return false;
+            }
             stream->enabled = true;
             stream->endpoint = &(g_ctx->multicast_endpoint);
             stream->flow_id = g_ctx->flow_id++;
@@ -2052,7 +2228,9 @@ bbl_stream_init() {
             stream->direction = BBL_DIRECTION_DOWN;
             stream->tx_network_interface = network_interface;
             stream->tx_interface = network_interface->interface;
-            bbl_stream_add(stream);
+            if(!bbl_stream_add(stream)) {
+                return false;
+            }
             LOG(DEBUG, "Autogenerated multicast traffic stream added to %s with %0.2lf PPS\n", 
                 network_interface->name, stream->pps);
         }
@@ -2182,8 +2360,12 @@ bbl_stream_reset(bbl_stream_s *stream)
     stream->reset_packets_rx = stream->rx_packets;
     stream->reset_loss = stream->rx_loss;
 
-    stream->rx_min_delay_us = 0;
-    stream->rx_max_delay_us = 0;
+    if(stream->rx_delay_histogram) {
+        bbl_histogram_flow_reset(stream->rx_delay_histogram);
+    }
+    if(stream->rx_loss_history) {
+        memset(stream->rx_loss_history, 0x0, sizeof(bbl_stream_loss_s));
+    }
     stream->rx_len = 0;
     stream->rx_fragments = 0;
     stream->rx_fragment_offset = 0;
@@ -2208,9 +2390,38 @@ bbl_stream_reset(bbl_stream_s *stream)
     stream->rate_packets_rx.avg_max = 0;
 
     stream->reset = true;
+    stream->rx_reset = true;
     stream->verified = false;
 }
 
+/**
+ * bbl_stream_update_pps
+ *
+ * Change the stream rate, which is applied by the TX thread
+ * owning the stream (see io_stream_update_pps). The update is
+ * signalled to the current and the migration target IO handle,
+ * because the owner changes while the stream is handed over
+ * to another TX thread.
+ *
+ * @param stream stream
+ * @param pps new rate
+ */
+void
+bbl_stream_update_pps(bbl_stream_s *stream, double pps)
+{
+    io_handle_s *io_target;
+
+    stream->pps = pps;
+    __atomic_store_n(&stream->update_pps, true, __ATOMIC_RELEASE);
+    io_target = __atomic_load_n(&stream->io_target, __ATOMIC_ACQUIRE);
+    if(io_target) {
+        io_target->update_streams = true;
+    }
+    if(stream->io) {
+        stream->io->update_streams = true;
+    }
+}
+
 const char *
 stream_type_string(bbl_stream_s *stream) {
     switch(stream->type) {
@@ -2264,6 +2475,14 @@ bbl_stream_rx(bbl_ethernet_header_s *eth, uint8_t *mac)
 
     stream = bbl_stream_index_get(bbl->flow_id);
     if(stream) {
+        if(unlikely(stream->rx_reset)) {
+            /* Delay values are written by the RX path only. */
+            stream->rx_reset = false;
+            stream->rx_min_delay_us = 0;
+            stream->rx_max_delay_us = 0;
+            stream->rx_jitter = 0;
+            stream->rx_last_transit = 0;
+        }
         flow_seq = bbl->flow_seq; 
         rx_last_seq = stream->rx_last_seq;
         if(rx_last_seq) {
@@ -2277,6 +2496,9 @@ bbl_stream_rx(bbl_ethernet_header_s *eth, uint8_t *mac)
                         LOG(LOSS, "LOSS Unicast flow: %lu seq: %lu last: %lu loss: %lu\n",
                             bbl->flow_id, flow_seq, rx_last_seq, loss);
                     }
+                    if(stream->rx_loss_history) {
+                        bbl_stream_loss_record(stream->rx_loss_history, loss, eth->timestamp.tv_sec);
+                    }
                 }
                 stream->rx_last_seq = flow_seq;
                 stream->rx_last_epoch = eth->timestamp.tv_sec;
@@ -2360,7 +2582,13 @@ bbl_stream_rx(bbl_ethernet_header_s *eth, uint8_t *mac)
             stream->rx_packets++;
         }
         if(g_ctx->config.stream_delay_calc) {
-            bbl_stream_delay(stream, &eth->timestamp, &bbl->timestamp);
+            if(g_ctx->config.io_timestamping) {
+                /* TX timestamps are taken from CLOCK_REALTIME 
+                 * to match kernel/NIC RX timestamps. */
+                bbl_stream_delay(stream, &eth->rx_timestamp, &bbl->timestamp);
+            } else {
+                bbl_stream_delay(stream, &eth->timestamp, &bbl->timestamp);
+            }
         }
         return stream;
     } else {
@@ -2468,6 +2696,110 @@ bbl_streams_enable_filter(bool enabled, int session_group_id,
     }
 }
 
+/**
+ * Get the clock source of RX timestamps used for the
+ * delay calculation (none means user space timestamps).
+ */
+static const char *
+bbl_stream_rx_timestamping(bbl_stream_s *stream)
+{
+    bbl_interface_s *interface = NULL;
+
+    if(stream->rx_access_interface) {
+        interface = stream->rx_access_interface->interface;
+    } else if(stream->rx_network_interface) {
+        interface = stream->rx_network_interface->interface;
+    } else if(stream->rx_a10nsp_interface) {
+        interface = stream->rx_a10nsp_interface->interface;
+    }
+    if(interface && interface->io.rx) {
+        return io_timestamping_string(interface->io.rx->timestamping);
+    }
+    return io_timestamping_string(g_ctx->config.io_timestamping);
+}
+
+static void
+bbl_stream_delay_json(bbl_stream_s *stream, json_t *root)
+{
+    bbl_histogram_s histogram;
+    if(stream->rx_delay_histogram && root) {
+        bbl_histogram_flow_copy(stream->rx_delay_histogram, &histogram);
+        bbl_histogram_json(&histogram, root, "rx-delay-us");
+        json_object_set_new(root, "rx-jitter-us", json_integer((stream->rx_jitter >> 4) / 1000));
+        json_object_set_new(root, "rx-timestamping", json_string(bbl_stream_rx_timestamping(stream)));
+    }
+}
+
+static void
+bbl_stream_loss_json(bbl_stream_s *stream, json_t *root)
+{
+    bbl_stream_loss_s *history = stream->rx_loss_history;
+    json_t *jobj, *jobj_array;
+    uint64_t bursts = 0;
+    __time_t epoch;
+
+    if(!(history && root)) {
+        return;
+    }
+
+    jobj_array = json_array();
+    for(uint8_t i = 0; i < BBL_STREAM_LOSS_BURST_BUCKETS; i++) {
+        if(!history->bursts[i]) continue;
+        bursts += history->bursts[i];
+        jobj = json_pack("{sI sI sI}",
+                         "min", 1ULL << i,
+                         "max", i < BBL_STREAM_LOSS_BURST_BUCKETS - 1 ? (2ULL << i) - 1 : history->burst_max,
+                         "bursts", (json_int_t)history->bursts[i]);
+        if(jobj) json_array_append_new(jobj_array, jobj);
+    }
+    json_object_set_new(root, "rx-loss-bursts", json_integer(bursts));
+    json_object_set_new(root, "rx-loss-burst-max", json_integer(history->burst_max));
+    json_object_set_new(root, "rx-loss-burst-histogram", jobj_array);
+
+    jobj_array = json_array();
+    if(history->epoch >= BBL_STREAM_LOSS_SECONDS) {
+        for(epoch = history->epoch - BBL_STREAM_LOSS_SECONDS + 1; epoch <= history->epoch; epoch++) {
+            if(!history->seconds[epoch % BBL_STREAM_LOSS_SECONDS]) continue;
+            jobj = json_pack("{sI sI}",
+                             "epoch", epoch,
+                             "loss", (json_int_t)history->seconds[epoch % BBL_STREAM_LOSS_SECONDS]);
+            if(jobj) json_array_append_new(jobj_array, jobj);
+        }
+    }
+    json_object_set_new(root, "rx-loss-history", jobj_array);
+}
+
+static json_t *
+bbl_stream_memory_json()
+{
+    bbl_interface_s *interface;
+    io_handle_s *io;
+    io_bucket_s *io_bucket;
+    uint64_t slot_bytes = 0;
+    uint64_t total_bytes;
+
+    CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+        io = interface->io.tx;
+        while(io) {
+            io_bucket = io->bucket_head;
+            while(io_bucket) {
+                slot_bytes += sizeof(io_bucket_s) + (io_bucket->slots_size * sizeof(io_stream_slot_s));
+                io_bucket = io_bucket->next;
+            }
+            io = io->next;
+        }
+    }
+    total_bytes = g_ctx->stream_arena.bytes_reserved + g_ctx->packet_arena.bytes_reserved + slot_bytes;
+
+    return json_pack("{sI sI sI sI sI sI}",
+        "streams", (json_int_t)g_ctx->streams,
+        "stream-bytes", (json_int_t)g_ctx->stream_arena.bytes_reserved,
+        "packet-bytes", (json_int_t)g_ctx->packet_arena.bytes_reserved,
+        "bucket-bytes", (json_int_t)slot_bytes,
+        "total-bytes", (json_int_t)total_bytes,
+        "bytes-per-stream", (json_int_t)(g_ctx->streams ? total_bytes / g_ctx->streams : 0));
+}
+
 static json_t *
 bbl_stream_summary_json(int session_group_id, const char *name, const char *interface, uint8_t direction)
 {
@@ -2503,6 +2835,7 @@ bbl_stream_summary_json(int session_group_id, const char *name, const char *inte
                 json_object_set_new(jobj, "session-id", json_integer(stream->session->session_id));
                 json_object_set_new(jobj, "session-traffic", json_boolean(stream->session_traffic));
             }
+            bbl_stream_delay_json(stream, jobj);
             json_array_append_new(jobj_array, jobj);
         }
 NEXT:
@@ -2612,6 +2945,9 @@ bbl_stream_json(bbl_stream_s *stream, bool debug)
             "rx-last-epoch", stream->rx_last_epoch
             );
 
+        bbl_stream_delay_json(stream, root);
+        bbl_stream_loss_json(stream, root);
+
         if(stream->rx_interface_changes) { 
             json_object_set_new(root, "rx-interface-changes", json_integer(stream->rx_interface_changes));
             json_object_set_new(root, "rx-interface-changed-epoch", json_integer(stream->rx_interface_changed_epoch));
@@ -2683,7 +3019,7 @@ bbl_stream_json(bbl_stream_s *stream, bool debug)
         json_object_set_new(root, "debug-tx-seq", json_integer(stream->flow_seq));
         json_object_set_new(root, "debug-max-packets", json_integer(stream->max_packets));
         json_object_set_new(root, "debug-tcp-flags", json_integer(stream->tcp_flags));
-        json_object_set_new(root, "debug-expired", json_integer(stream->expired));
+        json_object_set_new(root, "debug-tx-ready", json_boolean(stream->tx_ready));
     }
     return root;
 }
@@ -2780,10 +3116,11 @@ bbl_stream_ctrl_summary(int fd, uint32_t session_id __attribute__((unused)), jso
     json_unpack(arguments, "{s:s}", "name", &name);
     json_unpack(arguments, "{s:s}", "interface", &interface);
 
-    json_t *root = json_pack("{ss si so*}",
+    json_t *root = json_pack("{ss si so* so*}",
         "status", "ok",
         "code", 200,
-        "stream-summary", bbl_stream_summary_json(session_group_id, name, interface, direction));
+        "stream-summary", bbl_stream_summary_json(session_group_id, name, interface, direction),
+        "stream-memory", bbl_stream_memory_json());
 
     result = json_dumpfd(root, fd, 0);
     json_decref(root);
@@ -3029,9 +3366,7 @@ bbl_stream_ctrl_update(int fd, uint32_t session_id __attribute__((unused)), json
             stream->tcp_flags = tcp_flags;
         }
         if(pps) {
-            stream->update_pps = true;
-            stream->pps = pps;
-            stream->io->update_streams = true;
+            bbl_stream_update_pps(stream, pps);
         }
     } else {
         return bbl_ctrl_status(fd, "warning", 404, "stream not found");
@@ -9,6 +9,8 @@
 #ifndef __BBL_STREAM_H__
 #define __BBL_STREAM_H__
 
+#include "bbl_stream_stats.h"
+
 typedef enum {
     STREAM_STATE_ANY         = 0,
     STREAM_STATE_VERIFIED    = 1,
@@ -119,6 +121,7 @@ typedef struct bbl_stream_
     volatile bool enabled;
     volatile bool verified;
     volatile bool reset;
+    volatile bool rx_reset; /* reset RX delay with next packet received */
     volatile bool update_pps;
 
     bool threaded;
@@ -137,11 +140,16 @@ typedef struct bbl_stream_
     uint32_t ipv4_dst;
 
     double pps;
-    uint64_t expired;
 
     uint16_t tx_len; /* TX length */
     uint16_t tx_bbl_hdr_len; /* TX BBL HDR length */
-    uint8_t *tx_buf; /* TX buffer */
+    uint8_t *tx_buf; /* TX buffer (packet arena) */
+    bool tx_ready; /* TX buffer contains valid packet */
+    bool tx_changed; /* TX buffer rebuilt since last IO specific preparation */
+    bool tx_l4_offload; /* UDP checksum calculated by NIC (DPDK) */
+    uint8_t tx_l2_len; /* L2 header length for TX checksum offload */
+    uint8_t tx_l3_len; /* L3 header length for TX checksum offload */
+    void *tx_template; /* TX template mbuf without BBL header tail (DPDK) */
 
     uint8_t *ipv6_src;
     uint8_t *ipv6_dst;
@@ -149,7 +157,7 @@ typedef struct bbl_stream_
     bbl_stream_config_s *config;
 
     bbl_stream_s *next; /* Next stream (global) */
-    bbl_stream_s *io_next; /* Next stream of same IO bucket */
+    bbl_stream_s *io_next; /* Next stream handed over to IO handle */
     bbl_stream_s *group_next; /* Next stream of same group */
     bbl_stream_s *lag_next; /* Next stream of same LAG group */
     bbl_stream_s *session_next; /* Next stream of same session */
@@ -160,6 +168,7 @@ typedef struct bbl_stream_
     endpoint_state_t *endpoint;
 
     io_handle_s *io;
+    io_handle_s *volatile io_target; /* Migrate stream to this IO handle */
 
     bbl_access_interface_s *tx_access_interface;
     bbl_network_interface_s *tx_network_interface;
@@ -188,6 +197,10 @@ typedef struct bbl_stream_
 
     uint64_t rx_min_delay_us;
     uint64_t rx_max_delay_us;
+    bbl_histogram_flow_s *rx_delay_histogram; /* Allocated if stream delay histograms are enabled */
+    int64_t rx_jitter; /* RFC 3550 interarrival jitter (nsec scaled by 16) */
+    int64_t rx_last_transit; /* Last transit time (nsec) */
+    bbl_stream_loss_s *rx_loss_history; /* Allocated if stream loss calculation is enabled */
 
     uint16_t rx_len;
     uint64_t rx_first_seq;
@@ -253,6 +266,9 @@ bbl_stream_rx(bbl_ethernet_header_s *eth, uint8_t *mac);
 void
 bbl_stream_reset(bbl_stream_s *stream);
 
+void
+bbl_stream_update_pps(bbl_stream_s *stream, double pps);
+
 json_t *
 bbl_stream_json(bbl_stream_s *stream, bool debug);
 
@@ -292,4 +308,6 @@ bbl_stream_ctrl_stop_verified(int fd, uint32_t session_id, json_t *arguments);
 int
 bbl_stream_ctrl_update(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
 
+#include "bbl_stream_export.h"
+
 #endif
\ No newline at end of file
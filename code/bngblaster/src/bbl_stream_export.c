@@ -0,0 +1,235 @@
+/*
+ * BNG Blaster (BBL) - Binary Stream Export
+ *
+ * Fixed size packed stream records keyed by flow-id, 
+ * which are considerably faster to produce and consume 
+ * than the per stream JSON objects for large numbers 
+ * of streams. 
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bbl.h"
+#include "bbl_stream.h"
+#include <endian.h>
+#include <fcntl.h>
+
+#define FIELD(_name, _member, _type) \
+    { _name, offsetof(bbl_stream_export_record_s, _member), \
+      sizeof(((bbl_stream_export_record_s*)0)->_member), _type, 0 }
+
+static const bbl_stream_export_field_s g_export_fields[] = {
+    FIELD("flow-id", flow_id, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("tx-packets", tx_packets, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("tx-bytes", tx_bytes, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-packets", rx_packets, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-bytes", rx_bytes, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-loss", rx_loss, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-wrong-order", rx_wrong_order, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-first-seq", rx_first_seq, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-last-seq", rx_last_seq, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-delay-us-min", rx_delay_us_min, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-delay-us-max", rx_delay_us_max, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("tx-first-epoch", tx_first_epoch, BBL_STREAM_EXPORT_TYPE_SIGNED),
+    FIELD("rx-first-epoch", rx_first_epoch, BBL_STREAM_EXPORT_TYPE_SIGNED),
+    FIELD("rx-last-epoch", rx_last_epoch, BBL_STREAM_EXPORT_TYPE_SIGNED),
+    FIELD("tx-pps", tx_pps, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-pps", rx_pps, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("tx-len", tx_len, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("rx-len", rx_len, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("stream-group-id", stream_group_id, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("type", type, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("direction", direction, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+    FIELD("flags", flags, BBL_STREAM_EXPORT_TYPE_UNSIGNED),
+};
+
+#define EXPORT_FIELDS (sizeof(g_export_fields)/sizeof(g_export_fields[0]))
+
+static void
+bbl_stream_export_record(bbl_stream_s *stream, bbl_stream_export_record_s *record)
+{
+    uint64_t tx_packets = stream->tx_packets - stream->reset_packets_tx;
+    uint64_t rx_packets = stream->rx_packets - stream->reset_packets_rx;
+    uint8_t flags = 0;
+
+    if(stream->enabled) flags |= BBL_STREAM_EXPORT_FLAG_ENABLED;
+    if(*(stream->endpoint) == ENDPOINT_ACTIVE) flags |= BBL_STREAM_EXPORT_FLAG_ACTIVE;
+    if(stream->verified) flags |= BBL_STREAM_EXPORT_FLAG_VERIFIED;
+    if(stream->tcp) flags |= BBL_STREAM_EXPORT_FLAG_TCP;
+
+    record->flow_id = htole64(stream->flow_id);
+    record->tx_packets = htole64(tx_packets);
+    record->tx_bytes = htole64(tx_packets * stream->tx_len);
+    record->rx_packets = htole64(rx_packets);
+    record->rx_bytes = htole64(rx_packets * stream->rx_len);
+    record->rx_loss = htole64(stream->rx_loss - stream->reset_loss);
+    record->rx_wrong_order = htole64(stream->rx_wrong_order);
+    record->rx_first_seq = htole64(stream->rx_first_seq);
+    record->rx_last_seq = htole64(stream->rx_last_seq);
+    record->rx_delay_us_min = htole64(stream->rx_min_delay_us);
+    record->rx_delay_us_max = htole64(stream->rx_max_delay_us);
+    record->tx_first_epoch = htole64(stream->tx_first_epoch);
+    record->rx_first_epoch = htole64(stream->rx_first_epoch);
+    record->rx_last_epoch = htole64(stream->rx_last_epoch);
+    record->tx_pps = htole32(stream->rate_packets_tx.avg);
+    record->rx_pps = htole32(stream->rate_packets_rx.avg);
+    record->tx_len = htole16(stream->tx_len);
+    record->rx_len = htole16(stream->rx_len);
+    record->stream_group_id = htole16(stream->config->stream_group_id);
+    record->type = stream->type;
+    record->direction = stream->direction;
+    record->flags = flags;
+}
+
+/**
+ * Write all streams to binary export file.
+ *
+ * Symbolic links are never followed. With exclusive,
+ * the file must not exist, otherwise it is truncated.
+ *
+ * @param filename export file
+ * @param exclusive create new file only
+ * @param records number of records written (optional)
+ * @return true if successful
+ */
+bool
+bbl_stream_export(const char *filename, bool exclusive, uint64_t *records)
+{
+    bbl_stream_export_header_s header = {0};
+    bbl_stream_export_field_s field;
+    bbl_stream_export_record_s *chunk;
+    bbl_stream_s *stream;
+    uint64_t count = 0;
+    size_t len = 0;
+    size_t i;
+    FILE *file;
+    int flags = O_WRONLY|O_CREAT|O_NOFOLLOW|O_CLOEXEC;
+    int fd;
+
+    chunk = calloc(BBL_STREAM_EXPORT_CHUNK, sizeof(bbl_stream_export_record_s));
+    if(!chunk) {
+        return false;
+    }
+    flags |= exclusive ? O_EXCL : O_TRUNC;
+    fd = open(filename, flags, 0644);
+    file = fd < 0 ? NULL : fdopen(fd, "w");
+    if(!file) {
+        LOG(ERROR, "Failed to open stream export file %s (error %d)\n", filename, errno);
+        if(fd >= 0) close(fd);
+        free(chunk);
+        return false;
+    }
+
+    /* The number of records is updated after all records are written. */
+    memcpy(header.magic, BBL_STREAM_EXPORT_MAGIC, sizeof(BBL_STREAM_EXPORT_MAGIC));
+    header.version = htole16(BBL_STREAM_EXPORT_VERSION);
+    header.header_len = htole16(sizeof(header) + EXPORT_FIELDS * sizeof(field));
+    header.record_len = htole16(sizeof(bbl_stream_export_record_s));
+    header.fields = htole16(EXPORT_FIELDS);
+    header.timestamp = htole64(time(NULL));
+    if(fwrite(&header, sizeof(header), 1, file) != 1) {
+        goto ERROR;
+    }
+    for(i = 0; i < EXPORT_FIELDS; i++) {
+        field = g_export_fields[i];
+        field.offset = htole16(field.offset);
+        if(fwrite(&field, sizeof(field), 1, file) != 1) {
+            goto ERROR;
+        }
+    }
+
+    stream = g_ctx->stream_head;
+    while(stream) {
+        bbl_stream_export_record(stream, &chunk[len++]);
+        if(len == BBL_STREAM_EXPORT_CHUNK) {
+            if(fwrite(chunk, sizeof(bbl_stream_export_record_s), len, file) != len) {
+                goto ERROR;
+            }
+            count += len;
+            len = 0;
+        }
+        stream = stream->next;
+    }
+    if(len) {
+        if(fwrite(chunk, sizeof(bbl_stream_export_record_s), len, file) != len) {
+            goto ERROR;
+        }
+        count += len;
+    }
+
+    header.records = htole64(count);
+    if(fseek(file, 0, SEEK_SET) != 0 || 
+       fwrite(&header, sizeof(header), 1, file) != 1) {
+        goto ERROR;
+    }
+    if(fclose(file) != 0) {
+        LOG(ERROR, "Failed to write stream export file %s\n", filename);
+        free(chunk);
+        return false;
+    }
+    free(chunk);
+    if(records) *records = count;
+    return true;
+
+ERROR:
+    LOG(ERROR, "Failed to write stream export file %s\n", filename);
+    fclose(file);
+    free(chunk);
+    return false;
+}
+
+/**
+ * Write binary export file at the end of the test.
+ */
+void
+bbl_stream_export_final()
+{
+    if(!g_ctx->config.stream_export_filename) return;
+    bbl_stream_export(g_ctx->config.stream_export_filename, false, NULL);
+}
+
+/**
+ * Write binary export file via control socket. 
+ * 
+ * Any client connected to the control socket can 
+ * request this, so files are only created as new files 
+ * in the configured export directory. 
+ */
+int
+bbl_stream_ctrl_export(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
+{
+    int result = 0;
+    json_t *root;
+    const char *file = NULL;
+    char filename[PATH_MAX];
+    uint64_t records = 0;
+
+    if(!g_ctx->config.stream_export_directory) {
+        return bbl_ctrl_status(fd, "error", 403, "stream export directory not configured");
+    }
+    if(json_unpack(arguments, "{s:s}", "file", &file) != 0) {
+        return bbl_ctrl_status(fd, "error", 400, "missing file");
+    }
+    /* Only plain file names are accepted. */
+    if(!*file || strchr(file, '/') || strcmp(file, ".") == 0 || strcmp(file, "..") == 0) {
+        return bbl_ctrl_status(fd, "error", 400, "invalid file");
+    }
+    if(snprintf(filename, sizeof(filename), "%s/%s", 
+                g_ctx->config.stream_export_directory, file) >= (int)sizeof(filename)) {
+        return bbl_ctrl_status(fd, "error", 400, "invalid file");
+    }
+    if(!bbl_stream_export(filename, true, &records)) {
+        return bbl_ctrl_status(fd, "error", 500, "failed to write file");
+    }
+    root = json_pack("{ss si s{ss sI}}",
+                     "status", "ok",
+                     "code", 200,
+                     "stream-export",
+                     "file", filename,
+                     "records", records);
+    if(root) {
+        result = json_dumpfd(root, fd, 0);
+        json_decref(root);
+    }
+    return result;
+}
@@ -0,0 +1,84 @@
+/*
+ * BNG Blaster (BBL) - Binary Stream Export
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_STREAM_EXPORT_H__
+#define __BBL_STREAM_EXPORT_H__
+
+#define BBL_STREAM_EXPORT_MAGIC     "BBLSTRM"
+#define BBL_STREAM_EXPORT_VERSION   1
+#define BBL_STREAM_EXPORT_CHUNK     4096 /* records per write */
+
+#define BBL_STREAM_EXPORT_FLAG_ENABLED  0x01
+#define BBL_STREAM_EXPORT_FLAG_ACTIVE   0x02
+#define BBL_STREAM_EXPORT_FLAG_VERIFIED 0x04
+#define BBL_STREAM_EXPORT_FLAG_TCP      0x08
+
+#define BBL_STREAM_EXPORT_TYPE_UNSIGNED 0
+#define BBL_STREAM_EXPORT_TYPE_SIGNED   1
+
+/*
+ * The export file starts with a fixed header followed by
+ * a schema of field descriptors and all stream records. 
+ * All values are in little-endian byte order. 
+ *
+ * +--------+---------------------+---------------------+
+ * | header | field 1 ... field N | record 1 ... record M |
+ * +--------+---------------------+---------------------+
+ */
+typedef struct __attribute__((__packed__)) bbl_stream_export_header_ {
+    char magic[8];
+    uint16_t version;
+    uint16_t header_len; /* header and fields */
+    uint16_t record_len;
+    uint16_t fields;
+    uint64_t records;
+    uint64_t timestamp; /* epoch seconds */
+} bbl_stream_export_header_s;
+
+typedef struct __attribute__((__packed__)) bbl_stream_export_field_ {
+    char name[24];
+    uint16_t offset;
+    uint8_t len;
+    uint8_t type;
+    uint32_t reserved;
+} bbl_stream_export_field_s;
+
+typedef struct __attribute__((__packed__)) bbl_stream_export_record_ {
+    uint64_t flow_id;
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t rx_loss;
+    uint64_t rx_wrong_order;
+    uint64_t rx_first_seq;
+    uint64_t rx_last_seq;
+    uint64_t rx_delay_us_min;
+    uint64_t rx_delay_us_max;
+    int64_t tx_first_epoch;
+    int64_t rx_first_epoch;
+    int64_t rx_last_epoch;
+    uint32_t tx_pps;
+    uint32_t rx_pps;
+    uint16_t tx_len;
+    uint16_t rx_len;
+    uint16_t stream_group_id;
+    uint8_t type;
+    uint8_t direction;
+    uint8_t flags;
+    uint8_t reserved[7];
+} bbl_stream_export_record_s;
+
+bool
+bbl_stream_export(const char *filename, bool exclusive, uint64_t *records);
+
+void
+bbl_stream_export_final();
+
+int
+bbl_stream_ctrl_export(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
+
+#endif
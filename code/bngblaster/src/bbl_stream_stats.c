@@ -0,0 +1,70 @@
+/*
+ * BNG Blaster (BBL) - Stream RX Statistics
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <string.h>
+#include "bbl_stream_stats.h"
+
+/**
+ * bbl_stream_jitter
+ *
+ * RFC 3550 interarrival jitter (see appendix A.8),
+ * scaled by 16 to keep the fractional part.
+ *
+ * @param jitter jitter (nsec scaled by 16)
+ * @param last_transit last transit time (nsec) or zero
+ * @param transit transit time (nsec)
+ */
+void
+bbl_stream_jitter(int64_t *jitter, int64_t *last_transit, int64_t transit)
+{
+    int64_t d;
+
+    if(*last_transit) {
+        d = transit - *last_transit;
+        if(d < 0) d = -d;
+        *jitter += d - ((*jitter + 8) >> 4);
+    }
+    *last_transit = transit;
+}
+
+/**
+ * bbl_stream_loss_record
+ *
+ * Record loss burst (gap in sequence numbers)
+ * in loss burst histogram and per second history.
+ *
+ * @param history loss history
+ * @param loss packets lost (> 0)
+ * @param epoch RX epoch
+ */
+void
+bbl_stream_loss_record(bbl_stream_loss_s *history, uint64_t loss, __time_t epoch)
+{
+    uint8_t index = 63 - __builtin_clzll(loss);
+
+    if(index >= BBL_STREAM_LOSS_BURST_BUCKETS) {
+        index = BBL_STREAM_LOSS_BURST_BUCKETS - 1;
+    }
+    history->bursts[index]++;
+    if(loss > history->burst_max) {
+        history->burst_max = loss;
+    }
+
+    if(epoch > history->epoch) {
+        /* Clear all seconds without loss since last loss. */
+        if(epoch - history->epoch >= BBL_STREAM_LOSS_SECONDS) {
+            memset(history->seconds, 0x0, sizeof(history->seconds));
+        } else {
+            for(__time_t e = history->epoch + 1; e <= epoch; e++) {
+                history->seconds[e % BBL_STREAM_LOSS_SECONDS] = 0;
+            }
+        }
+        history->epoch = epoch;
+    } else if(history->epoch - epoch >= BBL_STREAM_LOSS_SECONDS) {
+        return;
+    }
+    history->seconds[epoch % BBL_STREAM_LOSS_SECONDS] += loss;
+}
@@ -0,0 +1,38 @@
+/*
+ * BNG Blaster (BBL) - Stream RX Statistics
+ *
+ * RFC 3550 interarrival jitter and loss burst
+ * tracking, kept free of other dependencies to
+ * allow unit testing.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_STREAM_STATS_H__
+#define __BBL_STREAM_STATS_H__
+
+#include <stdint.h>
+#include <time.h>
+
+#define BBL_STREAM_LOSS_BURST_BUCKETS   16 /* 1, 2-3, 4-7, ..., >= 32768 */
+#define BBL_STREAM_LOSS_SECONDS         64 /* Per second loss history */
+
+/**
+ * Stream loss burst histogram and per second loss
+ * history, which is written by the RX thread only.
+ */
+typedef struct bbl_stream_loss_
+{
+    uint32_t bursts[BBL_STREAM_LOSS_BURST_BUCKETS];
+    uint64_t burst_max; /* Max packets lost in a single gap */
+    __time_t epoch; /* Epoch of last loss */
+    uint32_t seconds[BBL_STREAM_LOSS_SECONDS];
+} bbl_stream_loss_s;
+
+void
+bbl_stream_jitter(int64_t *jitter, int64_t *last_transit, int64_t transit);
+
+void
+bbl_stream_loss_record(bbl_stream_loss_s *history, uint64_t loss, __time_t epoch);
+
+#endif
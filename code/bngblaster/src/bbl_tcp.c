@@ -153,26 +153,37 @@ err_t
 bbl_tcp_sent_cb(void *arg, struct tcp_pcb *tpcb, u16_t len)
 {
     bbl_tcp_ctx_s *tcpc = arg;
-    uint16_t tx;
+    uint32_t tx;
+    uint8_t flags;
     err_t result = ERR_OK;
 
-    UNUSED(len);
+    tcpc->bytes_tx += len;
 
     if(tcpc->tx.offset < tcpc->tx.len) {
-        tx = tcp_sndbuf(tpcb);
-        if(tx) {
-            if(tx > 4096) tx = 4096;
+        /* Hand over as much as possible from the application 
+         * buffer, limited by send buffer and send queue. */
+        while(tcpc->tx.offset < tcpc->tx.len) {
+            tx = tcp_sndbuf(tpcb);
+            if(!tx || tcp_sndqueuelen(tpcb) >= TCP_SND_QUEUELEN) {
+                result = ERR_MEM;
+                break;
+            }
+            if(tx > UINT16_MAX) tx = UINT16_MAX;
             if((tcpc->tx.offset + tx) > tcpc->tx.len) {
                 tx = tcpc->tx.len - tcpc->tx.offset;
             }
-            result = tcp_write(tpcb, tcpc->tx.buf + tcpc->tx.offset, tx, tcpc->tx.flags);
-            if(result == ERR_OK) {
-                tcpc->state = BBL_TCP_STATE_SENDING;
-                tcpc->tx.offset += tx;
+            flags = tcpc->tx.flags;
+            if((tcpc->tx.offset + tx) < tcpc->tx.len) {
+                flags |= TCP_WRITE_FLAG_MORE;
             }
-        } else {
-            result = ERR_MEM;
+            result = tcp_write(tpcb, tcpc->tx.buf + tcpc->tx.offset, tx, flags);
+            if(result != ERR_OK) {
+                break;
+            }
+            tcpc->state = BBL_TCP_STATE_SENDING;
+            tcpc->tx.offset += tx;
         }
+        tcp_output(tpcb);
     } else if(tcpc->pcb->unacked == NULL && tcpc->pcb->unsent == NULL) {
         /* Idle means that it is save to replace buffer. */
         tcpc->state = BBL_TCP_STATE_IDLE;
@@ -180,10 +191,6 @@ bbl_tcp_sent_cb(void *arg, struct tcp_pcb *tpcb, u16_t len)
             (tcpc->idle_cb)(tcpc->arg);
         }
     }
-
-    if(result == ERR_MEM) {
-        tcp_output(tpcb);
-    }
     return result;
 }
 
@@ -198,7 +205,7 @@ bbl_tcp_recv_cb(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
             if(tcpc->receive_cb) {
                 _p = p;
                 while(_p) {
-                    (tcpc->receive_cb)(tcpc->arg, p->payload, p->len);
+                    (tcpc->receive_cb)(tcpc->arg, _p->payload, _p->len);
                     _p = _p->next;
                 }
                 /* Signal application that read is finished. */
@@ -812,6 +819,26 @@ bbl_tcp_ipv6_connect_session(bbl_session_s *session, ipv6addr_t *src, ipv6addr_t
     return tcpc;
 }
 
+/**
+ * bbl_tcp_pbuf 
+ * 
+ * Received segments are copied as lwIP may 
+ * queue them (out of order queue).
+ * 
+ * @param payload received data
+ * @param len received data length
+ * @return pbuf or NULL
+ */
+static struct pbuf *
+bbl_tcp_pbuf(void *payload, uint16_t len)
+{
+    struct pbuf *pbuf = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+    if(pbuf) {
+        pbuf_take(pbuf, payload, len);
+    }
+    return pbuf;
+}
+
 /**
  * bbl_tcp_ipv4_rx 
  * 
@@ -845,7 +872,8 @@ bbl_tcp_ipv4_rx(bbl_network_interface_s *interface, bbl_ethernet_header_s *eth,
     ip_data.current_iphdr_src.type = IPADDR_TYPE_V4;
     ip_data.current_iphdr_src.u_addr.ip4.addr = ipv4->src;
 
-    pbuf = pbuf_alloc_reference(ipv4->payload, ipv4->payload_len, PBUF_ROM);
+    pbuf = bbl_tcp_pbuf(ipv4->payload, ipv4->payload_len);
+    if(!pbuf) return;
     tcp_input(pbuf, &interface->netif);
 }
 
@@ -882,7 +910,8 @@ bbl_tcp_ipv4_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
     ip_data.current_iphdr_src.type = IPADDR_TYPE_V4;
     ip_data.current_iphdr_src.u_addr.ip4.addr = ipv4->src;
 
-    pbuf = pbuf_alloc_reference(ipv4->payload, ipv4->payload_len, PBUF_ROM);
+    pbuf = bbl_tcp_pbuf(ipv4->payload, ipv4->payload_len);
+    if(!pbuf) return;
     tcp_input(pbuf, &session->netif);
 }
 
@@ -913,7 +942,8 @@ bbl_tcp_ipv6_rx(bbl_network_interface_s *interface, bbl_ethernet_header_s *eth,
         format_ipv6_address((ipv6addr_t*)ipv6->src), tcp->src);
 #endif
 
-    pbuf = pbuf_alloc_reference(ipv6->hdr, ipv6->len, PBUF_ROM);
+    pbuf = bbl_tcp_pbuf(ipv6->hdr, ipv6->len);
+    if(!pbuf) return;
     interface->netif.input(pbuf, &interface->netif);
 
     ip_data.current_netif = &interface->netif;
@@ -923,7 +953,8 @@ bbl_tcp_ipv6_rx(bbl_network_interface_s *interface, bbl_ethernet_header_s *eth,
     memcpy(&ip_data.current_iphdr_src.u_addr.ip6.addr, ipv6->src, sizeof(ip6_addr_t));
     ip_data.current_iphdr_src.type = IPADDR_TYPE_V6;
 
-    pbuf = pbuf_alloc_reference(ipv6->payload, ipv6->payload_len, PBUF_ROM);
+    pbuf = bbl_tcp_pbuf(ipv6->payload, ipv6->payload_len);
+    if(!pbuf) return;
     tcp_input(pbuf, &interface->netif);
 }
 
@@ -953,7 +984,8 @@ bbl_tcp_ipv6_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
         format_ipv6_address((ipv6addr_t*)ipv6->src), tcp->src);
 #endif
 
-    pbuf = pbuf_alloc_reference(ipv6->hdr, ipv6->len, PBUF_ROM);
+    pbuf = bbl_tcp_pbuf(ipv6->hdr, ipv6->len);
+    if(!pbuf) return;
     session->netif.input(pbuf, &session->netif);
 
     ip_data.current_netif = &session->netif;
@@ -963,7 +995,8 @@ bbl_tcp_ipv6_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
     memcpy(&ip_data.current_iphdr_src.u_addr.ip6.addr, ipv6->src, sizeof(ip6_addr_t));
     ip_data.current_iphdr_src.type = IPADDR_TYPE_V6;
 
-    pbuf = pbuf_alloc_reference(ipv6->payload, ipv6->payload_len, PBUF_ROM);
+    pbuf = bbl_tcp_pbuf(ipv6->payload, ipv6->payload_len);
+    if(!pbuf) return;
     tcp_input(pbuf, &session->netif);
 }
 
@@ -7,133 +7,376 @@
  * Copyright (C) 2020-2025, RtBrick, Inc.
  * SPDX-License-Identifier: BSD-3-Clause
  */
-#include "bbl.h"
-#include "bbl_session.h"
+#include "bbl_def.h"
+#include "bbl_protocols.h"
+#include <stdatomic.h>
+#include "bbl_txq.h"
 
+#define BBL_TXQ_SLOT_MAX_LEN BBL_TXQ_SLOT_LEN(BBL_TXQ_BUFFER_LEN)
+#define BBL_TXQ_SLOT_LEN(_len) \
+    ((sizeof(bbl_txq_slot_t) + (_len) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1))
+
+/**
+ * @brief Init TXQ ring buffer. 
+ *
+ * The TXQ is a multi-producer/single-consumer ring 
+ * buffer with variable length slots. Producers reserve 
+ * a slot of maximum length using compare and swap and 
+ * publish their slot by setting its ready flag without
+ * waiting for other producers. The consumer reads slots
+ * in the order of reservation and stops at the first
+ * slot not ready. Only the actual packet length is 
+ * consumed if no other producer has reserved a slot in 
+ * the meantime, which is always true for a single producer.
+ *
+ * A slot header may start at any cache line of the ring,
+ * therefore the ready flag is the first member and the 
+ * first word of every cache line which is not a ready 
+ * slot is kept zero.
+ *
+ * @param txq TXQ
+ * @param slots number of average sized slots
+ * @return true if successful
+ */
 bool
-bbl_txq_init(bbl_txq_s *txq, uint16_t size)
+bbl_txq_init(bbl_txq_s *txq, uint32_t slots)
 {
-    txq->ring = calloc(1, size * sizeof(bbl_txq_slot_t));
+    uint64_t size = (uint64_t)slots * BBL_TXQ_SLOT_AVG_LEN;
+
+    if(size < 4 * BBL_TXQ_SLOT_MAX_LEN) {
+        size = 4 * BBL_TXQ_SLOT_MAX_LEN;
+    }
+    if(size > UINT32_MAX - BBL_TXQ_SLOT_MAX_LEN) {
+        return false;
+    }
+    txq->ring = aligned_alloc(CACHE_LINE_SIZE, size);
     if(!txq->ring) {
         return false;
     }
-    txq->size   = size;
-    txq->read   = 0;
-    txq->write  = 0;
-    txq->next   = 1;
+    memset(txq->ring, 0x0, size);
+    txq->size = size;
+    atomic_init(&txq->read, 0);
+    atomic_init(&txq->reserve, 0);
+    atomic_init(&txq->stats.full, 0);
+    atomic_init(&txq->stats.encode_error, 0);
     return true;
 }
 
-bool
-bbl_txq_is_empty(bbl_txq_s *txq)
+static inline bbl_txq_slot_t *
+bbl_txq_slot(bbl_txq_s *txq, uint32_t offset)
 {
-    if(txq->read == txq->write) {
-        return true;
+    return (bbl_txq_slot_t*)(txq->ring + offset);
+}
+
+static inline uint32_t
+bbl_txq_offset(bbl_txq_s *txq, bbl_txq_slot_t *slot)
+{
+    return (uint8_t*)slot - txq->ring;
+}
+
+/**
+ * @brief Clear ready flags of all cache lines
+ * in the given range.
+ *
+ * @param txq TXQ
+ * @param start start of range
+ * @param len length of range
+ */
+static inline void
+bbl_txq_clear(bbl_txq_s *txq, uint32_t start, uint32_t len)
+{
+    for(uint32_t offset = start; offset < start + len; offset += CACHE_LINE_SIZE) {
+        atomic_store_explicit(&bbl_txq_slot(txq, offset)->ready, 0, memory_order_relaxed);
     }
-    return false;
 }
 
-bool
-bbl_txq_is_full(bbl_txq_s *txq)
+/**
+ * @brief Get start of next slot of maximum length 
+ * after prev, which is the end of reserved slots.
+ *
+ * Read and the end of reserved slots are never 
+ * equal after a slot is reserved, because this 
+ * state indicates an empty ring buffer.
+ *
+ * @param txq TXQ
+ * @param prev end of reserved slots
+ * @param read current read slot
+ * @param start start of next slot
+ * @return false if full
+ */
+static inline bool
+bbl_txq_next(bbl_txq_s *txq, uint32_t prev, uint32_t read, uint32_t *start)
 {
-    if(txq->read == txq->next) {
+    if(prev >= read) {
+        if(txq->size - prev > BBL_TXQ_SLOT_MAX_LEN) {
+            *start = prev;
+            return true;
+        }
+        if(read > BBL_TXQ_SLOT_MAX_LEN) {
+            *start = 0;
+            return true;
+        }
+    } else if(read - prev > BBL_TXQ_SLOT_MAX_LEN) {
+        *start = prev;
         return true;
     }
     return false;
 }
 
+#define BBL_TXQ_RESERVE(_seq, _offset) (((uint64_t)(_seq) << 32) | (_offset))
+#define BBL_TXQ_RESERVE_SEQ(_reserve) ((uint32_t)((_reserve) >> 32))
+#define BBL_TXQ_RESERVE_OFFSET(_reserve) ((uint32_t)(_reserve))
+
 /**
- * @brief Receive packet from TXQ 
- * and copy to target buffer (buf).
+ * @brief Reserve a slot of maximum length.
+ *
+ * The sequence number is incremented with every change 
+ * of the reservation, such that a successful compare 
+ * and swap guarantees that no other producer has 
+ * changed the reservation in the meantime (ABA). 
+ * Released space (see bbl_txq_reserve_end) is 
+ * acquired with the reservation.
  *
  * @param txq TXQ
- * @param buf target buffer
- * @return number of bytes copied
+ * @return slot or NULL if full
  */
-uint16_t
-bbl_txq_from_buffer(bbl_txq_s *txq, uint8_t *buf)
+static bbl_txq_slot_t *
+bbl_txq_reserve(bbl_txq_s *txq)
 {
     bbl_txq_slot_t *slot;
+    uint64_t reserve = atomic_load_explicit(&txq->reserve, memory_order_relaxed);
+    uint32_t read;
+    uint32_t start;
 
-    if(txq->read == txq->write) {
-        /* Empty! */
-        return 0;
-    }
+    do {
+        read = atomic_load_explicit(&txq->read, memory_order_acquire);
+        if(!bbl_txq_next(txq, BBL_TXQ_RESERVE_OFFSET(reserve), read, &start)) {
+            return NULL;
+        }
+    } while(!atomic_compare_exchange_weak_explicit(&txq->reserve, &reserve, 
+                BBL_TXQ_RESERVE(BBL_TXQ_RESERVE_SEQ(reserve) + 1, start + BBL_TXQ_SLOT_MAX_LEN),
+                memory_order_acquire, memory_order_relaxed));
 
-    slot = txq->ring + txq->read;
-    memcpy(buf, slot->packet, slot->packet_len);
+    slot = bbl_txq_slot(txq, start);
+    slot->prev = BBL_TXQ_RESERVE_OFFSET(reserve);
+    slot->seq = BBL_TXQ_RESERVE_SEQ(reserve) + 1;
+    slot->slot_len = BBL_TXQ_SLOT_MAX_LEN;
+    return slot;
+}
 
-    txq->read++;
-    if(txq->read == txq->size) {
-        txq->read = 0;
-    }
-    return slot->packet_len;
+/**
+ * @brief Change the end of the reservation 
+ * if no further slot is reserved.
+ *
+ * @param txq TXQ
+ * @param slot last reserved slot
+ * @param offset new end of reserved slots
+ * @return true if successful
+ */
+static bool
+bbl_txq_reserve_end(bbl_txq_s *txq, bbl_txq_slot_t *slot, uint32_t offset)
+{
+    uint64_t reserve = BBL_TXQ_RESERVE(slot->seq, bbl_txq_offset(txq, slot) + BBL_TXQ_SLOT_MAX_LEN);
+    return atomic_compare_exchange_strong_explicit(&txq->reserve, &reserve, 
+                BBL_TXQ_RESERVE(slot->seq + 1, offset),
+                memory_order_release, memory_order_relaxed);
 }
 
 /**
- * @brief Encode packet to TXQ.
+ * @brief Publish reserved slot.
+ *
+ * Previously reserved slots may still be pending, 
+ * in which case the consumer waits for them before 
+ * reading this slot.
  *
  * @param txq TXQ
- * @param eth ethernet structure
- * @return bbl_txq_result_t
+ * @param slot reserved slot
  */
-bbl_txq_result_t
-bbl_txq_to_buffer(bbl_txq_s *txq, bbl_ethernet_header_s *eth)
+static void
+bbl_txq_commit(bbl_txq_s *txq, bbl_txq_slot_t *slot)
 {
-    bbl_txq_slot_t *slot;
+    bbl_txq_slot_t *wrap;
+    uint32_t start = bbl_txq_offset(txq, slot);
+    uint32_t len;
 
-    if(txq->read == txq->next) {
-        txq->stats.full++;
-        return BBL_TXQ_FULL;
-    }
-    slot = txq->ring + txq->write;
-    slot->packet_len = 0;
-    if(encode_ethernet(slot->packet, &slot->packet_len, eth) == PROTOCOL_SUCCESS) {
-        txq->write = txq->next++;
-        if(txq->next == txq->size) {
-            txq->next = 0;
+    if(slot->packet_len != BBL_TXQ_SLOT_SKIP) {
+        len = BBL_TXQ_SLOT_LEN(slot->packet_len);
+        if(len < BBL_TXQ_SLOT_MAX_LEN && bbl_txq_reserve_end(txq, slot, start + len)) {
+            /* No further slot reserved, release unused space. */
+            slot->slot_len = len;
         }
-        return BBL_TXQ_OK;
-    } else {
-        txq->stats.encode_error++;
-        return BBL_TXQ_ENCODE_ERROR;
     }
+    if(start != slot->prev) {
+        /* Tell the consumer to continue at the start of the ring. */
+        wrap = bbl_txq_slot(txq, slot->prev);
+        wrap->packet_len = BBL_TXQ_SLOT_WRAP;
+        wrap->slot_len = txq->size - slot->prev;
+        atomic_store_explicit(&wrap->ready, 1, memory_order_release);
+    }
+    atomic_store_explicit(&slot->ready, 1, memory_order_release);
+}
+
+bool
+bbl_txq_is_empty(bbl_txq_s *txq)
+{
+    uint32_t read = atomic_load_explicit(&txq->read, memory_order_relaxed);
+    if(atomic_load_explicit(&bbl_txq_slot(txq, read)->ready, memory_order_acquire)) {
+        return false;
+    }
+    return true;
+}
+
+bool
+bbl_txq_is_full(bbl_txq_s *txq)
+{
+    uint32_t start;
+    return !bbl_txq_next(txq, 
+        BBL_TXQ_RESERVE_OFFSET(atomic_load_explicit(&txq->reserve, memory_order_relaxed)),
+        atomic_load_explicit(&txq->read, memory_order_acquire), &start);
 }
 
+/**
+ * @brief Get next slot to read (consumer only), 
+ * skipping cancelled slots.
+ *
+ * @param txq TXQ
+ * @return slot or NULL if empty or next slot 
+ * is not ready
+ */
 bbl_txq_slot_t *
 bbl_txq_read_slot(bbl_txq_s *txq)
 {
-    if(txq->read == txq->write) {
-        return NULL;
+    bbl_txq_slot_t *slot;
+    uint32_t read = atomic_load_explicit(&txq->read, memory_order_relaxed);
+
+    while(true) {
+        slot = bbl_txq_slot(txq, read);
+        if(!atomic_load_explicit(&slot->ready, memory_order_acquire)) {
+            return NULL;
+        }
+        if(slot->packet_len != BBL_TXQ_SLOT_WRAP && 
+           slot->packet_len != BBL_TXQ_SLOT_SKIP) {
+            return slot;
+        }
+        bbl_txq_read_next(txq);
+        read = atomic_load_explicit(&txq->read, memory_order_relaxed);
     }
-    return txq->ring + txq->read;
 }
 
+/**
+ * @brief Release current read slot (consumer only).
+ *
+ * @param txq TXQ
+ */
 void
 bbl_txq_read_next(bbl_txq_s *txq) 
 {
-    txq->read++;
-    if(txq->read == txq->size) {
-        txq->read = 0;
+    uint32_t read = atomic_load_explicit(&txq->read, memory_order_relaxed);
+    uint32_t len = bbl_txq_slot(txq, read)->slot_len;
+
+    bbl_txq_clear(txq, read, len);
+    read += len;
+    if(read == txq->size) {
+        read = 0;
     }
+    atomic_store_explicit(&txq->read, read, memory_order_release);
 }
 
+/**
+ * @brief Reserve slot of maximum length, which 
+ * must be either published with bbl_txq_write_next 
+ * or released with bbl_txq_write_cancel. 
+ *
+ * @param txq TXQ
+ * @return slot or NULL if full
+ */
 bbl_txq_slot_t *
 bbl_txq_write_slot(bbl_txq_s *txq)
 {
-    if(txq->read == txq->next) {
-        txq->stats.full++;
-        return NULL;
+    bbl_txq_slot_t *slot = bbl_txq_reserve(txq);
+    if(!slot) {
+        atomic_fetch_add_explicit(&txq->stats.full, 1, memory_order_relaxed);
     }
+    return slot;
+}
 
-    return txq->ring + txq->write;
+void
+bbl_txq_write_next(bbl_txq_s *txq, bbl_txq_slot_t *slot) 
+{
+    bbl_txq_commit(txq, slot);
 }
 
+/**
+ * @brief Release reserved slot without 
+ * publishing a packet.
+ *
+ * @param txq TXQ
+ * @param slot reserved slot
+ */
 void
-bbl_txq_write_next(bbl_txq_s *txq) 
+bbl_txq_write_cancel(bbl_txq_s *txq, bbl_txq_slot_t *slot) 
 {
-    txq->write = txq->next++;
-    if(txq->next == txq->size) {
-        txq->next = 0;
+    uint32_t start = bbl_txq_offset(txq, slot);
+
+    /* The packet might be partially written, 
+     * which must not leave ready flags behind 
+     * if the reservation is undone. */
+    bbl_txq_clear(txq, start + CACHE_LINE_SIZE, BBL_TXQ_SLOT_MAX_LEN - CACHE_LINE_SIZE);
+    if(bbl_txq_reserve_end(txq, slot, slot->prev)) {
+        /* No further slot reserved, undo reservation. */
+        return;
     }
-}
\ No newline at end of file
+    slot->packet_len = BBL_TXQ_SLOT_SKIP;
+    bbl_txq_commit(txq, slot);
+}
+
+/**
+ * @brief Receive packet from TXQ 
+ * and copy to target buffer (buf).
+ *
+ * @param txq TXQ
+ * @param buf target buffer
+ * @return number of bytes copied
+ */
+uint16_t
+bbl_txq_from_buffer(bbl_txq_s *txq, uint8_t *buf)
+{
+    bbl_txq_slot_t *slot;
+    uint16_t len;
+
+    slot = bbl_txq_read_slot(txq);
+    if(!slot) {
+        /* Empty! */
+        return 0;
+    }
+    len = slot->packet_len;
+    memcpy(buf, slot->packet, len);
+    bbl_txq_read_next(txq);
+    return len;
+}
+
+/**
+ * @brief Encode packet to TXQ.
+ *
+ * @param txq TXQ
+ * @param eth ethernet structure
+ * @return bbl_txq_result_t
+ */
+bbl_txq_result_t
+bbl_txq_to_buffer(bbl_txq_s *txq, bbl_ethernet_header_s *eth)
+{
+    bbl_txq_slot_t *slot = bbl_txq_write_slot(txq);
+
+    if(!slot) {
+        return BBL_TXQ_FULL;
+    }
+    slot->packet_len = 0;
+    if(encode_ethernet(slot->packet, &slot->packet_len, eth) == PROTOCOL_SUCCESS) {
+        bbl_txq_commit(txq, slot);
+        return BBL_TXQ_OK;
+    } else {
+        bbl_txq_write_cancel(txq, slot);
+        atomic_fetch_add_explicit(&txq->stats.encode_error, 1, memory_order_relaxed);
+        return BBL_TXQ_ENCODE_ERROR;
+    }
+}
@@ -16,6 +16,13 @@
 #define BBL_TXQ_DEFAULT_SIZE 4096
 #define BBL_TXQ_BUFFER_LEN 4074
 
+/* Ring buffer bytes per slot. Slots are variable length
+ * (header and packet aligned to cache line), so the ring
+ * holds more small packets (e.g. ARP, LACP) than slots. */
+#define BBL_TXQ_SLOT_AVG_LEN 2048
+#define BBL_TXQ_SLOT_WRAP UINT16_MAX
+#define BBL_TXQ_SLOT_SKIP (UINT16_MAX-1)
+
 typedef enum bbl_ring_result_ {
     BBL_TXQ_OK = 0,
     BBL_TXQ_ENCODE_ERROR,
@@ -23,33 +30,38 @@ typedef enum bbl_ring_result_ {
 } bbl_txq_result_t;
 
 typedef struct bbl_txq_slot_ {
+    atomic_uint_least32_t ready; /* slot published (must be first) */
     struct timespec timestamp;
+    struct timespec rx_timestamp;
+    uint32_t prev; /* end of previous slot (producer only) */
+    uint32_t seq; /* reservation sequence number (producer only) */
+    uint32_t slot_len; /* offset to next slot */
     uint16_t vlan_tci;
     uint16_t vlan_tpid;
-    uint16_t packet_len;
-    uint8_t packet[BBL_TXQ_BUFFER_LEN];
+    uint16_t packet_len; /* BBL_TXQ_SLOT_WRAP to continue at start of ring, 
+                          * BBL_TXQ_SLOT_SKIP for cancelled slots */
+    uint8_t packet[];
 } bbl_txq_slot_t;
 
 typedef struct bbl_txq_ {
-    bbl_txq_slot_t *ring; /* ring buffer */
-    uint16_t size; /* number of send slots */
+    uint8_t *ring; /* ring buffer */
+    uint32_t size; /* ring buffer size in bytes */
 
     char _pad0 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
 
-    atomic_uint_least16_t write; /* current write slot */
-    atomic_uint_least16_t next; /* next write slot */
+    atomic_uint_least64_t reserve; /* end of reserved slots (low) and sequence number (high) */
     struct {
-        uint32_t full; 
-        uint32_t encode_error;
+        atomic_uint_least32_t full; 
+        atomic_uint_least32_t encode_error;
     } stats;
 
     char _pad1 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
 
-    atomic_uint_least16_t read; /* current read slot */
+    atomic_uint_least32_t read; /* current read slot */
 } bbl_txq_s;
 
 bool
-bbl_txq_init(bbl_txq_s *txq, uint16_t slots);
+bbl_txq_init(bbl_txq_s *txq, uint32_t slots);
 
 bool
 bbl_txq_is_empty(bbl_txq_s *txq);
@@ -73,6 +85,9 @@ bbl_txq_slot_t *
 bbl_txq_write_slot(bbl_txq_s *txq);
 
 void
-bbl_txq_write_next(bbl_txq_s *txq);
+bbl_txq_write_next(bbl_txq_s *txq, bbl_txq_slot_t *slot);
+
+void
+bbl_txq_write_cancel(bbl_txq_s *txq, bbl_txq_slot_t *slot);
 
 #endif
\ No newline at end of file
@@ -72,7 +72,7 @@ bgp_init()
 
         /* Init RAW update file */
         if(config->raw_update_file) {
-            session->raw_update_start = bgp_raw_update_load(config->raw_update_file, true);
+            session->raw_update_start = bgp_raw_update_load(config->raw_update_file);
             if(!session->raw_update_start) {
                 return false;
             }
@@ -130,4 +130,56 @@ bgp_teardown()
         }
         session = session->next;
     }
+}
+
+/**
+ * bgp_raw_update_load 
+ * 
+ * @param file update file
+ * @return BGP RAW update structure
+ */
+bgp_raw_update_s *
+bgp_raw_update_load(const char *file)
+{
+    bgp_raw_update_s *raw_update = g_ctx->bgp_raw_updates;
+
+    /* Check if file is already loaded */
+    while(raw_update){
+        if(strcmp(file, raw_update->file) == 0) {
+            return raw_update;
+        }
+        raw_update = raw_update->next;
+    }
+    raw_update = bgp_raw_update_open(file);
+    if(raw_update) {
+        raw_update->next = g_ctx->bgp_raw_updates;
+        g_ctx->bgp_raw_updates = raw_update;
+        return raw_update;
+    } else {
+        return NULL;
+    }
+}
+
+/**
+ * bgp_raw_update_unload 
+ * 
+ * Remove file from the list of loaded
+ * files and release the file mapping.
+ * 
+ * @param raw_update BGP RAW update structure
+ */
+void
+bgp_raw_update_unload(bgp_raw_update_s *raw_update)
+{
+    bgp_raw_update_s **prev = &g_ctx->bgp_raw_updates;
+
+    while(*prev) {
+        if(*prev == raw_update) {
+            *prev = raw_update->next;
+            break;
+        }
+        prev = &(*prev)->next;
+    }
+    LOG(INFO, "Unloaded BGP RAW update file %s\n", raw_update->file);
+    bgp_raw_update_close(raw_update);
 }
\ No newline at end of file
@@ -15,6 +15,8 @@
 #include "bgp_message.h"
 #include "bgp_receive.h"
 #include "bgp_raw_update.h"
+#include "bgp_rib.h"
+#include "bgp_generator.h"
 #include "bgp_ctrl.h"
 
 bool
@@ -12,7 +12,7 @@
 static const char *
 raw_update_state(bgp_session_s *session) 
 {
-    if(session->raw_update) {
+    if(session->raw_update || session->config->generator) {
         if(session->update_start_timestamp.tv_sec) {
             if(session->raw_update_sending) {
                 return "sending";
@@ -27,13 +27,73 @@ raw_update_state(bgp_session_s *session)
     return NULL;
 }
 
+static json_int_t
+bgp_ctrl_rib_ms(struct timespec *timestamp, struct timespec *reference)
+{
+    struct timespec time_diff;
+    timespec_sub(&time_diff, timestamp, reference);
+    return time_diff.tv_sec * 1000 + time_diff.tv_nsec / 1000000;
+}
+
+/**
+ * bgp_ctrl_rib_json
+ *
+ * @param rib Adj-RIB-In
+ * @param reference timestamps are reported
+ *        in milliseconds relative to reference
+ * @return json object
+ */
+static json_t *
+bgp_ctrl_rib_json(bgp_rib_s *rib, struct timespec *reference)
+{
+    json_t *root, *eor;
+    struct timespec time_diff;
+    double seconds;
+    uint8_t family;
+
+    root = json_pack("{si sI sI si}",
+                     "prefixes", rib->count,
+                     "announced", rib->announced,
+                     "withdrawn", rib->withdrawn,
+                     "errors", rib->errors);
+    if(!root) {
+        return NULL;
+    }
+    for(family = 0; family < BGP_RIB_FAMILY_MAX; family++) {
+        json_object_set_new(root, bgp_rib_family_string(family), json_integer(rib->family_count[family]));
+    }
+    if(rib->first_prefix_timestamp.tv_sec) {
+        json_object_set_new(root, "first-prefix-ms", json_integer(bgp_ctrl_rib_ms(&rib->first_prefix_timestamp, reference)));
+        json_object_set_new(root, "last-prefix-ms", json_integer(bgp_ctrl_rib_ms(&rib->last_prefix_timestamp, reference)));
+        timespec_sub(&time_diff, &rib->last_prefix_timestamp, &rib->first_prefix_timestamp);
+        seconds = time_diff.tv_sec + (double)time_diff.tv_nsec / 1e9;
+        if(seconds > 0) {
+            json_object_set_new(root, "prefixes-per-second", json_real((rib->announced + rib->withdrawn) / seconds));
+        }
+    }
+    if(rib->eor) {
+        eor = json_array();
+        for(family = 0; family < BGP_RIB_FAMILY_MAX; family++) {
+            if(rib->eor & bgp_rib_family_flag(family)) {
+                json_array_append_new(eor, json_string(bgp_rib_family_string(family)));
+            }
+        }
+        json_object_set_new(root, "eor", eor);
+        json_object_set_new(root, "eor-ms", json_integer(bgp_ctrl_rib_ms(&rib->eor_timestamp, reference)));
+    }
+    return root;
+}
+
 static json_t *
 bgp_ctrl_session_json(bgp_session_s *session)
 {
     json_t *root = NULL;
     json_t *stats = NULL;
+    json_t *adj_rib_in = NULL;
     
     const char *raw_update_file = NULL;
+    uint64_t duration_us;
+    double goodput_mbps = 0;
 
     if(!session) {
         return NULL;
@@ -43,6 +103,12 @@ bgp_ctrl_session_json(bgp_session_s *session)
         raw_update_file = session->raw_update->file;
     }
 
+    /* Time to drain and achieved goodput of last raw update. */
+    duration_us = session->update_duration.tv_sec * 1000000 + session->update_duration.tv_nsec / 1000;
+    if(duration_us) {
+        goodput_mbps = (double)session->update_bytes * 8 / duration_us;
+    }
+
     stats = json_pack("{si si si si si si}",
                       "messages-rx", session->stats.message_rx,
                       "messages-tx", session->stats.message_tx,
@@ -55,7 +121,9 @@ bgp_ctrl_session_json(bgp_session_s *session)
         return NULL;
     }
 
-    root = json_pack("{ss ss ss si si ss ss si si ss ss* ss* si si si so*}",
+    adj_rib_in = bgp_ctrl_rib_json(&session->adj_rib_in, &session->established_timestamp);
+
+    root = json_pack("{ss ss ss si si ss ss si si ss ss* ss* si si si sI si sf so* so*}",
                      "interface", session->interface->name,
                      "local-address", session->local_address_str,
                      "local-id", format_ipv4_address(&session->config->id),
@@ -71,10 +139,22 @@ bgp_ctrl_session_json(bgp_session_s *session)
                      "raw-update-start-epoch", session->update_start_timestamp.tv_sec,
                      "raw-update-stop-epoch", session->update_stop_timestamp.tv_sec,
                      "raw-update-duration", session->update_duration.tv_sec,
-                     "stats", stats);
+                     "raw-update-duration-ms", duration_us / 1000,
+                     "raw-update-bytes", session->update_bytes,
+                     "raw-update-goodput-mbps", goodput_mbps,
+                     "stats", stats,
+                     "adj-rib-in", adj_rib_in);
 
     if(!root) {
         if(stats) json_decref(stats);
+        if(adj_rib_in) json_decref(adj_rib_in);
+        return NULL;
+    }
+    if(session->config->generator) {
+        json_object_set_new(root, "update-generator", json_pack("{si si si}",
+                            "prefixes", session->generator.prefixes,
+                            "updates", session->generator.updates,
+                            "prefixes-per-update", session->generator.nlri_max));
     }
     return root;
 }
@@ -177,7 +257,7 @@ bgp_ctrl_raw_update(int fd, uint32_t session_id __attribute__((unused)), json_t
     }
 
     /* Load file. */
-    raw_update = bgp_raw_update_load(file_path, true);
+    raw_update = bgp_raw_update_load(file_path);
     if(!raw_update) {
         return bbl_ctrl_status(fd, "error", 400, "failed to load file");
     }
@@ -237,9 +317,10 @@ bgp_ctrl_raw_update_list(int fd, uint32_t session_id __attribute__((unused)), js
     updates = json_array();
 
     while(raw_update){
-        update = json_pack("{ss* si si}",
+        update = json_pack("{ss* si si si}",
                            "file", raw_update->file,
                            "len", raw_update->len,
+                           "validated", raw_update->validated,
                            "updates", raw_update->updates);
         if(update) {
             json_array_append_new(updates, update);
@@ -260,6 +341,40 @@ bgp_ctrl_raw_update_list(int fd, uint32_t session_id __attribute__((unused)), js
     return result;
 }
 
+int
+bgp_ctrl_raw_update_unload(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
+{
+    bgp_session_s *bgp_session = g_ctx->bgp_sessions;
+    bgp_raw_update_s *raw_update = g_ctx->bgp_raw_updates;
+    const char *file_path;
+
+    /* Unpack further arguments */
+    if(json_unpack(arguments, "{s:s}", "file", &file_path) != 0) {
+        return bbl_ctrl_status(fd, "error", 400, "missing argument file");
+    }
+
+    while(raw_update) {
+        if(strcmp(file_path, raw_update->file) == 0) {
+            break;
+        }
+        raw_update = raw_update->next;
+    }
+    if(!raw_update) {
+        return bbl_ctrl_status(fd, "error", 404, "file not loaded");
+    }
+
+    /* Files referenced by any session can't be unloaded. */
+    while(bgp_session) {
+        if(bgp_session->raw_update == raw_update ||
+           bgp_session->raw_update_start == raw_update) {
+            return bbl_ctrl_status(fd, "error", 409, "file in use");
+        }
+        bgp_session = bgp_session->next;
+    }
+    bgp_raw_update_unload(raw_update);
+    return bbl_ctrl_status(fd, "ok", 200, NULL);
+}
+
 int
 bgp_ctrl_disconnect(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
 {
@@ -14,6 +14,7 @@
 #define BGP_PORT                    179
 #define BGP_MIN_MESSAGE_SIZE        19U
 #define BGP_MAX_MESSAGE_SIZE        4096U
+#define BGP_MAX_EXT_MESSAGE_SIZE    65535U
 #define BGP_BUF_SIZE                256*1024
 #define BGP_DEFAULT_AS              65000
 #define BGP_DEFAULT_HOLD_TIME       90
@@ -25,8 +26,26 @@
 #define BGP_MSG_KEEPALIVE           4
 
 #define BGP_CAPABILITY              2
+#define BGP_CAPABILITY_EXT_MESSAGE  6
 #define BGP_CAPABILITY_4_BYTE_AS    65
 
+#define BGP_PATH_ATTR_ORIGIN        1
+#define BGP_PATH_ATTR_AS_PATH       2
+#define BGP_PATH_ATTR_NEXT_HOP      3
+#define BGP_PATH_ATTR_LOCAL_PREF    5
+#define BGP_PATH_ATTR_MP_REACH      14
+#define BGP_PATH_ATTR_MP_UNREACH    15
+#define BGP_PATH_ATTR_FLAG_EXTENDED 0x10
+#define BGP_PATH_ATTR_FLAG_OPTIONAL 0x80
+#define BGP_PATH_ATTR_FLAG_TRANSIT  0x40
+
+#define BGP_GENERATOR_BUF_SIZE      1024*1024
+#define BGP_GENERATOR_ASN_MAX       63
+
+#define BGP_RIB_SIZE_MIN            1024
+
+#define BGP_RAW_UPDATE_CHUNK_SIZE   16*1024*1024
+
 #define BGP_IPV4_UC                 0x00000001
 #define BGP_IPv6_UC                 0x00000002
 #define BGP_IPv4_MC                 0x00000004
@@ -52,20 +71,112 @@ typedef enum bgp_state_ {
     BGP_CLOSING,
 } bgp_state_t;
 
+typedef enum bgp_rib_family_ {
+    BGP_RIB_IPV4_UC = 0,
+    BGP_RIB_IPV6_UC,
+    BGP_RIB_IPV4_LU,
+    BGP_RIB_IPV6_LU,
+    BGP_RIB_FAMILY_MAX
+} bgp_rib_family_t;
+
+/*
+ * BGP Adj-RIB-In Entry
+ */
+typedef struct bgp_rib_entry_ {
+    uint8_t prefix[IPV6_ADDR_LEN]; /* host bits zeroed */
+    uint8_t prefix_len;
+    uint8_t family; /* bgp_rib_family_t + 1, 0 means empty */
+    uint32_t label;
+} bgp_rib_entry_s;
+
+/*
+ * BGP Adj-RIB-In
+ *
+ * Open addressing hash table (linear probing)
+ * with fixed size entries.
+ */
+typedef struct bgp_rib_ {
+    bgp_rib_entry_s *entries;
+    uint32_t size; /* power of 2 */
+    uint32_t count;
+    uint32_t family_count[BGP_RIB_FAMILY_MAX];
+
+    uint64_t announced;
+    uint64_t withdrawn;
+    uint32_t errors;
+    uint32_t eor; /* families (BGP_IPV4_UC, ...) with End-of-RIB received */
+
+    struct timespec first_prefix_timestamp;
+    struct timespec last_prefix_timestamp;
+    struct timespec eor_timestamp;
+} bgp_rib_s;
+
 /*
  * BGP RAW Update File
  */
 typedef struct bgp_raw_update_ {
     const char *file;
 
-    uint8_t *buf;
+    uint8_t *buf; /* read-only file mapping */
     uint32_t len;
-    uint32_t updates;
+    int fd; /* kept open to detect file modifications */
+    struct timespec mtime;
+    uint32_t validated; /* bytes validated from start of file */
+    uint32_t updates; /* updates in validated bytes */
 
     /* Pointer to next instance */
     struct bgp_raw_update_ *next;
 } bgp_raw_update_s;
 
+/*
+ * BGP Update Generator Configuration
+ */
+typedef struct bgp_generator_config_ {
+    uint16_t afi;
+    uint8_t  safi;
+
+    uint8_t  prefix_len;
+    uint8_t  prefix_addr_len; /* 4 or 16 */
+    uint8_t  prefix[IPV6_ADDR_LEN]; /* base prefix */
+    uint32_t prefix_num;
+
+    uint8_t  next_hop_len; /* 4 or 16 */
+    uint8_t  next_hop[IPV6_ADDR_LEN]; /* base next-hop */
+    uint32_t next_hop_num;
+
+    uint32_t label_base; /* labeled unicast if not zero */
+    uint32_t label_num;
+
+    uint32_t asn[BGP_GENERATOR_ASN_MAX];
+    uint8_t  asn_count;
+
+    uint32_t local_pref;
+    bool     local_pref_enabled;
+
+    uint16_t message_size;
+    bool     withdraw;
+    bool     end_of_rib;
+} bgp_generator_config_s;
+
+/*
+ * BGP Update Generator
+ */
+typedef struct bgp_generator_ {
+    io_buffer_t buf;
+
+    uint64_t round;
+    uint32_t next_hop_index;
+    uint32_t nlri_max; /* prefixes per update */
+    uint16_t message_size;
+
+    uint32_t prefixes;
+    uint32_t updates;
+
+    bool started;
+    bool finished; /* all prefixes generated */
+    bool end_of_rib; /* end-of-rib generated */
+} bgp_generator_s;
+
 /*
  * BGP Configuration
  */
@@ -90,10 +201,14 @@ typedef struct bgp_config_ {
 
     bool reconnect;
     bool start_traffic;
+    bool adj_rib_in;
+    bool extended_message;
 
     char *network_interface;
     char *raw_update_file;
 
+    bgp_generator_config_s *generator;
+
     /* Pointer to next instance */
     struct bgp_config_ *next;
 } bgp_config_s;
@@ -134,8 +249,11 @@ typedef struct bgp_session_ {
         uint32_t as;
         uint32_t id;
         uint16_t hold_time;
+        bool extended_message;
     } peer;
 
+    uint16_t max_message_size;
+
     struct {
         uint32_t message_rx;
         uint32_t message_tx;
@@ -147,12 +265,17 @@ typedef struct bgp_session_ {
 
     bgp_raw_update_s *raw_update_start;
     bgp_raw_update_s *raw_update;
+    uint32_t raw_update_offset;
     bool raw_update_sending;
 
+    bgp_generator_s generator;
+    bgp_rib_s adj_rib_in;
+
     struct timespec established_timestamp;
     struct timespec update_start_timestamp;
     struct timespec update_stop_timestamp;
     struct timespec update_duration;
+    uint32_t update_bytes;
 
     bool teardown;
     uint8_t error_code;
@@ -0,0 +1,406 @@
+/*
+ * BNG Blaster (BBL) - BGP Update Generator
+ *
+ * Generates BGP UPDATE messages on demand in chunks
+ * of BGP_GENERATOR_BUF_SIZE into the TCP send path,
+ * so that large tables can be sent without RAW update
+ * files and without holding the whole table in memory.
+ *
+ * Prefixes are distributed round-robin over next-hops
+ * and packed per next-hop into updates, similar to the
+ * bgpupdate script.
+ *
+ * The generator depends on BGP definitions only,
+ * which allows to test and benchmark it standalone.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "../bbl_def.h"
+#include "../bbl_protocols.h"
+#include <utils.h>
+#include "bgp_def.h"
+#include "bgp_generator.h"
+
+#define BGP_GENERATOR_LABEL_MAX 1048575
+
+/**
+ * bgp_generator_add
+ *
+ * Add value shifted left by shift bits
+ * to a big endian address.
+ *
+ * @param addr address
+ * @param addr_len address length in bytes
+ * @param value value
+ * @param shift shift in bits
+ * @return false on overflow
+ */
+bool
+bgp_generator_add(uint8_t *addr, uint8_t addr_len, uint64_t value, uint8_t shift)
+{
+    int pos = addr_len - 1 - (shift / 8);
+    uint8_t bits = shift % 8;
+    uint64_t lo = value << bits;
+    uint64_t hi = bits ? value >> (64 - bits) : 0;
+    uint32_t sum, carry = 0;
+    uint8_t n, byte;
+
+    for(n = 0; n < 9 || carry; n++) {
+        if(n < 8) {
+            byte = (lo >> (8 * n)) & 0xff;
+        } else if(n == 8) {
+            byte = hi;
+        } else {
+            byte = 0;
+        }
+        if(pos < 0) {
+            if(byte || carry) {
+                return false;
+            }
+            continue;
+        }
+        sum = addr[pos] + byte + carry;
+        addr[pos--] = sum & 0xff;
+        carry = sum >> 8;
+    }
+    return true;
+}
+
+static uint32_t
+bgp_generator_prefix_bytes(bgp_generator_config_s *config)
+{
+    /* Prefix length (1 byte), optional label (3 bytes) and prefix. */
+    return 1 + (config->label_base ? 3 : 0) + (config->prefix_len + 7) / 8;
+}
+
+static uint32_t
+bgp_generator_attr_bytes(bgp_generator_config_s *config)
+{
+    uint32_t len = 0;
+
+    if(config->withdraw) {
+        if(config->afi == IANA_AFI_IPV4 && config->safi == 1) {
+            return 0;
+        }
+        /* MP_UNREACH_NLRI */
+        return 4 + 3;
+    }
+
+    len += 4; /* ORIGIN */
+    len += 3; /* AS_PATH */
+    if(config->asn_count) {
+        len += 2 + config->asn_count * 4;
+    }
+    if(config->local_pref_enabled) {
+        len += 7; /* LOCAL_PREF */
+    }
+    if(config->afi == IANA_AFI_IPV4 && config->safi == 1) {
+        len += 7; /* NEXT_HOP */
+    } else {
+        /* MP_REACH_NLRI */
+        len += 4 + 5 + config->next_hop_len;
+    }
+    return len;
+}
+
+/* Number of prefixes assigned to next-hop index. */
+static uint32_t
+bgp_generator_next_hop_prefixes(bgp_generator_config_s *config, uint32_t index)
+{
+    if(index >= config->prefix_num) {
+        return 0;
+    }
+    return (config->prefix_num - index + config->next_hop_num - 1) / config->next_hop_num;
+}
+
+static void
+bgp_generator_push_nlri(bgp_generator_config_s *config, uint8_t **cursor, uint32_t index, bool withdraw)
+{
+    uint8_t prefix[IPV6_ADDR_LEN];
+    uint8_t prefix_bytes = (config->prefix_len + 7) / 8;
+    uint8_t *p = *cursor;
+    uint32_t label;
+
+    memcpy(prefix, config->prefix, config->prefix_addr_len);
+    bgp_generator_add(prefix, config->prefix_addr_len, index,
+                      config->prefix_addr_len * 8 - config->prefix_len);
+
+    if(config->label_base) {
+        *p++ = config->prefix_len + 24;
+        if(withdraw) {
+            label = 0x800000; /* RFC 8277 compatibility value */
+        } else {
+            label = ((config->label_base + (index % config->label_num)) << 4) | 0x01;
+        }
+        write_be_uint(p, 3, label);
+        p += 3;
+    } else {
+        *p++ = config->prefix_len;
+    }
+    memcpy(p, prefix, prefix_bytes);
+    p += prefix_bytes;
+    *cursor = p;
+}
+
+static void
+bgp_generator_push_header(uint8_t **cursor)
+{
+    uint8_t *p = *cursor;
+    memset(p, 0xff, 16); /* marker */
+    p += 16;
+    p += 2; /* length */
+    *p++ = BGP_MSG_UPDATE;
+    *cursor = p;
+}
+
+static void
+bgp_generator_push_attr(uint8_t **cursor, uint8_t flags, uint8_t type, uint8_t len)
+{
+    uint8_t *p = *cursor;
+    *p++ = flags;
+    *p++ = type;
+    *p++ = len;
+    *cursor = p;
+}
+
+/**
+ * bgp_generator_update
+ *
+ * Generate one update message with prefixes
+ * index, index + step, index + 2 * step, ...
+ */
+static void
+bgp_generator_update(bgp_generator_s *generator, bgp_generator_config_s *config,
+                     uint32_t next_hop_index, uint64_t start, uint64_t stop)
+{
+    io_buffer_t *buffer = &generator->buf;
+
+    uint8_t *msg = buffer->data + buffer->idx;
+    uint8_t *p = msg;
+    uint8_t *withdrawn_len, *attr_len, *attr_start, *mp_len;
+    uint8_t next_hop[IPV6_ADDR_LEN];
+    uint64_t j;
+    uint8_t i;
+    bool ipv4_unicast = (config->afi == IANA_AFI_IPV4 && config->safi == 1);
+
+    bgp_generator_push_header(&p);
+
+    withdrawn_len = p;
+    p += 2;
+    if(config->withdraw && ipv4_unicast) {
+        for(j = start; j < stop; j++) {
+            bgp_generator_push_nlri(config, &p, next_hop_index + j * config->next_hop_num, true);
+        }
+        write_be_uint(withdrawn_len, 2, p - withdrawn_len - 2);
+        write_be_uint(p, 2, 0); /* path attribute length */
+        p += 2;
+        goto DONE;
+    }
+    write_be_uint(withdrawn_len, 2, 0);
+
+    attr_len = p;
+    p += 2;
+    attr_start = p;
+    if(config->withdraw) {
+        *p++ = BGP_PATH_ATTR_FLAG_OPTIONAL|BGP_PATH_ATTR_FLAG_EXTENDED;
+        *p++ = BGP_PATH_ATTR_MP_UNREACH;
+        mp_len = p;
+        p += 2;
+        write_be_uint(p, 2, config->afi);
+        p += 2;
+        *p++ = config->safi;
+        for(j = start; j < stop; j++) {
+            bgp_generator_push_nlri(config, &p, next_hop_index + j * config->next_hop_num, true);
+        }
+        write_be_uint(mp_len, 2, p - mp_len - 2);
+        write_be_uint(attr_len, 2, p - attr_start);
+        goto DONE;
+    }
+
+    memcpy(next_hop, config->next_hop, config->next_hop_len);
+    bgp_generator_add(next_hop, config->next_hop_len, next_hop_index, 0);
+
+    bgp_generator_push_attr(&p, BGP_PATH_ATTR_FLAG_TRANSIT, BGP_PATH_ATTR_ORIGIN, 1);
+    *p++ = 0; /* IGP */
+    if(config->asn_count) {
+        bgp_generator_push_attr(&p, BGP_PATH_ATTR_FLAG_TRANSIT, BGP_PATH_ATTR_AS_PATH, 2 + config->asn_count * 4);
+        *p++ = 2; /* AS_SEQUENCE */
+        *p++ = config->asn_count;
+        for(i = 0; i < config->asn_count; i++) {
+            write_be_uint(p, 4, config->asn[i]);
+            p += 4;
+        }
+    } else {
+        bgp_generator_push_attr(&p, BGP_PATH_ATTR_FLAG_TRANSIT, BGP_PATH_ATTR_AS_PATH, 0);
+    }
+    if(config->local_pref_enabled) {
+        bgp_generator_push_attr(&p, BGP_PATH_ATTR_FLAG_TRANSIT, BGP_PATH_ATTR_LOCAL_PREF, 4);
+        write_be_uint(p, 4, config->local_pref);
+        p += 4;
+    }
+    if(ipv4_unicast) {
+        bgp_generator_push_attr(&p, BGP_PATH_ATTR_FLAG_TRANSIT, BGP_PATH_ATTR_NEXT_HOP, 4);
+        memcpy(p, next_hop, 4);
+        p += 4;
+        write_be_uint(attr_len, 2, p - attr_start);
+        for(j = start; j < stop; j++) {
+            bgp_generator_push_nlri(config, &p, next_hop_index + j * config->next_hop_num, false);
+        }
+    } else {
+        *p++ = BGP_PATH_ATTR_FLAG_OPTIONAL|BGP_PATH_ATTR_FLAG_EXTENDED;
+        *p++ = BGP_PATH_ATTR_MP_REACH;
+        mp_len = p;
+        p += 2;
+        write_be_uint(p, 2, config->afi);
+        p += 2;
+        *p++ = config->safi;
+        *p++ = config->next_hop_len;
+        memcpy(p, next_hop, config->next_hop_len);
+        p += config->next_hop_len;
+        *p++ = 0; /* reserved */
+        for(j = start; j < stop; j++) {
+            bgp_generator_push_nlri(config, &p, next_hop_index + j * config->next_hop_num, false);
+        }
+        write_be_uint(mp_len, 2, p - mp_len - 2);
+        write_be_uint(attr_len, 2, p - attr_start);
+    }
+
+DONE:
+    write_be_uint(msg+16, 2, p - msg);
+    buffer->idx += p - msg;
+    generator->prefixes += stop - start;
+    generator->updates++;
+}
+
+static void
+bgp_generator_end_of_rib(bgp_generator_s *generator, bgp_generator_config_s *config)
+{
+    io_buffer_t *buffer = &generator->buf;
+
+    uint8_t *msg = buffer->data + buffer->idx;
+    uint8_t *p = msg;
+
+    bgp_generator_push_header(&p);
+    write_be_uint(p, 2, 0); /* withdrawn routes length */
+    p += 2;
+    if(config->afi == IANA_AFI_IPV4 && config->safi == 1) {
+        write_be_uint(p, 2, 0); /* path attribute length */
+        p += 2;
+    } else {
+        write_be_uint(p, 2, 6); /* path attribute length */
+        p += 2;
+        bgp_generator_push_attr(&p, BGP_PATH_ATTR_FLAG_OPTIONAL, BGP_PATH_ATTR_MP_UNREACH, 3);
+        write_be_uint(p, 2, config->afi);
+        p += 2;
+        *p++ = config->safi;
+    }
+    write_be_uint(msg+16, 2, p - msg);
+    buffer->idx += p - msg;
+    generator->updates++;
+}
+
+/**
+ * bgp_generator_fill
+ *
+ * Fill generator buffer with next chunk of update messages.
+ *
+ * @param generator update generator
+ * @param config update generator configuration
+ * @return number of bytes generated (0 if finished)
+ */
+uint32_t
+bgp_generator_fill(bgp_generator_s *generator, bgp_generator_config_s *config)
+{
+    io_buffer_t *buffer = &generator->buf;
+
+    uint64_t start, stop, count;
+
+    buffer->idx = 0;
+    while(buffer->size - buffer->idx >= generator->message_size) {
+        if(!generator->finished) {
+            count = bgp_generator_next_hop_prefixes(config, generator->next_hop_index);
+            start = generator->round * generator->nlri_max;
+            if(start < count) {
+                stop = start + generator->nlri_max;
+                if(stop > count) stop = count;
+                bgp_generator_update(generator, config, generator->next_hop_index, start, stop);
+            }
+            if(++generator->next_hop_index >= config->next_hop_num) {
+                generator->next_hop_index = 0;
+                generator->round++;
+                if(generator->round * generator->nlri_max >= bgp_generator_next_hop_prefixes(config, 0)) {
+                    generator->finished = true;
+                }
+            }
+        } else if(config->end_of_rib && !generator->end_of_rib) {
+            bgp_generator_end_of_rib(generator, config);
+            generator->end_of_rib = true;
+        } else {
+            break;
+        }
+    }
+    return buffer->idx;
+}
+
+/**
+ * bgp_generator_init
+ *
+ * Reset generator state for a new run.
+ *
+ * @param generator update generator
+ * @param config update generator configuration
+ * @param max_message_size max message size of session
+ * @return true if successful
+ */
+bool
+bgp_generator_init(bgp_generator_s *generator, bgp_generator_config_s *config,
+                   uint16_t max_message_size)
+{
+    uint32_t fixed;
+
+    if(!generator->buf.data) {
+        /* The buffer is kept for the lifetime of the session
+         * because lwIP references it (zero copy) until acked. */
+        generator->buf.data = malloc(BGP_GENERATOR_BUF_SIZE);
+        if(!generator->buf.data) {
+            return false;
+        }
+        generator->buf.size = BGP_GENERATOR_BUF_SIZE;
+    }
+    generator->buf.idx = 0;
+    generator->buf.start_idx = 0;
+
+    generator->message_size = config->message_size;
+    if(generator->message_size > max_message_size) {
+        generator->message_size = max_message_size;
+    }
+    fixed = BGP_MIN_MESSAGE_SIZE + 4 + bgp_generator_attr_bytes(config);
+    generator->nlri_max = (generator->message_size - fixed) / bgp_generator_prefix_bytes(config);
+    if(!generator->nlri_max) {
+        return false;
+    }
+
+    generator->round = 0;
+    generator->next_hop_index = 0;
+    generator->prefixes = 0;
+    generator->updates = 0;
+    generator->finished = false;
+    generator->end_of_rib = false;
+    generator->started = true;
+    return true;
+}
+
+/**
+ * bgp_generator_label_num
+ *
+ * Limit label count to valid label range.
+ */
+uint32_t
+bgp_generator_label_num(uint32_t label_base, uint32_t label_num)
+{
+    if(label_base + label_num - 1 > BGP_GENERATOR_LABEL_MAX) {
+        return BGP_GENERATOR_LABEL_MAX - label_base + 1;
+    }
+    return label_num;
+}
@@ -0,0 +1,23 @@
+/*
+ * BNG Blaster (BBL) - BGP Update Generator
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_BGP_GENERATOR_H__
+#define __BBL_BGP_GENERATOR_H__
+
+bool
+bgp_generator_add(uint8_t *addr, uint8_t addr_len, uint64_t value, uint8_t shift);
+
+uint32_t
+bgp_generator_label_num(uint32_t label_base, uint32_t label_num);
+
+bool
+bgp_generator_init(bgp_generator_s *generator, bgp_generator_config_s *config,
+                   uint16_t max_message_size);
+
+uint32_t
+bgp_generator_fill(bgp_generator_s *generator, bgp_generator_config_s *config);
+
+#endif
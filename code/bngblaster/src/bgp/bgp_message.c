@@ -49,6 +49,16 @@ push_mp_capability(io_buffer_t *buffer, uint16_t afi, uint8_t safi)
     write_be_uint(buffer->data+cap_idx-1, 1, length); /* update CAP length */
 }
 
+/* Extended Message Capability */
+static void
+push_ext_message_capability(io_buffer_t *buffer)
+{
+    push_be_uint(buffer, 1, 2); /* CAP code */
+    push_be_uint(buffer, 1, 2); /* CAP length */
+    push_be_uint(buffer, 1, BGP_CAPABILITY_EXT_MESSAGE);
+    push_be_uint(buffer, 1, 0); /* Length */
+}
+
 /* Extended Nexthop Capability */
 static void
 push_en_capability(io_buffer_t *buffer, uint16_t afi, uint16_t safi, uint16_t nh_afi)
@@ -148,6 +158,9 @@ bgp_push_open_message(bgp_session_s *session)
     if(config->extended_nexthop & BGP_IPv4_VPN_UC) {
         push_en_capability(buffer, 1, 128, 2);
     }
+    if(config->extended_message) {
+        push_ext_message_capability(buffer);
+    }
 
     /* Calculate optional parameters length field */
     opt_parms_length = buffer->idx - opt_parms_idx;
@@ -6,112 +6,158 @@
  * Copyright (C) 2020-2025, RtBrick, Inc.
  * SPDX-License-Identifier: BSD-3-Clause
  */
-#include "bgp.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../bbl_def.h"
+#include "../bbl_protocols.h"
+#include <logging.h>
+#include "bgp_def.h"
+#include "bgp_raw_update.h"
 
-static bgp_raw_update_s *
-bgp_raw_update_load_file(const char *file, bool decode_file)
+/**
+ * bgp_raw_update_open 
+ * 
+ * Map the file read-only, which is kept 
+ * free of other dependencies to allow 
+ * benchmarking the file based updates. 
+ * 
+ * @param file update file
+ * @return BGP RAW update structure
+ */
+bgp_raw_update_s *
+bgp_raw_update_open(const char *file)
 {
     bgp_raw_update_s *raw_update = NULL;
-    long fsize;
-    double fsize_kb;
-
+    struct stat st;
     uint8_t *buf = NULL;
-    uint32_t len = 0;
-    uint16_t msg_len;
-    uint8_t  msg_type;
+    int fd;
 
     /* Open file */
-    FILE *f = fopen(file, "rb");
-    if(f == NULL) {
+    fd = open(file, O_RDONLY|O_CLOEXEC);
+    if(fd < 0) {
         LOG(ERROR, "Failed to open BGP RAW update file %s\n", file);
         return NULL;
-    } 
-
-    /* Get file size */
-    fseek(f, 0, SEEK_END);
-    fsize = ftell(f);
-    fsize_kb = fsize/1024.0;
-    fseek(f, 0, SEEK_SET);
-
-    /* Load file into memory */
-    raw_update = calloc(1, sizeof(bgp_raw_update_s));
-    raw_update->file = strdup(file);
-    raw_update->buf = malloc(fsize);
-    raw_update->len = fsize;
-    if(fread(raw_update->buf, fsize, 1, f) != 1) {
-        fclose(f);
+    }
+    if(fstat(fd, &st) != 0 || st.st_size > UINT32_MAX) {
+        close(fd);
         LOG(ERROR, "Failed to read BGP RAW update file %s\n", file);
-        goto ERROR;
+        return NULL;
     }
-    fclose(f);
 
-    if(decode_file) {
-        /* Decode update stream */
-        buf = raw_update->buf;
-        len = raw_update->len;
-        while(len) {
-            if(len < BGP_MIN_MESSAGE_SIZE) {
-                goto DECODE_ERROR;
-            }
-            BUMP_BUFFER(buf, len, 16);
-            msg_len = be16toh(*(uint16_t*)buf);
-            BUMP_BUFFER(buf, len, sizeof(uint16_t));
-            msg_type = *buf;
-            BUMP_BUFFER(buf, len, sizeof(uint8_t));
-            if(msg_len < BGP_MIN_MESSAGE_SIZE ||
-               msg_len > BGP_MAX_MESSAGE_SIZE) {
-                goto DECODE_ERROR;
-            }
-            if((msg_len - BGP_MIN_MESSAGE_SIZE) > len) {
-                goto DECODE_ERROR;
-            }
-            if(msg_type == BGP_MSG_UPDATE) {
-                raw_update->updates++;
-            }
-            BUMP_BUFFER(buf, len, (msg_len - BGP_MIN_MESSAGE_SIZE));
+    /* Map file read-only, pages are read on demand
+     * while sending and shared by all sessions. */
+    if(st.st_size) {
+        buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(buf == MAP_FAILED) {
+            close(fd);
+            LOG(ERROR, "Failed to map BGP RAW update file %s (%s)\n", file, strerror(errno));
+            return NULL;
         }
+        madvise(buf, st.st_size, MADV_SEQUENTIAL);
     }
-    LOG(INFO, "Loaded BGP RAW update file %s (%.2f KB, %u updates)\n", 
-        file, fsize_kb, raw_update->updates);
+
+    raw_update = calloc(1, sizeof(bgp_raw_update_s));
+    raw_update->file = strdup(file);
+    raw_update->buf = buf;
+    raw_update->len = st.st_size;
+    raw_update->fd = fd;
+    raw_update->mtime = st.st_mtim;
+
+    LOG(INFO, "Loaded BGP RAW update file %s (%.2f KB)\n", 
+        file, raw_update->len/1024.0);
     return raw_update;
+}
 
-DECODE_ERROR:
-    LOG(ERROR, "Failed to decode BGP RAW update file %s\n", file);
-ERROR:
-    if(raw_update) {
-        if(raw_update->buf) {
-            free(raw_update->buf);
-        }
-        free(raw_update);
+/**
+ * bgp_raw_update_close 
+ * 
+ * Release the file mapping. 
+ * 
+ * @param raw_update BGP RAW update structure
+ */
+void
+bgp_raw_update_close(bgp_raw_update_s *raw_update)
+{
+    if(raw_update->buf) {
+        munmap(raw_update->buf, raw_update->len);
+    }
+    close(raw_update->fd);
+    free((char*)raw_update->file);
+    free(raw_update);
+}
+
+/*
+ * The file is mapped and not copied, therefore it must 
+ * not be modified while loaded. Accessing pages beyond 
+ * the end of a truncated file raises SIGBUS. 
+ */
+static bool
+bgp_raw_update_unchanged(bgp_raw_update_s *raw_update)
+{
+    struct stat st;
+
+    if(fstat(raw_update->fd, &st) != 0 || 
+       st.st_size != raw_update->len ||
+       st.st_mtim.tv_sec != raw_update->mtime.tv_sec ||
+       st.st_mtim.tv_nsec != raw_update->mtime.tv_nsec) {
+        LOG(ERROR, "BGP RAW update file %s modified after loading\n", raw_update->file);
+        return false;
     }
-    return NULL;
+    return true;
 }
 
 /**
- * bgp_raw_update_load 
+ * bgp_raw_update_chunk 
  * 
- * @param file update file
- * @param decode_file decode/parse file content if true
- * @return BGP RAW update structure
+ * Validate the message framing of the next chunk 
+ * of up to BGP_RAW_UPDATE_CHUNK_SIZE bytes. The file
+ * must not have changed since it was loaded.
+ * 
+ * @param raw_update BGP RAW update structure
+ * @param offset start of chunk (message boundary)
+ * @param max_len max message size
+ * @param updates returns number of updates in chunk
+ * @return chunk length or zero if completed or invalid
  */
-bgp_raw_update_s *
-bgp_raw_update_load(const char *file, bool decode_file)
+uint32_t
+bgp_raw_update_chunk(bgp_raw_update_s *raw_update, uint32_t offset,
+                     uint32_t max_len, uint32_t *updates)
 {
-    bgp_raw_update_s *raw_update = g_ctx->bgp_raw_updates;
+    uint8_t *buf = raw_update->buf + offset;
+    uint32_t len = raw_update->len - offset;
+    uint32_t chunk = 0;
+    uint16_t msg_len;
 
-    /* Check if file is already loaded */
-    while(raw_update){
-        if(strcmp(file, raw_update->file) == 0) {
-            return raw_update;
+    *updates = 0;
+    if(!bgp_raw_update_unchanged(raw_update)) {
+        return 0;
+    }
+    while(chunk < len && chunk < BGP_RAW_UPDATE_CHUNK_SIZE) {
+        msg_len = 0;
+        if(len - chunk >= BGP_MIN_MESSAGE_SIZE) {
+            msg_len = be16toh(*(uint16_t*)(buf+chunk+16));
+        }
+        if(msg_len < BGP_MIN_MESSAGE_SIZE ||
+           msg_len > max_len ||
+           msg_len > len - chunk) {
+            /* Send all valid messages before the error 
+             * and stop with the following chunk. */
+            if(!chunk) {
+                LOG(ERROR, "Failed to decode BGP RAW update file %s at offset %u\n",
+                    raw_update->file, offset);
+            }
+            break;
         }
-        raw_update = raw_update->next;
+        if(buf[chunk+18] == BGP_MSG_UPDATE) {
+            (*updates)++;
+        }
+        chunk += msg_len;
     }
-    raw_update = bgp_raw_update_load_file(file, decode_file);
-    if(raw_update) {
-        raw_update->next = g_ctx->bgp_raw_updates;
-        g_ctx->bgp_raw_updates = raw_update;
-        return raw_update;
-    } else {
-        return NULL;
+    if(offset == raw_update->validated) {
+        raw_update->validated += chunk;
+        raw_update->updates += *updates;
     }
-}
\ No newline at end of file
+    return chunk;
+}
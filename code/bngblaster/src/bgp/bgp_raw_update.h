@@ -10,6 +10,19 @@
 #define __BBL_BGP_RAW_UPDATE_H__
 
 bgp_raw_update_s *
-bgp_raw_update_load(const char *file, bool decode_file);
+bgp_raw_update_open(const char *file);
 
-#endif
\ No newline at end of file
+void
+bgp_raw_update_close(bgp_raw_update_s *raw_update);
+
+bgp_raw_update_s *
+bgp_raw_update_load(const char *file);
+
+void
+bgp_raw_update_unload(bgp_raw_update_s *raw_update);
+
+uint32_t
+bgp_raw_update_chunk(bgp_raw_update_s *raw_update, uint32_t offset,
+                     uint32_t max_len, uint32_t *updates);
+
+#endif
@@ -89,23 +89,31 @@ bgp_capability(bgp_session_s *session, uint8_t *start, uint8_t length)
 {
     uint8_t cap_code, cap_length;
 
-    if(length < 2) {
-        return false;
-    }
-    cap_code = read_be_uint(start, 1);
-    cap_length = read_be_uint(start+1, 1);
-    if(cap_length+2 > length) {
-        return false;
-    }
-    switch(cap_code) {
-        case BGP_CAPABILITY_4_BYTE_AS:
-            if(cap_length != 4) {
-                return false;
-            }
-            session->peer.as = read_be_uint(start+2, 4);
-            break;
-        default:
-            break;
+    /* An optional parameter may contain multiple capabilities. */
+    while(length) {
+        if(length < 2) {
+            return false;
+        }
+        cap_code = read_be_uint(start, 1);
+        cap_length = read_be_uint(start+1, 1);
+        if(cap_length+2 > length) {
+            return false;
+        }
+        switch(cap_code) {
+            case BGP_CAPABILITY_4_BYTE_AS:
+                if(cap_length != 4) {
+                    return false;
+                }
+                session->peer.as = read_be_uint(start+2, 4);
+                break;
+            case BGP_CAPABILITY_EXT_MESSAGE:
+                session->peer.extended_message = true;
+                break;
+            default:
+                break;
+        }
+        start += cap_length+2;
+        length -= cap_length+2;
     }
     return true;
 }
@@ -145,6 +153,13 @@ bgp_open(bgp_session_s *session, uint8_t *start, uint16_t length)
         opt_idx += opt_param_length;
     }
 
+    /* Extended messages (RFC 8654) */
+    if(session->config->extended_message && session->peer.extended_message) {
+        session->max_message_size = BGP_MAX_EXT_MESSAGE_SIZE;
+    } else {
+        session->max_message_size = BGP_MAX_MESSAGE_SIZE;
+    }
+
     LOG(BGP, "BGP (%s %s - %s) open message received with peer AS: %u, hold-time: %us\n",
         session->interface->name,
         session->local_address_str,
@@ -212,6 +227,29 @@ bgp_notification(bgp_session_s *session, uint8_t *start, uint16_t length)
     return true;
 }
 
+static bool
+bgp_update(bgp_session_s *session, uint8_t *start, uint16_t length)
+{
+    bgp_rib_s *rib = &session->adj_rib_in;
+    uint32_t eor;
+    uint8_t family;
+
+    if(!bgp_rib_decode_update(rib, start, length, session->config->adj_rib_in, &eor)) {
+        return false;
+    }
+    for(family = 0; eor && family < BGP_RIB_FAMILY_MAX; family++) {
+        if(eor & bgp_rib_family_flag(family)) {
+            LOG(BGP, "BGP (%s %s - %s) end-of-rib received for %s with %u prefixes\n",
+                session->interface->name,
+                session->local_address_str,
+                session->peer_address_str,
+                bgp_rib_family_string(family),
+                rib->family_count[family]);
+        }
+    }
+    return true;
+}
+
 /*
  * When there is only little data left and
  * the buffer start is close to buffer end,
@@ -253,7 +291,7 @@ bgp_read(bgp_session_s *session)
 
         length = read_be_uint(start+16, 2);
         if(length < BGP_MIN_MESSAGE_SIZE ||
-            length > BGP_MAX_MESSAGE_SIZE) {
+            length > session->max_message_size) {
             bgp_decode_error(session);
             return;
         }
@@ -293,6 +331,15 @@ bgp_read(bgp_session_s *session)
                 break;
             case BGP_MSG_UPDATE:
                 session->stats.update_rx++;
+                if(!bgp_update(session, start, length)) {
+                    /* Malformed UPDATE messages are counted and 
+                     * ignored to keep the session up (RFC 7606). */
+                    session->adj_rib_in.errors++;
+                    LOG(BGP, "BGP (%s %s - %s) invalid update message received\n",
+                        session->interface->name,
+                        session->local_address_str,
+                        session->peer_address_str);
+                }
                 break;
             default:
                 break;
@@ -0,0 +1,434 @@
+/*
+ * BNG Blaster (BBL) - BGP Adj-RIB-In
+ *
+ * Prefixes received from the peer are stored in a
+ * compact open addressing hash table (linear probing
+ * with backward shift deletion) with fixed size entries
+ * to support multi-million prefix tables.
+ *
+ * UPDATE messages are decoded in place from the read
+ * buffer. This file depends on BGP definitions only,
+ * which allows to unit test the decoder and table.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "../bbl_def.h"
+#include "../bbl_protocols.h"
+#include <utils.h>
+#include "bgp_def.h"
+#include "bgp_rib.h"
+
+static const char *bgp_rib_family_names[BGP_RIB_FAMILY_MAX] = {
+    "ipv4-unicast",
+    "ipv6-unicast",
+    "ipv4-labeled-unicast",
+    "ipv6-labeled-unicast"
+};
+
+static const uint32_t bgp_rib_family_flags[BGP_RIB_FAMILY_MAX] = {
+    BGP_IPV4_UC,
+    BGP_IPv6_UC,
+    BGP_IPv4_LU,
+    BGP_IPv6_LU
+};
+
+const char *
+bgp_rib_family_string(bgp_rib_family_t family)
+{
+    if(family < BGP_RIB_FAMILY_MAX) {
+        return bgp_rib_family_names[family];
+    }
+    return "unknown";
+}
+
+uint32_t
+bgp_rib_family_flag(bgp_rib_family_t family)
+{
+    if(family < BGP_RIB_FAMILY_MAX) {
+        return bgp_rib_family_flags[family];
+    }
+    return 0;
+}
+
+static inline uint32_t
+bgp_rib_hash(bgp_rib_entry_s *key)
+{
+    uint64_t a, b, h;
+
+    memcpy(&a, key->prefix, sizeof(a));
+    memcpy(&b, key->prefix+sizeof(a), sizeof(b));
+
+    h = a ^ (b * 0x9e3779b97f4a7c15ULL) ^ (((uint64_t)key->prefix_len << 8) | key->family);
+    /* 64 bit finalizer (MurmurHash3) */
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (uint32_t)h;
+}
+
+static inline bool
+bgp_rib_match(bgp_rib_entry_s *entry, bgp_rib_entry_s *key)
+{
+    return entry->family == key->family &&
+           entry->prefix_len == key->prefix_len &&
+           memcmp(entry->prefix, key->prefix, IPV6_ADDR_LEN) == 0;
+}
+
+static bool
+bgp_rib_resize(bgp_rib_s *rib, uint32_t size)
+{
+    bgp_rib_entry_s *entries;
+    bgp_rib_entry_s *entry;
+    uint32_t mask = size - 1;
+    uint32_t i, idx;
+
+    entries = calloc(size, sizeof(bgp_rib_entry_s));
+    if(!entries) {
+        return false;
+    }
+    for(i = 0; i < rib->size; i++) {
+        entry = &rib->entries[i];
+        if(!entry->family) continue;
+        idx = bgp_rib_hash(entry) & mask;
+        while(entries[idx].family) {
+            idx = (idx + 1) & mask;
+        }
+        entries[idx] = *entry;
+    }
+    free(rib->entries);
+    rib->entries = entries;
+    rib->size = size;
+    return true;
+}
+
+/**
+ * bgp_rib_add
+ *
+ * Add or replace prefix.
+ *
+ * @param rib Adj-RIB-In
+ * @param key prefix with family and label
+ * @return true if prefix was added
+ */
+bool
+bgp_rib_add(bgp_rib_s *rib, bgp_rib_entry_s *key)
+{
+    bgp_rib_entry_s *entry;
+    uint32_t mask, idx;
+
+    /* Keep load factor below 75%. */
+    if((rib->count + 1) * 4 > rib->size * 3) {
+        if(!bgp_rib_resize(rib, rib->size ? rib->size * 2 : BGP_RIB_SIZE_MIN)) {
+            return false;
+        }
+    }
+
+    mask = rib->size - 1;
+    idx = bgp_rib_hash(key) & mask;
+    while(true) {
+        entry = &rib->entries[idx];
+        if(!entry->family) {
+            break;
+        }
+        if(bgp_rib_match(entry, key)) {
+            /* Implicit withdraw */
+            entry->label = key->label;
+            return false;
+        }
+        idx = (idx + 1) & mask;
+    }
+    *entry = *key;
+    rib->count++;
+    rib->family_count[key->family-1]++;
+    return true;
+}
+
+/**
+ * bgp_rib_del
+ *
+ * @param rib Adj-RIB-In
+ * @param key prefix with family
+ * @return true if prefix was deleted
+ */
+bool
+bgp_rib_del(bgp_rib_s *rib, bgp_rib_entry_s *key)
+{
+    bgp_rib_entry_s *entry;
+    uint32_t mask, i, j, k;
+
+    if(!rib->count) {
+        return false;
+    }
+
+    mask = rib->size - 1;
+    i = bgp_rib_hash(key) & mask;
+    while(true) {
+        entry = &rib->entries[i];
+        if(!entry->family) {
+            return false;
+        }
+        if(bgp_rib_match(entry, key)) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    rib->count--;
+    rib->family_count[entry->family-1]--;
+
+    /* Backward shift deletion to keep probe
+     * sequences intact without tombstones. */
+    j = i;
+    while(true) {
+        j = (j + 1) & mask;
+        if(!rib->entries[j].family) {
+            break;
+        }
+        k = bgp_rib_hash(&rib->entries[j]) & mask;
+        if(i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+            continue;
+        }
+        rib->entries[i] = rib->entries[j];
+        i = j;
+    }
+    rib->entries[i].family = 0;
+    return true;
+}
+
+/**
+ * bgp_rib_free
+ *
+ * Delete all prefixes and reset statistics.
+ *
+ * @param rib Adj-RIB-In
+ */
+void
+bgp_rib_free(bgp_rib_s *rib)
+{
+    if(rib->entries) {
+        free(rib->entries);
+    }
+    memset(rib, 0x0, sizeof(bgp_rib_s));
+}
+
+/*
+ * Decode NLRI (RFC 4271, RFC 4760 and RFC 8277)
+ * directly from the read buffer and update Adj-RIB-In.
+ */
+static bool
+bgp_rib_decode_nlri(bgp_rib_s *rib, bgp_rib_family_t family, 
+                    uint8_t *start, uint16_t length, bool withdraw, bool store)
+{
+    bgp_rib_entry_s key;
+    uint16_t idx = 0;
+    uint8_t prefix_len;
+    uint8_t prefix_bytes;
+    uint8_t max_len = 32;
+    bool labeled = false;
+    uint32_t count = 0;
+
+    if(family == BGP_RIB_IPV6_UC || family == BGP_RIB_IPV6_LU) {
+        max_len = 128;
+    }
+    if(family == BGP_RIB_IPV4_LU || family == BGP_RIB_IPV6_LU) {
+        labeled = true;
+    }
+
+    while(idx < length) {
+        memset(&key, 0x0, sizeof(key));
+        key.family = family + 1;
+        prefix_len = start[idx++];
+        if(labeled) {
+            /* Label stack (3 bytes per label) is part of the prefix length. 
+             * Withdraw messages contain a single label field only. */
+            while(true) {
+                if(prefix_len < 24 || idx + 3 > length) {
+                    return false;
+                }
+                key.label = read_be_uint(start+idx, 3) >> 4;
+                prefix_len -= 24;
+                idx += 3;
+                if(withdraw || (start[idx-1] & 0x01)) {
+                    break;
+                }
+            }
+        }
+        if(prefix_len > max_len) {
+            return false;
+        }
+        prefix_bytes = (prefix_len + 7) / 8;
+        if(idx + prefix_bytes > length) {
+            return false;
+        }
+        memcpy(key.prefix, start+idx, prefix_bytes);
+        if(prefix_len % 8) {
+            key.prefix[prefix_bytes-1] &= (uint8_t)(0xff << (8 - (prefix_len % 8)));
+        }
+        key.prefix_len = prefix_len;
+        idx += prefix_bytes;
+
+        if(store) {
+            if(withdraw) {
+                bgp_rib_del(rib, &key);
+            } else {
+                bgp_rib_add(rib, &key);
+            }
+        }
+        count++;
+    }
+
+    if(count) {
+        if(withdraw) {
+            rib->withdrawn += count;
+        } else {
+            rib->announced += count;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &rib->last_prefix_timestamp);
+        if(!rib->first_prefix_timestamp.tv_sec) {
+            rib->first_prefix_timestamp = rib->last_prefix_timestamp;
+        }
+    }
+    return true;
+}
+
+static bool
+bgp_rib_decode_family(uint16_t afi, uint8_t safi, bgp_rib_family_t *family)
+{
+    switch(afi) {
+        case 1:
+            switch(safi) {
+                case 1: *family = BGP_RIB_IPV4_UC; return true;
+                case 4: *family = BGP_RIB_IPV4_LU; return true;
+                default: return false;
+            }
+        case 2:
+            switch(safi) {
+                case 1: *family = BGP_RIB_IPV6_UC; return true;
+                case 4: *family = BGP_RIB_IPV6_LU; return true;
+                default: return false;
+            }
+        default:
+            return false;
+    }
+}
+
+static void
+bgp_rib_decode_eor(bgp_rib_s *rib, bgp_rib_family_t family, uint32_t *eor)
+{
+    rib->eor |= bgp_rib_family_flag(family);
+    *eor |= bgp_rib_family_flag(family);
+    clock_gettime(CLOCK_MONOTONIC, &rib->eor_timestamp);
+}
+
+/**
+ * bgp_rib_decode_update
+ *
+ * Streaming UPDATE message decoder. Only the NLRI 
+ * of supported families (IPv4/IPv6 unicast and labeled 
+ * unicast) are processed, all other attributes are skipped.
+ *
+ * @param rib Adj-RIB-In
+ * @param start message start (BGP header)
+ * @param length message length
+ * @param store add/delete prefixes or count only
+ * @param eor families (BGP_IPV4_UC, ...) with End-of-RIB
+ *        received in this message
+ * @return false if message is malformed
+ */
+bool
+bgp_rib_decode_update(bgp_rib_s *rib, uint8_t *start, uint16_t length, bool store, uint32_t *eor)
+{
+    uint16_t withdrawn_len, attr_len, nlri_len;
+    uint32_t idx, attr_end; /* 32 bit to not wrap with invalid lengths */
+    uint16_t afi, len;
+    uint8_t flags, type, safi, nh_len;
+    bgp_rib_family_t family;
+
+    *eor = 0;
+    if(length < 23) {
+        return false;
+    }
+    idx = BGP_MIN_MESSAGE_SIZE;
+    withdrawn_len = read_be_uint(start+idx, 2);
+    idx += 2;
+    if(idx + withdrawn_len + 2 > length) {
+        return false;
+    }
+    if(!bgp_rib_decode_nlri(rib, BGP_RIB_IPV4_UC, start+idx, withdrawn_len, true, store)) {
+        return false;
+    }
+    idx += withdrawn_len;
+    attr_len = read_be_uint(start+idx, 2);
+    idx += 2;
+    if(idx + attr_len > length) {
+        return false;
+    }
+    attr_end = idx + attr_len;
+    nlri_len = length - attr_end;
+
+    if(withdrawn_len == 0 && attr_len == 0 && nlri_len == 0) {
+        bgp_rib_decode_eor(rib, BGP_RIB_IPV4_UC, eor);
+        return true;
+    }
+
+    /* Path attributes */
+    while(idx < attr_end) {
+        if(idx + 3 > attr_end) {
+            return false;
+        }
+        flags = start[idx];
+        type = start[idx+1];
+        if(flags & BGP_PATH_ATTR_FLAG_EXTENDED) {
+            if(idx + 4 > attr_end) {
+                return false;
+            }
+            len = read_be_uint(start+idx+2, 2);
+            idx += 4;
+        } else {
+            len = start[idx+2];
+            idx += 3;
+        }
+        if(idx + len > attr_end) {
+            return false;
+        }
+        switch(type) {
+            case BGP_PATH_ATTR_MP_REACH:
+                if(len < 5) {
+                    return false;
+                }
+                afi = read_be_uint(start+idx, 2);
+                safi = start[idx+2];
+                nh_len = start[idx+3];
+                if(5 + nh_len > len) {
+                    return false;
+                }
+                if(bgp_rib_decode_family(afi, safi, &family)) {
+                    if(!bgp_rib_decode_nlri(rib, family, start+idx+5+nh_len, len-5-nh_len, false, store)) {
+                        return false;
+                    }
+                }
+                break;
+            case BGP_PATH_ATTR_MP_UNREACH:
+                if(len < 3) {
+                    return false;
+                }
+                afi = read_be_uint(start+idx, 2);
+                safi = start[idx+2];
+                if(bgp_rib_decode_family(afi, safi, &family)) {
+                    if(len == 3) {
+                        bgp_rib_decode_eor(rib, family, eor);
+                    } else if(!bgp_rib_decode_nlri(rib, family, start+idx+3, len-3, true, store)) {
+                        return false;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+        idx += len;
+    }
+
+    return bgp_rib_decode_nlri(rib, BGP_RIB_IPV4_UC, start+attr_end, nlri_len, false, store);
+}
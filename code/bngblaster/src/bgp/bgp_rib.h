@@ -0,0 +1,28 @@
+/*
+ * BNG Blaster (BBL) - BGP Adj-RIB-In
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_BGP_RIB_H__
+#define __BBL_BGP_RIB_H__
+
+const char *
+bgp_rib_family_string(bgp_rib_family_t family);
+
+uint32_t
+bgp_rib_family_flag(bgp_rib_family_t family);
+
+bool
+bgp_rib_add(bgp_rib_s *rib, bgp_rib_entry_s *key);
+
+bool
+bgp_rib_del(bgp_rib_s *rib, bgp_rib_entry_s *key);
+
+void
+bgp_rib_free(bgp_rib_s *rib);
+
+bool
+bgp_rib_decode_update(bgp_rib_s *rib, uint8_t *start, uint16_t length, bool store, uint32_t *eor);
+
+#endif
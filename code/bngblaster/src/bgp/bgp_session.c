@@ -101,8 +101,6 @@ bgp_raw_update_stop_cb(void *arg)
                  &session->update_start_timestamp);
 
     session->raw_update_sending = false;
-    session->stats.message_tx += session->raw_update->updates;
-    session->stats.update_tx += session->raw_update->updates;
     
     LOG(BGP, "BGP (%s %s - %s) raw update stop after %lds\n",
         session->interface->name,
@@ -110,6 +108,17 @@ bgp_raw_update_stop_cb(void *arg)
         session->peer_address_str,
         session->update_duration.tv_sec);
 
+    if(session->raw_update_offset < session->raw_update->len) {
+        /* Do not start traffic if the RAW update file 
+         * is invalid or was modified while sending. */
+        LOG(ERROR, "BGP (%s %s - %s) raw update failed at offset %u of %u bytes\n",
+            session->interface->name,
+            session->local_address_str,
+            session->peer_address_str,
+            session->raw_update_offset, session->raw_update->len);
+        return;
+    }
+
     if(session->config->start_traffic) {
         LOG(BGP, "BGP (%s %s - %s) start traffic streams\n",
             session->interface->name,
@@ -119,26 +128,140 @@ bgp_raw_update_stop_cb(void *arg)
     }
 }
 
+/**
+ * bgp_raw_update_idle_cb
+ *
+ * Called if the previous chunk of the RAW update
+ * file is fully acknowledged to validate and send
+ * the next one directly from the file mapping.
+ */
+static void 
+bgp_raw_update_idle_cb(void *arg)
+{
+    bgp_session_s *session = (bgp_session_s*)arg;
+    bgp_raw_update_s *raw_update = session->raw_update;
+    uint32_t updates;
+    uint32_t len;
+
+    len = bgp_raw_update_chunk(raw_update, session->raw_update_offset, 
+                               session->max_message_size, &updates);
+    if(!len) {
+        bgp_raw_update_stop_cb(session);
+        return;
+    }
+    if(!bbl_tcp_send(session->tcpc, raw_update->buf + session->raw_update_offset, len)) {
+        return;
+    }
+    session->raw_update_offset += len;
+    session->update_bytes += len;
+    session->stats.message_tx += updates;
+    session->stats.update_tx += updates;
+}
+
+static void
+bgp_generator_stop(bgp_session_s *session)
+{
+    session->tcpc->idle_cb = NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, &session->update_stop_timestamp);
+    timespec_sub(&session->update_duration, 
+                 &session->update_stop_timestamp, 
+                 &session->update_start_timestamp);
+
+    session->raw_update_sending = false;
+
+    LOG(BGP, "BGP (%s %s - %s) update generator stop after %lds (%u prefixes, %u updates)\n",
+        session->interface->name,
+        session->local_address_str,
+        session->peer_address_str,
+        session->update_duration.tv_sec,
+        session->generator.prefixes,
+        session->generator.updates);
+
+    if(session->config->start_traffic) {
+        LOG(BGP, "BGP (%s %s - %s) start traffic streams\n",
+            session->interface->name,
+            session->local_address_str,
+            session->peer_address_str);
+        global_traffic_enable(true);
+    }
+}
+
+/**
+ * bgp_generator_idle_cb
+ *
+ * Called if the previous chunk of generated 
+ * updates is fully acknowledged to generate 
+ * and send the next one. 
+ */
+static void 
+bgp_generator_idle_cb(void *arg)
+{
+    bgp_session_s *session = (bgp_session_s*)arg;
+    uint32_t updates = session->generator.updates;
+    uint32_t len;
+
+    len = bgp_generator_fill(&session->generator, session->config->generator);
+    if(!len) {
+        bgp_generator_stop(session);
+        return;
+    }
+    if(!bbl_tcp_send(session->tcpc, session->generator.buf.data, len)) {
+        return;
+    }
+    updates = session->generator.updates - updates;
+    session->update_bytes += len;
+    session->stats.message_tx += updates;
+    session->stats.update_tx += updates;
+}
+
 void
 bgp_session_update_job(timer_s *timer) 
 {
     bgp_session_s *session = timer->data;
 
     if(session->state == BGP_ESTABLISHED) {
-        if(session->raw_update && !session->raw_update_sending) {
-            if(bbl_tcp_send(session->tcpc, session->raw_update->buf, session->raw_update->len)) {
-                session->raw_update_sending = true;
-
-                LOG(BGP, "BGP (%s %s - %s) raw update start\n",
+        if(session->config->generator && !session->generator.started) {
+            if(session->tcpc->state != BBL_TCP_STATE_IDLE) {
+                goto RETRY;
+            }
+            if(!bgp_generator_init(&session->generator, session->config->generator,
+                                   session->max_message_size)) {
+                LOG(ERROR, "BGP (%s %s - %s) failed to init update generator\n",
                     session->interface->name,
                     session->local_address_str,
                     session->peer_address_str);
+                timer->periodic = false;
+                return;
+            }
+            session->raw_update_sending = true;
+            session->update_bytes = 0;
 
-                clock_gettime(CLOCK_MONOTONIC, &session->update_start_timestamp);
-                session->tcpc->idle_cb = bgp_raw_update_stop_cb;
-            } else {
+            LOG(BGP, "BGP (%s %s - %s) update generator start (%u prefixes per update)\n",
+                session->interface->name,
+                session->local_address_str,
+                session->peer_address_str,
+                session->generator.nlri_max);
+
+            clock_gettime(CLOCK_MONOTONIC, &session->update_start_timestamp);
+            session->tcpc->idle_cb = bgp_generator_idle_cb;
+            bgp_generator_idle_cb(session);
+        } else if(session->raw_update && !session->raw_update_sending) {
+            if(session->tcpc->state != BBL_TCP_STATE_IDLE) {
                 goto RETRY;
             }
+            session->raw_update_sending = true;
+            session->raw_update_offset = 0;
+            session->update_bytes = 0;
+
+            LOG(BGP, "BGP (%s %s - %s) raw update start\n",
+                session->interface->name,
+                session->local_address_str,
+                session->peer_address_str);
+
+            clock_gettime(CLOCK_MONOTONIC, &session->update_start_timestamp);
+            session->tcpc->idle_cb = bgp_raw_update_idle_cb;
+            bgp_raw_update_idle_cb(session);
         }
     }
     timer->periodic = false;
@@ -335,6 +458,8 @@ bgp_session_connect(bgp_session_s *session, time_t delay)
         session->peer.as = 0;
         session->peer.id = 0;
         session->peer.hold_time = 0;
+        session->peer.extended_message = false;
+        session->max_message_size = BGP_MAX_MESSAGE_SIZE;
 
         session->stats.message_rx = 0;
         session->stats.message_tx = 0;
@@ -345,6 +470,9 @@ bgp_session_connect(bgp_session_s *session, time_t delay)
 
         session->raw_update = session->raw_update_start;
         session->raw_update_sending = false;
+        session->generator.started = false;
+
+        bgp_rib_free(&session->adj_rib_in);
 
         session->established_timestamp.tv_sec = 0;
         session->established_timestamp.tv_nsec = 0;
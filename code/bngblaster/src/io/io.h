@@ -10,6 +10,7 @@
 #define __BBL_IO_H__
 
 #include <assert.h>
+#include <sys/eventfd.h>
 
 #include "../bbl.h"
 #include "../bbl_pcap.h"
@@ -26,6 +27,7 @@
 
 #include "io_raw.h"
 #include "io_packet_mmap.h"
+#include "io_af_xdp.h"
 
 #ifdef BNGBLASTER_DPDK
 #include "io_dpdk.h"
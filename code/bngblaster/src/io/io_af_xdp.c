@@ -0,0 +1,938 @@
+/*
+ * BNG Blaster (BBL) - IO AF_XDP
+ *
+ * AF_XDP sockets receive packets directly from the driver via a small
+ * XDP program redirecting all packets of a NIC queue into the socket
+ * bound to this queue. Packet buffers are located in a user space memory
+ * area (UMEM) shared with the kernel, which is divided into equal sized
+ * frames. The frames are passed between user space and kernel using four
+ * single producer/single consumer rings (fill, completion, RX and TX).
+ *
+ * Each IO handle is bound to the NIC queue matching its identifier.
+ * The first RX or TX IO handle of a queue creates the UMEM of this
+ * queue, sized for both directions, and the other one shares this
+ * UMEM (XDP_SHARED_UMEM) with the first half of the frames reserved
+ * for RX (fill ring) and the second half for TX (completion ring).
+ * This allows RX and TX threads to access the UMEM rings lock-free.
+ *
+ * This implementation uses the kernel UAPI directly, such that no
+ * further libraries (libbpf/libxdp) are required.
+ *
+ * https://www.kernel.org/doc/html/latest/networking/af_xdp.html
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "io.h"
+
+#include <linux/if_xdp.h>
+#include <linux/bpf.h>
+#include <sys/syscall.h>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+#define IO_XSK_FRAME_SIZE   4096
+#define IO_XSK_FILL_MIN     64
+
+extern bool g_init_phase;
+extern bool g_traffic;
+
+typedef struct io_xsk_ring_ {
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void *ring;
+    void *map;
+    size_t map_len;
+    uint32_t size;
+    uint32_t mask;
+    uint32_t cached_prod;
+    uint32_t cached_cons;
+} io_xsk_ring_s;
+
+typedef struct io_xsk_umem_ {
+    int fd; /* socket owning the UMEM */
+    uint32_t queue;
+    uint8_t *area;
+    uint64_t area_len;
+    uint32_t frames_rx; /* frames reserved for RX */
+    uint32_t frames_tx; /* frames reserved for TX */
+    io_xsk_ring_s fill;
+    io_xsk_ring_s comp;
+    struct io_xsk_umem_ *next;
+} io_xsk_umem_s;
+
+typedef struct io_xsk_ {
+    io_xsk_umem_s *umem;
+    io_xsk_ring_s ring; /* RX or TX ring */
+    uint64_t *frames; /* free TX frames (stack) */
+    uint32_t frames_free;
+    bool zero_copy;
+} io_xsk_s;
+
+/* Ring Functions */
+
+static inline uint32_t
+xsk_cons_peek(io_xsk_ring_s *ring, uint32_t max)
+{
+    uint32_t entries = ring->cached_prod - ring->cached_cons;
+    if(entries == 0) {
+        ring->cached_prod = __atomic_load_n(ring->producer, __ATOMIC_ACQUIRE);
+        entries = ring->cached_prod - ring->cached_cons;
+    }
+    return entries > max ? max : entries;
+}
+
+static inline void
+xsk_cons_release(io_xsk_ring_s *ring, uint32_t entries)
+{
+    ring->cached_cons += entries;
+    __atomic_store_n(ring->consumer, ring->cached_cons, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t
+xsk_prod_free(io_xsk_ring_s *ring, uint32_t min)
+{
+    uint32_t free = ring->size - (ring->cached_prod - ring->cached_cons);
+    if(free < min) {
+        ring->cached_cons = __atomic_load_n(ring->consumer, __ATOMIC_ACQUIRE);
+        free = ring->size - (ring->cached_prod - ring->cached_cons);
+    }
+    return free;
+}
+
+static inline void
+xsk_prod_submit(io_xsk_ring_s *ring)
+{
+    __atomic_store_n(ring->producer, ring->cached_prod, __ATOMIC_RELEASE);
+}
+
+static inline struct xdp_desc *
+xsk_desc(io_xsk_ring_s *ring, uint32_t idx)
+{
+    return &((struct xdp_desc*)ring->ring)[idx & ring->mask];
+}
+
+static inline uint64_t *
+xsk_addr(io_xsk_ring_s *ring, uint32_t idx)
+{
+    return &((uint64_t*)ring->ring)[idx & ring->mask];
+}
+
+static uint32_t
+xsk_ring_size(uint32_t slots)
+{
+    uint32_t size = IO_XSK_FILL_MIN;
+    while(size < slots) {
+        size <<= 1;
+    }
+    return size;
+}
+
+static bool
+xsk_ring_mmap(io_handle_s *io, int fd, io_xsk_ring_s *ring, struct xdp_ring_offset *offset,
+              uint32_t size, size_t entry_len, off_t pgoff)
+{
+    uint8_t *map;
+    size_t map_len = offset->desc + (size * entry_len);
+
+    map = mmap(NULL, map_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, pgoff);
+    if(map == MAP_FAILED) {
+        LOG(ERROR, "Failed to map AF_XDP ring for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    ring->producer = (uint32_t*)(map + offset->producer);
+    ring->consumer = (uint32_t*)(map + offset->consumer);
+    ring->flags = (uint32_t*)(map + offset->flags);
+    ring->ring = map + offset->desc;
+    ring->map = map;
+    ring->map_len = map_len;
+    ring->size = size;
+    ring->mask = size - 1;
+    ring->cached_prod = *ring->producer;
+    ring->cached_cons = *ring->consumer;
+    return true;
+}
+
+static void
+xsk_ring_unmap(io_xsk_ring_s *ring)
+{
+    if(ring->map) {
+        munmap(ring->map, ring->map_len);
+        ring->map = NULL;
+    }
+}
+
+/* XDP Program */
+
+static int
+xdp_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/**
+ * Load and attach the XDP program redirecting all packets
+ * received on a NIC queue to the AF_XDP socket stored in the
+ * socket map at the index of this queue. Packets received
+ * on queues without socket are passed to the kernel.
+ */
+static bool
+xdp_prog_attach(bbl_interface_s *interface)
+{
+    bbl_link_config_s *config = interface->config;
+    union bpf_attr attr;
+    int prog_fd;
+
+    uint32_t queues = config->rx_threads ? config->rx_threads : 1;
+
+    if(interface->io.xdp_link_fd) {
+        return true;
+    }
+
+    memset(&attr, 0x0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = queues;
+    interface->io.xdp_map_fd = xdp_bpf(BPF_MAP_CREATE, &attr);
+    if(interface->io.xdp_map_fd < 0) {
+        LOG(ERROR, "Failed to create AF_XDP socket map for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        return false;
+    }
+
+    struct bpf_insn prog[] = {
+        /* r2 = ctx->rx_queue_index */
+        { .code = BPF_LDX|BPF_MEM|BPF_W, .dst_reg = BPF_REG_2, .src_reg = BPF_REG_1,
+          .off = offsetof(struct xdp_md, rx_queue_index) },
+        /* r1 = socket map */
+        { .code = BPF_LD|BPF_DW|BPF_IMM, .dst_reg = BPF_REG_1, .src_reg = BPF_PSEUDO_MAP_FD,
+          .imm = interface->io.xdp_map_fd },
+        { .code = 0 },
+        /* r3 = XDP_PASS (default action if no socket is bound to queue) */
+        { .code = BPF_ALU64|BPF_MOV|BPF_K, .dst_reg = BPF_REG_3, .imm = XDP_PASS },
+        /* r0 = bpf_redirect_map(r1, r2, r3) */
+        { .code = BPF_JMP|BPF_CALL, .imm = BPF_FUNC_redirect_map },
+        { .code = BPF_JMP|BPF_EXIT },
+    };
+    const char license[] = "Dual BSD/GPL";
+
+    memset(&attr, 0x0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uintptr_t)prog;
+    attr.insn_cnt = sizeof(prog)/sizeof(prog[0]);
+    attr.license = (uintptr_t)license;
+    snprintf(attr.prog_name, sizeof(attr.prog_name), "bbl_xsk");
+    prog_fd = xdp_bpf(BPF_PROG_LOAD, &attr);
+    if(prog_fd < 0) {
+        LOG(ERROR, "Failed to load AF_XDP program for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        goto ERROR;
+    }
+
+    /* The program is detached automatically
+     * if the link is closed (process exits). */
+    memset(&attr, 0x0, sizeof(attr));
+    attr.link_create.prog_fd = prog_fd;
+    attr.link_create.target_ifindex = interface->kernel_index;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = config->xdp_flags;
+    interface->io.xdp_link_fd = xdp_bpf(BPF_LINK_CREATE, &attr);
+    close(prog_fd);
+    if(interface->io.xdp_link_fd < 0) {
+        LOG(ERROR, "Failed to attach AF_XDP program to interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        interface->io.xdp_link_fd = 0;
+        goto ERROR;
+    }
+    LOG(DEBUG, "AF_XDP program attached to interface %s (%u queues)\n",
+        interface->name, queues);
+    return true;
+
+ERROR:
+    close(interface->io.xdp_map_fd);
+    interface->io.xdp_map_fd = 0;
+    return false;
+}
+
+static bool
+xdp_map_update(io_handle_s *io)
+{
+    union bpf_attr attr;
+    uint32_t queue = io->id;
+    uint32_t fd = io->fd;
+
+    memset(&attr, 0x0, sizeof(attr));
+    attr.map_fd = io->interface->io.xdp_map_fd;
+    attr.key = (uintptr_t)&queue;
+    attr.value = (uintptr_t)&fd;
+    attr.flags = BPF_ANY;
+    if(xdp_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+        LOG(ERROR, "Failed to add AF_XDP socket for interface %s queue %u - %s (%d)\n",
+            io->interface->name, queue, strerror(errno), errno);
+        return false;
+    }
+    return true;
+}
+
+/* UMEM */
+
+static io_xsk_umem_s *
+xsk_umem_get(bbl_interface_s *interface, uint32_t queue)
+{
+    io_xsk_umem_s *umem = interface->io.xsk_umem;
+    while(umem) {
+        if(umem->queue == queue) {
+            return umem;
+        }
+        umem = umem->next;
+    }
+    return NULL;
+}
+
+static io_xsk_umem_s *
+xsk_umem_create(io_handle_s *io, struct xdp_mmap_offsets *offsets)
+{
+    bbl_interface_s *interface = io->interface;
+    bbl_link_config_s *config = interface->config;
+    io_xsk_umem_s *umem;
+    struct xdp_umem_reg reg = {0};
+    socklen_t optlen = sizeof(*offsets);
+    uint32_t rx_queues = config->rx_threads ? config->rx_threads : 1;
+    uint32_t tx_queues = config->tx_threads ? config->tx_threads : 1;
+    int fill_size = IO_XSK_FILL_MIN;
+    int comp_size = IO_XSK_FILL_MIN;
+
+    umem = calloc(1, sizeof(io_xsk_umem_s));
+    if(!umem) return NULL;
+    umem->fd = io->fd;
+    umem->queue = io->id;
+    /* Reserve frames for the RX and TX IO handle of this
+     * queue, independent of which one is created first. */
+    if(umem->queue < rx_queues) {
+        umem->frames_rx = xsk_ring_size(config->io_slots_rx);
+        fill_size = umem->frames_rx;
+    }
+    if(umem->queue < tx_queues) {
+        umem->frames_tx = xsk_ring_size(config->io_slots_tx);
+        comp_size = umem->frames_tx;
+    }
+    umem->area_len = (uint64_t)(umem->frames_rx + umem->frames_tx) * IO_XSK_FRAME_SIZE;
+    umem->area = mmap(NULL, umem->area_len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(umem->area == MAP_FAILED) {
+        LOG(ERROR, "Failed to allocate %lu byte AF_XDP UMEM for interface %s\n",
+            umem->area_len, interface->name);
+        free(umem);
+        return NULL;
+    }
+
+    reg.addr = (uintptr_t)umem->area;
+    reg.len = umem->area_len;
+    reg.chunk_size = IO_XSK_FRAME_SIZE;
+    reg.headroom = 0;
+    if(setsockopt(io->fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) == -1 ||
+       setsockopt(io->fd, SOL_XDP, XDP_UMEM_FILL_RING, &fill_size, sizeof(fill_size)) == -1 ||
+       setsockopt(io->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &comp_size, sizeof(comp_size)) == -1 ||
+       getsockopt(io->fd, SOL_XDP, XDP_MMAP_OFFSETS, offsets, &optlen) == -1) {
+        LOG(ERROR, "Failed to register AF_XDP UMEM for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        goto ERROR;
+    }
+    if(!xsk_ring_mmap(io, io->fd, &umem->fill, &offsets->fr, fill_size,
+                      sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING)) {
+        goto ERROR;
+    }
+    if(!xsk_ring_mmap(io, io->fd, &umem->comp, &offsets->cr, comp_size,
+                      sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING)) {
+        goto ERROR;
+    }
+
+    LOG(DEBUG, "Setup %lu byte AF_XDP UMEM (%u RX and %u TX frames) for interface %s queue %u\n",
+        umem->area_len, umem->frames_rx, umem->frames_tx, interface->name, umem->queue);
+
+    umem->next = interface->io.xsk_umem;
+    interface->io.xsk_umem = umem;
+    return umem;
+
+ERROR:
+    xsk_ring_unmap(&umem->fill);
+    munmap(umem->area, umem->area_len);
+    free(umem);
+    return NULL;
+}
+
+static void
+xsk_umem_free(bbl_interface_s *interface, io_xsk_umem_s *umem)
+{
+    io_xsk_umem_s **prev = &interface->io.xsk_umem;
+
+    while(*prev) {
+        if(*prev == umem) {
+            *prev = umem->next;
+            break;
+        }
+        prev = &(*prev)->next;
+    }
+    xsk_ring_unmap(&umem->fill);
+    xsk_ring_unmap(&umem->comp);
+    munmap(umem->area, umem->area_len);
+    free(umem);
+}
+
+/* RX/TX Helper */
+
+static void
+xsk_rx_wakeup(io_handle_s *io)
+{
+    io_xsk_s *xsk = io->xsk;
+    if(*xsk->umem->fill.flags & XDP_RING_NEED_WAKEUP) {
+        io->stats.polled++;
+        recvfrom(io->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+    }
+}
+
+/**
+ * Return RX frames to the fill ring and
+ * release them from the RX ring.
+ */
+static void
+xsk_rx_release(io_xsk_s *xsk, uint32_t count)
+{
+    io_xsk_ring_s *fill = &xsk->umem->fill;
+    uint32_t i;
+
+    if(!count) return;
+    xsk_prod_free(fill, count);
+    for(i = 0; i < count; i++) {
+        *xsk_addr(fill, fill->cached_prod++) =
+            xsk_desc(&xsk->ring, xsk->ring.cached_cons + i)->addr & ~((uint64_t)IO_XSK_FRAME_SIZE-1);
+    }
+    xsk_prod_submit(fill);
+    xsk_cons_release(&xsk->ring, count);
+}
+
+/**
+ * Reclaim TX frames from completion ring.
+ */
+static void
+xsk_tx_complete(io_xsk_s *xsk)
+{
+    io_xsk_ring_s *comp = &xsk->umem->comp;
+    uint32_t count, i;
+
+    count = xsk_cons_peek(comp, comp->size);
+    if(count) {
+        for(i = 0; i < count; i++) {
+            xsk->frames[xsk->frames_free++] = *xsk_addr(comp, comp->cached_cons + i);
+        }
+        xsk_cons_release(comp, count);
+    }
+}
+
+/**
+ * Notify kernel about new packets in the TX ring.
+ *
+ * In copy mode, the kernel sends only a limited number of packets
+ * per system call, such that this needs to be repeated until all
+ * packets are consumed.
+ */
+static void
+xsk_tx_kick(io_handle_s *io)
+{
+    io_xsk_s *xsk = io->xsk;
+    io_xsk_ring_s *ring = &xsk->ring;
+    uint32_t retry = io->queued;
+
+    xsk_prod_submit(ring);
+    io->queued = 0;
+    while(retry--) {
+        if(!(__atomic_load_n(ring->flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP)) {
+            break;
+        }
+        if(sendto(io->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0) {
+            if(errno != EAGAIN && errno != EBUSY && errno != ENOBUFS && errno != ENETDOWN) {
+                LOG(IO, "AF_XDP sendto on interface %s failed with error %s (%d)\n",
+                    io->interface->name, strerror(errno), errno);
+                io->stats.io_errors++;
+            }
+            break;
+        }
+        if(xsk->zero_copy ||
+           __atomic_load_n(ring->consumer, __ATOMIC_ACQUIRE) == ring->cached_prod) {
+            break;
+        }
+    }
+}
+
+/**
+ * Get next TX frame if there is space
+ * left in the TX ring.
+ */
+static inline bool
+xsk_tx_frame(io_handle_s *io, uint64_t *addr)
+{
+    io_xsk_s *xsk = io->xsk;
+    if(unlikely(xsk->frames_free == 0 || xsk_prod_free(&xsk->ring, 1) == 0)) {
+        io->stats.no_buffer++;
+        return false;
+    }
+    *addr = xsk->frames[--xsk->frames_free];
+    io->buf = xsk->umem->area + *addr;
+    return true;
+}
+
+static inline void
+xsk_tx_push(io_handle_s *io, uint64_t addr)
+{
+    io_xsk_s *xsk = io->xsk;
+    struct xdp_desc *desc = xsk_desc(&xsk->ring, xsk->ring.cached_prod++);
+    desc->addr = addr;
+    desc->len = io->buf_len;
+    desc->options = 0;
+    io->queued++;
+    io->stats.packets++;
+    io->stats.bytes += io->buf_len;
+}
+
+/**
+ * This job is for AF_XDP RX in main thread!
+ */
+void
+io_af_xdp_rx_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+    io_xsk_s *xsk = io->xsk;
+    bbl_interface_s *interface = io->interface;
+
+    struct xdp_desc *desc;
+    uint32_t count, i;
+
+    bbl_ethernet_header_s *eth;
+
+    protocol_error_t decode_result;
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread == NULL);
+
+    count = xsk_cons_peek(&xsk->ring, xsk->ring.size);
+    if(!count) {
+        xsk_rx_wakeup(io);
+        return;
+    }
+
+    /* Get RX timestamp */
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    for(i = 0; i < count; i++) {
+        desc = xsk_desc(&xsk->ring, xsk->ring.cached_cons + i);
+        io->buf = xsk->umem->area + desc->addr;
+        io->buf_len = desc->len;
+        io->stats.packets++;
+        io->stats.bytes += io->buf_len;
+        decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+        if(decode_result == PROTOCOL_SUCCESS) {
+            /* Copy RX timestamp */
+            eth->timestamp.tv_sec = io->timestamp.tv_sec;
+            eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+            /* Dump the packet into pcap file */
+            if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+                pcap = true;
+                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+            }
+            bbl_rx_handler(interface, eth);
+        } else {
+            /* Dump the packet into pcap file */
+            if(g_ctx->pcap.write_buf) {
+                pcap = true;
+                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+            }
+            if(decode_result == UNKNOWN_PROTOCOL) {
+                io->stats.unknown++;
+            } else {
+                io->stats.protocol_errors++;
+            }
+        }
+    }
+    /* Return ownership back to kernel */
+    xsk_rx_release(xsk, count);
+    if(pcap) {
+        pcapng_fflush();
+    }
+}
+
+/**
+ * This job is for AF_XDP TX in main thread!
+ */
+void
+io_af_xdp_tx_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+    io_xsk_s *xsk = io->xsk;
+    bbl_interface_s *interface = io->interface;
+
+    bbl_stream_s *stream = NULL;
+    uint16_t burst = interface->config->io_burst;
+    uint64_t addr;
+    uint64_t now;
+
+    bool ctrl = true;
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_EGRESS);
+    assert(io->thread == NULL);
+
+    if(io->update_streams) {
+        io_stream_update_pps(io);
+    }
+
+    xsk_tx_complete(xsk);
+
+    /* Get TX timestamp */
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    now = timespec_to_nsec(timer->timestamp);
+    while(burst) {
+        if(!xsk_tx_frame(io, &addr)) {
+            break;
+        }
+        if(unlikely(ctrl)) {
+            /* First send all control traffic which has higher priority. */
+            if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                xsk->frames[xsk->frames_free++] = addr;
+                ctrl = false;
+                continue;
+            }
+        } else {
+            if(!(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP)) {
+                xsk->frames[xsk->frames_free++] = addr;
+                bbl_stream_io_stop(io);
+                break;
+            }
+            stream = bbl_stream_io_send_iter(io, now);
+            if(unlikely(stream == NULL)) {
+                xsk->frames[xsk->frames_free++] = addr;
+                break;
+            }
+            memcpy(io->buf, stream->tx_buf, stream->tx_len);
+            io->buf_len = stream->tx_len;
+            stream->tx_packets++;
+            stream->flow_seq++;
+        }
+        xsk_tx_push(io, addr);
+        burst--;
+
+        /* Dump the packet into pcap file. */
+        if(g_ctx->pcap.write_buf && (ctrl || g_ctx->pcap.include_streams)) {
+            pcap = true;
+            pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                      interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
+        }
+    }
+    if(pcap) {
+        pcapng_fflush();
+    }
+    if(io->queued) {
+        xsk_tx_kick(io);
+    }
+}
+
+void
+io_af_xdp_thread_rx_run_fn(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+    io_xsk_s *xsk = io->xsk;
+
+    struct xdp_desc *desc;
+    uint32_t count, i;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread);
+
+    struct timespec sleep, rem;
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 10000; /* 0.01ms */
+
+    io->vlan_tci = 0;
+    while(thread->active) {
+        count = xsk_cons_peek(&xsk->ring, xsk->ring.size);
+        if(!count) {
+            xsk_rx_wakeup(io);
+            io_thread_rx_wait(thread, io, &sleep);
+            continue;
+        }
+        thread->idle = 0;
+
+        /* Get RX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        for(i = 0; i < count; i++) {
+            desc = xsk_desc(&xsk->ring, xsk->ring.cached_cons + i);
+            io->buf = xsk->umem->area + desc->addr;
+            io->buf_len = desc->len;
+            /* Process packet */
+            if(io_thread_rx_handler(thread, io) == IO_FULL) {
+                break;
+            }
+        }
+        /* Return ownership back to kernel */
+        xsk_rx_release(xsk, i);
+        if(i < count) {
+            nanosleep(&sleep, &rem);
+        }
+    }
+}
+
+void
+io_af_xdp_thread_tx_run_fn(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+    io_xsk_s *xsk = io->xsk;
+    bbl_interface_s *interface = io->interface;
+
+    bbl_txq_s *txq = thread->txq;
+    bbl_txq_slot_t *slot;
+
+    bbl_stream_s *stream = NULL;
+    uint16_t io_burst = interface->config->io_burst;
+    uint16_t burst = 0;
+    uint64_t addr;
+    uint64_t now;
+
+    bool ctrl = true;
+
+    struct timespec sleep;
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 10;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_EGRESS);
+    assert(io->thread);
+
+    while(thread->active) {
+        io_thread_tx_wait(thread, io, &sleep);
+        if(io->update_streams) {
+            io_stream_update_pps(io);
+        }
+
+        xsk_tx_complete(xsk);
+
+        /* Get TX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+
+        burst = io_burst;
+        ctrl = true;
+        now = timespec_to_nsec(&io->timestamp);
+        while(burst) {
+            if(!xsk_tx_frame(io, &addr)) {
+                break;
+            }
+            if(unlikely(ctrl)) {
+                /* First send all control traffic which has higher priority. */
+                slot = bbl_txq_read_slot(txq);
+                if(slot) {
+                    io->buf_len = slot->packet_len;
+                    memcpy(io->buf, slot->packet, slot->packet_len);
+                    bbl_txq_read_next(txq);
+                } else {
+                    xsk->frames[xsk->frames_free++] = addr;
+                    ctrl = false;
+                    continue;
+                }
+            } else {
+                if(!(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP)) {
+                    xsk->frames[xsk->frames_free++] = addr;
+                    bbl_stream_io_stop(io);
+                    break;
+                }
+                /* Send traffic streams up to allowed burst. */
+                stream = bbl_stream_io_send_iter(io, now);
+                if(unlikely(stream == NULL)) {
+                    xsk->frames[xsk->frames_free++] = addr;
+                    break;
+                }
+                memcpy(io->buf, stream->tx_buf, stream->tx_len);
+                io->buf_len = stream->tx_len;
+                stream->tx_packets++;
+                stream->flow_seq++;
+            }
+            xsk_tx_push(io, addr);
+            burst--;
+        }
+        if(io->queued) {
+            xsk_tx_kick(io);
+        }
+    }
+}
+
+static bool
+io_af_xdp_socket_open(io_handle_s *io)
+{
+    bbl_interface_s *interface = io->interface;
+    bbl_link_config_s *config = interface->config;
+
+    io_xsk_s *xsk;
+    io_xsk_umem_s *umem = NULL;
+    struct xdp_mmap_offsets offsets = {0};
+    struct sockaddr_xdp sxdp = {0};
+    struct xdp_options options = {0};
+    socklen_t optlen;
+    uint32_t i;
+
+    int ring_size;
+    int ring_opt = XDP_RX_RING;
+
+    xsk = calloc(1, sizeof(io_xsk_s));
+    if(!xsk) return false;
+    io->xsk = xsk;
+
+    io->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if(io->fd == -1) {
+        LOG(ERROR, "Failed to open AF_XDP socket for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        goto ERROR;
+    }
+
+    umem = xsk_umem_get(interface, io->id);
+    if(umem) {
+        /* Share UMEM with RX socket of the same queue. */
+        sxdp.sxdp_flags = XDP_SHARED_UMEM;
+        sxdp.sxdp_shared_umem_fd = umem->fd;
+    } else {
+        umem = xsk_umem_create(io, &offsets);
+        if(!umem) {
+            goto ERROR;
+        }
+        sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP;
+    }
+    xsk->umem = umem;
+
+    if(io->direction == IO_INGRESS) {
+        ring_size = xsk_ring_size(config->io_slots_rx);
+    } else {
+        ring_opt = XDP_TX_RING;
+        ring_size = xsk_ring_size(config->io_slots_tx);
+    }
+    optlen = sizeof(offsets);
+    if(setsockopt(io->fd, SOL_XDP, ring_opt, &ring_size, sizeof(ring_size)) == -1 ||
+       getsockopt(io->fd, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &optlen) == -1) {
+        LOG(ERROR, "Failed to setup AF_XDP ring for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        goto ERROR;
+    }
+    if(io->direction == IO_INGRESS) {
+        if(!xsk_ring_mmap(io, io->fd, &xsk->ring, &offsets.rx, ring_size,
+                          sizeof(struct xdp_desc), XDP_PGOFF_RX_RING)) {
+            goto ERROR;
+        }
+        /* Pass all RX frames to the kernel. */
+        for(i = 0; i < umem->frames_rx; i++) {
+            *xsk_addr(&umem->fill, umem->fill.cached_prod++) = (uint64_t)i * IO_XSK_FRAME_SIZE;
+        }
+        xsk_prod_submit(&umem->fill);
+    } else {
+        if(!xsk_ring_mmap(io, io->fd, &xsk->ring, &offsets.tx, ring_size,
+                          sizeof(struct xdp_desc), XDP_PGOFF_TX_RING)) {
+            goto ERROR;
+        }
+        xsk->frames = calloc(umem->frames_tx, sizeof(uint64_t));
+        if(!xsk->frames) goto ERROR;
+        for(i = 0; i < umem->frames_tx; i++) {
+            xsk->frames[xsk->frames_free++] = (uint64_t)(umem->frames_rx + i) * IO_XSK_FRAME_SIZE;
+        }
+    }
+
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = interface->kernel_index;
+    sxdp.sxdp_queue_id = io->id;
+    if(bind(io->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)) == -1) {
+        LOG(ERROR, "Failed to bind AF_XDP socket for interface %s queue %u - %s (%d)\n",
+            interface->name, io->id, strerror(errno), errno);
+        goto ERROR;
+    }
+
+    optlen = sizeof(options);
+    if(getsockopt(io->fd, SOL_XDP, XDP_OPTIONS, &options, &optlen) == 0) {
+        xsk->zero_copy = options.flags & XDP_OPTIONS_ZEROCOPY;
+    }
+    LOG(DEBUG, "Setup AF_XDP %s socket (%d slots) for interface %s queue %u (%s)\n",
+        io->direction == IO_INGRESS ? "RX" : "TX", ring_size,
+        interface->name, io->id, xsk->zero_copy ? "zero-copy" : "copy");
+    return true;
+
+ERROR:
+    xsk_ring_unmap(&xsk->ring);
+    if(umem && umem->fd == io->fd) {
+        /* UMEM created by this socket is not shared yet. */
+        xsk_umem_free(interface, umem);
+    }
+    if(io->fd != -1) {
+        close(io->fd);
+        io->fd = -1;
+    }
+    free(xsk->frames);
+    free(xsk);
+    io->xsk = NULL;
+    return false;
+}
+
+bool
+io_af_xdp_init(io_handle_s *io)
+{
+    bbl_interface_s *interface = io->interface;
+    bbl_link_config_s *config = interface->config;
+
+    io_thread_s *thread = io->thread;
+
+    if(!xdp_prog_attach(interface)) {
+        return false;
+    }
+    if(!io_af_xdp_socket_open(io)) {
+        return false;
+    }
+    if(io->direction == IO_INGRESS) {
+        if(!xdp_map_update(io)) {
+            return false;
+        }
+    }
+
+    if(thread) {
+        if(io->direction == IO_INGRESS) {
+            thread->run_fn = io_af_xdp_thread_rx_run_fn;
+        } else {
+            thread->run_fn = io_af_xdp_thread_tx_run_fn;
+        }
+    } else {
+        if(io->direction == IO_INGRESS) {
+            if(!io_interface_rx_job_add(io, &io_af_xdp_rx_job)) {
+                return false;
+            }
+        } else {
+            timer_add_periodic(&g_ctx->timer_root, &interface->io.tx_job, "TX", 0,
+                config->tx_interval, io, &io_af_xdp_tx_job);
+        }
+    }
+    return true;
+}
+
+void
+io_af_xdp_set_max_stream_len()
+{
+    uint16_t len = IO_XSK_FRAME_SIZE - XDP_PACKET_HEADROOM - BBL_MAX_STREAM_OVERHEAD;
+
+    if(len < g_ctx->config.io_max_stream_len) {
+        LOG(DEBUG, "Set max allowed stream length to %u because of AF_XDP limitations\n", len);
+        g_ctx->config.io_max_stream_len = len;
+    }
+}
@@ -10,9 +10,16 @@
 #define __BBL_IO_DEF_H__
 
 #define IO_TOKENS_PER_PACKET 1000
+#define IO_TPACKET_V3_FRAME_SIZE 2048
+#define IO_THREAD_POLL_TIMEOUT 10 /* msec */
+#define IO_EVENT_RX_INTERVAL 1 /* sec, fallback RX job interval with event loop */
+#define IO_BUCKET_SLOTS_MIN 16 /* initial stream slots per bucket */
+#define IO_PACING_SPIN_NSEC 20000 /* busy wait for the last 20us before departure */
 
 typedef struct io_handle_ io_handle_s;
 typedef struct io_thread_ io_thread_s;
+typedef struct io_xsk_ io_xsk_s;
+typedef struct io_xsk_umem_ io_xsk_umem_s;
 
 typedef enum io_result_ {
     IO_SUCCESS,
@@ -40,6 +47,26 @@ typedef enum {
     IO_MODE_AF_XDP              /* AF_XDP */
 } __attribute__ ((__packed__)) io_mode_t;
 
+typedef enum {
+    IO_TIMESTAMPING_NONE = 0,   /* user space timestamps */
+    IO_TIMESTAMPING_SOFTWARE,   /* kernel software timestamps */
+    IO_TIMESTAMPING_HARDWARE    /* NIC hardware timestamps */
+} __attribute__ ((__packed__)) io_timestamping_t;
+
+typedef enum {
+    IO_TXTIME_NONE = 0,         /* software pacing only */
+    IO_TXTIME_FQ,               /* SO_TXTIME launch times (CLOCK_MONOTONIC) for fq qdisc */
+    IO_TXTIME_ETF               /* SO_TXTIME launch times (CLOCK_TAI) for etf qdisc */
+} __attribute__ ((__packed__)) io_txtime_t;
+
+/* Dense array of streams per bucket, which allows the TX
+ * threads to check which streams are due to be sent
+ * without dereferencing the streams itself. */
+typedef struct io_stream_slot_ {
+    uint64_t expired; /* offset in nsec from bucket base */
+    bbl_stream_s *stream;
+} io_stream_slot_s;
+
 typedef struct io_bucket_ {
     double pps;
     uint64_t nsec;
@@ -47,9 +74,10 @@ typedef struct io_bucket_ {
 
     struct io_bucket_ *next;
 
-    bbl_stream_s *stream_head;
-    bbl_stream_s *stream_cur;
+    io_stream_slot_s *slots;
+    io_stream_slot_s *slot_cur;
     uint32_t stream_count;
+    uint32_t slots_size;
 } io_bucket_s;
 
 typedef struct io_handle_ {
@@ -60,18 +88,39 @@ typedef struct io_handle_ {
     int fd;
     int fanout_id;
     int fanout_type;
-    struct tpacket_req req;
+    struct tpacket_req3 req;
     struct sockaddr_ll addr;
+    bool tpacket_v3; /* block based RX ring */
+    io_timestamping_t timestamping; /* RX timestamping */
 
     volatile bool update_streams;
+    volatile int64_t tx_lag; /* TX scheduling lag in nsec (moving average) */
+    bbl_stream_s *migrate_head; /* Streams handed over from other TX threads */
+
+    /* Per packet stream pacing (TX threads only) */
+    struct {
+        bool enabled;
+        io_txtime_t txtime;
+        uint64_t next; /* departure time of next packet in nsec (CLOCK_MONOTONIC) */
+        uint64_t interval; /* TX thread interval in nsec */
+        uint64_t delay; /* launch time delay in nsec (SO_TXTIME) */
+        int64_t offset; /* launch time clock offset in nsec (CLOCK_TAI) */
+    } pacing;
 
 #ifdef BNGBLASTER_DPDK
     struct rte_eth_dev_tx_buffer *tx_buffer;
     struct rte_mempool *mbuf_pool;
-    struct rte_mbuf *mbuf;
+    struct rte_mbuf **mbufs; /* TX burst */
+    uint16_t mbufs_count;
     uint16_t queue;
 #endif
 
+    io_xsk_s *xsk; /* AF_XDP socket */
+
+    struct mmsghdr *mmsg; /* RAW message vector */
+    uint8_t *mmsg_control; /* RAW message control buffers (timestamps) */
+    uint16_t mmsg_count;
+
     uint8_t *ring; /* ring buffer */
     unsigned int cursor; /* ring buffer cursor */
     unsigned int queued;
@@ -91,8 +140,11 @@ typedef struct io_handle_ {
 
     uint32_t stream_count;
     double stream_pps;
-    
+    double rebalance_pps; /* Stream PPS selected for migration */
+    struct io_handle_ *rebalance_target;
+
     struct timespec timestamp; /* user space timestamps */
+    struct timespec rx_timestamp; /* kernel/NIC RX timestamps (stream delay only) */
 
     struct {
         uint64_t packets;
@@ -103,7 +155,11 @@ typedef struct io_handle_ {
         uint64_t to_long;
         uint64_t no_buffer;
         uint64_t polled;
+        uint64_t batches;
         uint64_t dropped;
+        uint64_t streams_migrated_in;
+        uint64_t streams_migrated_out;
+        uint64_t pacing_late;
     } stats;
 
     struct io_handle_ *next;
@@ -125,6 +181,14 @@ typedef struct io_thread_ {
     io_thread_cb_fn teardown_fn;
 
     uint8_t *sp;
+    uint32_t idle; /* empty RX polls */
+
+    /* Event loop only (-1 otherwise). RX threads 
+     * notify the main thread about received packets,
+     * idle TX threads are woken up by the main thread. */
+    int event_fd;
+    bool signaled; /* RX thread has notified main thread */
+    bool sleeping; /* TX thread blocks on event_fd */
 
     io_handle_s *io;
     bbl_txq_s *txq;
@@ -34,6 +34,8 @@
 #include <rte_version.h>
 #include <rte_ethdev.h>
 #include <rte_malloc.h>
+#include <rte_memcpy.h>
+#include <rte_ip.h>
 
 #define NUM_MBUFS 8192
 #define MBUF_CACHE_SIZE 256
@@ -234,25 +236,232 @@ io_dpdk_rx_job(timer_s *timer)
     }
 }
 
-static bool
-io_dpdk_mbuf_alloc(io_handle_s *io)
+/**
+ * Stream packets exceeding the mbuf data room 
+ * can't be sent and are counted as to long.
+ */
+static void
+io_dpdk_tx_lo_long(io_handle_s *io)
+{
+    if(io->stats.to_long == 0) {
+        /* Log error for first oversized packet only! */
+        LOG(ERROR, "DPDK: interface %s failed to send to long packet (%u byte)\n", 
+            io->interface->name, io->buf_len);
+    }
+    io->stats.to_long++;
+}
+
+/**
+ * Get the mbuf of the next free TX burst slot 
+ * or NULL if the burst is full. 
+ * 
+ * Pending packets are located between io->cursor
+ * and io->cursor + io->queued. Slots which are not 
+ * pending keep their allocated mbuf for later use.
+ */
+static inline struct rte_mbuf *
+io_dpdk_tx_mbuf(io_handle_s *io)
+{
+    unsigned int i = io->cursor + io->queued;
+    if(unlikely(i >= io->mbufs_count)) {
+        return NULL;
+    }
+    if(!io->mbufs[i]) {
+        io->mbufs[i] = rte_pktmbuf_alloc(io->mbuf_pool);
+        if(unlikely(!io->mbufs[i])) {
+            io->stats.no_buffer++;
+            return NULL;
+        }
+    }
+    io->buf = rte_pktmbuf_mtod(io->mbufs[i], uint8_t *);
+    return io->mbufs[i];
+}
+
+static inline void
+io_dpdk_tx_push(io_handle_s *io, struct rte_mbuf *mbuf, uint16_t len)
 {
-    struct rte_mbuf *mbuf = rte_pktmbuf_alloc(io->mbuf_pool);
-    if(!mbuf) {
+    mbuf->data_len = len;
+    mbuf->pkt_len = len;
+    mbuf->next = NULL;
+    mbuf->nb_segs = 1;
+    mbuf->ol_flags = 0;
+    io->queued++;
+    io->stats.packets++;
+    io->stats.bytes += len;
+}
+
+/**
+ * Prepare TX checksum offload and template mbuf 
+ * after the stream packet has been (re)built. 
+ * 
+ * UDP checksum offload is restricted to plain IPv4 (without 
+ * options or fragmentation) and IPv6 (without extension headers) 
+ * UDP streams over Ethernet/VLAN, where the NIC computes the 
+ * checksum from the pseudo header checksum stored in the packet. 
+ * 
+ * The template mbuf holds a copy of the packet without the last 
+ * 16 bytes of the BBL header (sequence and timestamp), which are 
+ * the only bytes changing per packet if no L4 checksum is updated 
+ * in software. 
+ */
+static void
+io_dpdk_tx_stream_prepare(io_handle_s *io, bbl_stream_s *stream)
+{
+    bbl_interface_s *interface = io->interface;
+    struct rte_mbuf *template = stream->tx_template;
+    uint16_t udp_len = stream->tx_bbl_hdr_len + UDP_HDR_LEN;
+    uint16_t l4_offset = stream->tx_len - udp_len;
+    uint16_t len = stream->tx_len - 16;
+    uint16_t l3_len = 0;
+    uint16_t *checksum;
+    uint8_t *ip;
+
+    stream->tx_changed = false;
+    stream->tx_l4_offload = false;
+    stream->tx_template = NULL;
+    if(template) {
+        /* The template is freed with the last 
+         * packet still referring to it. */
+        rte_pktmbuf_free(template);
+        template = NULL;
+    }
+    if(stream->tcp) {
+        return;
+    }
+
+    if(interface->tx_udp_checksum_offload && g_ctx->config.stream_udp_checksum) {
+        if(stream->ipv6_src && stream->ipv6_dst) {
+            ip = stream->tx_buf + l4_offset - IPV6_HDR_LEN;
+            if(l4_offset >= RTE_ETHER_HDR_LEN + IPV6_HDR_LEN && 
+               *(uint16_t*)(ip-2) == htobe16(ETH_TYPE_IPV6) && 
+               (ip[0] >> 4) == 6 && ip[6] == IPV6_NEXT_HEADER_UDP) {
+                l3_len = IPV6_HDR_LEN;
+            }
+        } else {
+            ip = stream->tx_buf + l4_offset - sizeof(struct rte_ipv4_hdr);
+            if(l4_offset >= RTE_ETHER_HDR_LEN + sizeof(struct rte_ipv4_hdr) && 
+               *(uint16_t*)(ip-2) == htobe16(ETH_TYPE_IPV4) && 
+               ip[0] == 0x45 && ip[9] == PROTOCOL_IPV4_UDP && 
+               (*(uint16_t*)(ip+6) & htobe16(IPV4_MF|IPV4_OFFMASK)) == 0) {
+                l3_len = sizeof(struct rte_ipv4_hdr);
+            }
+        }
+        if(!l3_len || l4_offset - l3_len > 127) {
+            /* Keep software checksum, mbuf l2_len has 7 bits only. */
+            return;
+        }
+        /* Replace the checksum calculated in software with 
+         * the pseudo header checksum expected by the NIC. */
+        checksum = (uint16_t*)(stream->tx_buf + l4_offset + 6);
+        if(l3_len == IPV6_HDR_LEN) {
+            *checksum = rte_ipv6_phdr_cksum((struct rte_ipv6_hdr*)ip, RTE_MBUF_F_TX_IPV6);
+        } else {
+            *checksum = rte_ipv4_phdr_cksum((struct rte_ipv4_hdr*)ip, RTE_MBUF_F_TX_IPV4);
+        }
+        stream->tx_l2_len = l4_offset - l3_len;
+        stream->tx_l3_len = l3_len;
+        stream->tx_l4_offload = true;
+    } else if(g_ctx->config.stream_udp_checksum) {
+        return;
+    }
+
+    if(!interface->tx_mbuf_template || stream->tx_len > RTE_MBUF_DEFAULT_DATAROOM) {
+        return;
+    }
+    template = rte_pktmbuf_alloc(io->mbuf_pool);
+    if(!template) {
         io->stats.no_buffer++;
-        return false;
+        return;
     }
-    if(rte_pktmbuf_append(mbuf, 2048) == NULL) {
-        rte_pktmbuf_free(mbuf);
+    rte_memcpy(rte_pktmbuf_mtod(template, uint8_t *), stream->tx_buf, len);
+    template->data_len = len;
+    template->pkt_len = len;
+    if(stream->tx_l4_offload) {
+        /* Offload flags are inherited by attached mbufs. */
+        template->ol_flags = stream->tx_l3_len == IPV6_HDR_LEN ? 
+            RTE_MBUF_F_TX_IPV6 | RTE_MBUF_F_TX_UDP_CKSUM : 
+            RTE_MBUF_F_TX_IPV4 | RTE_MBUF_F_TX_UDP_CKSUM;
+        template->l2_len = stream->tx_l2_len;
+        template->l3_len = stream->tx_l3_len;
+    }
+    stream->tx_template = template;
+}
+
+/**
+ * Queue the current packet of the stream using 
+ * the mbuf of the next free TX burst slot. 
+ * 
+ * With template, the slot mbuf is attached (indirect) 
+ * to the stream template followed by a small segment 
+ * with the per packet BBL header tail, otherwise the 
+ * whole packet is copied into the slot mbuf. 
+ */
+static inline bool
+io_dpdk_tx_stream(io_handle_s *io, struct rte_mbuf *mbuf, bbl_stream_s *stream)
+{
+    struct rte_mbuf *template;
+    struct rte_mbuf *tail;
+    uint16_t len;
+
+    if(unlikely(stream->tx_changed)) {
+        io_dpdk_tx_stream_prepare(io, stream);
+    }
+    template = stream->tx_template;
+    if(template) {
+        tail = rte_pktmbuf_alloc(io->mbuf_pool);
+        if(unlikely(!tail)) {
+            io->stats.no_buffer++;
+            return false;
+        }
+        len = stream->tx_len - template->data_len;
+        rte_memcpy(rte_pktmbuf_mtod(tail, uint8_t *), stream->tx_buf + template->data_len, len);
+        tail->data_len = len;
+        tail->pkt_len = len;
+        rte_pktmbuf_attach(mbuf, template);
+        mbuf->next = tail;
+        mbuf->nb_segs = 2;
+        mbuf->pkt_len = stream->tx_len;
+        io->queued++;
+        io->stats.packets++;
+        io->stats.bytes += stream->tx_len;
+        return true;
+    }
+    rte_memcpy(io->buf, stream->tx_buf, stream->tx_len);
+    io_dpdk_tx_push(io, mbuf, stream->tx_len);
+    if(stream->tx_l4_offload) {
+        mbuf->ol_flags = stream->tx_l3_len == IPV6_HDR_LEN ? 
+            RTE_MBUF_F_TX_IPV6 | RTE_MBUF_F_TX_UDP_CKSUM : 
+            RTE_MBUF_F_TX_IPV4 | RTE_MBUF_F_TX_UDP_CKSUM;
+        mbuf->l2_len = stream->tx_l2_len;
+        mbuf->l3_len = stream->tx_l3_len;
+    }
+    return true;
+}
+
+/**
+ * Send all pending packets with a single TX burst. 
+ * 
+ * Packets not accepted by the PMD remain pending 
+ * and will be retried with the next call. 
+ */
+static bool
+io_dpdk_tx_flush(io_handle_s *io)
+{
+    struct rte_mbuf **pkts = &io->mbufs[io->cursor];
+    uint16_t sent, i;
+
+    sent = rte_eth_tx_burst(io->interface->port_id, io->queue, pkts, io->queued);
+    for(i = 0; i < sent; i++) {
+        /* Ownership passed to PMD. */
+        pkts[i] = NULL;
+    }
+    io->cursor += sent;
+    io->queued -= sent;
+    if(io->queued) {
         io->stats.no_buffer++;
         return false;
     }
-    mbuf->data_len = 0;
-    mbuf->next = NULL;
-    
-    io->mbuf = mbuf;
-    io->buf = rte_pktmbuf_mtod(mbuf, uint8_t *);
-    io->buf_len = 0;
+    io->cursor = 0;
     return true;
 }
 
@@ -266,6 +475,7 @@ io_dpdk_tx_job(timer_s *timer)
     bbl_interface_s *interface = io->interface;
 
     bbl_stream_s *stream = NULL;
+    struct rte_mbuf *mbuf;
     uint16_t burst = interface->config->io_burst;
     uint64_t now;
     bool pcap = false;
@@ -278,83 +488,62 @@ io_dpdk_tx_job(timer_s *timer)
         io_stream_update_pps(io);
     }
 
+    /* Retry pending packets from last interval first. */
+    if(io->queued && !io_dpdk_tx_flush(io)) {
+        return;
+    }
+
     /* Get TX timestamp */
     //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
 
-    while(burst) {
-        if(!io->mbuf) {
-            if(!io_dpdk_mbuf_alloc(io)) {
-                break;
-            }
+    /* First send all control traffic which has higher priority. */
+    while(burst && (mbuf = io_dpdk_tx_mbuf(io))) {
+        if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+            break;
         }
-        if(likely(io->buf_len == 0)) {
-            if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
-                io->buf_len = 0;
-                break;
-            }        
-        }
-        /* Transmit the packet. */
-        io->mbuf->data_len = io->buf_len;
-        if(rte_eth_tx_burst(interface->port_id, io->queue, &io->mbuf, 1) != 0) {
-            /* Dump the packet into pcap file. */
-            if(unlikely(g_ctx->pcap.write_buf != NULL)) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-            }
-            io->stats.packets++;
-            io->stats.bytes += io->buf_len;
-            io->mbuf = NULL;
-            io->buf_len = 0;
-            burst--;
-        } else {
-            /* This packet will be retried next interval 
-             * because io->buf_len is not reset to zero. */
-            io->stats.io_errors++;
-            burst = 0;
+        io_dpdk_tx_push(io, mbuf, io->buf_len);
+        burst--;
+        /* Dump the packet into pcap file. */
+        if(unlikely(g_ctx->pcap.write_buf != NULL)) {
+            pcap = true;
+            pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                      interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
         }
     }
     if(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP) {
         now = timespec_to_nsec(timer->timestamp);
-        while(burst) {
+        while(burst && (mbuf = io_dpdk_tx_mbuf(io))) {
             /* Send traffic streams up to allowed burst. */
-            if(!io->mbuf) {
-                if(!io_dpdk_mbuf_alloc(io)) {
-                    break;
-                }
-            }
             stream = bbl_stream_io_send_iter(io, now);
             if(unlikely(stream == NULL)) {
                 break;
             }
-            /* Transmit the packet. */
-            io->mbuf->data_len = io->buf_len;
-            if(rte_eth_tx_burst(interface->port_id, io->queue, &io->mbuf, 1) != 0) {
-                /* Dump the packet into pcap file. */
-                if(unlikely(g_ctx->pcap.write_buf && g_ctx->pcap.include_streams)) {
-                    pcap = true;
-                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                            interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-                }
-                stream->tx_packets++;
-                stream->flow_seq++;
-                io->stats.packets++;
-                io->stats.bytes += io->buf_len;
-                io->mbuf = NULL;
-                io->buf_len = 0;
-                burst--;
-            } else {
-                /* This packet will be retried next interval 
-                * because io->buf_len is not reset to zero. */
-                io->stats.io_errors++;
-                burst = 0;
+            if(unlikely(stream->tx_len > rte_pktmbuf_tailroom(mbuf))) {
+                io->buf_len = stream->tx_len;
+                io_dpdk_tx_lo_long(io);
+                continue;
+            }
+            if(unlikely(!io_dpdk_tx_stream(io, mbuf, stream))) {
+                break;
+            }
+            stream->tx_packets++;
+            stream->flow_seq++;
+            burst--;
+            /* Dump the packet into pcap file. */
+            if(unlikely(g_ctx->pcap.write_buf && g_ctx->pcap.include_streams)) {
+                pcap = true;
+                pcapng_push_packet_header(&io->timestamp, stream->tx_buf, stream->tx_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
             }
         }
     } else {
         bbl_stream_io_stop(io);
     }
+    if(io->queued) {
+        io_dpdk_tx_flush(io);
+    }
     if(pcap) {
         pcapng_fflush();
     }
@@ -411,6 +600,7 @@ io_dpdk_thread_tx_run_fn(io_thread_s *thread)
     bbl_txq_slot_t *slot;
 
     bbl_stream_s *stream = NULL;
+    struct rte_mbuf *mbuf;
     uint16_t io_burst = interface->config->io_burst;
     uint16_t burst = 0;
     uint64_t now;
@@ -423,38 +613,30 @@ io_dpdk_thread_tx_run_fn(io_thread_s *thread)
     assert(io->direction == IO_EGRESS);
     assert(io->thread);
 
-
-
     while(thread->active) {
         nanosleep(&sleep, &rem);
         if(io->update_streams) {
             io_stream_update_pps(io);
         }
+
+        /* Retry pending packets first. */
+        if(io->queued && !io_dpdk_tx_flush(io)) {
+            continue;
+        }
         burst = io_burst;
 
         /* First send all control traffic which has higher priority. */
-        while((slot = bbl_txq_read_slot(txq))) {
+        while(burst && (slot = bbl_txq_read_slot(txq))) {
             /* This packet will be retried next interval 
              * because slot is not marked as read. */
-            if(!io->mbuf) {
-                if(!io_dpdk_mbuf_alloc(io)) {
-                    break;
-                }
-            }
-            /* Transmit the packet. */
-            io->mbuf->data_len = slot->packet_len;
-            memcpy(io->buf, slot->packet, slot->packet_len);
-            if(rte_eth_tx_burst(interface->port_id, io->queue, &io->mbuf, 1) != 0) {
-                io->stats.packets++;
-                io->stats.bytes += slot->packet_len;
-                io->mbuf = NULL;
-                bbl_txq_read_next(txq);
-                if(burst) burst--;
-            } else {
-                io->stats.io_errors++;
-                burst = 0;
+            mbuf = io_dpdk_tx_mbuf(io);
+            if(!mbuf) {
                 break;
             }
+            rte_memcpy(io->buf, slot->packet, slot->packet_len);
+            io_dpdk_tx_push(io, mbuf, slot->packet_len);
+            bbl_txq_read_next(txq);
+            burst--;
         }
 
         /* Get TX timestamp */
@@ -462,39 +644,33 @@ io_dpdk_thread_tx_run_fn(io_thread_s *thread)
 
         if(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP) {
             now = timespec_to_nsec(&io->timestamp);
-            while(burst) {
+            while(burst && (mbuf = io_dpdk_tx_mbuf(io))) {
                 /* Send traffic streams up to allowed burst. */
-                if(!io->mbuf) {
-                    if(!io_dpdk_mbuf_alloc(io)) {
-                        break;
-                    }
-                }
                 stream = bbl_stream_io_send_iter(io, now);
                 if(unlikely(stream == NULL)) {
                     break;
                 }
-                /* Transmit the packet. */
-                io->mbuf->data_len = stream->tx_len;
-                memcpy(io->buf, stream->tx_buf, stream->tx_len);
-                if(rte_eth_tx_burst(interface->port_id, io->queue, &io->mbuf, 1) != 0) {
-                    stream->tx_packets++;
-                    stream->flow_seq++;
-                    io->stats.packets++;
-                    io->stats.bytes += stream->tx_len;
-                    io->mbuf = NULL;
-                    burst--;
-                } else {
-                    io->stats.io_errors++;
-                    burst = 0;
+                if(unlikely(stream->tx_len > rte_pktmbuf_tailroom(mbuf))) {
+                    io->buf_len = stream->tx_len;
+                    io_dpdk_tx_lo_long(io);
+                    continue;
+                }
+                if(unlikely(!io_dpdk_tx_stream(io, mbuf, stream))) {
+                    break;
                 }
+                stream->tx_packets++;
+                stream->flow_seq++;
+                burst--;
             }
         } else {
             bbl_stream_io_stop(io);
         }
+        if(io->queued) {
+            io_dpdk_tx_flush(io);
+        }
     }
 }
 
-
 bool
 io_dpdk_add_mbuf_pool(io_handle_s *io)
 {
@@ -574,7 +750,23 @@ io_dpdk_interface_init(bbl_interface_s *interface)
     if(config->rx_threads) {
         nb_rx_queue = config->rx_threads;
     }
-    if(dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE) {
+    if(dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_UDP_CKSUM) {
+        local_port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_UDP_CKSUM;
+        interface->tx_udp_checksum_offload = true;
+    }
+    if(config->tx_mbuf_template) {
+        if(dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MULTI_SEGS) {
+            local_port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_MULTI_SEGS;
+            interface->tx_mbuf_template = true;
+        } else {
+            LOG(DPDK, "DPDK: interface %s (%u) does not support multi segment TX (template disabled)\n",
+                interface->name, port_id);
+        }
+    }
+    if(!interface->tx_mbuf_template && 
+       dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE) {
+        /* Fast free requires direct mbufs, which 
+         * is not the case with template mbufs. */
         local_port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE;
     }
 
@@ -652,7 +844,9 @@ io_dpdk_interface_init(bbl_interface_s *interface)
         io->next = interface->io.tx;
         interface->io.tx = io;
         io->interface = interface;
-        io->buf = malloc(IO_BUFFER_LEN);
+        io->mbufs = calloc(config->io_burst, sizeof(struct rte_mbuf *));
+        if(!io->mbufs) return false;
+        io->mbufs_count = config->io_burst;
         if(config->tx_threads) {
             if(!io_thread_init(io)) {
                 return false;
@@ -66,6 +66,54 @@ set_promisc(bbl_interface_s *interface) {
     return true;
 }
 
+/**
+ * Event loop callback executed in the main loop 
+ * if the RX socket of the interface becomes readable.
+ */
+static void
+io_interface_rx_event(timer_event_s *event)
+{
+    bbl_interface_s *interface = event->data;
+    timer_s *timer = interface->io.rx_job;
+    struct timespec now;
+
+    if(timer) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timer->timestamp = &now;
+        (*timer->cb)(timer);
+    }
+}
+
+/**
+ * io_interface_rx_job_add
+ *
+ * Start the main loop job receiving packets from
+ * the IO handle (no RX threads).
+ *
+ * With event loop, the job is executed as soon as
+ * the socket becomes readable and the periodic job
+ * remains as fallback only. 
+ *
+ * @param io IO handle
+ * @param cb RX job
+ * @return true if successful
+ */
+bool
+io_interface_rx_job_add(io_handle_s *io, void (*cb)(timer_s *))
+{
+    bbl_interface_s *interface = io->interface;
+
+    if(!g_ctx->config.event_loop) {
+        return timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 
+                                  0, interface->config->rx_interval, io, cb);
+    }
+    if(!timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 
+                           IO_EVENT_RX_INTERVAL, 0, io, cb)) {
+        return false;
+    }
+    return timer_event_add(&g_ctx->timer_root, io->fd, interface, &io_interface_rx_event);
+}
+
 static bool
 io_interface_init_rx(bbl_interface_s *interface)
 {
@@ -105,6 +153,11 @@ io_interface_init_rx(bbl_interface_s *interface)
                     return false;
                 }
                 break;
+            case IO_MODE_AF_XDP:
+                if(!io_af_xdp_init(io)) {
+                    return false;
+                }
+                break;
             default:
                 return false;
         }
@@ -151,6 +204,11 @@ io_interface_init_tx(bbl_interface_s *interface)
                     return false;
                 }
                 break;
+            case IO_MODE_AF_XDP:
+                if(!io_af_xdp_init(io)) {
+                    return false;
+                }
+                break;
             default:
                 return false;
         }
@@ -206,6 +264,18 @@ io_interface_init(bbl_interface_s *interface)
 {
     bbl_link_config_s *config = interface->config;
 
+    if(g_ctx->config.io_timestamping && 
+       (config->io_mode == IO_MODE_AF_XDP || config->io_mode == IO_MODE_DPDK)) {
+        LOG(ERROR, "Timestamping is not supported with io-mode %s on interface %s\n",
+            config->io_mode == IO_MODE_AF_XDP ? "af_xdp" : "dpdk", interface->name);
+        return false;
+    }
+    if(g_ctx->config.stream_pacing && (config->tx_threads == 0 ||
+       config->io_mode == IO_MODE_AF_XDP || config->io_mode == IO_MODE_DPDK)) {
+        LOG(INFO, "Warning: Stream pacing is not supported on interface %s (requires tx-threads and io-mode packet_mmap_raw, packet_mmap or raw)\n",
+            interface->name);
+    }
+
 #ifdef BNGBLASTER_DPDK
     if(config->io_mode == IO_MODE_DPDK) {
         if(!io_dpdk_interface_init(interface)) {
@@ -9,6 +9,9 @@
 #ifndef __BBL_IO_INTERFACE_H__
 #define __BBL_IO_INTERFACE_H__
 
+bool
+io_interface_rx_job_add(io_handle_s *io, void (*cb)(timer_s *));
+
 bool
 io_interface_init(bbl_interface_s *interface);
 
@@ -20,6 +20,9 @@
 extern bool g_init_phase;
 extern bool g_traffic;
 
+/* Kernel software or NIC hardware timestamp present in frame header. */
+#define TP_STATUS_TS_ANY (TP_STATUS_TS_SOFTWARE|TP_STATUS_TS_RAW_HARDWARE)
+
 static void
 poll_kernel(io_handle_s *io, short events)
 {
@@ -65,9 +68,11 @@ io_packet_mmap_rx_job(timer_s *timer)
     }
 
     /* Get RX timestamp */
-    //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->timestamping) {
+        clock_gettime(CLOCK_REALTIME, &io->rx_timestamp);
+    }
     while(tphdr->tp_status & TP_STATUS_USER) {
         io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
         io->buf_len = tphdr->tp_len;
@@ -87,10 +92,15 @@ io_packet_mmap_rx_job(timer_s *timer)
                 }
             }
             /* Copy RX timestamp */
-            //eth->timestamp.tv_sec = tphdr->tp_sec; /* ktime/hw timestamp */
-            //eth->timestamp.tv_nsec = tphdr->tp_nsec; /* ktime/hw timestamp */
             eth->timestamp.tv_sec = io->timestamp.tv_sec;
             eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+            if(io->timestamping && tphdr->tp_status & TP_STATUS_TS_ANY) {
+                eth->rx_timestamp.tv_sec = tphdr->tp_sec; /* ktime/hw timestamp */
+                eth->rx_timestamp.tv_nsec = tphdr->tp_nsec; /* ktime/hw timestamp */
+            } else if(io->timestamping) {
+                eth->rx_timestamp.tv_sec = io->rx_timestamp.tv_sec;
+                eth->rx_timestamp.tv_nsec = io->rx_timestamp.tv_nsec;
+            }
             /* Dump the packet into pcap file */
             if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
                 pcap = true;
@@ -123,6 +133,106 @@ io_packet_mmap_rx_job(timer_s *timer)
     }
 }
 
+/**
+ * This job is for PACKET_MMAP (TPACKET_V3) RX in main thread!
+ */
+void
+io_packet_mmap_v3_rx_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+    bbl_interface_s *interface = io->interface;
+
+    struct tpacket_block_desc *pbd;
+    struct tpacket3_hdr *tphdr;
+    uint32_t pkts;
+
+    bbl_ethernet_header_s *eth;
+    uint16_t vlan;
+
+    protocol_error_t decode_result;
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_PACKET_MMAP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread == NULL);
+
+    pbd = (struct tpacket_block_desc*)(io->ring + (io->cursor * io->req.tp_block_size));
+    if(!(pbd->hdr.bh1.block_status & TP_STATUS_USER)) {
+        /* If no block is available poll kernel */
+        poll_kernel(io, POLLIN);
+        return;
+    }
+
+    /* Get RX timestamp */
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->timestamping) {
+        clock_gettime(CLOCK_REALTIME, &io->rx_timestamp);
+    }
+    while(pbd->hdr.bh1.block_status & TP_STATUS_USER) {
+        pkts = pbd->hdr.bh1.num_pkts;
+        tphdr = (struct tpacket3_hdr*)((uint8_t*)pbd + pbd->hdr.bh1.offset_to_first_pkt);
+        while(pkts--) {
+            io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
+            io->buf_len = tphdr->tp_snaplen;
+            io->stats.packets++;
+            io->stats.bytes += io->buf_len;
+            decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+            if(decode_result == PROTOCOL_SUCCESS) {
+                if(tphdr->tp_status & TP_STATUS_VLAN_VALID) {
+                    vlan = tphdr->hv1.tp_vlan_tci & BBL_ETH_VLAN_ID_MAX;
+                    /* Restore stripped outer VLAN tag */
+                    eth->vlan_inner = eth->vlan_outer;
+                    eth->vlan_inner_priority = eth->vlan_outer_priority;
+                    eth->vlan_outer = vlan;
+                    eth->vlan_outer_priority = tphdr->hv1.tp_vlan_tci >> 13;
+                    if(tphdr->hv1.tp_vlan_tpid == ETH_TYPE_QINQ) {
+                        eth->qinq = true;
+                    }
+                }
+                /* Copy RX timestamp */
+                eth->timestamp.tv_sec = io->timestamp.tv_sec;
+                eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+                if(io->timestamping && tphdr->tp_status & TP_STATUS_TS_ANY) {
+                    eth->rx_timestamp.tv_sec = tphdr->tp_sec; /* ktime/hw timestamp */
+                    eth->rx_timestamp.tv_nsec = tphdr->tp_nsec; /* ktime/hw timestamp */
+                } else if(io->timestamping) {
+                    eth->rx_timestamp.tv_sec = io->rx_timestamp.tv_sec;
+                    eth->rx_timestamp.tv_nsec = io->rx_timestamp.tv_nsec;
+                }
+                /* Dump the packet into pcap file */
+                if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+                    pcap = true;
+                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                              interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+                }
+                bbl_rx_handler(interface, eth);
+            } else {
+                /* Dump the packet into pcap file */
+                if(g_ctx->pcap.write_buf) {
+                    pcap = true;
+                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                              interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+                }
+                if(decode_result == UNKNOWN_PROTOCOL) {
+                    io->stats.unknown++;
+                } else {
+                    io->stats.protocol_errors++;
+                }
+            }
+            tphdr = (struct tpacket3_hdr*)((uint8_t*)tphdr + tphdr->tp_next_offset);
+        }
+        /* Return ownership of the whole block back to kernel */
+        pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        /* Get next block */
+        io->cursor = (io->cursor + 1) % io->req.tp_block_nr;
+        pbd = (struct tpacket_block_desc*)(io->ring + (io->cursor * io->req.tp_block_size));
+    }
+    if(pcap) {
+        pcapng_fflush();
+    }
+}
+
 /**
  * This job is for PACKET_MMAP TX in main thread!
  */
@@ -244,7 +354,8 @@ io_packet_mmap_thread_rx_run_fn(io_thread_s *thread)
     assert(io->direction == IO_INGRESS);
     assert(io->thread);
 
-    struct timespec sleep, rem;
+    struct timespec sleep;
+    struct timespec rx_timestamp = {0};
 
     sleep.tv_sec = 0;
     sleep.tv_nsec = 10000; /* 0.01ms */
@@ -253,17 +364,27 @@ io_packet_mmap_thread_rx_run_fn(io_thread_s *thread)
         frame_ptr = ring + (cursor * frame_size);
         tphdr = (struct tpacket2_hdr*)frame_ptr;
         if(!(tphdr->tp_status & TP_STATUS_USER)) {
-            /* If no buffer is available poll kernel */
-            //poll_kernel(io, POLLIN);
-            nanosleep(&sleep, &rem);
+            /* If no buffer is available wait */
+            io_thread_rx_wait(thread, io, &sleep);
             continue;
         }
+        thread->idle = 0;
 
         /* Get RX timestamp */
         clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->timestamping) {
+            clock_gettime(CLOCK_REALTIME, &rx_timestamp);
+        }
         while(tphdr->tp_status & TP_STATUS_USER) {
             io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
             io->buf_len = tphdr->tp_len;
+            if(io->timestamping && tphdr->tp_status & TP_STATUS_TS_ANY) {
+                io->rx_timestamp.tv_sec = tphdr->tp_sec;
+                io->rx_timestamp.tv_nsec = tphdr->tp_nsec;
+            } else if(io->timestamping) {
+                io->rx_timestamp.tv_sec = rx_timestamp.tv_sec;
+                io->rx_timestamp.tv_nsec = rx_timestamp.tv_nsec;
+            }
             if(tphdr->tp_status & TP_STATUS_VLAN_VALID) {
                 io->vlan_tci = tphdr->tp_vlan_tci;
                 io->vlan_tpid = tphdr->tp_vlan_tpid;
@@ -281,7 +402,85 @@ io_packet_mmap_thread_rx_run_fn(io_thread_s *thread)
             frame_ptr = ring + (cursor * frame_size);
             tphdr = (struct tpacket2_hdr*)frame_ptr;
         }
-        nanosleep(&sleep, &rem);
+        io_thread_rx_wait(thread, io, &sleep);
+    }
+}
+
+void
+io_packet_mmap_v3_thread_rx_run_fn(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+
+    uint32_t cursor = io->cursor;
+    uint32_t block_size = io->req.tp_block_size;
+    uint32_t block_nr = io->req.tp_block_nr;
+    uint8_t *ring = io->ring;
+
+    struct tpacket_block_desc *pbd = NULL;
+    struct tpacket3_hdr *tphdr = NULL;
+    uint32_t pkts = 0;
+
+    assert(io->mode == IO_MODE_PACKET_MMAP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread);
+
+    struct timespec sleep, rem;
+    struct timespec rx_timestamp = {0};
+
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 10000; /* 0.01ms */
+
+    while(thread->active) {
+        if(!pkts) {
+            pbd = (struct tpacket_block_desc*)(ring + (cursor * block_size));
+            if(!(pbd->hdr.bh1.block_status & TP_STATUS_USER)) {
+                /* If no block is available wait for block retire timeout */
+                io_thread_rx_wait(thread, io, &sleep);
+                continue;
+            }
+            thread->idle = 0;
+            pkts = pbd->hdr.bh1.num_pkts;
+            tphdr = (struct tpacket3_hdr*)((uint8_t*)pbd + pbd->hdr.bh1.offset_to_first_pkt);
+        }
+
+        /* Get RX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->timestamping) {
+            clock_gettime(CLOCK_REALTIME, &rx_timestamp);
+        }
+        while(pkts) {
+            io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
+            io->buf_len = tphdr->tp_snaplen;
+            if(io->timestamping && tphdr->tp_status & TP_STATUS_TS_ANY) {
+                io->rx_timestamp.tv_sec = tphdr->tp_sec;
+                io->rx_timestamp.tv_nsec = tphdr->tp_nsec;
+            } else if(io->timestamping) {
+                io->rx_timestamp.tv_sec = rx_timestamp.tv_sec;
+                io->rx_timestamp.tv_nsec = rx_timestamp.tv_nsec;
+            }
+            if(tphdr->tp_status & TP_STATUS_VLAN_VALID) {
+                io->vlan_tci = tphdr->hv1.tp_vlan_tci;
+                io->vlan_tpid = tphdr->hv1.tp_vlan_tpid;
+            } else {
+                io->vlan_tci = 0;
+            }
+            /* Process packet */
+            if(io_thread_rx_handler(thread, io) == IO_FULL) {
+                break;
+            }
+            tphdr = (struct tpacket3_hdr*)((uint8_t*)tphdr + tphdr->tp_next_offset);
+            pkts--;
+        }
+        if(pkts) {
+            /* Continue with the remaining packets 
+             * of the current block after sleep. */
+            nanosleep(&sleep, &rem);
+            continue;
+        }
+        /* Return ownership of the whole block back to kernel */
+        pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        /* Get next block */
+        cursor = (cursor + 1) % block_nr;
     }
 }
 
@@ -301,10 +500,11 @@ io_packet_mmap_thread_tx_run_fn(io_thread_s *thread)
     uint16_t io_burst = interface->config->io_burst;
     uint16_t burst = 0;
     uint64_t now;
+    uint64_t departure;
 
     bool ctrl = true;
 
-    struct timespec sleep, rem;
+    struct timespec sleep;
     sleep.tv_sec = 0;
     sleep.tv_nsec = 10;
 
@@ -313,7 +513,7 @@ io_packet_mmap_thread_tx_run_fn(io_thread_s *thread)
     assert(io->thread);
 
     while(thread->active) {
-        nanosleep(&sleep, &rem);
+        io_thread_tx_wait(thread, io, &sleep);
         if(io->update_streams) {
             io_stream_update_pps(io);
         }
@@ -357,10 +557,25 @@ io_packet_mmap_thread_tx_run_fn(io_thread_s *thread)
                     bbl_stream_io_stop(io);
                     break;
                 }
-                /* Send traffic streams up to allowed burst. */
-                stream = bbl_stream_io_send_iter(io, now);
-                if(unlikely(stream == NULL)) {
-                    break;
+                if(io->pacing.enabled) {
+                    /* Send one packet per departure time, which
+                     * is also used as TX timestamp of the packet. */
+                    departure = io_stream_pacing_next(io, now);
+                    if(!departure) {
+                        break;
+                    }
+                    io->timestamp.tv_sec = departure / SEC;
+                    io->timestamp.tv_nsec = departure % SEC;
+                    stream = bbl_stream_io_send_iter(io, departure);
+                    if(unlikely(stream == NULL)) {
+                        continue;
+                    }
+                } else {
+                    /* Send traffic streams up to allowed burst. */
+                    stream = bbl_stream_io_send_iter(io, now);
+                    if(unlikely(stream == NULL)) {
+                        break;
+                    }
                 }
                 memcpy(io->buf, stream->tx_buf, stream->tx_len);
                 io->buf_len = stream->tx_len;
@@ -402,21 +617,32 @@ io_packet_mmap_init(io_handle_s *io)
     bbl_link_config_s *config = interface->config;
     
     io_thread_s *thread = io->thread;
-    
+
+    if(io->direction == IO_INGRESS && config->rx_tpacket_v3) {
+        io->tpacket_v3 = true;
+    }
+    if(thread && io->direction == IO_EGRESS && g_ctx->config.stream_pacing) {
+        io_stream_pacing_init(io, 1000 * config->io_burst);
+    }
     if(!io_socket_open(io)) {
         return false;
     }
 
     if(thread) {
         if(io->direction == IO_INGRESS) {
-            thread->run_fn = io_packet_mmap_thread_rx_run_fn;
+            if(io->tpacket_v3) {
+                thread->run_fn = io_packet_mmap_v3_thread_rx_run_fn;
+            } else {
+                thread->run_fn = io_packet_mmap_thread_rx_run_fn;
+            }
         } else {
             thread->run_fn = io_packet_mmap_thread_tx_run_fn;
         }
     } else {
         if(io->direction == IO_INGRESS) {
-            timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0, 
-                config->rx_interval, io, &io_packet_mmap_rx_job);
+            if(!io_interface_rx_job_add(io, io->tpacket_v3 ? &io_packet_mmap_v3_rx_job : &io_packet_mmap_rx_job)) {
+                return false;
+            }
         } else {
             timer_add_periodic(&g_ctx->timer_root, &interface->io.tx_job, "TX", 0, 
                 config->tx_interval, io, &io_packet_mmap_tx_job);
@@ -7,10 +7,115 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "io.h"
+#include <linux/errqueue.h>
 
 extern bool g_init_phase;
 extern bool g_traffic;
 
+/* Control message buffer for SCM_TIMESTAMPING. */
+#define IO_RAW_CONTROL_LEN CMSG_SPACE(sizeof(struct scm_timestamping))
+/* Control message buffer for SCM_TXTIME. */
+#define IO_RAW_TXTIME_LEN CMSG_SPACE(sizeof(uint64_t))
+
+/**
+ * Allocate the message vector used to send or receive
+ * up to count packets with a single system call.
+ */
+static bool
+io_raw_mmsg_init(io_handle_s *io, uint16_t count)
+{
+    struct cmsghdr *cmsg;
+    struct iovec *iov;
+    uint8_t *buf;
+    uint16_t i;
+
+    io->mmsg = calloc(count, sizeof(struct mmsghdr));
+    iov = calloc(count, sizeof(struct iovec));
+    buf = malloc((size_t)count * IO_BUFFER_LEN);
+    if(!(io->mmsg && iov && buf)) {
+        return false;
+    }
+    for(i = 0; i < count; i++) {
+        iov[i].iov_base = buf + ((size_t)i * IO_BUFFER_LEN);
+        iov[i].iov_len = IO_BUFFER_LEN;
+        io->mmsg[i].msg_hdr.msg_iov = &iov[i];
+        io->mmsg[i].msg_hdr.msg_iovlen = 1;
+        if(io->direction == IO_EGRESS) {
+            io->mmsg[i].msg_hdr.msg_name = &io->addr;
+            io->mmsg[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_ll);
+        }
+    }
+    if(io->direction == IO_INGRESS && g_ctx->config.io_timestamping) {
+        io->mmsg_control = calloc(count, IO_RAW_CONTROL_LEN);
+        if(!io->mmsg_control) {
+            return false;
+        }
+        for(i = 0; i < count; i++) {
+            io->mmsg[i].msg_hdr.msg_control = io->mmsg_control + ((size_t)i * IO_RAW_CONTROL_LEN);
+        }
+    }
+    if(io->direction == IO_EGRESS && io->pacing.txtime) {
+        io->mmsg_control = calloc(count, IO_RAW_TXTIME_LEN);
+        if(!io->mmsg_control) {
+            return false;
+        }
+        for(i = 0; i < count; i++) {
+            io->mmsg[i].msg_hdr.msg_control = io->mmsg_control + ((size_t)i * IO_RAW_TXTIME_LEN);
+            io->mmsg[i].msg_hdr.msg_controllen = IO_RAW_TXTIME_LEN;
+            cmsg = CMSG_FIRSTHDR(&io->mmsg[i].msg_hdr);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TXTIME;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+        }
+    }
+    io->mmsg_count = count;
+    return true;
+}
+
+/**
+ * Receive up to io->mmsg_count packets
+ * with a single system call.
+ */
+static inline int
+io_raw_recv(io_handle_s *io)
+{
+    if(io->mmsg_control) {
+        /* The control buffer length is 
+         * overwritten by the kernel. */
+        for(uint16_t i = 0; i < io->mmsg_count; i++) {
+            io->mmsg[i].msg_hdr.msg_controllen = IO_RAW_CONTROL_LEN;
+        }
+    }
+    return recvmmsg(io->fd, io->mmsg, io->mmsg_count, 0, NULL);
+}
+
+/**
+ * Get kernel software or NIC hardware timestamp
+ * from received message (SCM_TIMESTAMPING).
+ *
+ * @param io IO handle
+ * @param msg received message
+ * @param timestamp timestamp (only changed if found)
+ */
+static inline void
+io_raw_timestamp(io_handle_s *io, struct msghdr *msg, struct timespec *timestamp)
+{
+    struct cmsghdr *cmsg;
+    struct scm_timestamping *tss;
+
+    for(cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            tss = (struct scm_timestamping*)CMSG_DATA(cmsg);
+            if(io->timestamping == IO_TIMESTAMPING_HARDWARE && tss->ts[2].tv_sec) {
+                *timestamp = tss->ts[2];
+            } else if(tss->ts[0].tv_sec) {
+                *timestamp = tss->ts[0];
+            }
+            return;
+        }
+    }
+}
+
 /**
  * This job is for RAW RX in main thread!
  */
@@ -20,54 +125,70 @@ io_raw_rx_job(timer_s *timer)
     io_handle_s *io = timer->data;
     bbl_interface_s *interface = io->interface;
 
-    struct sockaddr saddr;
-    int saddr_size = sizeof(saddr);
-
     bbl_ethernet_header_s *eth;
 
     protocol_error_t decode_result;
     bool pcap = false;
+    int count, i;
 
     assert(io->mode == IO_MODE_RAW);
     assert(io->direction == IO_INGRESS);
     assert(io->thread == NULL);
 
     /* Get RX timestamp */
-    //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->timestamping) {
+        clock_gettime(CLOCK_REALTIME, &io->rx_timestamp);
+    }
     while(true) {
-        io->buf_len = recvfrom(io->fd, io->buf, IO_BUFFER_LEN, 0, &saddr , (socklen_t*)&saddr_size);
-        if(io->buf_len < 14 || io->buf_len > IO_BUFFER_LEN) {
+        count = io_raw_recv(io);
+        if(count <= 0) {
             break;
         }
-        io->stats.packets++;
-        io->stats.bytes += io->buf_len;
-        decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
-        if(decode_result == PROTOCOL_SUCCESS) {
-            /* Copy RX timestamp */
-            eth->timestamp.tv_sec = io->timestamp.tv_sec;
-            eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
-            /* Dump the packet into pcap file */
-            if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                        interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
-            }
-            bbl_rx_handler(interface, eth);
-        } else {
-            /* Dump the packet into pcap file */
-            if(g_ctx->pcap.write_buf) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+        io->stats.batches++;
+        for(i = 0; i < count; i++) {
+            io->buf = io->mmsg[i].msg_hdr.msg_iov->iov_base;
+            io->buf_len = io->mmsg[i].msg_len;
+            if(io->buf_len < 14 || io->mmsg[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                continue;
             }
-            if(decode_result == UNKNOWN_PROTOCOL) {
-                io->stats.unknown++;
+            io->stats.packets++;
+            io->stats.bytes += io->buf_len;
+            decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+            if(decode_result == PROTOCOL_SUCCESS) {
+                /* Copy RX timestamp */
+                eth->timestamp.tv_sec = io->timestamp.tv_sec;
+                eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+                if(io->timestamping) {
+                    eth->rx_timestamp.tv_sec = io->rx_timestamp.tv_sec;
+                    eth->rx_timestamp.tv_nsec = io->rx_timestamp.tv_nsec;
+                    io_raw_timestamp(io, &io->mmsg[i].msg_hdr, &eth->rx_timestamp);
+                }
+                /* Dump the packet into pcap file */
+                if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+                    pcap = true;
+                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                            interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+                }
+                bbl_rx_handler(interface, eth);
             } else {
-                io->stats.protocol_errors++;
+                /* Dump the packet into pcap file */
+                if(g_ctx->pcap.write_buf) {
+                    pcap = true;
+                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                              interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+                }
+                if(decode_result == UNKNOWN_PROTOCOL) {
+                    io->stats.unknown++;
+                } else {
+                    io->stats.protocol_errors++;
+                }
             }
         }
+        if(count < io->mmsg_count) {
+            break;
+        }
     }
     if(pcap) {
         pcapng_fflush();
@@ -91,6 +212,83 @@ io_raw_tx_lo_long(io_handle_s *io)
     io->stats.to_long++;
 }
 
+/**
+ * Get the buffer of the next free TX message
+ * or NULL if the message vector is full.
+ * 
+ * Pending messages are located between io->cursor
+ * and io->cursor + io->queued.
+ */
+static inline uint8_t *
+io_raw_tx_buf(io_handle_s *io)
+{
+    unsigned int i = io->cursor + io->queued;
+    if(i >= io->mmsg_count) {
+        return NULL;
+    }
+    return io->mmsg[i].msg_hdr.msg_iov->iov_base;
+}
+
+static inline void
+io_raw_tx_push(io_handle_s *io, uint16_t len)
+{
+    io->mmsg[io->cursor + io->queued].msg_hdr.msg_iov->iov_len = len;
+    io->queued++;
+}
+
+/**
+ * Set the launch time (SO_TXTIME) of the last pushed
+ * TX message, where launch is a CLOCK_MONOTONIC
+ * timestamp in nsec.
+ */
+static inline void
+io_raw_tx_txtime(io_handle_s *io, uint64_t launch)
+{
+    struct msghdr *msg = &io->mmsg[io->cursor + io->queued - 1].msg_hdr;
+    *(uint64_t*)CMSG_DATA(CMSG_FIRSTHDR(msg)) = launch + io->pacing.offset;
+}
+
+/**
+ * Send all pending TX messages with as few system calls as possible. 
+ * 
+ * Messages not accepted by the kernel remain pending and 
+ * will be retried with the next call. 
+ */
+static bool
+io_raw_tx_flush(io_handle_s *io)
+{
+    struct mmsghdr *mmsg;
+    int sent, i;
+
+    while(io->queued) {
+        mmsg = &io->mmsg[io->cursor];
+        sent = sendmmsg(io->fd, mmsg, io->queued, 0);
+        if(sent > 0) {
+            io->stats.batches++;
+            for(i = 0; i < sent; i++) {
+                io->stats.packets++;
+                io->stats.bytes += mmsg[i].msg_len;
+            }
+        } else if(errno == EMSGSIZE) {
+            io->buf_len = mmsg->msg_hdr.msg_iov->iov_len;
+            io_raw_tx_lo_long(io);
+            io->buf_len = 0;
+            sent = 1;
+        } else {
+            if(errno != EAGAIN && errno != ENOBUFS) {
+                LOG(IO, "RAW sendmmsg on interface %s failed with error %s (%d)\n", 
+                    io->interface->name, strerror(errno), errno);
+            }
+            io->stats.io_errors++;
+            return false;
+        }
+        io->cursor += sent;
+        io->queued -= sent;
+    }
+    io->cursor = 0;
+    return true;
+}
+
 /**
  * This job is for RAW TX in main thread!
  */
@@ -102,6 +300,8 @@ io_raw_tx_job(timer_s *timer)
 
     bbl_stream_s *stream = NULL;
     uint16_t burst = interface->config->io_burst;
+    uint16_t len;
+    uint8_t *buf;
     uint64_t now;
     bool pcap = false;
 
@@ -113,81 +313,59 @@ io_raw_tx_job(timer_s *timer)
         io_stream_update_pps(io);
     }
 
+    /* Retry pending packets from last interval first. */
+    if(io->queued && !io_raw_tx_flush(io)) {
+        return;
+    }
+
     /* Get TX timestamp */
     //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
 
-    while(burst) {
-        if(likely(io->buf_len == 0)) {
-            if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
-                io->buf_len = 0;
-                break;
-            }
+    /* First send all control traffic which has higher priority. */
+    while(burst && (buf = io_raw_tx_buf(io))) {
+        if(bbl_tx(interface, buf, &len) != PROTOCOL_SUCCESS) {
+            break;
         }
-        if(sendto(io->fd, io->buf, io->buf_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) > 0) {
-            /* Dump the packet into pcap file. */
-            if(unlikely(g_ctx->pcap.write_buf != NULL)) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-            }
-            io->stats.packets++;
-            io->stats.bytes += io->buf_len;
-            io->buf_len = 0;
-            burst--;
-        } else {
-            if(errno == EMSGSIZE) {
-                io_raw_tx_lo_long(io);
-                io->buf_len = 0;
-            } else {
-                /* This packet will be retried next interval 
-                 * because io->buf_len is not reset to zero. */
-                LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                    interface->name, strerror(errno), errno);
-                io->stats.io_errors++;
-                burst = 0;
-            }
+        io_raw_tx_push(io, len);
+        burst--;
+        /* Dump the packet into pcap file. */
+        if(unlikely(g_ctx->pcap.write_buf != NULL)) {
+            pcap = true;
+            pcapng_push_packet_header(&io->timestamp, buf, len,
+                                      interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
         }
     }
 
     if(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP) {
         now = timespec_to_nsec(timer->timestamp);
-        while(burst) {
+        while(burst && (buf = io_raw_tx_buf(io))) {
             /* Send traffic streams up to allowed burst. */
             stream = bbl_stream_io_send_iter(io, now);
             if(unlikely(stream == NULL)) {
                 break;
             }
-            if(sendto(io->fd, stream->tx_buf, stream->tx_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) > 0) {
-                /* Dump the packet into pcap file. */
-                if(unlikely(g_ctx->pcap.write_buf && g_ctx->pcap.include_streams)) {
-                    pcap = true;
-                    pcapng_push_packet_header(&io->timestamp, stream->tx_buf, stream->tx_len,
-                                              interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-                }
-                stream->tx_packets++;
-                stream->flow_seq++;
-                io->stats.packets++;
-                io->stats.bytes += stream->tx_len;
-                burst--;
-            } else {
-                if(errno == EMSGSIZE) {
-                    io->buf_len = stream->tx_len;
-                    io_raw_tx_lo_long(io);
-                    io->buf_len = 0;
-                } else {
-                    LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                        interface->name, strerror(errno), errno);
-                    io->bucket_cur->stream_cur = stream;
-                    io->stats.io_errors++;
-                    burst = 0;
-                }
+            /* The stream buffer is updated with every packet sent, 
+             * therefore it must be copied before the next one. */
+            memcpy(buf, stream->tx_buf, stream->tx_len);
+            io_raw_tx_push(io, stream->tx_len);
+            stream->tx_packets++;
+            stream->flow_seq++;
+            burst--;
+            /* Dump the packet into pcap file. */
+            if(unlikely(g_ctx->pcap.write_buf && g_ctx->pcap.include_streams)) {
+                pcap = true;
+                pcapng_push_packet_header(&io->timestamp, buf, stream->tx_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
             }
         }
     } else {
         bbl_stream_io_stop(io);
     }
+    if(io->queued) {
+        io_raw_tx_flush(io);
+    }
     if(unlikely(pcap)) {
         pcapng_fflush();
     }
@@ -198,26 +376,43 @@ io_raw_thread_rx_run_fn(io_thread_s *thread)
 {
     io_handle_s *io = thread->io;
 
-    struct sockaddr saddr;
-    int saddr_size = sizeof(saddr);
+    int count, i;
 
     assert(io->direction == IO_INGRESS);
 
-    struct timespec sleep, rem;
+    struct timespec sleep;
+    struct timespec rx_timestamp = {0};
     sleep.tv_sec = 0;
     sleep.tv_nsec = 1000; /* 0.001ms */
 
     while(thread->active) {
-        /* Get RX timestamp */
-        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
         /* Receive from socket */
-        io->buf_len = recvfrom(io->fd, io->buf, IO_BUFFER_LEN, 0, &saddr , (socklen_t*)&saddr_size);
-        if(io->buf_len < 14 || io->buf_len > IO_BUFFER_LEN) {
-            nanosleep(&sleep, &rem);
+        count = io_raw_recv(io);
+        if(count <= 0) {
+            io_thread_rx_wait(thread, io, &sleep);
             continue;
         }
-        /* Process packet */
-        io_thread_rx_handler(thread, io);
+        thread->idle = 0;
+        /* Get RX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->timestamping) {
+            clock_gettime(CLOCK_REALTIME, &rx_timestamp);
+        }
+        io->stats.batches++;
+        for(i = 0; i < count; i++) {
+            io->buf = io->mmsg[i].msg_hdr.msg_iov->iov_base;
+            io->buf_len = io->mmsg[i].msg_len;
+            if(io->buf_len < 14 || io->mmsg[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                continue;
+            }
+            if(io->timestamping) {
+                io->rx_timestamp.tv_sec = rx_timestamp.tv_sec;
+                io->rx_timestamp.tv_nsec = rx_timestamp.tv_nsec;
+                io_raw_timestamp(io, &io->mmsg[i].msg_hdr, &io->rx_timestamp);
+            }
+            /* Process packet */
+            io_thread_rx_handler(thread, io);
+        }
     }
 }
 
@@ -233,9 +428,11 @@ io_raw_thread_tx_run_fn(io_thread_s *thread)
     bbl_stream_s *stream = NULL;
     uint16_t io_burst = interface->config->io_burst;
     uint16_t burst = 0;
+    uint8_t *buf;
     uint64_t now;
+    uint64_t departure = 0;
 
-    struct timespec sleep, rem;
+    struct timespec sleep, tai;
     sleep.tv_sec = 0;
     sleep.tv_nsec = 1000 * io_burst; 
 
@@ -244,61 +441,73 @@ io_raw_thread_tx_run_fn(io_thread_s *thread)
     assert(io->thread);
 
     while(thread->active) {
-        nanosleep(&sleep, &rem);
+        io_thread_tx_wait(thread, io, &sleep);
         if(io->update_streams) {
             io_stream_update_pps(io);
         }
+
+        /* Retry pending packets first. */
+        if(io->queued && !io_raw_tx_flush(io)) {
+            continue;
+        }
         burst = io_burst;
 
+        /* Get TX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        now = timespec_to_nsec(&io->timestamp);
+        if(io->pacing.txtime == IO_TXTIME_ETF) {
+            clock_gettime(CLOCK_TAI, &tai);
+            io->pacing.offset = timespec_to_nsec(&tai) - now;
+        }
+
         /* First send all control traffic which has higher priority. */
-        while((slot = bbl_txq_read_slot(txq))) {
-            if(sendto(io->fd, slot->packet, slot->packet_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) >= 0 ) {
-                io->stats.packets++;
-                io->stats.bytes += slot->packet_len;
-                bbl_txq_read_next(txq);
-                if(burst) burst--;
-            } else {
-                LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                    io->interface->name, strerror(errno), errno);
-                io->stats.io_errors++;
-                burst = 0;
-                break;
+        while(burst && (buf = io_raw_tx_buf(io)) && (slot = bbl_txq_read_slot(txq))) {
+            memcpy(buf, slot->packet, slot->packet_len);
+            io_raw_tx_push(io, slot->packet_len);
+            if(io->pacing.txtime) {
+                io_raw_tx_txtime(io, now + io->pacing.delay);
             }
+            bbl_txq_read_next(txq);
+            burst--;
         }
 
-        /* Get TX timestamp */
-        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
         if(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP) {
-            now = timespec_to_nsec(&io->timestamp);
-            while(burst) {
-                /* Send traffic streams up to allowed burst. */
-                stream = bbl_stream_io_send_iter(io, now);
-                if(unlikely(stream == NULL)) {
-                    break;
-                }
-                if(unlikely(sendto(io->fd, stream->tx_buf, stream->tx_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) >=0)) {
-                    stream->tx_packets++;
-                    stream->flow_seq++;
-                    io->stats.packets++;
-                    io->stats.bytes += stream->tx_len;
-                    burst--;
+            while(burst && (buf = io_raw_tx_buf(io))) {
+                if(io->pacing.enabled) {
+                    /* Send one packet per departure time, which
+                     * is also used as TX timestamp of the packet. */
+                    departure = io_stream_pacing_next(io, now);
+                    if(!departure) {
+                        break;
+                    }
+                    io->timestamp.tv_sec = departure / SEC;
+                    io->timestamp.tv_nsec = departure % SEC;
+                    stream = bbl_stream_io_send_iter(io, departure);
+                    if(unlikely(stream == NULL)) {
+                        continue;
+                    }
                 } else {
-                    if(errno == EMSGSIZE) {
-                        io->buf_len = stream->tx_len;
-                        io_raw_tx_lo_long(io);
-                        io->buf_len = 0;
-                    } else {
-                        LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                            io->interface->name, strerror(errno), errno);
-                        io->bucket_cur->stream_cur = stream;
-                        io->stats.io_errors++;
-                        burst = 0;
+                    /* Send traffic streams up to allowed burst. */
+                    stream = bbl_stream_io_send_iter(io, now);
+                    if(unlikely(stream == NULL)) {
+                        break;
                     }
                 }
+                memcpy(buf, stream->tx_buf, stream->tx_len);
+                io_raw_tx_push(io, stream->tx_len);
+                if(io->pacing.txtime) {
+                    io_raw_tx_txtime(io, departure);
+                }
+                stream->tx_packets++;
+                stream->flow_seq++;
+                burst--;
             }
         } else {
             bbl_stream_io_stop(io);
         }
+        if(io->queued) {
+            io_raw_tx_flush(io);
+        }
     }
 }
 
@@ -310,8 +519,12 @@ io_raw_init(io_handle_s *io)
     
     io_thread_s *thread = io->thread;
     
-    io->buf = malloc(IO_BUFFER_LEN);
-
+    if(thread && io->direction == IO_EGRESS && g_ctx->config.stream_pacing) {
+        io_stream_pacing_init(io, 1000 * config->io_burst);
+    }
+    if(!io_raw_mmsg_init(io, config->io_burst)) {
+        return false;
+    }
     if(!io_socket_open(io)) {
         return false;
     }
@@ -324,8 +537,9 @@ io_raw_init(io_handle_s *io)
         }
     } else {
         if(io->direction == IO_INGRESS) {
-            timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0, 
-                config->rx_interval, io, &io_raw_rx_job);
+            if(!io_interface_rx_job_add(io, &io_raw_rx_job)) {
+                return false;
+            }
         } else {
             timer_add_periodic(&g_ctx->timer_root, &interface->io.tx_job, "TX", 0, 
                 config->tx_interval, io, &io_raw_tx_job);
@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "io.h"
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
 
 /* Bypass TC_QDISC, such that the kernel is hammered 30% less with 
  * processing packets. Only for the TX FD. */
@@ -78,16 +80,36 @@ set_ring(io_handle_s *io, int slots)
     } else {
         flag = PACKET_TX_RING;
     }
-    io->req.tp_block_size = getpagesize(); /* 4096 */
-    io->req.tp_frame_size = io->req.tp_block_size;
-    io->req.tp_block_nr = slots;
-    io->req.tp_frame_nr = slots;
+    if(io->tpacket_v3) {
+        /* TPACKET_V3 packs multiple variable sized frames into large blocks, 
+         * which are passed to user space if full or after the block retire 
+         * timeout. The frame size is only used to calculate the number of 
+         * blocks, such that the ring is large enough for the given slots. */
+        bbl_link_config_s *config = io->interface->config;
+        unsigned int page_size = getpagesize();
+        io->req.tp_block_size = ((config->rx_block_size + page_size - 1) / page_size) * page_size;
+        io->req.tp_frame_size = TPACKET_ALIGN(IO_TPACKET_V3_FRAME_SIZE);
+        io->req.tp_block_nr = ((unsigned int)slots * io->req.tp_frame_size) / io->req.tp_block_size;
+        if(io->req.tp_block_nr < 2) {
+            io->req.tp_block_nr = 2;
+        }
+        io->req.tp_frame_nr = (io->req.tp_block_size / io->req.tp_frame_size) * io->req.tp_block_nr;
+        io->req.tp_retire_blk_tov = config->rx_block_timeout;
+        io->req.tp_sizeof_priv = 0;
+        io->req.tp_feature_req_word = 0;
+    } else {
+        io->req.tp_block_size = getpagesize(); /* 4096 */
+        io->req.tp_frame_size = io->req.tp_block_size;
+        io->req.tp_block_nr = slots;
+        io->req.tp_frame_nr = slots;
+    }
 
     ring_size = io->req.tp_block_nr * io->req.tp_block_size;
 
-    LOG(DEBUG, "Setup %u byte packet_mmap ringbuffer (%d slots) for interface %s\n", 
-        ring_size, slots, io->interface->name);
-    if(setsockopt(io->fd, SOL_PACKET, flag, &io->req, sizeof(struct tpacket_req)) == -1) {
+    LOG(DEBUG, "Setup %u byte packet_mmap ringbuffer (%d slots, %u blocks) for interface %s\n", 
+        ring_size, slots, io->req.tp_block_nr, io->interface->name);
+    if(setsockopt(io->fd, SOL_PACKET, flag, &io->req, 
+                  io->tpacket_v3 ? sizeof(struct tpacket_req3) : sizeof(struct tpacket_req)) == -1) {
         LOG(ERROR, "Allocating ringbuffer error for interface %s - %s (%d)\n",
             io->interface->name, strerror(errno), errno);
         return false;
@@ -99,6 +121,99 @@ set_ring(io_handle_s *io, int slots)
     return true;
 }
 
+/* Enable NIC hardware RX timestamps for all packets. */
+static bool
+set_hwtstamp(io_handle_s *io)
+{
+    struct hwtstamp_config hwconfig = {0};
+    struct ifreq ifr = {0};
+
+    hwconfig.tx_type = HWTSTAMP_TX_OFF;
+    hwconfig.rx_filter = HWTSTAMP_FILTER_ALL;
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", io->interface->name);
+    ifr.ifr_data = (void*)&hwconfig;
+    if(ioctl(io->fd, SIOCSHWTSTAMP, &ifr) == -1) {
+        LOG(INFO, "Warning: Hardware timestamping not supported by interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    return true;
+}
+
+/* Enable kernel software or NIC hardware RX timestamps. 
+ * The PACKET_MMAP ring stores timestamps in the frame header 
+ * (tp_sec/tp_nsec), where raw sockets receive them as control 
+ * message (SCM_TIMESTAMPING). If hardware timestamps are not 
+ * supported, kernel software timestamps are used instead. */
+static bool
+set_timestamping(io_handle_s *io)
+{
+    int flags;
+
+    io->timestamping = g_ctx->config.io_timestamping;
+    if(io->timestamping == IO_TIMESTAMPING_HARDWARE) {
+        if(!set_hwtstamp(io)) {
+            io->timestamping = IO_TIMESTAMPING_SOFTWARE;
+        }
+    }
+    if(io->mode == IO_MODE_PACKET_MMAP) {
+        if(io->timestamping == IO_TIMESTAMPING_HARDWARE) {
+            flags = SOF_TIMESTAMPING_RAW_HARDWARE;
+        } else {
+            flags = SOF_TIMESTAMPING_SOFTWARE;
+        }
+        if(setsockopt(io->fd, SOL_PACKET, PACKET_TIMESTAMP, &flags, sizeof(flags)) == -1) {
+            LOG(ERROR, "Failed to set packet timestamping for interface %s - %s (%d)\n",
+                io->interface->name, strerror(errno), errno);
+            return false;
+        }
+    } else {
+        flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if(io->timestamping == IO_TIMESTAMPING_HARDWARE) {
+            flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        }
+        if(setsockopt(io->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == -1) {
+            LOG(ERROR, "Failed to set socket timestamping for interface %s - %s (%d)\n",
+                io->interface->name, strerror(errno), errno);
+            return false;
+        }
+    }
+    LOG(DEBUG, "Enabled %s RX timestamping for interface %s\n",
+        io_timestamping_string(io->timestamping), io->interface->name);
+    return true;
+}
+
+/* Enable launch times (SO_TXTIME) for stream pacing. The
+ * launch time is enforced by the fq (CLOCK_MONOTONIC) or 
+ * etf (CLOCK_TAI) qdisc of the interface. */
+static bool
+set_txtime(io_handle_s *io)
+{
+    struct sock_txtime txtime = {0};
+
+    if(io->pacing.txtime == IO_TXTIME_ETF) {
+        txtime.clockid = CLOCK_TAI;
+    } else {
+        txtime.clockid = CLOCK_MONOTONIC;
+    }
+    if(setsockopt(io->fd, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime)) == -1) {
+        LOG(ERROR, "Failed to set txtime for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    return true;
+}
+
+const char *
+io_timestamping_string(io_timestamping_t timestamping)
+{
+    switch(timestamping) {
+        case IO_TIMESTAMPING_SOFTWARE: return "software";
+        case IO_TIMESTAMPING_HARDWARE: return "hardware";
+        default: return "none";
+    }
+}
+
 bool
 io_socket_open(io_handle_s *io) {
 
@@ -132,13 +247,19 @@ io_socket_open(io_handle_s *io) {
             io->interface->name, strerror(errno), errno);
         return false;
     }
-    if(io->direction == IO_EGRESS && interface->config->qdisc_bypass) {
+    if(io->pacing.txtime) {
+        /* Launch times are enforced by the qdisc, 
+         * which must not be bypassed therefore. */
+        if(!set_txtime(io)) {
+            return false;
+        }
+    } else if(io->direction == IO_EGRESS && interface->config->qdisc_bypass) {
         if(!set_qdisc_bypass(io)) {
             return false;
         }
     }
     if(io->mode == IO_MODE_PACKET_MMAP) {
-        if(!set_packet_version(io, TPACKET_V2)) {
+        if(!set_packet_version(io, io->tpacket_v3 ? TPACKET_V3 : TPACKET_V2)) {
             return false;
         }
         if(!set_ring(io, slots)) {
@@ -146,6 +267,11 @@ io_socket_open(io_handle_s *io) {
         }
     }
 
+    if(io->direction == IO_INGRESS && g_ctx->config.io_timestamping) {
+        if(!set_timestamping(io)) {
+            return false;
+        }
+    }
     if(!set_fanout(io)) {
         return false;
     }
@@ -9,6 +9,9 @@
 #ifndef __BBL_IO_SOCKET_H__
 #define __BBL_IO_SOCKET_H__
 
+const char *
+io_timestamping_string(io_timestamping_t timestamping);
+
 bool
 io_socket_open(io_handle_s *io);
 
@@ -38,34 +38,39 @@ bucket_new(io_handle_s *io, double pps)
 static void
 bucket_stream_add(io_bucket_s *io_bucket, bbl_stream_s *stream)
 {
-    stream->io_next = io_bucket->stream_head;
-    io_bucket->stream_head = stream;
+    io_stream_slot_s *slots;
+    uint32_t size;
+
+    if(io_bucket->stream_count == io_bucket->slots_size) {
+        size = io_bucket->slots_size ? io_bucket->slots_size * 2 : IO_BUCKET_SLOTS_MIN;
+        slots = realloc(io_bucket->slots, size * sizeof(io_stream_slot_s));
+        assert(slots);
+        io_bucket->slots = slots;
+        io_bucket->slots_size = size;
+        io_bucket->slot_cur = NULL;
+    }
+    io_bucket->slots[io_bucket->stream_count].expired = 0;
+    io_bucket->slots[io_bucket->stream_count].stream = stream;
     io_bucket->stream_count++;
 }
 
 static void
 bucket_shuffle(io_bucket_s *io_bucket)
 {
-    bbl_stream_s *stream;
-    bbl_stream_s *next;
+    io_stream_slot_s slot;
+    uint32_t i, j;
 
     if(!io_bucket) return;
 
-    if(io_bucket->stream_count) {
-        stream = io_bucket->stream_head;
-        while(stream) {
-            next = stream->io_next;
-            if(next && next->flow_id%3==0) {
-                stream->io_next = next->io_next;
-                stream = next->io_next;
-                next->io_next = io_bucket->stream_head;
-                io_bucket->stream_head = next;
-            } else {
-                stream = next;
-            }
-        }
+    /* Deterministic Fisher-Yates shuffle using
+     * the flow-id as source of randomness. */
+    for(i = io_bucket->stream_count; i > 1; i--) {
+        j = io_bucket->slots[i-1].stream->flow_id % i;
+        slot = io_bucket->slots[i-1];
+        io_bucket->slots[i-1] = io_bucket->slots[j];
+        io_bucket->slots[j] = slot;
     }
-    io_bucket->stream_cur = NULL;
+    io_bucket->slot_cur = NULL;
 }
 
 static void
@@ -73,38 +78,47 @@ bucket_smear(io_bucket_s *io_bucket)
 {
     uint64_t nsec = 0;
     uint64_t step_nsec;
-    bbl_stream_s *stream;
 
     if(io_bucket && io_bucket->stream_count) {
         step_nsec = io_bucket->nsec / io_bucket->stream_count;
         io_bucket->base = 0;
-        io_bucket->stream_cur = NULL;
-        stream = io_bucket->stream_head;
-        while(stream) {
+        io_bucket->slot_cur = NULL;
+        for(uint32_t i = 0; i < io_bucket->stream_count; i++) {
             nsec += step_nsec;
-            stream->expired = nsec;
-            stream = stream->io_next;
+            io_bucket->slots[i].expired = nsec;
         }
     }
 }
 
+/**
+ * io_stream_add
+ *
+ * Add stream to the bucket matching its current PPS. The 
+ * PPS is read once, such that the bucket PPS is always the 
+ * rate accounted in io->stream_pps for all of its streams, 
+ * even if the stream PPS is changed concurrently.
+ *
+ * @param io IO handle
+ * @param stream stream
+ */
 void
 io_stream_add(io_handle_s *io, bbl_stream_s *stream)
 {
     io_bucket_s *io_bucket = io->bucket_head;
+    double pps = stream->pps;
 
     stream->io = io;
-    io->stream_pps += stream->pps;
+    io->stream_pps += pps;
     io->stream_count++;
     while(io_bucket) {
-        if(io_bucket->pps == stream->pps) {
+        if(io_bucket->pps == pps) {
             bucket_stream_add(io_bucket, stream);
             return;
         }
         io_bucket = io_bucket->next;
     }
 
-    io_bucket = bucket_new(io, stream->pps);
+    io_bucket = bucket_new(io, pps);
     bucket_stream_add(io_bucket, stream);
 }
 
@@ -116,8 +130,7 @@ io_stream_clear(io_handle_s *io)
     io->stream_count = 0;
     while(io_bucket) {
         io_bucket->stream_count = 0;
-        io_bucket->stream_head = NULL;
-        io_bucket->stream_cur = NULL;
+        io_bucket->slot_cur = NULL;
         io_bucket = io_bucket->next;
     }
 }
@@ -147,47 +160,285 @@ io_stream_smear_all()
     }
 }
 
+/**
+ * io_stream_pacing_init
+ *
+ * Enable per packet stream pacing for TX threads.
+ *
+ * @param io IO handle
+ * @param interval TX thread interval in nsec
+ */
+void
+io_stream_pacing_init(io_handle_s *io, uint64_t interval)
+{
+    io->pacing.enabled = true;
+    io->pacing.interval = interval;
+    if(io->mode == IO_MODE_RAW) {
+        io->pacing.txtime = g_ctx->config.io_txtime;
+    }
+    if(io->pacing.txtime) {
+        /* Packets are handed over to the kernel up to two
+         * intervals ahead of their launch time, such that
+         * they are never late if queued to the qdisc. */
+        io->pacing.delay = interval * 2;
+    }
+}
+
+/**
+ * io_stream_pacing_wait
+ *
+ * Wait until the departure time of the next packet
+ * but not longer than the TX thread interval. The
+ * last IO_PACING_SPIN_NSEC before departure are spent
+ * in a busy loop, because nanosleep is not precise
+ * enough for microsecond pacing.
+ *
+ * @param io IO handle
+ */
+void
+io_stream_pacing_wait(io_handle_s *io)
+{
+    struct timespec ts;
+    uint64_t next = io->pacing.next;
+    uint64_t now;
+
+    if(next && !io->pacing.txtime) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        now = timespec_to_nsec(&ts);
+        if(next <= now) return;
+        if(next - now <= io->pacing.interval) {
+            if(next - now > IO_PACING_SPIN_NSEC) {
+                ts.tv_sec = 0;
+                ts.tv_nsec = next - now - IO_PACING_SPIN_NSEC;
+                nanosleep(&ts, NULL);
+            }
+            do {
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+            } while(timespec_to_nsec(&ts) < next);
+            return;
+        }
+    }
+    ts.tv_sec = 0;
+    ts.tv_nsec = io->pacing.interval;
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * io_stream_pacing_next
+ *
+ * Get the departure time of the next packet. The
+ * departures are spaced by the inverse of the PPS
+ * of all streams of the IO handle, where the order
+ * of the streams is defined by the IO buckets.
+ *
+ * @param io IO handle
+ * @param now nsec timestamp (CLOCK_MONOTONIC)
+ * @return departure time in nsec or zero if not due
+ */
+uint64_t
+io_stream_pacing_next(io_handle_s *io, uint64_t now)
+{
+    uint64_t next = io->pacing.next;
+
+    if(io->stream_pps <= 0) {
+        io->pacing.next = 0;
+        return 0;
+    }
+    now += io->pacing.delay;
+    if(next + io->pacing.interval < now) {
+        /* Restart departures instead of sending
+         * a burst to catch up if we are late. */
+        if(next) io->stats.pacing_late++;
+        next = now;
+    } else if(next > now) {
+        return 0;
+    }
+    io->pacing.next = next + (uint64_t)(SEC / io->stream_pps);
+    return next;
+}
+
+/**
+ * io_stream_migrate
+ *
+ * Hand over stream to another TX thread. This function
+ * is called from the current owner of the stream after
+ * it was removed from all buckets. The stream is pushed
+ * to the lock-free inbox of the target IO handle which
+ * is drained by the target thread in io_stream_update_pps.
+ *
+ * @param io source IO handle
+ * @param stream stream
+ */
+static void
+io_stream_migrate(io_handle_s *io, bbl_stream_s *stream)
+{
+    io_handle_s *target = stream->io_target;
+    bbl_stream_s *head = __atomic_load_n(&target->migrate_head, __ATOMIC_RELAXED);
+
+    do {
+        stream->io_next = head;
+    } while(!__atomic_compare_exchange_n(&target->migrate_head, &head, stream, true,
+                                         __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    io->stats.streams_migrated_out++;
+    target->update_streams = true;
+}
+
 void
 io_stream_update_pps(io_handle_s *io)
 {
     io_bucket_s *io_bucket = io->bucket_head;
     bbl_stream_s *stream;
     bbl_stream_s *stream_next;
-    bbl_stream_s *stream_prev;
+    bbl_stream_s *update = NULL;
+    uint32_t i, count;
+
+    /* Reset the flag before processing the streams to
+     * ensure that updates signalled in the meantime are
+     * not lost but handled with the next call. */
+    io->update_streams = false;
+
+    /* Take over streams handed over from other TX threads. */
+    stream_next = __atomic_exchange_n(&io->migrate_head, NULL, __ATOMIC_ACQUIRE);
+    while(stream_next) {
+        stream = stream_next;
+        stream_next = stream->io_next;
+        stream->io_next = NULL;
+        /* A pending PPS update is kept and applied
+         * below, because it might have been signalled 
+         * to the previous owner of the stream only. */
+        io_stream_add(io, stream);
+        __atomic_store_n(&stream->io_target, NULL, __ATOMIC_RELEASE);
+        io->stats.streams_migrated_in++;
+    }
 
     while(io_bucket) {
-        stream_next = io_bucket->stream_head;
-        stream_prev = NULL;
-        while(stream_next) {
-            stream = stream_next;
-            stream_next = stream->io_next;
-            if(stream->update_pps) {
+        count = 0;
+        for(i = 0; i < io_bucket->stream_count; i++) {
+            stream = io_bucket->slots[i].stream;
+            if(stream->io_target && stream->io_target != io) {
+                /* Remove stream from bucket and hand 
+                 * over stream to target thread. */
+                io->stream_count--;
+                io->stream_pps -= io_bucket->pps;
+                io_stream_migrate(io, stream);
+            } else if(stream->update_pps) {
                 LOG(DEBUG, "Update stream %s flow-id %lu pps from %0.2lf to %0.2lf\n", 
                     stream->config->name, stream->flow_id,
                     io_bucket->pps, stream->pps);
 
-                /* Remove stream from bucket. */
-                if(stream_prev) {
-                    stream_prev->io_next = stream_next;
-                } else {
-                    io_bucket->stream_head = stream_next;
-                }
-                stream->io_next = NULL;
-                /* Add stream to new bucket. */
+                /* Remove stream from bucket, which is added
+                 * to the new bucket after all buckets are 
+                 * processed to not modify the slots while
+                 * iterating over them. */
                 io->stream_count--;
-                io->stream_pps -= stream->pps;
-                io_stream_add(io, stream);
-                if(stream->pps < 1.0) {
-                    stream->rate_packets_rx.avg = 0;
-                    stream->rate_packets_tx.avg = 0;
-                }
-                stream->update_pps = false;
+                io->stream_pps -= io_bucket->pps;
+                stream->io_next = update;
+                update = stream;
             } else {
-                stream_prev = stream;
+                io_bucket->slots[count++] = io_bucket->slots[i];
             }
         }
+        io_bucket->stream_count = count;
         io_bucket = io_bucket->next;
     }
+
+    /* Add streams to new bucket. */
+    while(update) {
+        stream = update;
+        update = stream->io_next;
+        stream->io_next = NULL;
+        stream->update_pps = false;
+        io_stream_add(io, stream);
+        if(stream->pps < 1.0) {
+            stream->rate_packets_rx.avg = 0;
+            stream->rate_packets_tx.avg = 0;
+        }
+    }
     io_stream_smear(io);
-    io->update_streams = false;
+}
+
+/**
+ * io_stream_rebalance_job
+ *
+ * Periodic job to migrate streams from the TX thread
+ * with the highest scheduling lag to the TX thread with
+ * the lowest lag of the same interface. The streams are
+ * only marked here, the actual hand over is done by the
+ * TX threads (see io_stream_update_pps).
+ *
+ * @param timer timer
+ */
+void
+io_stream_rebalance_job(timer_s *timer)
+{
+    bbl_interface_s *interface;
+    bbl_stream_s *stream;
+    io_handle_s *io;
+    io_handle_s *source;
+    io_handle_s *target;
+
+    int64_t lag = g_ctx->config.stream_rebalance_lag;
+    uint32_t streams = 0;
+    bool rebalance = false;
+
+    UNUSED(timer);
+
+    CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+        source = NULL;
+        target = NULL;
+        io = interface->io.tx;
+        while(io) {
+            io->rebalance_pps = 0;
+            io->rebalance_target = NULL;
+            if(io->thread && !io->update_streams) {
+                if(!source || io->tx_lag > source->tx_lag) source = io;
+                if(!target || io->tx_lag < target->tx_lag) target = io;
+            }
+            io = io->next;
+        }
+        if(!(source && target && source != target)) continue;
+        if(source->tx_lag < lag || target->tx_lag > lag / 2) continue;
+
+        /* Move half of the PPS difference between both threads
+         * but at least 10% of the source PPS, as the lag might be
+         * caused by streams with larger packets or CPU contention. */
+        source->rebalance_pps = (source->stream_pps - target->stream_pps) / 2;
+        if(source->rebalance_pps < source->stream_pps / 10) {
+            source->rebalance_pps = source->stream_pps / 10;
+        }
+        source->rebalance_target = target;
+        rebalance = true;
+        LOG(DEBUG, "Rebalance streams on interface %s from TX thread %d (lag %ld us) to %d (lag %ld us)\n",
+            interface->name, source->id, source->tx_lag / 1000,
+            target->id, target->tx_lag / 1000);
+    }
+    if(!rebalance) return;
+
+    stream = g_ctx->stream_head;
+    while(stream) {
+        if(!(stream->lag || __atomic_load_n(&stream->io_target, __ATOMIC_ACQUIRE))) {
+            io = stream->io;
+            if(io && io->rebalance_target && io->rebalance_pps >= stream->pps) {
+                io->rebalance_pps -= stream->pps;
+                stream->io_target = io->rebalance_target;
+                streams++;
+            }
+        }
+        stream = stream->next;
+    }
+
+    /* Signal source threads after all streams are marked. */
+    CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+        io = interface->io.tx;
+        while(io) {
+            if(io->rebalance_target) {
+                io->rebalance_target = NULL;
+                io->update_streams = true;
+            }
+            io = io->next;
+        }
+    }
+    if(streams) {
+        LOG(INFO, "Rebalance %u streams between TX threads\n", streams);
+    }
 }
\ No newline at end of file
@@ -21,7 +21,19 @@ io_stream_smear(io_handle_s *io);
 void
 io_stream_smear_all();
 
+void
+io_stream_pacing_init(io_handle_s *io, uint64_t interval);
+
+void
+io_stream_pacing_wait(io_handle_s *io);
+
+uint64_t
+io_stream_pacing_next(io_handle_s *io, uint64_t now);
+
 void
 io_stream_update_pps(io_handle_s *io);
 
+void
+io_stream_rebalance_job(timer_s *timer);
+
 #endif
\ No newline at end of file
@@ -8,6 +8,8 @@
  */
 #include "io.h"
 
+extern bool g_traffic;
+
 /** 
  * This function redirects the packet in the
  * IO buffer to the main thread via the TXQ 
@@ -31,11 +33,19 @@ redirect(io_thread_s *thread, io_handle_s *io)
     if((slot = bbl_txq_write_slot(thread->txq))) {
         slot->timestamp.tv_sec = io->timestamp.tv_sec;
         slot->timestamp.tv_nsec = io->timestamp.tv_nsec;
+        slot->rx_timestamp.tv_sec = io->rx_timestamp.tv_sec;
+        slot->rx_timestamp.tv_nsec = io->rx_timestamp.tv_nsec;
         slot->vlan_tci = io->vlan_tci;
         slot->vlan_tpid = io->vlan_tpid;
         slot->packet_len = io->buf_len;
         memcpy(slot->packet, io->buf, io->buf_len);
-        bbl_txq_write_next(thread->txq);
+        bbl_txq_write_next(thread->txq, slot);
+        /* Notify the main thread once until it 
+         * has processed the TXQ (event loop only). */
+        if(thread->event_fd >= 0 && 
+           !__atomic_exchange_n(&thread->signaled, true, __ATOMIC_SEQ_CST)) {
+            eventfd_write(thread->event_fd, 1);
+        }
         return IO_REDIRECT;
     }
     return IO_FULL;
@@ -80,6 +90,8 @@ io_thread_rx_handler(io_thread_s *thread, io_handle_s *io)
             /* Copy RX timestamp */
             eth->timestamp.tv_sec = io->timestamp.tv_sec;
             eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+            eth->rx_timestamp.tv_sec = io->rx_timestamp.tv_sec;
+            eth->rx_timestamp.tv_nsec = io->rx_timestamp.tv_nsec;
             if(bbl_rx_thread(io->interface, eth)) {
                 return IO_SUCCESS;
             }
@@ -93,6 +105,90 @@ io_thread_rx_handler(io_thread_s *thread, io_handle_s *io)
     return redirect(thread, io);
 }
 
+/** 
+ * This function is called from RX threads 
+ * if no packets are available. 
+ * 
+ * Without event loop, the thread simply sleeps. 
+ * With event loop, the thread continues busy polling
+ * for rx-busy-poll empty polls before it blocks on the 
+ * socket until packets are received, which brings 
+ * idle CPU usage close to zero. The poll timeout
+ * is required to check if the thread is still active. 
+ * 
+ * @param thread thread handle
+ * @param io IO handle
+ * @param sleep sleep time without event loop
+ */
+void
+io_thread_rx_wait(io_thread_s *thread, io_handle_s *io, struct timespec *sleep)
+{
+    struct pollfd pollset;
+    struct timespec rem;
+
+    if(!g_ctx->config.event_loop) {
+        nanosleep(sleep, &rem);
+        return;
+    }
+    if(thread->idle < g_ctx->config.rx_busy_poll) {
+        thread->idle++;
+        return;
+    }
+    pollset.fd = io->fd;
+    pollset.events = POLLIN;
+    pollset.revents = 0;
+    io->stats.polled++;
+    poll(&pollset, 1, IO_THREAD_POLL_TIMEOUT);
+}
+
+/** 
+ * This function is called from TX threads 
+ * before sending the next burst. 
+ * 
+ * With event loop, TX threads without pending 
+ * packets and without active traffic streams block 
+ * on their event file descriptor until the main 
+ * thread enqueues packets into the TXQ. The poll 
+ * timeout is required to check if the thread is 
+ * still active and to pick up started streams. 
+ * 
+ * Otherwise, the thread waits for the next paced 
+ * departure or simply sleeps. Busy TX threads keep
+ * this pacing loop with event loop too, because
+ * blocking them would delay stream scheduling.
+ * 
+ * @param thread thread handle
+ * @param io IO handle
+ * @param sleep sleep time without pacing
+ */
+void
+io_thread_tx_wait(io_thread_s *thread, io_handle_s *io, struct timespec *sleep)
+{
+    struct pollfd pollset;
+    struct timespec rem;
+    eventfd_t value;
+
+    if(thread->event_fd >= 0 && !io->queued && !(g_traffic && io->stream_count)) {
+        __atomic_store_n(&thread->sleeping, true, __ATOMIC_SEQ_CST);
+        if(bbl_txq_is_empty(thread->txq)) {
+            pollset.fd = thread->event_fd;
+            pollset.events = POLLIN;
+            pollset.revents = 0;
+            io->stats.polled++;
+            if(poll(&pollset, 1, IO_THREAD_POLL_TIMEOUT) > 0) {
+                eventfd_read(thread->event_fd, &value);
+            }
+        }
+        __atomic_store_n(&thread->sleeping, false, __ATOMIC_RELAXED);
+        return;
+    }
+    if(io->pacing.enabled) {
+        io_stream_pacing_wait(io);
+    } else {
+        nanosleep(sleep, &rem);
+    }
+}
+
 /** 
  * This job is scheduled in the main loop receiving 
  * packets from a RX thread via TXQ ring buffer. 
@@ -131,6 +227,8 @@ io_thread_main_rx_job(timer_s *timer)
                     /* Copy RX timestamp */
                     eth->timestamp.tv_sec = slot->timestamp.tv_sec;
                     eth->timestamp.tv_nsec = slot->timestamp.tv_nsec;
+                    eth->rx_timestamp.tv_sec = slot->rx_timestamp.tv_sec;
+                    eth->rx_timestamp.tv_nsec = slot->rx_timestamp.tv_nsec;
                     /* Dump the packet into pcap file. */
                     if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
                         pcap = true;
@@ -177,6 +275,7 @@ io_thread_main_tx_job(timer_s *timer)
     protocol_error_t tx_result = IGNORED;
 
     bool pcap = false;
+    bool wakeup = false;
 
     /* Get TX timestamp */
     struct timespec timestamp;
@@ -190,9 +289,20 @@ io_thread_main_tx_job(timer_s *timer)
                 pcapng_push_packet_header(&timestamp, slot->packet, slot->packet_len,
                                           interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
             }
-            bbl_txq_write_next(txq);
-        } else if(tx_result == EMPTY) {
-            break;
+            bbl_txq_write_next(txq, slot);
+            wakeup = true;
+        } else {
+            bbl_txq_write_cancel(txq, slot);
+            if(tx_result == EMPTY) {
+                break;
+            }
+        }
+    }
+    if(wakeup && thread->event_fd >= 0) {
+        /* Wake up idle TX thread (event loop only). */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&thread->sleeping, __ATOMIC_SEQ_CST)) {
+            eventfd_write(thread->event_fd, 1);
         }
     }
     if(pcap) {
@@ -200,6 +310,29 @@ io_thread_main_tx_job(timer_s *timer)
     }
 }
 
+/** 
+ * Event loop callback executed in the main loop 
+ * if a RX thread has received packets. 
+ */
+static void
+io_thread_rx_event(timer_event_s *event)
+{
+    io_thread_s *thread = event->data;
+    timer_s *timer = thread->io->interface->io.rx_job;
+    eventfd_t value;
+    struct timespec now;
+
+    eventfd_read(thread->event_fd, &value);
+    /* Reset before reading the TXQ, such that 
+     * further packets are notified again. */
+    __atomic_store_n(&thread->signaled, false, __ATOMIC_SEQ_CST);
+    if(timer) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timer->timestamp = &now;
+        io_thread_main_rx_job(timer);
+    }
+}
+
 void *
 io_thread_main(void *thread_data)
 {
@@ -261,12 +394,35 @@ io_thread_init(io_handle_s *io)
     /* Default run function which might be overwritten */
     thread->run_fn = NULL;
 
+    /* Init thread event file descriptor */
+    thread->event_fd = -1;
+    if(g_ctx->config.event_loop) {
+        thread->event_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+        if(thread->event_fd < 0) {
+            LOG(ERROR, "Failed to init thread eventfd %s (%d)\n", strerror(errno), errno);
+            return false;
+        }
+    }
+
     /* Add thread main loop timers/jobs */
     if(io->direction == IO_INGRESS && !interface->io.rx_job) {
-        /** Start job reading from RX thread TXQ */
-        timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 
-                           0, config->rx_interval, 
-                           interface, &io_thread_main_rx_job);
+        /** Start job reading from RX thread TXQ. With event loop,
+         * this job is triggered by the RX threads and the
+         * periodic job remains as fallback only. */
+        if(g_ctx->config.event_loop) {
+            timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 
+                               IO_EVENT_RX_INTERVAL, 0, 
+                               interface, &io_thread_main_rx_job);
+        } else {
+            timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 
+                               0, config->rx_interval, 
+                               interface, &io_thread_main_rx_job);
+        }
+    }
+    if(io->direction == IO_INGRESS && thread->event_fd >= 0) {
+        if(!timer_event_add(&g_ctx->timer_root, thread->event_fd, thread, &io_thread_rx_event)) {
+            return false;
+        }
     }
 
     if(io->direction == IO_EGRESS && !interface->io.tx_job) {
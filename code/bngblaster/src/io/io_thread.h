@@ -21,4 +21,10 @@ io_thread_stop_all();
 io_result_t
 io_thread_rx_handler(io_thread_s *thread, io_handle_s *io);
 
+void
+io_thread_rx_wait(io_thread_s *thread, io_handle_s *io, struct timespec *sleep);
+
+void
+io_thread_tx_wait(io_thread_s *thread, io_handle_s *io, struct timespec *sleep);
+
 #endif
\ No newline at end of file
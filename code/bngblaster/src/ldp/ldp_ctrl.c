@@ -88,6 +88,8 @@ ldp_ctrl_session_json(ldp_session_s *session)
     const char *raw_update_file = NULL;
     char *local_address;
     char *peer_address;
+    uint64_t duration_us;
+    double goodput_mbps = 0;
 
     if(!session) {
         return NULL;
@@ -97,6 +99,12 @@ ldp_ctrl_session_json(ldp_session_s *session)
         raw_update_file = session->raw_update->file;
     }
 
+    /* Time to drain and achieved goodput of last raw update. */
+    duration_us = session->update_duration.tv_sec * 1000000 + session->update_duration.tv_nsec / 1000;
+    if(duration_us) {
+        goodput_mbps = (double)session->update_bytes * 8 / duration_us;
+    }
+
     stats = json_pack("{si si si si si si}",
                       "pdu-rx", session->stats.pdu_rx,
                       "pdu-tx", session->stats.pdu_tx,
@@ -117,7 +125,7 @@ ldp_ctrl_session_json(ldp_session_s *session)
         peer_address = format_ipv4_address(&session->peer.ipv4_address);
     }
 
-    root = json_pack("{si ss ss ss ss ss ss si ss* ss* so*}",
+    root = json_pack("{si ss ss ss ss ss ss si ss* ss* si sI si sf so*}",
                      "ldp-instance-id", session->instance->config->id,
                      "interface", session->interface->name,
                      "local-address", local_address,
@@ -128,6 +136,10 @@ ldp_ctrl_session_json(ldp_session_s *session)
                      "state-transitions", session->state_transitions,
                      "raw-update-state", raw_update_state(session),
                      "raw-update-file", raw_update_file,
+                     "raw-update-duration", session->update_duration.tv_sec,
+                     "raw-update-duration-ms", duration_us / 1000,
+                     "raw-update-bytes", session->update_bytes,
+                     "raw-update-goodput-mbps", goodput_mbps,
                      "stats", stats);
     if(!root) {
         if(stats) json_decref(stats);
@@ -246,7 +258,7 @@ ldp_ctrl_raw_update(int fd, uint32_t session_id __attribute__((unused)), json_t
     }
 
     /* Load file. */
-    raw_update = ldp_raw_update_load(file_path, true);
+    raw_update = ldp_raw_update_load(file_path);
     if(!raw_update) {
         return bbl_ctrl_status(fd, "error", 400, "failed to load file");
     }
@@ -315,6 +327,7 @@ ldp_ctrl_raw_update_list(int fd, uint32_t session_id __attribute__((unused)), js
         update = json_pack("{ss* si si si}",
                            "file", raw_update->file,
                            "len", raw_update->len,
+                           "validated", raw_update->validated,
                            "pdu", raw_update->pdu,
                            "messages", raw_update->messages);
         if(update) {
@@ -336,6 +349,45 @@ ldp_ctrl_raw_update_list(int fd, uint32_t session_id __attribute__((unused)), js
     return result;
 }
 
+int
+ldp_ctrl_raw_update_unload(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
+{
+    ldp_instance_s *ldp_instance = g_ctx->ldp_instances;
+    ldp_session_s *ldp_session;
+    ldp_raw_update_s *raw_update = g_ctx->ldp_raw_updates;
+    const char *file_path;
+
+    /* Unpack further arguments */
+    if(json_unpack(arguments, "{s:s}", "file", &file_path) != 0) {
+        return bbl_ctrl_status(fd, "error", 400, "missing argument file");
+    }
+
+    while(raw_update) {
+        if(strcmp(file_path, raw_update->file) == 0) {
+            break;
+        }
+        raw_update = raw_update->next;
+    }
+    if(!raw_update) {
+        return bbl_ctrl_status(fd, "error", 404, "file not loaded");
+    }
+
+    /* Files referenced by any session can't be unloaded. */
+    while(ldp_instance) {
+        ldp_session = ldp_instance->sessions;
+        while(ldp_session) {
+            if(ldp_session->raw_update == raw_update ||
+               ldp_session->raw_update_start == raw_update) {
+                return bbl_ctrl_status(fd, "error", 409, "file in use");
+            }
+            ldp_session = ldp_session->next;
+        }
+        ldp_instance = ldp_instance->next;
+    }
+    ldp_raw_update_unload(raw_update);
+    return bbl_ctrl_status(fd, "ok", 200, NULL);
+}
+
 int
 ldp_ctrl_disconnect(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
 {
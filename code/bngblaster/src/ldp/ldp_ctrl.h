@@ -24,6 +24,9 @@ ldp_ctrl_raw_update(int fd, uint32_t session_id __attribute__((unused)), json_t
 int
 ldp_ctrl_raw_update_list(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)));
 
+int
+ldp_ctrl_raw_update_unload(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
+
 int
 ldp_ctrl_disconnect(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
 
@@ -20,6 +20,7 @@
 #define LDP_MIN_TLV_LEN                             4
 
 #define LDP_BUF_SIZE                                256*1024
+#define LDP_RAW_UPDATE_CHUNK_SIZE                   16*1024*1024
 
 #define LDP_MESSAGE_TYPE_NOTIFICATION               0x0001
 #define LDP_MESSAGE_TYPE_HELLO                      0x0100
@@ -127,10 +128,13 @@ typedef struct ldp_db_entry_ {
 typedef struct ldp_raw_update_ {
     const char *file;
 
-    uint8_t *buf;
+    uint8_t *buf; /* read-only file mapping */
     uint32_t len;
-    uint32_t pdu; /* PDU counter */
-    uint32_t messages; /* Message counter*/
+    int fd; /* kept open to detect file modifications */
+    struct timespec mtime;
+    uint32_t validated; /* bytes validated from start of file */
+    uint32_t pdu; /* PDU counter (validated bytes) */
+    uint32_t messages; /* Message counter (validated bytes) */
 
     /* Pointer to next instance */
     struct ldp_raw_update_ *next;
@@ -227,11 +231,14 @@ typedef struct ldp_session_ {
 
     ldp_raw_update_s *raw_update_start;
     ldp_raw_update_s *raw_update;
+    uint32_t raw_update_offset;
     bool raw_update_sending;
 
     struct timespec operational_timestamp;
     struct timespec update_start_timestamp;
     struct timespec update_stop_timestamp;
+    struct timespec update_duration;
+    uint32_t update_bytes;
 
     bool teardown;
 
@@ -8,100 +8,60 @@
  */
 #include "ldp.h"
 
+#include <fcntl.h>
+
 static ldp_raw_update_s *
-ldp_raw_update_load_file(const char *file, bool decode_file)
+ldp_raw_update_load_file(const char *file)
 {
     ldp_raw_update_s *raw_update = NULL;
-    long fsize;
-    double fsize_kb;
-
+    struct stat st;
     uint8_t *buf = NULL;
-    uint32_t len = 0;
-
-    uint16_t pdu_length;
-    uint16_t msg_len;
+    int fd;
 
     /* Open file */
-    FILE *f = fopen(file, "rb");
-    if(f == NULL) {
+    fd = open(file, O_RDONLY|O_CLOEXEC);
+    if(fd < 0) {
         LOG(ERROR, "Failed to open LDP RAW update file %s\n", file);
         return NULL;
-    } 
-
-    /* Get file size */
-    fseek(f, 0, SEEK_END);
-    fsize = ftell(f);
-    fsize_kb = fsize/1024.0;
-    fseek(f, 0, SEEK_SET);
-
-    /* Load file into memory */
-    raw_update = calloc(1, sizeof(ldp_raw_update_s));
-    raw_update->file = strdup(file);
-    raw_update->buf = malloc(fsize);
-    raw_update->len = fsize;
-    if(fread(raw_update->buf, fsize, 1, f) != 1) {
-        fclose(f);
+    }
+    if(fstat(fd, &st) != 0 || st.st_size > UINT32_MAX) {
+        close(fd);
         LOG(ERROR, "Failed to read LDP RAW update file %s\n", file);
-        goto ERROR;
+        return NULL;
     }
-    fclose(f);
-
-    if(decode_file) {
-        /* Decode update stream */
-        buf = raw_update->buf;
-        len = raw_update->len;
-        while(len) {
-            if(len < LDP_MIN_PDU_LEN) {
-                goto DECODE_ERROR;
-            }
-            raw_update->pdu++;
 
-            BUMP_BUFFER(buf, len, sizeof(uint16_t));
-            pdu_length = be16toh(*(uint16_t*)buf);
-            BUMP_BUFFER(buf, len, sizeof(uint16_t));
-            if(pdu_length > len) {
-                goto DECODE_ERROR;
-            }
-            BUMP_BUFFER(buf, len, LDP_IDENTIFIER_LEN);
-            while(pdu_length > LDP_MIN_MSG_LEN) {
-                BUMP_BUFFER(buf, len, sizeof(uint16_t));
-                msg_len = be16toh(*(uint16_t*)buf);
-                BUMP_BUFFER(buf, len, sizeof(uint16_t));
-                pdu_length -= 4;
-                if(msg_len > pdu_length) {
-                    goto DECODE_ERROR;
-                }
-                BUMP_BUFFER(buf, len, msg_len);
-                pdu_length -= msg_len;
-                raw_update->messages++;
-            }
+    /* Map file read-only, pages are read on demand
+     * while sending and shared by all sessions. */
+    if(st.st_size) {
+        buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(buf == MAP_FAILED) {
+            close(fd);
+            LOG(ERROR, "Failed to map LDP RAW update file %s (%s)\n", file, strerror(errno));
+            return NULL;
         }
+        madvise(buf, st.st_size, MADV_SEQUENTIAL);
     }
-    LOG(INFO, "Loaded LDP RAW update file %s (%.2f KB, %u pdu, %u messages)\n", 
-        file, fsize_kb, raw_update->pdu, raw_update->messages);
-    return raw_update;
 
-DECODE_ERROR:
-    LOG(ERROR, "Failed to decode LDP RAW update file %s\n", file);
-ERROR:
-    if(raw_update) {
-        if(raw_update->buf) {
-            free(raw_update->buf);
-        }
-        free(raw_update);
-    }
-    return NULL;
+    raw_update = calloc(1, sizeof(ldp_raw_update_s));
+    raw_update->file = strdup(file);
+    raw_update->buf = buf;
+    raw_update->len = st.st_size;
+    raw_update->fd = fd;
+    raw_update->mtime = st.st_mtim;
+
+    LOG(INFO, "Loaded LDP RAW update file %s (%.2f KB)\n", 
+        file, raw_update->len/1024.0);
+    return raw_update;
 }
 
 /**
  * ldp_raw_update_load 
  * 
  * @param file update file
- * @param decode_file decode/parse file content if true
  * @return LDP RAW update structure
  */
 ldp_raw_update_s *
-ldp_raw_update_load(const char *file, bool decode_file)
+ldp_raw_update_load(const char *file)
 {
     ldp_raw_update_s *raw_update = g_ctx->ldp_raw_updates;
 
@@ -112,7 +72,7 @@ ldp_raw_update_load(const char *file, bool decode_file)
         }
         raw_update = raw_update->next;
     }
-    raw_update = ldp_raw_update_load_file(file, decode_file);
+    raw_update = ldp_raw_update_load_file(file);
     if(raw_update) {
         raw_update->next = g_ctx->ldp_raw_updates;
         g_ctx->ldp_raw_updates = raw_update;
@@ -120,4 +80,137 @@ ldp_raw_update_load(const char *file, bool decode_file)
     } else {
         return NULL;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * ldp_raw_update_unload 
+ * 
+ * Remove file from the list of loaded
+ * files and release the file mapping.
+ * 
+ * @param raw_update LDP RAW update structure
+ */
+void
+ldp_raw_update_unload(ldp_raw_update_s *raw_update)
+{
+    ldp_raw_update_s **prev = &g_ctx->ldp_raw_updates;
+
+    while(*prev) {
+        if(*prev == raw_update) {
+            *prev = raw_update->next;
+            break;
+        }
+        prev = &(*prev)->next;
+    }
+    LOG(INFO, "Unloaded LDP RAW update file %s\n", raw_update->file);
+    if(raw_update->buf) {
+        munmap(raw_update->buf, raw_update->len);
+    }
+    close(raw_update->fd);
+    free((char*)raw_update->file);
+    free(raw_update);
+}
+
+static uint32_t
+ldp_raw_update_pdu(uint8_t *buf, uint32_t len, uint32_t *messages)
+{
+    uint32_t pdu_length;
+    uint32_t msg_len;
+    uint8_t *msg;
+
+    if(len < LDP_MIN_PDU_LEN) {
+        return 0;
+    }
+    /* PDU length excludes version and length field. */
+    pdu_length = be16toh(*(uint16_t*)(buf+2));
+    if(pdu_length < LDP_IDENTIFIER_LEN || pdu_length > len - 4) {
+        return 0;
+    }
+    msg = buf + LDP_MIN_PDU_LEN;
+    pdu_length -= LDP_IDENTIFIER_LEN;
+    *messages = 0;
+    while(pdu_length) {
+        if(pdu_length < 4) {
+            return 0;
+        }
+        msg_len = be16toh(*(uint16_t*)(msg+2)) + 4;
+        if(msg_len > pdu_length) {
+            return 0;
+        }
+        msg += msg_len;
+        pdu_length -= msg_len;
+        (*messages)++;
+    }
+    return msg - buf;
+}
+
+/*
+ * The file is mapped and not copied, therefore it must 
+ * not be modified while loaded. Accessing pages beyond 
+ * the end of a truncated file raises SIGBUS. 
+ */
+static bool
+ldp_raw_update_unchanged(ldp_raw_update_s *raw_update)
+{
+    struct stat st;
+
+    if(fstat(raw_update->fd, &st) != 0 || 
+       st.st_size != raw_update->len ||
+       st.st_mtim.tv_sec != raw_update->mtime.tv_sec ||
+       st.st_mtim.tv_nsec != raw_update->mtime.tv_nsec) {
+        LOG(ERROR, "LDP RAW update file %s modified after loading\n", raw_update->file);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * ldp_raw_update_chunk 
+ * 
+ * Validate the PDU and message framing of the next 
+ * chunk of up to LDP_RAW_UPDATE_CHUNK_SIZE bytes. 
+ * The file must not have changed since it was loaded.
+ * 
+ * @param raw_update LDP RAW update structure
+ * @param offset start of chunk (PDU boundary)
+ * @param pdu returns number of PDU in chunk
+ * @param messages returns number of messages in chunk
+ * @return chunk length or zero if completed or invalid
+ */
+uint32_t
+ldp_raw_update_chunk(ldp_raw_update_s *raw_update, uint32_t offset,
+                     uint32_t *pdu, uint32_t *messages)
+{
+    uint8_t *buf = raw_update->buf + offset;
+    uint32_t len = raw_update->len - offset;
+    uint32_t chunk = 0;
+    uint32_t pdu_len;
+    uint32_t pdu_messages;
+
+    *pdu = 0;
+    *messages = 0;
+    if(!ldp_raw_update_unchanged(raw_update)) {
+        return 0;
+    }
+    while(chunk < len && chunk < LDP_RAW_UPDATE_CHUNK_SIZE) {
+        pdu_len = ldp_raw_update_pdu(buf+chunk, len-chunk, &pdu_messages);
+        if(!pdu_len) {
+            /* Send all valid PDU before the error 
+             * and stop with the following chunk. */
+            if(!chunk) {
+                LOG(ERROR, "Failed to decode LDP RAW update file %s at offset %u\n",
+                    raw_update->file, offset);
+            }
+            break;
+        }
+        (*pdu)++;
+        *messages += pdu_messages;
+        chunk += pdu_len;
+    }
+    if(offset == raw_update->validated) {
+        raw_update->validated += chunk;
+        raw_update->pdu += *pdu;
+        raw_update->messages += *messages;
+    }
+    return chunk;
+}
@@ -10,6 +10,13 @@
 #define __BBL_LDP_RAW_UPDATE_H__
 
 ldp_raw_update_s *
-ldp_raw_update_load(const char *file, bool decode_file);
+ldp_raw_update_load(const char *file);
 
-#endif
\ No newline at end of file
+void
+ldp_raw_update_unload(ldp_raw_update_s *raw_update);
+
+uint32_t
+ldp_raw_update_chunk(ldp_raw_update_s *raw_update, uint32_t offset,
+                     uint32_t *pdu, uint32_t *messages);
+
+#endif
@@ -93,23 +93,57 @@ void
 ldp_raw_update_stop_cb(void *arg)
 {
     ldp_session_s *session = (ldp_session_s*)arg;
-    struct timespec time_diff;
 
     session->tcpc->idle_cb = NULL;
 
     clock_gettime(CLOCK_MONOTONIC, &session->update_stop_timestamp);
-    timespec_sub(&time_diff, 
+    timespec_sub(&session->update_duration, 
                  &session->update_stop_timestamp, 
                  &session->update_start_timestamp);
 
     session->raw_update_sending = false;
-    session->stats.pdu_tx += session->raw_update->pdu;
-    session->stats.message_tx += session->raw_update->messages;
     
     LOG(LDP, "LDP (%s - %s) raw update stop after %lds\n",
         ldp_id_to_str(session->local.lsr_id, session->local.label_space_id),
         ldp_id_to_str(session->peer.lsr_id, session->peer.label_space_id),
-        time_diff.tv_sec);
+        session->update_duration.tv_sec);
+
+    if(session->raw_update_offset < session->raw_update->len) {
+        LOG(ERROR, "LDP (%s - %s) raw update failed at offset %u of %u bytes\n",
+            ldp_id_to_str(session->local.lsr_id, session->local.label_space_id),
+            ldp_id_to_str(session->peer.lsr_id, session->peer.label_space_id),
+            session->raw_update_offset, session->raw_update->len);
+    }
+}
+
+/**
+ * ldp_raw_update_idle_cb
+ *
+ * Called if the previous chunk of the RAW update
+ * file is fully acknowledged to validate and send
+ * the next one directly from the file mapping.
+ */
+static void 
+ldp_raw_update_idle_cb(void *arg)
+{
+    ldp_session_s *session = (ldp_session_s*)arg;
+    ldp_raw_update_s *raw_update = session->raw_update;
+    uint32_t pdu;
+    uint32_t messages;
+    uint32_t len;
+
+    len = ldp_raw_update_chunk(raw_update, session->raw_update_offset, &pdu, &messages);
+    if(!len) {
+        ldp_raw_update_stop_cb(session);
+        return;
+    }
+    if(!bbl_tcp_send(session->tcpc, raw_update->buf + session->raw_update_offset, len)) {
+        return;
+    }
+    session->raw_update_offset += len;
+    session->update_bytes += len;
+    session->stats.pdu_tx += pdu;
+    session->stats.message_tx += messages;
 }
 
 void
@@ -119,18 +153,20 @@ ldp_session_update_job(timer_s *timer)
 
     if(session->state == LDP_OPERATIONAL) {
         if(session->raw_update && !session->raw_update_sending) {
-            if(bbl_tcp_send(session->tcpc, session->raw_update->buf, session->raw_update->len)) {
-                session->raw_update_sending = true;
-
-                LOG(LDP, "LDP (%s - %s) raw update start\n",
-                    ldp_id_to_str(session->local.lsr_id, session->local.label_space_id),
-                    ldp_id_to_str(session->peer.lsr_id, session->peer.label_space_id));
-
-                clock_gettime(CLOCK_MONOTONIC, &session->update_start_timestamp);
-                session->tcpc->idle_cb = ldp_raw_update_stop_cb;
-            } else {
+            if(session->tcpc->state != BBL_TCP_STATE_IDLE) {
                 goto RETRY;
             }
+            session->raw_update_sending = true;
+            session->raw_update_offset = 0;
+            session->update_bytes = 0;
+
+            LOG(LDP, "LDP (%s - %s) raw update start\n",
+                ldp_id_to_str(session->local.lsr_id, session->local.label_space_id),
+                ldp_id_to_str(session->peer.lsr_id, session->peer.label_space_id));
+
+            clock_gettime(CLOCK_MONOTONIC, &session->update_start_timestamp);
+            session->tcpc->idle_cb = ldp_raw_update_idle_cb;
+            ldp_raw_update_idle_cb(session);
         }
     }
     timer->periodic = false;
@@ -479,7 +515,7 @@ ldp_session_ipv4_init(ldp_session_s *session, ldp_adjacency_s *adjacency,
         session->local.keepalive_time = config->keepalive_time;
         session->local.max_pdu_len = LDP_MAX_PDU_LEN_INIT;
         if(config->raw_update_file) {
-            session->raw_update_start = ldp_raw_update_load(config->raw_update_file, true);
+            session->raw_update_start = ldp_raw_update_load(config->raw_update_file);
         }
         session->next = instance->sessions;
         instance->sessions = session;
@@ -538,7 +574,7 @@ ldp_session_ipv6_init(ldp_session_s *session, ldp_adjacency_s *adjacency,
         session->local.keepalive_time = config->keepalive_time;
         session->local.max_pdu_len = LDP_MAX_PDU_LEN_INIT;
         if(config->raw_update_file) {
-            session->raw_update_start = ldp_raw_update_load(config->raw_update_file, true);
+            session->raw_update_start = ldp_raw_update_load(config->raw_update_file);
         }
         session->next = instance->sessions;
         instance->sessions = session;
@@ -70,11 +70,11 @@ extern unsigned char debug_flags;
 
 /* MEM_SIZE: the size of the heap memory. If the application will send
    a lot of data that needs to be copied, this should be set high. */
-#define MEM_SIZE                 4*1024*1024
+#define MEM_SIZE                 16*1024*1024
 /* MEMP_NUM_PBUF: the number of memp struct pbufs. If the application
    sends a lot of data out of ROM (or other static memory), this
    should be set high. */
-#define MEMP_NUM_PBUF            4096
+#define MEMP_NUM_PBUF            16384
 /* MEMP_NUM_RAW_PCB: the number of UDP protocol control blocks. One
    per active RAW "connection". */
 #define MEMP_NUM_RAW_PCB         3
@@ -89,7 +89,7 @@ extern unsigned char debug_flags;
 #define MEMP_NUM_TCP_PCB_LISTEN  256
 /* MEMP_NUM_TCP_SEG: the number of simultaneously queued TCP
    segments. */
-#define MEMP_NUM_TCP_SEG         2048
+#define MEMP_NUM_TCP_SEG         16384
 /* MEMP_NUM_SYS_TIMEOUT: the number of simultaneously active
    timeouts. */
 #define MEMP_NUM_SYS_TIMEOUT     257
@@ -111,7 +111,7 @@ extern unsigned char debug_flags;
 #define PBUF_POOL_SIZE           2048
 
 /* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
-#define PBUF_POOL_BUFSIZE       256
+#define PBUF_POOL_BUFSIZE       1536
 
 /* PBUF_LINK_HLEN: the number of bytes that should be allocated for a
    link level header. */
@@ -129,26 +129,43 @@ extern unsigned char debug_flags;
 #define TCP_TTL                  255
 
 /* Controls if TCP should queue segments that arrive out of
-   order. Define to 0 if your device is low on memory. */
-#define TCP_QUEUE_OOSEQ          0
+   order. Received segments are copied into PBUF_RAM buffers
+   (see bbl_tcp_pbuf) as lwIP keeps out of order segments. */
+#define TCP_QUEUE_OOSEQ          1
 
-/* TCP Maximum segment size. */
-#define TCP_MSS                  1024
+/* Limit out of order queue per connection. */
+#define TCP_OOSEQ_MAX_BYTES      TCP_WND
+#define TCP_OOSEQ_MAX_PBUFS      1024
+
+/* Send selective acknowledgements (requires TCP_QUEUE_OOSEQ). */
+#define LWIP_TCP_SACK_OUT        1
+#define LWIP_TCP_MAX_SACK_NUM    4
+
+/* TCP Maximum segment size. The effective MSS is derived
+   from the MTU of the lwIP network interface. */
+#define TCP_MSS                  8960
+#define TCP_CALCULATE_EFF_SEND_MSS 1
+
+/* TCP window scaling. */
+#define LWIP_WND_SCALE           1
+#define TCP_RCV_SCALE            5
 
 /* TCP sender buffer space (bytes). */
-#define TCP_SND_BUF              (32 * TCP_MSS)
+#define TCP_SND_BUF              (1024 * 1024)
 
 /* TCP sender buffer space (pbufs). This must be at least = 2 *
-   TCP_SND_BUF/TCP_MSS for things to work. */
-#define TCP_SND_QUEUELEN         (8 * TCP_SND_BUF/TCP_MSS)
+   TCP_SND_BUF/TCP_MSS for things to work. Sized for the
+   minimum MSS with one header and one reference pbuf
+   per segment. */
+#define TCP_SND_QUEUELEN         4096
 
 /* TCP writable space (bytes). This must be less than or equal
    to TCP_SND_BUF. It is the amount of space which must be
    available in the tcp snd_buf for select to return writable */
-#define TCP_SNDLOWAT             (TCP_SND_BUF/2)
+#define TCP_SNDLOWAT             (2 * TCP_MSS)
 
 /* TCP receive window. */
-#define TCP_WND                  (32 * TCP_MSS)
+#define TCP_WND                  (1024 * 1024)
 
 /* Maximum number of retransmissions of data segments. */
 #define TCP_MAXRTX               12
@@ -0,0 +1,432 @@
+/*
+ * BNG Blaster (BBL) - BGP UPDATE Decoder and Adj-RIB-In Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <bbl_def.h>
+#include <bbl_protocols.h>
+#include <utils.h>
+#include <bgp/bgp_def.h>
+#include <bgp/bgp_rib.h>
+
+#define TEST_KEYS 4096
+
+static uint16_t
+test_update(uint8_t *buf,
+            uint8_t *withdrawn, uint16_t withdrawn_len,
+            uint8_t *attr, uint16_t attr_len,
+            uint8_t *nlri, uint16_t nlri_len)
+{
+    uint16_t len = BGP_MIN_MESSAGE_SIZE;
+
+    memset(buf, 0xff, 16);
+    buf[18] = BGP_MSG_UPDATE;
+    write_be_uint(buf+len, 2, withdrawn_len);
+    len += 2;
+    memcpy(buf+len, withdrawn, withdrawn_len);
+    len += withdrawn_len;
+    write_be_uint(buf+len, 2, attr_len);
+    len += 2;
+    memcpy(buf+len, attr, attr_len);
+    len += attr_len;
+    memcpy(buf+len, nlri, nlri_len);
+    len += nlri_len;
+    write_be_uint(buf+16, 2, len);
+    return len;
+}
+
+static void
+test_key(bgp_rib_entry_s *key, bgp_rib_family_t family, uint32_t index, uint8_t prefix_len)
+{
+    memset(key, 0x0, sizeof(*key));
+    key->family = family + 1;
+    key->prefix_len = prefix_len;
+    write_be_uint(key->prefix, 4, index << 8);
+}
+
+static bool
+test_rib_lookup(bgp_rib_s *rib, bgp_rib_entry_s *key)
+{
+    /* Add of existing prefix replaces the label only. */
+    uint32_t count = rib->count;
+    if(bgp_rib_add(rib, key)) {
+        bgp_rib_del(rib, key);
+        assert_int_equal(rib->count, count);
+        return false;
+    }
+    return true;
+}
+
+static void
+test_bgp_rib_add_del(void **unused) {
+    (void) unused;
+
+    bgp_rib_s rib = {0};
+    bgp_rib_entry_s key;
+
+    test_key(&key, BGP_RIB_IPV4_LU, 1, 24);
+    key.label = 100;
+    assert_true(bgp_rib_add(&rib, &key));
+    assert_int_equal(rib.size, BGP_RIB_SIZE_MIN);
+    assert_int_equal(rib.count, 1);
+    assert_int_equal(rib.family_count[BGP_RIB_IPV4_LU], 1);
+
+    /* Implicit withdraw */
+    key.label = 200;
+    assert_false(bgp_rib_add(&rib, &key));
+    assert_int_equal(rib.count, 1);
+
+    /* Same prefix in other family or with other length. */
+    test_key(&key, BGP_RIB_IPV4_UC, 1, 24);
+    assert_true(bgp_rib_add(&rib, &key));
+    test_key(&key, BGP_RIB_IPV4_UC, 1, 25);
+    assert_true(bgp_rib_add(&rib, &key));
+    assert_int_equal(rib.count, 3);
+    assert_int_equal(rib.family_count[BGP_RIB_IPV4_UC], 2);
+
+    assert_true(bgp_rib_del(&rib, &key));
+    assert_false(bgp_rib_del(&rib, &key));
+    test_key(&key, BGP_RIB_IPV4_LU, 1, 24);
+    assert_true(bgp_rib_del(&rib, &key));
+    assert_int_equal(rib.count, 1);
+    assert_int_equal(rib.family_count[BGP_RIB_IPV4_LU], 0);
+    assert_int_equal(rib.family_count[BGP_RIB_IPV4_UC], 1);
+
+    bgp_rib_free(&rib);
+    assert_null(rib.entries);
+    assert_int_equal(rib.count, 0);
+    assert_false(bgp_rib_del(&rib, &key));
+}
+
+static void
+test_bgp_rib_delete_reinsert(void **unused) {
+    (void) unused;
+
+    bgp_rib_s rib = {0};
+    bgp_rib_entry_s key;
+    bool present[TEST_KEYS] = {0};
+    uint32_t count = 0;
+    uint32_t seed = 1;
+    uint32_t i, k;
+
+    /* Close to the maximum load factor, long probe sequences
+     * wrap around the end of the table. Random deletes must
+     * keep all remaining probe sequences intact. */
+    for(i = 0; i < 767; i++) {
+        test_key(&key, BGP_RIB_IPV4_UC, i, 24);
+        assert_true(bgp_rib_add(&rib, &key));
+        present[i] = true;
+        count++;
+    }
+    assert_int_equal(rib.size, BGP_RIB_SIZE_MIN);
+
+    for(i = 0; i < 200000; i++) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % 1000;
+        test_key(&key, BGP_RIB_IPV4_UC, k, 24);
+        if(present[k]) {
+            assert_true(bgp_rib_del(&rib, &key));
+            present[k] = false;
+            count--;
+        } else if(count < 767) {
+            assert_true(bgp_rib_add(&rib, &key));
+            present[k] = true;
+            count++;
+        } else {
+            assert_false(bgp_rib_del(&rib, &key));
+        }
+        assert_int_equal(rib.count, count);
+    }
+    assert_int_equal(rib.size, BGP_RIB_SIZE_MIN);
+    for(k = 0; k < 1000; k++) {
+        test_key(&key, BGP_RIB_IPV4_UC, k, 24);
+        assert_int_equal(test_rib_lookup(&rib, &key), present[k]);
+    }
+
+    /* Grow the table and delete all prefixes. */
+    for(k = 0; k < TEST_KEYS; k++) {
+        test_key(&key, BGP_RIB_IPV4_UC, k, 24);
+        assert_int_equal(bgp_rib_add(&rib, &key), !present[k]);
+    }
+    assert_int_equal(rib.count, TEST_KEYS);
+    assert_true(rib.size > BGP_RIB_SIZE_MIN);
+    for(k = 0; k < TEST_KEYS; k += 2) {
+        test_key(&key, BGP_RIB_IPV4_UC, k, 24);
+        assert_true(bgp_rib_del(&rib, &key));
+    }
+    for(k = 0; k < TEST_KEYS; k++) {
+        test_key(&key, BGP_RIB_IPV4_UC, k, 24);
+        assert_int_equal(test_rib_lookup(&rib, &key), k & 1);
+    }
+    for(k = 1; k < TEST_KEYS; k += 2) {
+        test_key(&key, BGP_RIB_IPV4_UC, k, 24);
+        assert_true(bgp_rib_del(&rib, &key));
+    }
+    assert_int_equal(rib.count, 0);
+    assert_int_equal(rib.family_count[BGP_RIB_IPV4_UC], 0);
+    for(i = 0; i < rib.size; i++) {
+        assert_int_equal(rib.entries[i].family, 0);
+    }
+    bgp_rib_free(&rib);
+}
+
+static void
+test_bgp_decode_ipv4_unicast(void **unused) {
+    (void) unused;
+
+    bgp_rib_s rib = {0};
+    bgp_rib_entry_s key;
+    uint8_t buf[256];
+    uint16_t len;
+    uint32_t eor;
+
+    uint8_t attr[] = {
+        0x40, BGP_PATH_ATTR_ORIGIN, 1, 0,
+        0x40, BGP_PATH_ATTR_AS_PATH, 0,
+        0x40, BGP_PATH_ATTR_NEXT_HOP, 4, 10, 0, 0, 1
+    };
+    uint8_t nlri[] = {
+        24, 10, 1, 1,
+        32, 10, 2, 2, 2,
+        9, 10, 0xff, /* host bits set */
+        0
+    };
+    uint8_t withdrawn[] = {
+        24, 10, 1, 1,
+        9, 10, 0x80
+    };
+
+    len = test_update(buf, NULL, 0, attr, sizeof(attr), nlri, sizeof(nlri));
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, 0);
+    assert_int_equal(rib.count, 4);
+    assert_int_equal(rib.announced, 4);
+    assert_int_equal(rib.family_count[BGP_RIB_IPV4_UC], 4);
+    assert_true(rib.first_prefix_timestamp.tv_sec || rib.first_prefix_timestamp.tv_nsec);
+
+    memset(&key, 0x0, sizeof(key));
+    key.family = BGP_RIB_IPV4_UC + 1;
+    key.prefix_len = 9;
+    key.prefix[0] = 10;
+    key.prefix[1] = 0x80;
+    assert_true(test_rib_lookup(&rib, &key));
+
+    len = test_update(buf, withdrawn, sizeof(withdrawn), NULL, 0, NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, 0);
+    assert_int_equal(rib.count, 2);
+    assert_int_equal(rib.withdrawn, 2);
+
+    /* Count only */
+    bgp_rib_free(&rib);
+    len = test_update(buf, NULL, 0, attr, sizeof(attr), nlri, sizeof(nlri));
+    assert_true(bgp_rib_decode_update(&rib, buf, len, false, &eor));
+    assert_int_equal(rib.count, 0);
+    assert_int_equal(rib.announced, 4);
+    bgp_rib_free(&rib);
+}
+
+static void
+test_bgp_decode_truncated(void **unused) {
+    (void) unused;
+
+    bgp_rib_s rib = {0};
+    uint8_t buf[256];
+    uint16_t len;
+    uint32_t eor;
+
+    uint8_t attr[] = { 0x40, BGP_PATH_ATTR_ORIGIN, 1, 0 };
+    uint8_t nlri_short[] = { 24, 10, 1 };
+    uint8_t nlri_long[] = { 33, 10, 1, 1, 1, 1 };
+    uint8_t attr_short[] = { 0x40, BGP_PATH_ATTR_ORIGIN, 2, 0 };
+    uint8_t attr_ext_short[] = { 0x50, BGP_PATH_ATTR_ORIGIN, 0 };
+    uint8_t mp_reach_nh[] = {
+        0x80, BGP_PATH_ATTR_MP_REACH, 5, 0, 1, 1, 4, 10
+    };
+
+    /* Minimum UPDATE length */
+    len = test_update(buf, NULL, 0, NULL, 0, NULL, 0);
+    assert_false(bgp_rib_decode_update(&rib, buf, len-1, true, &eor));
+
+    /* Prefix exceeds message */
+    len = test_update(buf, NULL, 0, attr, sizeof(attr), nlri_short, sizeof(nlri_short));
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    len = test_update(buf, nlri_short, sizeof(nlri_short), NULL, 0, NULL, 0);
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+
+    /* Prefix length exceeds address length */
+    len = test_update(buf, NULL, 0, attr, sizeof(attr), nlri_long, sizeof(nlri_long));
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+
+    /* Withdrawn routes or attribute length exceeds message */
+    len = test_update(buf, NULL, 0, attr, sizeof(attr), NULL, 0);
+    write_be_uint(buf+BGP_MIN_MESSAGE_SIZE, 2, 8);
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    len = test_update(buf, NULL, 0, attr, sizeof(attr), NULL, 0);
+    assert_false(bgp_rib_decode_update(&rib, buf, len-1, true, &eor));
+
+    /* Total path attribute length must not wrap around (23 + 65530) */
+    memset(buf, 0x0, 100);
+    len = test_update(buf, NULL, 0, NULL, 0, NULL, 0);
+    write_be_uint(buf+BGP_MIN_MESSAGE_SIZE+2, 2, 65530);
+    assert_false(bgp_rib_decode_update(&rib, buf, 100, true, &eor));
+
+    /* Attribute exceeds attribute length */
+    len = test_update(buf, NULL, 0, attr_short, sizeof(attr_short), NULL, 0);
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    len = test_update(buf, NULL, 0, attr_ext_short, sizeof(attr_ext_short), NULL, 0);
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+
+    /* Next-hop exceeds MP_REACH_NLRI */
+    len = test_update(buf, NULL, 0, mp_reach_nh, sizeof(mp_reach_nh), NULL, 0);
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+
+    assert_int_equal(rib.count, 0);
+    assert_int_equal(rib.announced, 0);
+    bgp_rib_free(&rib);
+}
+
+static void
+test_bgp_decode_labeled(void **unused) {
+    (void) unused;
+
+    bgp_rib_s rib = {0};
+    bgp_rib_entry_s key;
+    uint8_t buf[256];
+    uint16_t len;
+    uint32_t eor;
+
+    uint8_t mp_reach[] = {
+        0x90, BGP_PATH_ATTR_MP_REACH, 0, 26,
+        0, 1, 4, 4, 10, 0, 0, 1, 0,
+        /* 10.1.1.0/24 label 1000 */
+        24+24, 0x00, 0x3e, 0x81, 10, 1, 1,
+        /* 10.2.2.0/24 label stack 16, 2000 */
+        24+48, 0x00, 0x01, 0x00, 0x00, 0x7d, 0x01, 10, 2, 2
+    };
+    uint8_t mp_unreach[] = {
+        0x90, BGP_PATH_ATTR_MP_UNREACH, 0, 10,
+        0, 1, 4,
+        /* 10.1.1.0/24 with compatibility label */
+        24+24, 0x80, 0x00, 0x00, 10, 1, 1
+    };
+    uint8_t mp_reach_v6[] = {
+        0x90, BGP_PATH_ATTR_MP_REACH, 0, 29,
+        0, 2, 4, 16,
+        0xfc, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+        /* fc00:1::/32 label 3000 */
+        32+24, 0x00, 0xbb, 0x81, 0xfc, 0x00, 0x00, 0x01
+    };
+    uint8_t mp_reach_no_label[] = {
+        0x90, BGP_PATH_ATTR_MP_REACH, 0, 11,
+        0, 1, 4, 4, 10, 0, 0, 1, 0,
+        /* Prefix length shorter than label */
+        16, 10
+    };
+    uint8_t mp_reach_no_bos[] = {
+        0x90, BGP_PATH_ATTR_MP_REACH, 0, 15,
+        0, 1, 4, 4, 10, 0, 0, 1, 0,
+        /* Missing bottom of stack */
+        24+24, 0x00, 0x3e, 0x80, 10, 1
+    };
+
+    len = test_update(buf, NULL, 0, mp_reach, sizeof(mp_reach), NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(rib.count, 2);
+    assert_int_equal(rib.family_count[BGP_RIB_IPV4_LU], 2);
+
+    /* Bottom label of the stack is stored. */
+    for(uint32_t i = 0; i < rib.size; i++) {
+        if(rib.entries[i].family) {
+            assert_int_equal(rib.entries[i].family, BGP_RIB_IPV4_LU + 1);
+            assert_int_equal(rib.entries[i].prefix_len, 24);
+            assert_int_equal(rib.entries[i].label, rib.entries[i].prefix[1] == 1 ? 1000 : 2000);
+        }
+    }
+
+    len = test_update(buf, NULL, 0, mp_unreach, sizeof(mp_unreach), NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, 0);
+    assert_int_equal(rib.count, 1);
+    assert_int_equal(rib.withdrawn, 1);
+
+    len = test_update(buf, NULL, 0, mp_reach_v6, sizeof(mp_reach_v6), NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(rib.family_count[BGP_RIB_IPV6_LU], 1);
+    memset(&key, 0x0, sizeof(key));
+    key.family = BGP_RIB_IPV6_LU + 1;
+    key.prefix_len = 32;
+    key.prefix[0] = 0xfc;
+    key.prefix[3] = 0x01;
+    assert_true(bgp_rib_del(&rib, &key));
+
+    len = test_update(buf, NULL, 0, mp_reach_no_label, sizeof(mp_reach_no_label), NULL, 0);
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    len = test_update(buf, NULL, 0, mp_reach_no_bos, sizeof(mp_reach_no_bos), NULL, 0);
+    assert_false(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(rib.count, 1);
+    bgp_rib_free(&rib);
+}
+
+static void
+test_bgp_decode_eor(void **unused) {
+    (void) unused;
+
+    bgp_rib_s rib = {0};
+    uint8_t buf[64];
+    uint16_t len;
+    uint32_t eor;
+
+    uint8_t eor_ipv6_uc[] = { 0x80, BGP_PATH_ATTR_MP_UNREACH, 3, 0, 2, 1 };
+    uint8_t eor_ipv4_lu[] = { 0x80, BGP_PATH_ATTR_MP_UNREACH, 3, 0, 1, 4 };
+    uint8_t eor_ipv6_lu[] = { 0x90, BGP_PATH_ATTR_MP_UNREACH, 0, 3, 0, 2, 4 };
+    uint8_t eor_evpn[] = { 0x80, BGP_PATH_ATTR_MP_UNREACH, 3, 0, 25, 70 };
+    uint8_t origin[] = { 0x40, BGP_PATH_ATTR_ORIGIN, 1, 0 };
+
+    len = test_update(buf, NULL, 0, NULL, 0, NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, BGP_IPV4_UC);
+    assert_int_equal(rib.eor, BGP_IPV4_UC);
+    assert_true(rib.eor_timestamp.tv_sec || rib.eor_timestamp.tv_nsec);
+
+    len = test_update(buf, NULL, 0, eor_ipv6_uc, sizeof(eor_ipv6_uc), NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, BGP_IPv6_UC);
+    len = test_update(buf, NULL, 0, eor_ipv4_lu, sizeof(eor_ipv4_lu), NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, BGP_IPv4_LU);
+    len = test_update(buf, NULL, 0, eor_ipv6_lu, sizeof(eor_ipv6_lu), NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, BGP_IPv6_LU);
+    assert_int_equal(rib.eor, BGP_IPV4_UC|BGP_IPv6_UC|BGP_IPv4_LU|BGP_IPv6_LU);
+
+    /* Unsupported families are ignored. */
+    len = test_update(buf, NULL, 0, eor_evpn, sizeof(eor_evpn), NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, 0);
+
+    /* Update without prefixes is no End-of-RIB. */
+    len = test_update(buf, NULL, 0, origin, sizeof(origin), NULL, 0);
+    assert_true(bgp_rib_decode_update(&rib, buf, len, true, &eor));
+    assert_int_equal(eor, 0);
+    assert_int_equal(rib.announced, 0);
+    bgp_rib_free(&rib);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_bgp_rib_add_del),
+        cmocka_unit_test(test_bgp_rib_delete_reinsert),
+        cmocka_unit_test(test_bgp_decode_ipv4_unicast),
+        cmocka_unit_test(test_bgp_decode_truncated),
+        cmocka_unit_test(test_bgp_decode_labeled),
+        cmocka_unit_test(test_bgp_decode_eor),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
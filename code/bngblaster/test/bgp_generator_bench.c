@@ -0,0 +1,338 @@
+/*
+ * BGP Update Generator Benchmark
+ *
+ * Usage: bench-bgp-generator [prefixes]
+ *
+ * Generates the given number of prefixes (default 1M)
+ * per address family and message size, followed by
+ * End-of-RIB, and withdraws them again. Reports the
+ * generator throughput and decodes all generated
+ * updates back into an Adj-RIB-In to verify message
+ * packing, labels, withdraws and End-of-RIB.
+ *
+ * As baseline, the generated announcements are written
+ * to a RAW update file (as created by bgpupdate), which
+ * is mapped and validated chunk by chunk as done for
+ * sessions using a raw-update-file.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <bbl_def.h>
+#include <bbl_protocols.h>
+#include <utils.h>
+#include <logging.h>
+#include <bgp/bgp_def.h>
+#include <bgp/bgp_rib.h>
+#include <bgp/bgp_generator.h>
+#include <bgp/bgp_raw_update.h>
+
+#define BENCH_NEXT_HOPS 4
+#define BENCH_LABEL_BASE 1000
+#define BENCH_LABEL_NUM 100
+
+struct keyval_ log_names[] = {
+    { 0, NULL}
+};
+
+typedef struct bench_case_ {
+    const char *name;
+    uint16_t afi;
+    bool labeled;
+    bgp_rib_family_t family;
+    uint32_t eor;
+} bench_case_s;
+
+static const bench_case_s bench_cases[] = {
+    { "ipv4",    IANA_AFI_IPV4, false, BGP_RIB_IPV4_UC, BGP_IPV4_UC },
+    { "ipv6",    IANA_AFI_IPV6, false, BGP_RIB_IPV6_UC, BGP_IPv6_UC },
+    { "ipv4-lu", IANA_AFI_IPV4, true,  BGP_RIB_IPV4_LU, BGP_IPv4_LU },
+    { "ipv6-lu", IANA_AFI_IPV6, true,  BGP_RIB_IPV6_LU, BGP_IPv6_LU },
+};
+
+static const uint16_t bench_message_sizes[] = {
+    BGP_MAX_MESSAGE_SIZE, BGP_MAX_EXT_MESSAGE_SIZE
+};
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_config(bgp_generator_config_s *config, const bench_case_s *c,
+             uint32_t prefixes, uint16_t message_size, bool withdraw)
+{
+    memset(config, 0x0, sizeof(*config));
+    config->afi = c->afi;
+    config->safi = c->labeled ? 4 : 1;
+    if(c->afi == IANA_AFI_IPV4) {
+        /* 10.0.0.0/24 */
+        config->prefix_len = 24;
+        config->prefix_addr_len = IPV4_ADDR_LEN;
+        config->prefix[0] = 10;
+        config->next_hop_len = IPV4_ADDR_LEN;
+        config->next_hop[0] = 192;
+        config->next_hop[1] = 168;
+    } else {
+        /* fc00::/48 */
+        config->prefix_len = 48;
+        config->prefix_addr_len = IPV6_ADDR_LEN;
+        config->prefix[0] = 0xfc;
+        config->next_hop_len = IPV6_ADDR_LEN;
+        config->next_hop[0] = 0xfd;
+    }
+    config->prefix_num = prefixes;
+    config->next_hop_num = BENCH_NEXT_HOPS;
+    if(c->labeled) {
+        config->label_base = BENCH_LABEL_BASE;
+        config->label_num = BENCH_LABEL_NUM;
+    }
+    config->asn[0] = 65001;
+    config->asn[1] = 65002;
+    config->asn_count = 2;
+    config->local_pref = 100;
+    config->local_pref_enabled = true;
+    config->message_size = message_size;
+    config->withdraw = withdraw;
+    config->end_of_rib = true;
+}
+
+static uint32_t
+bench_prefix_index(bgp_rib_entry_s *entry)
+{
+    if(entry->family == BGP_RIB_IPV4_UC + 1 || entry->family == BGP_RIB_IPV4_LU + 1) {
+        return (read_be_uint(entry->prefix, 4) - 0x0a000000) >> 8;
+    }
+    return read_be_uint(entry->prefix+2, 4);
+}
+
+/*
+ * Generate all updates of one configuration and decode
+ * them back. Returns false if verification failed.
+ */
+static bool
+bench_run(const bench_case_s *c, bgp_generator_config_s *config, bgp_rib_s *rib, FILE *file,
+          uint32_t *nlri_max, uint32_t *updates, uint64_t *bytes, double *cpu)
+{
+    bgp_generator_s generator = {0};
+    uint32_t prefix_bytes = 1 + (config->label_base ? 3 : 0) + (config->prefix_len + 7) / 8;
+    uint32_t len, idx, eor, full = 0;
+    uint64_t prefixes;
+    uint16_t length;
+    uint8_t *msg;
+    bool eor_received = false;
+    double start;
+
+    *updates = 0;
+    *bytes = 0;
+    *cpu = 0;
+    if(!bgp_generator_init(&generator, config, BGP_MAX_EXT_MESSAGE_SIZE)) {
+        fprintf(stderr, "%s: init failed\n", c->name);
+        return false;
+    }
+    *nlri_max = generator.nlri_max;
+
+    while(true) {
+        start = bench_cpu_time();
+        len = bgp_generator_fill(&generator, config);
+        *cpu += bench_cpu_time() - start;
+        if(!len) break;
+        *bytes += len;
+        if(file && fwrite(generator.buf.data, len, 1, file) != 1) {
+            fprintf(stderr, "%s: failed to write RAW update file\n", c->name);
+            return false;
+        }
+
+        for(idx = 0; idx < len; idx += length) {
+            msg = generator.buf.data + idx;
+            length = read_be_uint(msg+16, 2);
+            if(length < BGP_MIN_MESSAGE_SIZE || idx + length > len ||
+               length > config->message_size || msg[18] != BGP_MSG_UPDATE) {
+                fprintf(stderr, "%s: invalid message at offset %u\n", c->name, idx);
+                return false;
+            }
+            if(eor_received) {
+                fprintf(stderr, "%s: update after End-of-RIB\n", c->name);
+                return false;
+            }
+            prefixes = rib->announced + rib->withdrawn;
+            if(!bgp_rib_decode_update(rib, msg, length, true, &eor)) {
+                fprintf(stderr, "%s: decode failed at offset %u\n", c->name, idx);
+                return false;
+            }
+            prefixes = rib->announced + rib->withdrawn - prefixes;
+            if(eor) {
+                if(eor != c->eor || prefixes) {
+                    fprintf(stderr, "%s: invalid End-of-RIB\n", c->name);
+                    return false;
+                }
+                eor_received = true;
+            } else if(prefixes > generator.nlri_max) {
+                fprintf(stderr, "%s: %lu prefixes exceed nlri_max %u\n",
+                        c->name, prefixes, generator.nlri_max);
+                return false;
+            } else if(prefixes == generator.nlri_max) {
+                /* Full updates have no space left for another prefix. */
+                if(length + prefix_bytes <= generator.message_size) {
+                    fprintf(stderr, "%s: update with %u bytes not packed\n", c->name, length);
+                    return false;
+                }
+                full++;
+            }
+            (*updates)++;
+        }
+    }
+
+    if(!eor_received || *updates != generator.updates ||
+       generator.prefixes != config->prefix_num) {
+        fprintf(stderr, "%s: missing updates or End-of-RIB\n", c->name);
+        return false;
+    }
+    /* Only the last update per next-hop may be partial. */
+    if(full + BENCH_NEXT_HOPS + 1 < *updates) {
+        fprintf(stderr, "%s: only %u of %u updates full\n", c->name, full, *updates);
+        return false;
+    }
+    free(generator.buf.data);
+    return true;
+}
+
+/*
+ * Validate and copy the RAW update file chunk by chunk
+ * like sessions sending a raw-update-file, where each
+ * chunk is copied into the TCP send buffer.
+ */
+static bool
+bench_raw_file(const bench_case_s *c, const char *file, uint16_t message_size,
+               uint32_t updates, uint64_t bytes, double *cpu)
+{
+    bgp_raw_update_s *raw_update;
+    uint32_t offset = 0, total = 0;
+    uint32_t len, chunk_updates;
+    uint8_t *buf;
+    double start;
+
+    raw_update = bgp_raw_update_open(file);
+    buf = malloc(BGP_RAW_UPDATE_CHUNK_SIZE + BGP_MAX_EXT_MESSAGE_SIZE);
+    if(!(raw_update && buf)) {
+        fprintf(stderr, "%s: failed to open RAW update file\n", c->name);
+        return false;
+    }
+    start = bench_cpu_time();
+    while((len = bgp_raw_update_chunk(raw_update, offset, message_size, &chunk_updates))) {
+        memcpy(buf, raw_update->buf + offset, len);
+        offset += len;
+        total += chunk_updates;
+    }
+    *cpu = bench_cpu_time() - start;
+    bgp_raw_update_close(raw_update);
+    free(buf);
+    if(offset != bytes || total != updates) {
+        fprintf(stderr, "%s: RAW update file with %u of %u updates\n", c->name, total, updates);
+        return false;
+    }
+    return true;
+}
+
+static bool
+bench_verify_rib(const bench_case_s *c, bgp_rib_s *rib, uint32_t prefixes)
+{
+    bgp_rib_entry_s *entry;
+    uint32_t i, index;
+
+    if(rib->count != prefixes || rib->family_count[c->family] != prefixes) {
+        fprintf(stderr, "%s: %u of %u prefixes received\n", c->name, rib->count, prefixes);
+        return false;
+    }
+    for(i = 0; i < rib->size; i++) {
+        entry = &rib->entries[i];
+        if(!entry->family) continue;
+        index = bench_prefix_index(entry);
+        if(index >= prefixes) {
+            fprintf(stderr, "%s: unexpected prefix index %u\n", c->name, index);
+            return false;
+        }
+        if(c->labeled && entry->label != BENCH_LABEL_BASE + (index % BENCH_LABEL_NUM)) {
+            fprintf(stderr, "%s: invalid label %u for prefix index %u\n", c->name, entry->label, index);
+            return false;
+        }
+    }
+    return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+    bgp_generator_config_s config;
+    bgp_rib_s rib;
+    uint32_t prefixes = 1000000;
+    uint32_t nlri_max, updates;
+    uint64_t bytes;
+    size_t c, s;
+    double cpu;
+    bool withdraw;
+    char file[] = "/tmp/bench-bgp-generator-XXXXXX";
+    FILE *fp;
+    int fd;
+
+    if(argc > 1) prefixes = strtoul(argv[1], NULL, 10);
+    if(!prefixes) {
+        fprintf(stderr, "Usage: %s [prefixes]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-8s %-8s %6s %8s %10s %12s %10s\n",
+           "family", "type", "size", "nlri-max", "updates", "prefixes/s", "MB/s");
+    for(c = 0; c < sizeof(bench_cases)/sizeof(bench_cases[0]); c++) {
+        for(s = 0; s < sizeof(bench_message_sizes)/sizeof(bench_message_sizes[0]); s++) {
+            memset(&rib, 0x0, sizeof(rib));
+            strcpy(file + sizeof(file) - 7, "XXXXXX");
+            fd = mkstemp(file);
+            fp = fd < 0 ? NULL : fdopen(fd, "w");
+            if(!fp) {
+                fprintf(stderr, "Failed to create RAW update file %s\n", file);
+                return 1;
+            }
+            for(withdraw = false; ; withdraw = true) {
+                bench_config(&config, &bench_cases[c], prefixes, bench_message_sizes[s], withdraw);
+                if(!bench_run(&bench_cases[c], &config, &rib, withdraw ? NULL : fp,
+                              &nlri_max, &updates, &bytes, &cpu)) {
+                    unlink(file);
+                    return 1;
+                }
+                if(!bench_verify_rib(&bench_cases[c], &rib, withdraw ? 0 : prefixes)) {
+                    unlink(file);
+                    return 1;
+                }
+                printf("%-8s %-8s %6u %8u %10u %12.0f %10.1f\n",
+                       bench_cases[c].name, withdraw ? "withdraw" : "announce",
+                       bench_message_sizes[s], nlri_max, updates,
+                       cpu > 0 ? prefixes / cpu : 0, cpu > 0 ? bytes / cpu / 1e6 : 0);
+                if(withdraw) break;
+
+                /* RAW update file baseline for announcements. */
+                fclose(fp);
+                if(!bench_raw_file(&bench_cases[c], file, bench_message_sizes[s], updates, bytes, &cpu)) {
+                    unlink(file);
+                    return 1;
+                }
+                unlink(file);
+                printf("%-8s %-8s %6u %8u %10u %12.0f %10.1f\n",
+                       bench_cases[c].name, "raw-file",
+                       bench_message_sizes[s], nlri_max, updates,
+                       cpu > 0 ? prefixes / cpu : 0, cpu > 0 ? bytes / cpu / 1e6 : 0);
+            }
+            if(rib.announced != prefixes || rib.withdrawn != prefixes) {
+                fprintf(stderr, "%s: announced %lu withdrawn %lu\n",
+                        bench_cases[c].name, rib.announced, rib.withdrawn);
+                return 1;
+            }
+            bgp_rib_free(&rib);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * BNG Blaster (BBL) - Histogram Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <bbl_histogram.h>
+
+static void
+test_histogram_index(void **unused) {
+    (void) unused;
+
+    uint64_t value;
+    uint16_t index;
+
+    /* Values up to 31 are exact. */
+    for(value = 0; value < 32; value++) {
+        assert_int_equal(bbl_histogram_index(value), value);
+        assert_int_equal(bbl_histogram_lowest(value), value);
+        assert_int_equal(bbl_histogram_highest(value), value);
+    }
+    /* 16 linear buckets per power of two. */
+    assert_int_equal(bbl_histogram_index(32), 32);
+    assert_int_equal(bbl_histogram_index(33), 32);
+    assert_int_equal(bbl_histogram_index(34), 33);
+    assert_int_equal(bbl_histogram_index(63), 47);
+    assert_int_equal(bbl_histogram_index(64), 48);
+    assert_int_equal(bbl_histogram_lowest(48), 64);
+    assert_int_equal(bbl_histogram_highest(48), 67);
+
+    /* Values above max are recorded in the last bucket. */
+    assert_int_equal(bbl_histogram_index(BBL_HISTOGRAM_VALUE_MAX), BBL_HISTOGRAM_BUCKETS - 1);
+    assert_int_equal(bbl_histogram_index(BBL_HISTOGRAM_VALUE_MAX + 1), BBL_HISTOGRAM_BUCKETS - 1);
+    assert_int_equal(bbl_histogram_index(UINT64_MAX), BBL_HISTOGRAM_BUCKETS - 1);
+    assert_int_equal(bbl_histogram_highest(BBL_HISTOGRAM_BUCKETS - 1), BBL_HISTOGRAM_VALUE_MAX);
+
+    /* Each value is within the bounds of its bucket 
+     * and the relative error is below 1/16. */
+    for(value = 1; value <= BBL_HISTOGRAM_VALUE_MAX; value += 1 + (value / 7)) {
+        index = bbl_histogram_index(value);
+        assert_true(bbl_histogram_lowest(index) <= value);
+        assert_true(bbl_histogram_highest(index) >= value);
+        assert_true((bbl_histogram_highest(index) - bbl_histogram_lowest(index)) * 16 <= value);
+    }
+    /* Buckets are contiguous. */
+    for(index = 1; index < BBL_HISTOGRAM_BUCKETS - 1; index++) {
+        assert_int_equal(bbl_histogram_lowest(index), bbl_histogram_highest(index - 1) + 1);
+    }
+}
+
+static void
+test_histogram_percentile(void **unused) {
+    (void) unused;
+
+    bbl_histogram_s *histogram = bbl_histogram_init();
+    uint64_t value;
+
+    assert_non_null(histogram);
+    assert_int_equal(bbl_histogram_percentile(histogram, 50.0), 0);
+    assert_int_equal(bbl_histogram_percentile(NULL, 50.0), 0);
+
+    /* 1 to 1000 usec recorded once. */
+    for(value = 1; value <= 1000; value++) {
+        bbl_histogram_record(histogram, value, 1);
+    }
+    assert_int_equal(histogram->count, 1000);
+
+    /* Percentiles report the highest value of the
+     * bucket, which is within 1/16 of the exact value. */
+    value = bbl_histogram_percentile(histogram, 50.0);
+    assert_true(value >= 500 && value <= 500 + 500 / 16);
+    value = bbl_histogram_percentile(histogram, 99.0);
+    assert_true(value >= 990 && value <= 990 + 990 / 16);
+    value = bbl_histogram_percentile(histogram, 99.9);
+    assert_true(value >= 999 && value <= 999 + 999 / 16);
+    assert_int_equal(bbl_histogram_percentile(histogram, 0.0), 1);
+    assert_int_equal(bbl_histogram_percentile(histogram, 200.0), 
+                     bbl_histogram_highest(bbl_histogram_index(1000)));
+
+    /* A single outlier does not hide the distribution. */
+    memset(histogram, 0x0, sizeof(bbl_histogram_s));
+    bbl_histogram_record(histogram, 100, 999);
+    bbl_histogram_record(histogram, 50000, 1);
+    assert_int_equal(bbl_histogram_percentile(histogram, 50.0), bbl_histogram_highest(bbl_histogram_index(100)));
+    assert_int_equal(bbl_histogram_percentile(histogram, 99.0), bbl_histogram_highest(bbl_histogram_index(100)));
+    assert_int_equal(bbl_histogram_percentile(histogram, 100.0), bbl_histogram_highest(bbl_histogram_index(50000)));
+    free(histogram);
+}
+
+static void
+test_histogram_flow_sync(void **unused) {
+    (void) unused;
+
+    bbl_histogram_flow_s flow = {0};
+    bbl_histogram_s interface = {0};
+    bbl_histogram_s global = {0};
+    bbl_histogram_s copy = {0};
+
+    bbl_histogram_flow_record(&flow, 10);
+    bbl_histogram_flow_record(&flow, 10);
+    bbl_histogram_flow_record(&flow, 2000);
+
+    /* Only values recorded since last sync are added. */
+    bbl_histogram_flow_sync(&flow, bbl_histogram_index(10), bbl_histogram_index(2000), &interface, &global);
+    assert_int_equal(interface.count, 3);
+    assert_int_equal(global.count, 3);
+    assert_int_equal(interface.buckets[10], 2);
+    bbl_histogram_flow_sync(&flow, bbl_histogram_index(10), bbl_histogram_index(2000), &interface, &global);
+    assert_int_equal(interface.count, 3);
+
+    /* Invalid range falls back to all buckets. */
+    bbl_histogram_flow_record(&flow, 5);
+    bbl_histogram_flow_sync(&flow, 10, 0, NULL, &global);
+    assert_int_equal(interface.count, 3);
+    assert_int_equal(global.count, 4);
+    assert_int_equal(global.buckets[5], 1);
+
+    bbl_histogram_merge(&interface, &global);
+    assert_int_equal(interface.count, 7);
+    assert_int_equal(interface.buckets[10], 4);
+
+    bbl_histogram_flow_copy(&flow, &copy);
+    assert_int_equal(copy.count, 4);
+    bbl_histogram_flow_reset(&flow);
+    bbl_histogram_flow_copy(&flow, &copy);
+    assert_int_equal(copy.count, 0);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_histogram_index),
+        cmocka_unit_test(test_histogram_percentile),
+        cmocka_unit_test(test_histogram_flow_sync),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -46,9 +46,47 @@ test_protocols_decode_pppoe_ipcp_conf_request(void **unused) {
 
 }
 
+static void
+test_protocols_checksum_update(void **unused) {
+    (void) unused;
+
+    uint8_t tcp[1480];
+    uint8_t old[17];
+    uint16_t *checksum = (uint16_t*)(tcp+16);
+    uint16_t expected;
+    uint16_t tcp_len;
+    uint16_t offset;
+    uint32_t src = 0x0100000a;
+    uint32_t dst = 0x0200000a;
+    int i, n;
+
+    srand(1);
+    for(tcp_len = 64; tcp_len < sizeof(tcp); tcp_len += 71) {
+        for(i = 0; i < tcp_len; i++) {
+            tcp[i] = rand();
+        }
+        *checksum = 0;
+        *checksum = bbl_ipv4_tcp_checksum(src, dst, tcp, tcp_len);
+        /* Change the last 16 bytes starting at even offset. */
+        offset = (tcp_len - 16) & ~1;
+        for(n = 0; n < 8; n++) {
+            memcpy(old, tcp+offset, tcp_len-offset);
+            for(i = tcp_len-16; i < tcp_len; i++) {
+                tcp[i] = rand();
+            }
+            *checksum = bbl_checksum_update(*checksum, old, tcp+offset, tcp_len-offset);
+            expected = *checksum;
+            *checksum = 0;
+            assert_int_equal(expected, bbl_ipv4_tcp_checksum(src, dst, tcp, tcp_len));
+            *checksum = expected;
+        }
+    }
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_protocols_decode_pppoe_ipcp_conf_request),
+        cmocka_unit_test(test_protocols_checksum_update),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+/*
+ * BNG Blaster (BBL) - Stream RX Statistics Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <bbl_stream_stats.h>
+
+static void
+test_stream_jitter_first(void **unused) {
+    (void) unused;
+
+    int64_t jitter = 0;
+    int64_t last_transit = 0;
+
+    /* The first packet has no reference. */
+    bbl_stream_jitter(&jitter, &last_transit, 5000);
+    assert_int_equal(jitter, 0);
+    assert_int_equal(last_transit, 5000);
+}
+
+static void
+test_stream_jitter_step(void **unused) {
+    (void) unused;
+
+    int64_t jitter = 0;
+    int64_t last_transit = 0;
+
+    /* J = J + (|D| - J) / 16 = 160 / 16 */
+    bbl_stream_jitter(&jitter, &last_transit, 1000);
+    bbl_stream_jitter(&jitter, &last_transit, 1160);
+    assert_int_equal(jitter >> 4, 10);
+
+    /* Negative differences count the same. */
+    jitter = 0;
+    last_transit = 0;
+    bbl_stream_jitter(&jitter, &last_transit, 1160);
+    bbl_stream_jitter(&jitter, &last_transit, 1000);
+    assert_int_equal(jitter >> 4, 10);
+}
+
+static void
+test_stream_jitter_constant(void **unused) {
+    (void) unused;
+
+    int64_t jitter = 0;
+    int64_t last_transit = 0;
+
+    for(int i = 0; i < 1000; i++) {
+        bbl_stream_jitter(&jitter, &last_transit, 250000);
+    }
+    assert_int_equal(jitter, 0);
+}
+
+static void
+test_stream_jitter_converge(void **unused) {
+    (void) unused;
+
+    int64_t jitter = 0;
+    int64_t last_transit = 0;
+
+    /* Alternating transit times converge to |D|. */
+    for(int i = 0; i < 1000; i++) {
+        bbl_stream_jitter(&jitter, &last_transit, (i & 1) ? 2000 : 1000);
+    }
+    assert_in_range(jitter >> 4, 990, 1000);
+
+    /* Jitter decays if transit becomes constant. */
+    for(int i = 0; i < 1000; i++) {
+        bbl_stream_jitter(&jitter, &last_transit, 1000);
+    }
+    assert_in_range(jitter >> 4, 0, 1);
+}
+
+static void
+test_stream_loss_bursts(void **unused) {
+    (void) unused;
+
+    bbl_stream_loss_s history = {0};
+
+    bbl_stream_loss_record(&history, 1, 1);
+    bbl_stream_loss_record(&history, 2, 1);
+    bbl_stream_loss_record(&history, 3, 1);
+    bbl_stream_loss_record(&history, 4, 1);
+    bbl_stream_loss_record(&history, 7, 1);
+    bbl_stream_loss_record(&history, 32768, 1);
+    bbl_stream_loss_record(&history, 100000, 1);
+
+    assert_int_equal(history.bursts[0], 1);
+    assert_int_equal(history.bursts[1], 2);
+    assert_int_equal(history.bursts[2], 2);
+    assert_int_equal(history.bursts[3], 0);
+    /* Last bucket collects all bursts of 32768 and above. */
+    assert_int_equal(history.bursts[BBL_STREAM_LOSS_BURST_BUCKETS-1], 2);
+    assert_int_equal(history.burst_max, 100000);
+    assert_int_equal(history.seconds[1], 1+2+3+4+7+32768+100000);
+}
+
+static void
+test_stream_loss_seconds(void **unused) {
+    (void) unused;
+
+    bbl_stream_loss_s history = {0};
+    __time_t epoch = 1000;
+
+    bbl_stream_loss_record(&history, 5, epoch);
+    bbl_stream_loss_record(&history, 3, epoch+1);
+    bbl_stream_loss_record(&history, 2, epoch+1);
+    assert_int_equal(history.seconds[epoch % BBL_STREAM_LOSS_SECONDS], 5);
+    assert_int_equal(history.seconds[(epoch+1) % BBL_STREAM_LOSS_SECONDS], 5);
+    assert_int_equal(history.epoch, epoch+1);
+
+    /* Late loss within the history window is added. */
+    bbl_stream_loss_record(&history, 1, epoch);
+    assert_int_equal(history.seconds[epoch % BBL_STREAM_LOSS_SECONDS], 6);
+    assert_int_equal(history.epoch, epoch+1);
+
+    /* Seconds which wrapped around without loss are cleared. */
+    bbl_stream_loss_record(&history, 4, epoch+BBL_STREAM_LOSS_SECONDS);
+    assert_int_equal(history.seconds[epoch % BBL_STREAM_LOSS_SECONDS], 4);
+    assert_int_equal(history.seconds[(epoch+1) % BBL_STREAM_LOSS_SECONDS], 5);
+    bbl_stream_loss_record(&history, 1, epoch+BBL_STREAM_LOSS_SECONDS+1);
+    assert_int_equal(history.seconds[(epoch+1) % BBL_STREAM_LOSS_SECONDS], 1);
+
+    /* Loss older than the history window is not recorded. */
+    bbl_stream_loss_record(&history, 9, epoch);
+    assert_int_equal(history.seconds[epoch % BBL_STREAM_LOSS_SECONDS], 4);
+    assert_int_equal(history.bursts[3], 1);
+
+    /* Gaps larger than the history window clear all seconds. */
+    epoch += 10 * BBL_STREAM_LOSS_SECONDS;
+    bbl_stream_loss_record(&history, 1, epoch);
+    for(int i = 0; i < BBL_STREAM_LOSS_SECONDS; i++) {
+        assert_int_equal(history.seconds[i], i == epoch % BBL_STREAM_LOSS_SECONDS ? 1 : 0);
+    }
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_stream_jitter_first),
+        cmocka_unit_test(test_stream_jitter_step),
+        cmocka_unit_test(test_stream_jitter_constant),
+        cmocka_unit_test(test_stream_jitter_converge),
+        cmocka_unit_test(test_stream_loss_bursts),
+        cmocka_unit_test(test_stream_loss_seconds),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,261 @@
+/*
+ * BNG Blaster (BBL) - TXQ Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <bbl_def.h>
+#include <bbl_protocols.h>
+#include <bbl_txq.h>
+
+#define TEST_PRODUCERS 4
+#define TEST_PACKETS 200000
+
+typedef struct test_producer_ {
+    bbl_txq_s *txq;
+    uint32_t id;
+    uint64_t cancelled;
+} test_producer_s;
+
+static uint16_t
+test_packet_len(uint32_t id, uint32_t seq)
+{
+    /* Mix of small and large packets. */
+    return 8 + ((seq * 7919 + id * 104729) % (BBL_TXQ_BUFFER_LEN - 8));
+}
+
+static void
+test_packet_write(bbl_txq_slot_t *slot, uint32_t id, uint32_t seq)
+{
+    uint16_t len = test_packet_len(id, seq);
+    memcpy(slot->packet, &id, sizeof(id));
+    memcpy(slot->packet+4, &seq, sizeof(seq));
+    memset(slot->packet+8, (uint8_t)(id + seq), len - 8);
+    slot->packet_len = len;
+}
+
+static bool
+test_packet_check(bbl_txq_slot_t *slot, uint32_t *id, uint32_t *seq)
+{
+    memcpy(id, slot->packet, sizeof(*id));
+    memcpy(seq, slot->packet+4, sizeof(*seq));
+    if(slot->packet_len != test_packet_len(*id, *seq)) {
+        return false;
+    }
+    for(uint16_t i = 8; i < slot->packet_len; i++) {
+        if(slot->packet[i] != (uint8_t)(*id + *seq)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *
+test_producer(void *arg)
+{
+    test_producer_s *producer = arg;
+    bbl_txq_slot_t *slot;
+    uint32_t seq = 0;
+
+    while(seq < TEST_PACKETS) {
+        slot = bbl_txq_write_slot(producer->txq);
+        if(!slot) {
+            sched_yield();
+            continue;
+        }
+        if(seq % 13 == 0 && producer->cancelled < seq / 13) {
+            /* Cancel some reservations. */
+            producer->cancelled++;
+            bbl_txq_write_cancel(producer->txq, slot);
+            continue;
+        }
+        test_packet_write(slot, producer->id, seq++);
+        bbl_txq_write_next(producer->txq, slot);
+    }
+    return NULL;
+}
+
+static void
+test_txq_single_producer(void **unused) {
+    (void) unused;
+
+    bbl_txq_s txq = {0};
+    bbl_txq_slot_t *slot;
+    uint32_t id, seq, i;
+    uint32_t written = 0;
+
+    assert_true(bbl_txq_init(&txq, 16));
+    assert_true(bbl_txq_is_empty(&txq));
+    assert_null(bbl_txq_read_slot(&txq));
+
+    /* Small slots consume only their actual length. */
+    while((slot = bbl_txq_write_slot(&txq))) {
+        slot->packet_len = 64;
+        memset(slot->packet, 0x0, 64);
+        memcpy(slot->packet+4, &written, sizeof(written));
+        written++;
+        bbl_txq_write_next(&txq, slot);
+    }
+    assert_true(bbl_txq_is_full(&txq));
+    assert_true(written > txq.size / (BBL_TXQ_BUFFER_LEN + sizeof(bbl_txq_slot_t)));
+    for(i = 0; i < written; i++) {
+        slot = bbl_txq_read_slot(&txq);
+        assert_non_null(slot);
+        assert_int_equal(slot->packet_len, 64);
+        memcpy(&seq, slot->packet+4, sizeof(seq));
+        assert_int_equal(seq, i);
+        bbl_txq_read_next(&txq);
+    }
+    assert_null(bbl_txq_read_slot(&txq));
+    assert_true(bbl_txq_is_empty(&txq));
+
+    /* Cancelled slots are never read and wrap
+     * around the end of the ring buffer. */
+    for(i = 0; i < 1000; i++) {
+        slot = bbl_txq_write_slot(&txq);
+        assert_non_null(slot);
+        bbl_txq_write_cancel(&txq, slot);
+        slot = bbl_txq_write_slot(&txq);
+        assert_non_null(slot);
+        test_packet_write(slot, 1, i);
+        bbl_txq_write_next(&txq, slot);
+        slot = bbl_txq_read_slot(&txq);
+        assert_non_null(slot);
+        assert_true(test_packet_check(slot, &id, &seq));
+        assert_int_equal(id, 1);
+        assert_int_equal(seq, i);
+        bbl_txq_read_next(&txq);
+    }
+    assert_true(bbl_txq_is_empty(&txq));
+    free(txq.ring);
+}
+
+static void
+test_txq_cancel_after_reserve(void **unused) {
+    (void) unused;
+
+    bbl_txq_s txq = {0};
+    bbl_txq_slot_t *slot1, *slot2;
+    uint32_t id, seq;
+
+    assert_true(bbl_txq_init(&txq, 16));
+
+    /* A slot cancelled after a further slot was
+     * reserved is skipped by the consumer. */
+    slot1 = bbl_txq_write_slot(&txq);
+    slot2 = bbl_txq_write_slot(&txq);
+    assert_non_null(slot1);
+    assert_non_null(slot2);
+    test_packet_write(slot2, 2, 2);
+    bbl_txq_write_cancel(&txq, slot1);
+    bbl_txq_write_next(&txq, slot2);
+
+    slot1 = bbl_txq_read_slot(&txq);
+    assert_non_null(slot1);
+    assert_true(test_packet_check(slot1, &id, &seq));
+    assert_int_equal(id, 2);
+    assert_int_equal(seq, 2);
+    bbl_txq_read_next(&txq);
+    assert_null(bbl_txq_read_slot(&txq));
+    free(txq.ring);
+}
+
+static void
+test_txq_commit_out_of_order(void **unused) {
+    (void) unused;
+
+    bbl_txq_s txq = {0};
+    bbl_txq_slot_t *slot1, *slot2;
+    uint32_t id, seq;
+
+    assert_true(bbl_txq_init(&txq, 16));
+
+    /* Publishing a slot does not wait for previously
+     * reserved slots, but the consumer stops at the 
+     * first slot which is not ready. */
+    slot1 = bbl_txq_write_slot(&txq);
+    slot2 = bbl_txq_write_slot(&txq);
+    assert_non_null(slot1);
+    assert_non_null(slot2);
+    test_packet_write(slot2, 2, 2);
+    bbl_txq_write_next(&txq, slot2);
+    assert_true(bbl_txq_is_empty(&txq));
+    assert_null(bbl_txq_read_slot(&txq));
+
+    test_packet_write(slot1, 1, 1);
+    bbl_txq_write_next(&txq, slot1);
+    slot1 = bbl_txq_read_slot(&txq);
+    assert_non_null(slot1);
+    assert_true(test_packet_check(slot1, &id, &seq));
+    assert_int_equal(id, 1);
+    bbl_txq_read_next(&txq);
+    slot2 = bbl_txq_read_slot(&txq);
+    assert_non_null(slot2);
+    assert_true(test_packet_check(slot2, &id, &seq));
+    assert_int_equal(id, 2);
+    bbl_txq_read_next(&txq);
+    assert_null(bbl_txq_read_slot(&txq));
+    assert_true(bbl_txq_is_empty(&txq));
+    free(txq.ring);
+}
+
+static void
+test_txq_concurrent_producers(void **unused) {
+    (void) unused;
+
+    bbl_txq_s txq = {0};
+    bbl_txq_slot_t *slot;
+    pthread_t threads[TEST_PRODUCERS];
+    test_producer_s producers[TEST_PRODUCERS];
+    uint32_t next[TEST_PRODUCERS] = {0};
+    uint64_t received = 0;
+    uint32_t id, seq;
+
+    assert_true(bbl_txq_init(&txq, 64));
+    for(uint32_t i = 0; i < TEST_PRODUCERS; i++) {
+        producers[i].txq = &txq;
+        producers[i].id = i;
+        producers[i].cancelled = 0;
+        assert_int_equal(pthread_create(&threads[i], NULL, test_producer, &producers[i]), 0);
+    }
+
+    /* Packets of each producer must be received
+     * complete and in order. */
+    while(received < TEST_PRODUCERS * TEST_PACKETS) {
+        slot = bbl_txq_read_slot(&txq);
+        if(!slot) {
+            sched_yield();
+            continue;
+        }
+        assert_true(test_packet_check(slot, &id, &seq));
+        assert_true(id < TEST_PRODUCERS);
+        assert_int_equal(seq, next[id]);
+        next[id]++;
+        received++;
+        bbl_txq_read_next(&txq);
+    }
+    for(uint32_t i = 0; i < TEST_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+        assert_int_equal(next[i], TEST_PACKETS);
+    }
+    assert_null(bbl_txq_read_slot(&txq));
+    assert_true(bbl_txq_is_empty(&txq));
+    free(txq.ring);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_txq_single_producer),
+        cmocka_unit_test(test_txq_cancel_after_reserve),
+        cmocka_unit_test(test_txq_commit_out_of_order),
+        cmocka_unit_test(test_txq_concurrent_producers),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -4,11 +4,414 @@
  * Hannes Gredler, February 2024
  * Christian Giese, October 2024
  *
+ * The internet and fletcher checksum kernels are 
+ * implemented generic and vectorized (SSE2/AVX2), 
+ * whereby the fastest implementation supported by 
+ * the CPU is selected at runtime.
+ *
  * Copyright (C) 2020-2025, RtBrick, Inc.
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "checksum.h"
 
+#if CHECKSUM_X86
+#include <immintrin.h>
+#endif
+
+typedef uint32_t (*internet_sum_fn)(const uint8_t *buf, size_t len);
+typedef void (*fletcher_sum_fn)(const uint8_t *buf, size_t len, uint64_t *c0, uint64_t *c1);
+
+static uint32_t internet_sum_init(const uint8_t *buf, size_t len);
+static void fletcher_sum_init(const uint8_t *buf, size_t len, uint64_t *c0, uint64_t *c1);
+
+static internet_sum_fn g_internet_sum = internet_sum_init;
+static fletcher_sum_fn g_fletcher_sum = fletcher_sum_init;
+static checksum_impl_t g_checksum_impl = CHECKSUM_IMPL_GENERIC;
+
+static uint32_t
+internet_sum_fold(uint64_t sum)
+{
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return sum;
+}
+
+/* Sum up 32 bit words into 64 bit which is equal to 
+ * the one's complement sum of 16 bit words after 
+ * folding (RFC 1071). A left-over byte is added 
+ * as is, equal to the former 16 bit word loop. */
+static uint32_t
+internet_sum_generic(const uint8_t *buf, size_t len)
+{
+    uint64_t sum = 0;
+    uint32_t w32;
+    uint16_t w16;
+
+    while(len >= 16) {
+        memcpy(&w32, buf, sizeof(w32)); sum += w32;
+        memcpy(&w32, buf+4, sizeof(w32)); sum += w32;
+        memcpy(&w32, buf+8, sizeof(w32)); sum += w32;
+        memcpy(&w32, buf+12, sizeof(w32)); sum += w32;
+        buf += 16;
+        len -= 16;
+    }
+    while(len >= 4) {
+        memcpy(&w32, buf, sizeof(w32)); sum += w32;
+        buf += 4;
+        len -= 4;
+    }
+    if(len >= 2) {
+        memcpy(&w16, buf, sizeof(w16)); sum += w16;
+        buf += 2;
+        len -= 2;
+    }
+    if(len) {
+        sum += *buf;
+    }
+    return internet_sum_fold(sum);
+}
+
+/* The block of n bytes b[0..n-1] updates the fletcher
+ * sums as c1 += n * c0 + sum((n - i) * b[i]) and 
+ * c0 += sum(b[i]) which allows to process blocks 
+ * of bytes in parallel. */
+static void
+fletcher_sum_generic(const uint8_t *buf, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    uint64_t _c0 = *c0;
+    uint64_t _c1 = *c1;
+
+    /* 10x loop unrolling */
+    while(len >= 10) {
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        _c0 += *buf++;
+        _c1 += _c0;
+        len -= 10;
+    }
+
+    /* remainder */
+    while(len) {
+        _c0 += *buf++;
+        _c1 += _c0;
+        len--;
+    }
+    *c0 = _c0;
+    *c1 = _c1;
+}
+
+#if CHECKSUM_X86
+
+/* Max number of blocks before 32 bit 
+ * weighted sums must be widened. */
+#define FLETCHER_BLOCKS_MAX 4096
+
+/* Shorter buffers are faster processed
+ * by the next smaller implementation. */
+#define CHECKSUM_SIMD_MIN_LEN 64
+#define CHECKSUM_AVX2_MIN_LEN 256
+
+static uint64_t
+hsum_epi64_sse2(__m128i v)
+{
+    return (uint64_t)_mm_cvtsi128_si64(v) + 
+           (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(v, v));
+}
+
+static uint32_t
+internet_sum_sse2(const uint8_t *buf, size_t len)
+{
+    __m128i zero, acc0, acc1, v;
+
+    if(len < CHECKSUM_SIMD_MIN_LEN) {
+        return internet_sum_generic(buf, len);
+    }
+    zero = _mm_setzero_si128();
+    acc0 = zero;
+    acc1 = zero;
+    while(len >= 32) {
+        v = _mm_loadu_si128((const __m128i*)buf);
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, zero));
+        v = _mm_loadu_si128((const __m128i*)(buf+16));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, zero));
+        buf += 32;
+        len -= 32;
+    }
+    if(len >= 16) {
+        v = _mm_loadu_si128((const __m128i*)buf);
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, zero));
+        buf += 16;
+        len -= 16;
+    }
+    return internet_sum_fold(
+        (uint64_t)internet_sum_generic(buf, len) +
+        internet_sum_fold(hsum_epi64_sse2(_mm_add_epi64(acc0, acc1))));
+}
+
+static void
+fletcher_sum_sse2(const uint8_t *buf, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wlo = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+    const __m128i whi = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+    __m128i vc0, vc1, vw, v;
+    uint64_t blocks, i;
+
+    if(len < CHECKSUM_SIMD_MIN_LEN) {
+        fletcher_sum_generic(buf, len, c0, c1);
+        return;
+    }
+    while(len >= 16) {
+        blocks = len / 16;
+        if(blocks > FLETCHER_BLOCKS_MAX) blocks = FLETCHER_BLOCKS_MAX;
+        vc0 = zero; /* byte sums */
+        vc1 = zero; /* prefix sums of byte sums */
+        vw = zero;  /* weighted byte sums */
+        for(i = 0; i < blocks; i++) {
+            v = _mm_loadu_si128((const __m128i*)buf);
+            vc1 = _mm_add_epi64(vc1, vc0);
+            vc0 = _mm_add_epi64(vc0, _mm_sad_epu8(v, zero));
+            vw = _mm_add_epi32(vw, _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), wlo));
+            vw = _mm_add_epi32(vw, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), whi));
+            buf += 16;
+        }
+        len -= blocks * 16;
+        *c1 += blocks * 16 * *c0 + 16 * hsum_epi64_sse2(vc1) + 
+               hsum_epi64_sse2(_mm_add_epi64(_mm_unpacklo_epi32(vw, zero), 
+                                             _mm_unpackhi_epi32(vw, zero)));
+        *c0 += hsum_epi64_sse2(vc0);
+    }
+    fletcher_sum_generic(buf, len, c0, c1);
+}
+
+__attribute__((target("avx2"))) static uint64_t
+hsum_epi64_avx2(__m256i v)
+{
+    return hsum_epi64_sse2(_mm_add_epi64(_mm256_castsi256_si128(v), 
+                                         _mm256_extracti128_si256(v, 1)));
+}
+
+__attribute__((target("avx2"))) static uint32_t
+internet_sum_avx2(const uint8_t *buf, size_t len)
+{
+    __m256i zero, acc0, acc1, v;
+    uint64_t sum;
+
+    if(len < CHECKSUM_AVX2_MIN_LEN) {
+        return internet_sum_sse2(buf, len);
+    }
+    zero = _mm256_setzero_si256();
+    acc0 = zero;
+    acc1 = zero;
+    while(len >= 64) {
+        v = _mm256_loadu_si256((const __m256i*)buf);
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
+        v = _mm256_loadu_si256((const __m256i*)(buf+32));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
+        buf += 64;
+        len -= 64;
+    }
+    if(len >= 32) {
+        v = _mm256_loadu_si256((const __m256i*)buf);
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
+        buf += 32;
+        len -= 32;
+    }
+    sum = hsum_epi64_avx2(_mm256_add_epi64(acc0, acc1));
+    /* Avoid AVX to SSE transition penalty. */
+    _mm256_zeroupper();
+    return internet_sum_fold((uint64_t)internet_sum_sse2(buf, len) + internet_sum_fold(sum));
+}
+
+__attribute__((target("avx2"))) static void
+fletcher_sum_avx2(const uint8_t *buf, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i weights = _mm256_set_epi8(
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+        17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32);
+    __m256i vc0, vc1, vw, v;
+    uint64_t blocks, i;
+
+    if(len < CHECKSUM_AVX2_MIN_LEN) {
+        fletcher_sum_sse2(buf, len, c0, c1);
+        return;
+    }
+    while(len >= 32) {
+        blocks = len / 32;
+        if(blocks > FLETCHER_BLOCKS_MAX) blocks = FLETCHER_BLOCKS_MAX;
+        vc0 = zero; /* byte sums */
+        vc1 = zero; /* prefix sums of byte sums */
+        vw = zero;  /* weighted byte sums */
+        for(i = 0; i < blocks; i++) {
+            v = _mm256_loadu_si256((const __m256i*)buf);
+            vc1 = _mm256_add_epi64(vc1, vc0);
+            vc0 = _mm256_add_epi64(vc0, _mm256_sad_epu8(v, zero));
+            vw = _mm256_add_epi32(vw, _mm256_madd_epi16(_mm256_maddubs_epi16(v, weights), ones));
+            buf += 32;
+        }
+        len -= blocks * 32;
+        *c1 += blocks * 32 * *c0 + 32 * hsum_epi64_avx2(vc1) + 
+               hsum_epi64_avx2(_mm256_add_epi64(_mm256_unpacklo_epi32(vw, zero), 
+                                                _mm256_unpackhi_epi32(vw, zero)));
+        *c0 += hsum_epi64_avx2(vc0);
+    }
+    /* Avoid AVX to SSE transition penalty. */
+    _mm256_zeroupper();
+    fletcher_sum_sse2(buf, len, c0, c1);
+}
+
+#endif
+
+static const struct {
+    const char *name;
+    internet_sum_fn internet_sum;
+    fletcher_sum_fn fletcher_sum;
+} checksum_impls[CHECKSUM_IMPL_MAX] = {
+    { "generic", internet_sum_generic, fletcher_sum_generic },
+#if CHECKSUM_X86
+    { "sse2", internet_sum_sse2, fletcher_sum_sse2 },
+    { "avx2", internet_sum_avx2, fletcher_sum_avx2 },
+#else
+    { "sse2", NULL, NULL },
+    { "avx2", NULL, NULL },
+#endif
+};
+
+/**
+ * @brief checksum_impl_name
+ */
+const char *
+checksum_impl_name(checksum_impl_t impl)
+{
+    if(impl < CHECKSUM_IMPL_MAX) {
+        return checksum_impls[impl].name;
+    }
+    return "unknown";
+}
+
+/**
+ * @brief checksum_impl_supported
+ * 
+ * Returns true if the implementation is 
+ * available and supported by the CPU.
+ */
+bool
+checksum_impl_supported(checksum_impl_t impl)
+{
+    switch(impl) {
+        case CHECKSUM_IMPL_GENERIC:
+            return true;
+#if CHECKSUM_X86
+        case CHECKSUM_IMPL_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case CHECKSUM_IMPL_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief checksum_impl_set
+ * 
+ * Select checksum implementation, which is 
+ * otherwise selected automatically with the 
+ * first checksum calculated. 
+ */
+bool
+checksum_impl_set(checksum_impl_t impl)
+{
+    if(!checksum_impl_supported(impl)) {
+        return false;
+    }
+    g_internet_sum = checksum_impls[impl].internet_sum;
+    g_fletcher_sum = checksum_impls[impl].fletcher_sum;
+    g_checksum_impl = impl;
+    return true;
+}
+
+/**
+ * @brief checksum_impl_get
+ */
+checksum_impl_t
+checksum_impl_get(void)
+{
+    if(g_internet_sum == internet_sum_init) {
+        checksum_impl_set(checksum_impl_best());
+    }
+    return g_checksum_impl;
+}
+
+/**
+ * @brief checksum_impl_best
+ * 
+ * Returns the fastest implementation supported by the CPU.
+ */
+checksum_impl_t
+checksum_impl_best(void)
+{
+    checksum_impl_t impl = CHECKSUM_IMPL_MAX - 1;
+    while(impl > CHECKSUM_IMPL_GENERIC && !checksum_impl_supported(impl)) {
+        impl--;
+    }
+    return impl;
+}
+
+static uint32_t
+internet_sum_init(const uint8_t *buf, size_t len)
+{
+    checksum_impl_set(checksum_impl_best());
+    return g_internet_sum(buf, len);
+}
+
+static void
+fletcher_sum_init(const uint8_t *buf, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    checksum_impl_set(checksum_impl_best());
+    g_fletcher_sum(buf, len, c0, c1);
+}
+
+/**
+ * @brief calculate_internet_sum
+ * 
+ * Returns the one's complement sum of all 16 bit words 
+ * in host byte order folded to 16 bit (RFC 1071). Partial 
+ * sums can be added and folded again before complementing 
+ * the final sum to get the internet checksum.
+ */
+uint32_t
+calculate_internet_sum(const void *buf, size_t len)
+{
+    return g_internet_sum(buf, len);
+}
+
 /**
  * @brief validate_fletcher_checksum
  * 
@@ -18,17 +421,11 @@
 uint16_t
 validate_fletcher_checksum(const uint8_t *pptr, uint length)
 {
-
     uint64_t c0, c1;
-    uint idx;
 
     c0 = 0;
     c1 = 0;
-
-    for(idx = 0; idx < length; idx++) {
-        c0 = c0 + *(pptr++);
-        c1 += c0;
-    }
+    g_fletcher_sum(pptr, length, &c0, &c1);
 
     c0 = c0 % 255;
     c1 = c1 % 255;
@@ -45,51 +442,21 @@ validate_fletcher_checksum(const uint8_t *pptr, uint length)
 uint16_t
 calculate_fletcher_checksum(uint8_t *pptr, uint checksum_offset, uint length)
 {
+    uint64_t sum0, sum1;
     int64_t c0, c1;
-    int tlen;
 
-    c0 = 0;
-    c1 = 0;
+    sum0 = 0;
+    sum1 = 0;
 
     /* reset checksum field */
     *(pptr + checksum_offset) = 0;
     *(pptr + checksum_offset + 1) = 0;
 
-    /* 10x loop unrolling */
-    tlen = length;
-    while(tlen >= 10) {
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-
-        tlen -= 10;
-    }
+    g_fletcher_sum(pptr, length, &sum0, &sum1);
 
-    /* remainder */
-    while (--tlen >= 0) {
-        c0 += *pptr++;
-        c1 += c0;
-    }
-
-    c0 = c0 % 255;
-    c1 = (c1 - (length - checksum_offset) * c0) % 255;
+    c0 = sum0 % 255;
+    c1 = (int64_t)(sum1 % 255);
+    c1 = (c1 - (int64_t)((length - checksum_offset) % 255) * c0) % 255;
     if (c1 <= 0) {
         c1 += 255;
     }
@@ -12,6 +12,37 @@
 #define __COMMON_CHECKSUM_H__
 #include "common.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CHECKSUM_X86 1
+#else
+#define CHECKSUM_X86 0
+#endif
+
+typedef enum checksum_impl_ {
+    CHECKSUM_IMPL_GENERIC = 0,
+    CHECKSUM_IMPL_SSE2,
+    CHECKSUM_IMPL_AVX2,
+    CHECKSUM_IMPL_MAX
+} checksum_impl_t;
+
+const char *
+checksum_impl_name(checksum_impl_t impl);
+
+bool
+checksum_impl_supported(checksum_impl_t impl);
+
+bool
+checksum_impl_set(checksum_impl_t impl);
+
+checksum_impl_t
+checksum_impl_get(void);
+
+checksum_impl_t
+checksum_impl_best(void);
+
+uint32_t
+calculate_internet_sum(const void *buf, size_t len);
+
 uint16_t
 validate_fletcher_checksum(const uint8_t *pptr, uint length);
 
@@ -8,6 +8,9 @@
  */
 #include "timer.h"
 #include "logging.h"
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 /**
  * Set timer expiration.
@@ -143,43 +146,233 @@ timer_change(timer_s *timer)
     timer->on_change_list = true;
 }
 
+/**
+ * Expiration of the first timer in a bucket.
+ * Buckets in the heap are never empty.
+ */
+static inline struct timespec *
+timer_bucket_expire(timer_bucket_s *timer_bucket)
+{
+    return &CIRCLEQ_FIRST(&timer_bucket->timer_qhead)->expire;
+}
+
+static inline void
+timer_heap_set(timer_root_s *root, uint32_t i, timer_bucket_s *timer_bucket)
+{
+    root->bucket_heap[i] = timer_bucket;
+    timer_bucket->heap_index = i + 1;
+}
+
 static void
+timer_heap_up(timer_root_s *root, uint32_t i)
+{
+    timer_bucket_s *timer_bucket = root->bucket_heap[i];
+    uint32_t parent;
+
+    while(i) {
+        parent = (i - 1) >> 1;
+        if(timespec_compare(timer_bucket_expire(timer_bucket), 
+                            timer_bucket_expire(root->bucket_heap[parent])) != -1) {
+            break;
+        }
+        timer_heap_set(root, i, root->bucket_heap[parent]);
+        i = parent;
+    }
+    timer_heap_set(root, i, timer_bucket);
+}
+
+static void
+timer_heap_down(timer_root_s *root, uint32_t i)
+{
+    timer_bucket_s *timer_bucket = root->bucket_heap[i];
+    uint32_t child;
+
+    while(true) {
+        child = (i << 1) + 1;
+        if(child >= root->bucket_heap_size) {
+            break;
+        }
+        if(child + 1 < root->bucket_heap_size &&
+           timespec_compare(timer_bucket_expire(root->bucket_heap[child+1]), 
+                            timer_bucket_expire(root->bucket_heap[child])) == -1) {
+            child++;
+        }
+        if(timespec_compare(timer_bucket_expire(root->bucket_heap[child]), 
+                            timer_bucket_expire(timer_bucket)) != -1) {
+            break;
+        }
+        timer_heap_set(root, i, root->bucket_heap[child]);
+        i = child;
+    }
+    timer_heap_set(root, i, timer_bucket);
+}
+
+static inline void
+timer_heap_push(timer_root_s *root, timer_bucket_s *timer_bucket)
+{
+    timer_heap_set(root, root->bucket_heap_size++, timer_bucket);
+    timer_heap_up(root, root->bucket_heap_size - 1);
+}
+
+/**
+ * Insert a new bucket into the heap. 
+ * 
+ * Slots of buckets taken out by the timer walk stay 
+ * reserved, such that returning those buckets to 
+ * the heap can't fail.
+ */
+static bool
+timer_heap_insert(timer_root_s *root, timer_bucket_s *timer_bucket)
+{
+    timer_bucket_s **heap;
+    uint32_t len;
+
+    if(root->bucket_heap_size + root->bucket_heap_reserved >= root->bucket_heap_len) {
+        len = root->bucket_heap_len ? root->bucket_heap_len * 2 : 64;
+        heap = realloc(root->bucket_heap, len * sizeof(timer_bucket_s*));
+        if(!heap) {
+            return false;
+        }
+        root->bucket_heap = heap;
+        root->bucket_heap_len = len;
+    }
+    timer_heap_push(root, timer_bucket);
+    return true;
+}
+
+static void
+timer_heap_remove(timer_root_s *root, timer_bucket_s *timer_bucket)
+{
+    uint32_t i = timer_bucket->heap_index - 1;
+    timer_bucket_s *last;
+
+    timer_bucket->heap_index = 0;
+    last = root->bucket_heap[--root->bucket_heap_size];
+    if(last != timer_bucket) {
+        timer_heap_set(root, i, last);
+        timer_heap_up(root, i);
+        timer_heap_down(root, last->heap_index - 1);
+    }
+}
+
+/**
+ * Restore heap order after the first timer 
+ * of a bucket has been changed.
+ */
+static void
+timer_heap_update(timer_bucket_s *timer_bucket)
+{
+    timer_root_s *root = timer_bucket->timer_root;
+    if(timer_bucket->heap_index) {
+        timer_heap_up(root, timer_bucket->heap_index - 1);
+        timer_heap_down(root, timer_bucket->heap_index - 1);
+    }
+}
+
+static inline uint32_t
+timer_bucket_hash(time_t sec, long nsec)
+{
+    uint64_t key = ((uint64_t)sec * SEC) + nsec;
+    return (key * 0x9e3779b97f4a7c15ULL) >> (64 - TIMER_BUCKET_HASH_BITS);
+}
+
+static timer_bucket_s *
+timer_bucket_lookup(timer_root_s *root, time_t sec, long nsec)
+{
+    timer_bucket_s *timer_bucket = root->bucket_hash[timer_bucket_hash(sec, nsec)];
+    while(timer_bucket) {
+        if(timer_bucket->sec == sec && timer_bucket->nsec == nsec) {
+            return timer_bucket;
+        }
+        timer_bucket = timer_bucket->hash_next;
+    }
+    return NULL;
+}
+
+static void
+timer_bucket_unlink(timer_root_s *root, timer_bucket_s *timer_bucket)
+{
+    timer_bucket_s **prev = &root->bucket_hash[timer_bucket_hash(timer_bucket->sec, timer_bucket->nsec)];
+    while(*prev) {
+        if(*prev == timer_bucket) {
+            *prev = timer_bucket->hash_next;
+            break;
+        }
+        prev = &(*prev)->hash_next;
+    }
+    timer_bucket->hash_next = NULL;
+}
+
+static bool
 timer_enqueue_bucket(timer_root_s *root, timer_s *timer, time_t sec, long nsec)
 {
     timer_bucket_s *timer_bucket;
+    uint32_t hash;
 
     /* Find the bucket for insertion. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
-        if(timer_bucket->sec != sec ||  timer_bucket->nsec != nsec) {
-            continue;
-        }
-        /* Found it! */
-        goto INSERT;
+    timer_bucket = timer_bucket_lookup(root, sec, nsec);
+    if(timer_bucket) {
+        timer->timer_bucket = timer_bucket;
+        CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
+        timer_bucket->timers++;
+        return true;
     }
 
     /* No bucket found that matches the timer values. 
      * Create a fresh bucket. */
     timer_bucket = calloc(1, sizeof(timer_bucket_s));
     if(!timer_bucket) {
-        return;
+        return false;
     }
-
-    CIRCLEQ_INSERT_TAIL(&root->timer_bucket_qhead, timer_bucket, timer_bucket_qnode);
     CIRCLEQ_INIT(&timer_bucket->timer_qhead);
     timer_bucket->sec = sec;
     timer_bucket->nsec = nsec;
     timer_bucket->timer_root = root;
+
+    /* The heap is ordered by the first timer of each
+     * bucket, which must be enqueued before. */
+    CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
+    timer_bucket->timers++;
+    if(!timer_heap_insert(root, timer_bucket)) {
+        free(timer_bucket);
+        return false;
+    }
+    timer->timer_bucket = timer_bucket;
+
+    CIRCLEQ_INSERT_TAIL(&root->timer_bucket_qhead, timer_bucket, timer_bucket_qnode);
+    hash = timer_bucket_hash(sec, nsec);
+    timer_bucket->hash_next = root->bucket_hash[hash];
+    root->bucket_hash[hash] = timer_bucket;
     root->buckets++;
 
 #ifdef BNGBLASTER_TIMER_LOGGING
     LOG(TIMER_DETAIL, "Add timer bucket %lu.%06lus\n",
         timer_bucket->sec, timer_bucket->nsec/1000);
 #endif
+    return true;
+}
 
- INSERT:
-    timer->timer_bucket = timer_bucket;
-    CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
-    timer_bucket->timers++;
+/**
+ * Move a timer which could not be enqueued to 
+ * the garbage collection queue and delete 
+ * references to this timer.
+ */
+static void
+timer_enqueue_failed(timer_root_s *root, timer_s *timer)
+{
+    LOG(ERROR, "Failed to enqueue %s timer (out of memory)\n", timer->name);
+
+    timer->timer_bucket = NULL;
+    if(timer->on_change_list) {
+        CIRCLEQ_REMOVE(&root->timer_change_qhead, timer, timer_change_qnode);
+        timer->on_change_list = false;
+    }
+    CIRCLEQ_INSERT_TAIL(&root->timer_gc_qhead, timer, timer_qnode);
+    root->gc++;
+    if(timer->ptimer) {
+        *timer->ptimer = NULL;
+        timer->ptimer = NULL;
+    }
 }
 
 /**
@@ -191,9 +384,12 @@ timer_dequeue_bucket(timer_s *timer)
     timer_root_s *timer_root;
     timer_bucket_s *timer_bucket;
 
+    bool first;
+
     timer_bucket = timer->timer_bucket;
     timer_root = timer_bucket->timer_root;
 
+    first = (CIRCLEQ_FIRST(&timer_bucket->timer_qhead) == timer);
     CIRCLEQ_REMOVE(&timer_bucket->timer_qhead, timer, timer_qnode);
     timer_bucket->timers--;
     timer->timer_bucket = NULL;
@@ -202,18 +398,28 @@ timer_dequeue_bucket(timer_s *timer)
      * remove the bucket as well. */
     if(!timer_bucket->timers) {
         CIRCLEQ_REMOVE(&timer_root->timer_bucket_qhead, timer_bucket, timer_bucket_qnode);
+        timer_bucket_unlink(timer_root, timer_bucket);
+        if(timer_bucket->heap_index) {
+            timer_heap_remove(timer_root, timer_bucket);
+        }
 
 #ifdef BNGBLASTER_TIMER_LOGGING
         LOG(TIMER_DETAIL, "  Delete timer bucket %lu.%06lus\n",
             timer_bucket->sec, timer_bucket->nsec/1000);
 #endif
 
-        free(timer_bucket);
+        /* Buckets currently processed by the timer 
+         * walk are freed at the end of the walk. */
+        if(!timer_bucket->walk) {
+            free(timer_bucket);
+        }
         timer_root->buckets--;
+    } else if(first) {
+        timer_heap_update(timer_bucket);
     }
 }
 
-static void
+static bool
 timer_requeue(timer_s *timer, time_t sec, long nsec)
 {
     timer_root_s *timer_root;
@@ -231,16 +437,20 @@ timer_requeue(timer_s *timer, time_t sec, long nsec)
     if(timer_bucket->sec == sec && timer_bucket->nsec == nsec) {
         CIRCLEQ_REMOVE(&timer_bucket->timer_qhead, timer, timer_qnode);
         CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
+        timer_heap_update(timer_bucket);
     } else {
         timer_dequeue_bucket(timer);
-        timer_enqueue_bucket(timer_root, timer, sec, nsec);
+        if(!timer_enqueue_bucket(timer_root, timer, sec, nsec)) {
+            timer_enqueue_failed(timer_root, timer);
+            return false;
+        }
     }
 
 #ifdef BNGBLASTER_TIMER_LOGGING
     LOG(TIMER_DETAIL, "  Reset %s timer, expire in %lu.%06lus\n", 
         timer->name, sec, nsec/1000);
 #endif
-
+    return true;
 }
 
 static void
@@ -277,6 +487,7 @@ timer_smear_bucket_internal(timer_bucket_s *timer_bucket)
                 timer->expire.tv_sec, timer->expire.tv_nsec / 1000);
 #endif
         }
+        timer_heap_update(timer_bucket);
     }
 }
 
@@ -290,12 +501,9 @@ timer_smear_bucket(timer_root_s *root, time_t sec, long nsec)
     timer_bucket_s *timer_bucket;
 
     /* Find the bucket for smearing. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
-        if(timer_bucket->sec != sec ||  timer_bucket->nsec != nsec) {
-            continue;
-        }
+    timer_bucket = timer_bucket_lookup(root, sec, nsec);
+    if(timer_bucket) {
         timer_smear_bucket_internal(timer_bucket);
-        return;
     }
 }
 
@@ -393,8 +601,11 @@ timer_process_changes(timer_root_s *root)
 /**
  * Enqueue a timer with a given callback function onto 
  * the hierarchical timer list.
+ *
+ * @return false if the timer could not be enqueued
+ *         (out of memory), *ptimer is reset in this case
  */
-void
+bool
 timer_add(timer_root_s *root, timer_s **ptimer, char *name,
           time_t sec, long nsec,
           void *data, void (*cb)(timer_s *))
@@ -404,7 +615,9 @@ timer_add(timer_root_s *root, timer_s **ptimer, char *name,
     /* This timer already is enqueued. Requeue. */
     if(timer) {
         clock_gettime(CLOCK_MONOTONIC, &timer->expire);
-        timer_requeue(timer, sec, nsec);
+        if(!timer_requeue(timer, sec, nsec)) {
+            return false;
+        }
         /* Update data and cb if there was a change.
          * Do the reformatting of name only during a change. */
         if(timer->data != data || timer->cb != cb) {
@@ -412,7 +625,7 @@ timer_add(timer_root_s *root, timer_s **ptimer, char *name,
             timer->data = data;
             timer->cb = cb;
         }
-        return;
+        return true;
     }
 
     if(CIRCLEQ_EMPTY(&root->timer_gc_qhead)) {
@@ -427,7 +640,8 @@ timer_add(timer_root_s *root, timer_s **ptimer, char *name,
     }
 
     if(!timer) {
-        return;
+        LOG(ERROR, "Failed to allocate %s timer (out of memory)\n", name);
+        return false;
     }
 
     /* Store name, data, callback and misc. data. */
@@ -440,27 +654,86 @@ timer_add(timer_root_s *root, timer_s **ptimer, char *name,
     *ptimer = timer;
 
     /* Enqueue it into the correct timer bucket. */
-    timer_enqueue_bucket(root, timer, sec, nsec);
+    if(!timer_enqueue_bucket(root, timer, sec, nsec)) {
+        timer_enqueue_failed(root, timer);
+        return false;
+    }
 
 #ifdef BNGBLASTER_TIMER_LOGGING
     LOG(TIMER, "Add %s timer, expire in %lu.%06lus\n", timer->name, sec, nsec/1000);
 #endif
+    return true;
 }
 
-void
+bool
 timer_add_periodic(timer_root_s *root, timer_s **ptimer, char *name,
                    time_t sec, long nsec, 
                    void *data, void (*cb)(timer_s *))
 {
     timer_s *timer;
 
-    timer_add(root, ptimer, name, sec, nsec, data, cb);
+    if(!timer_add(root, ptimer, name, sec, nsec, data, cb)) {
+        return false;
+    }
 
     timer = *ptimer;
     if(timer) {
         timer->periodic = true;
         timer->reset = true;
     }
+    return true;
+}
+
+/**
+ * Block until the next timer expires or any of the
+ * registered file descriptors becomes readable. 
+ */
+static void
+timer_event_wait(timer_root_s *root)
+{
+    struct epoll_event events[TIMER_EVENTS_MAX];
+    struct itimerspec its = {0};
+    timer_event_s *event;
+    uint64_t expirations;
+    int res, i;
+
+    /* Arm the timerfd with the absolute expiration
+     * of the first bucket in the heap. An expiration 
+     * in the past fires immediately. An empty heap 
+     * disarms the timerfd. */
+    if(root->bucket_heap_size) {
+        its.it_value = *timer_bucket_expire(root->bucket_heap[0]);
+        if(!its.it_value.tv_sec && !its.it_value.tv_nsec) {
+            its.it_value.tv_nsec = 1;
+        }
+    }
+    if(timerfd_settime(root->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+        LOG(ERROR, "Timer Error: timerfd_settime %s (%d)\n", strerror(errno), errno);
+        return;
+    }
+
+    res = epoll_wait(root->epoll_fd, events, TIMER_EVENTS_MAX, -1);
+    if(res == -1) {
+        switch (errno) {
+            case EINTR: /* Ctrl-C */
+                break;
+            default:
+                LOG(ERROR, "Timer Error: epoll_wait %s (%d)\n", strerror(errno), errno);
+                break;
+        }
+        return;
+    }
+    for(i = 0; i < res; i++) {
+        event = events[i].data.ptr;
+        if(event) {
+            (*event->cb)(event);
+        } else {
+            /* Timer expired, the next walk will do the rest. */
+            if(read(root->timer_fd, &expirations, sizeof(expirations)) < 0) {
+                continue;
+            }
+        }
+    }
 }
 
 /**
@@ -473,11 +746,15 @@ timer_walk(timer_root_s *root)
 {
     timer_s *timer;
     timer_bucket_s *timer_bucket;
+    timer_bucket_s *walk = NULL;
     struct timespec now, min, sleep, rem;
     int res;
 
     /* No buckets filled and we're done. */
-    if(CIRCLEQ_EMPTY(&root->timer_bucket_qhead)) {
+    if(!root->bucket_heap_size) {
+        if(root->event) {
+            timer_event_wait(root);
+        }
         return;
     }
 
@@ -488,18 +765,27 @@ timer_walk(timer_root_s *root)
         now.tv_sec, now.tv_nsec / 1000);
 #endif
 
-    min.tv_sec = 0;
-    min.tv_nsec = 0;
-
-    /* Walk all buckets. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
+    /* Walk all expired buckets in order of expiration. 
+     * Expired buckets are taken out of the heap until 
+     * all changes are processed, such that each bucket 
+     * is visited at most once per walk. */
+    while(root->bucket_heap_size) {
+        timer_bucket = root->bucket_heap[0];
+        if(timespec_compare(timer_bucket_expire(timer_bucket), &now) == 1) {
+            break;
+        }
+        timer_heap_remove(root, timer_bucket);
+        root->bucket_heap_reserved++;
+        timer_bucket->walk = true;
+        timer_bucket->walk_next = walk;
+        walk = timer_bucket;
 
 #ifdef BNGBLASTER_TIMER_LOGGING
         LOG(TIMER_DETAIL, "  Checking timer bucket %lu.%06lus\n",
             timer_bucket->sec, timer_bucket->nsec/1000);
 #endif
 
-        /* First pass. Call into expired nodes. */
+        /* Call into expired nodes. */
         CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
 
             /* Hitting the first non-expired timer means
@@ -534,37 +820,30 @@ timer_walk(timer_root_s *root)
     /* Process all changes from the last timer run. */
     timer_process_changes(root);
 
-    /* Second pass. Figure out min sleep time. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
-        CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
-
-            /* Ignore deleted timers that wait for change processing. */
-            if(timer->delete) {
-                continue;
-            }
+    /* Return all visited buckets to the heap. */
+    while(walk) {
+        timer_bucket = walk;
+        walk = timer_bucket->walk_next;
+        timer_bucket->walk = false;
+        timer_bucket->walk_next = NULL;
+        root->bucket_heap_reserved--;
+        if(timer_bucket->timers) {
+            timer_heap_push(root, timer_bucket);
+        } else {
+            free(timer_bucket);
+        }
+    }
 
-            /* First timer in the queue becomes the actual minimum. */
-            if(min.tv_sec == 0 && min.tv_nsec == 0) {
-                min.tv_sec = timer->expire.tv_sec;
-                min.tv_nsec = timer->expire.tv_nsec;
-            }
+    if(root->event) {
+        timer_event_wait(root);
+        return;
+    }
 
-            /* Find the min timer. */
-            if(timespec_compare(&timer->expire, &min) == -1) {
-                min.tv_sec = timer->expire.tv_sec;
-                min.tv_nsec = timer->expire.tv_nsec;
-#ifdef BNGBLASTER_TIMER_LOGGING
-                LOG(TIMER_DETAIL, "New minimum sleep (%s) timer, found %lu.%06lus\n",
-                    timer->name, min.tv_sec, min.tv_nsec / 1000);
-#endif
-            }
-            /* Hitting the first non-expired timer means
-             * we're done processing this buckets queue. */
-            if(timespec_compare(&timer->expire, &now) == 1) {
-                break;
-            }
-        }
+    /* The first bucket in the heap has the min sleep time. */
+    if(!root->bucket_heap_size) {
+        return;
     }
+    min = *timer_bucket_expire(root->bucket_heap[0]);
 
     /* Calculate the sleep timer. */
 #ifdef BNGBLASTER_TIMER_LOGGING
@@ -601,6 +880,99 @@ timer_init_root(timer_root_s *timer_root)
     CIRCLEQ_INIT(&timer_root->timer_bucket_qhead);
     CIRCLEQ_INIT(&timer_root->timer_gc_qhead);
     CIRCLEQ_INIT(&timer_root->timer_change_qhead);
+    memset(timer_root->bucket_hash, 0x0, sizeof(timer_root->bucket_hash));
+    timer_root->bucket_heap = NULL;
+    timer_root->bucket_heap_size = 0;
+    timer_root->bucket_heap_len = 0;
+    timer_root->bucket_heap_reserved = 0;
+    timer_root->event = false;
+    timer_root->epoll_fd = -1;
+    timer_root->timer_fd = -1;
+    timer_root->events = NULL;
+}
+
+/**
+ * Enable the event loop for a timer root.
+ * 
+ * The timer walk blocks on epoll with a timerfd armed 
+ * for the next expiration instead of nanosleep.
+ *
+ * @param root timer root
+ * @return true if successful
+ */
+bool
+timer_event_init(timer_root_s *root)
+{
+    struct epoll_event ev = {0};
+
+    if(root->event) {
+        return true;
+    }
+    root->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(root->epoll_fd == -1) {
+        LOG(ERROR, "Timer Error: epoll_create1 %s (%d)\n", strerror(errno), errno);
+        return false;
+    }
+    root->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC);
+    if(root->timer_fd == -1) {
+        LOG(ERROR, "Timer Error: timerfd_create %s (%d)\n", strerror(errno), errno);
+        close(root->epoll_fd);
+        root->epoll_fd = -1;
+        return false;
+    }
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if(epoll_ctl(root->epoll_fd, EPOLL_CTL_ADD, root->timer_fd, &ev) == -1) {
+        LOG(ERROR, "Timer Error: epoll_ctl %s (%d)\n", strerror(errno), errno);
+        close(root->timer_fd);
+        close(root->epoll_fd);
+        root->timer_fd = -1;
+        root->epoll_fd = -1;
+        return false;
+    }
+    root->event = true;
+    return true;
+}
+
+/**
+ * Register a file descriptor with the timer event loop.
+ * 
+ * The callback is executed from timer walk 
+ * if the file descriptor becomes readable.
+ *
+ * @param root timer root
+ * @param fd file descriptor
+ * @param data misc. data passed to callback
+ * @param cb callback function
+ * @return true if successful
+ */
+bool
+timer_event_add(timer_root_s *root, int fd, void *data, void (*cb)(timer_event_s *))
+{
+    struct epoll_event ev = {0};
+    timer_event_s *event;
+
+    if(!root->event || !cb) {
+        return false;
+    }
+    event = calloc(1, sizeof(timer_event_s));
+    if(!event) {
+        return false;
+    }
+    event->fd = fd;
+    event->data = data;
+    event->cb = cb;
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = event;
+    if(epoll_ctl(root->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        LOG(ERROR, "Timer Error: epoll_ctl %s (%d)\n", strerror(errno), errno);
+        free(event);
+        return false;
+    }
+    event->next = root->events;
+    root->events = event;
+    return true;
 }
 
 /**
@@ -613,6 +985,7 @@ timer_flush_root(timer_root_s *timer_root)
 {
     timer_s *timer;
     timer_bucket_s *timer_bucket;
+    timer_event_s *event;
 
     /* First step. Walk all timers and move them onto the GC thread. */
     CIRCLEQ_FOREACH(timer_bucket, &timer_root->timer_bucket_qhead, timer_bucket_qnode) {
@@ -629,4 +1002,21 @@ timer_flush_root(timer_root_s *timer_root)
         timer_root->gc--;
         free(timer);
     }
+    free(timer_root->bucket_heap);
+    timer_root->bucket_heap = NULL;
+    timer_root->bucket_heap_len = 0;
+
+    /* Flush event loop. */
+    while(timer_root->events) {
+        event = timer_root->events;
+        timer_root->events = event->next;
+        free(event);
+    }
+    if(timer_root->event) {
+        close(timer_root->timer_fd);
+        close(timer_root->epoll_fd);
+        timer_root->timer_fd = -1;
+        timer_root->epoll_fd = -1;
+        timer_root->event = false;
+    }
 }
\ No newline at end of file
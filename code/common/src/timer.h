@@ -14,6 +14,20 @@
 #define MSEC 1000000 /* 1 million nanoseconds == 1 msec */
 #define SEC 1000000000 /* 1 billion nanoseconds == 1 sec */
 
+#define TIMER_BUCKET_HASH_BITS 10
+#define TIMER_BUCKET_HASH_SIZE (1 << TIMER_BUCKET_HASH_BITS)
+
+#define TIMER_EVENTS_MAX 16
+
+/* File descriptor registered with the timer event loop. */
+typedef struct timer_event_
+{
+    struct timer_event_ *next;
+    int fd;
+    void *data; /* misc. data */
+    void (*cb)(struct timer_event_ *); /* callback function. */
+} timer_event_s;
+
 /*  Top level data structure for timers. */
 typedef struct timer_root_
 {
@@ -21,9 +35,29 @@ typedef struct timer_root_
     CIRCLEQ_HEAD(timer_gc_root_, timer_ ) timer_gc_qhead; /* Garbage collection list */
     CIRCLEQ_HEAD(timer_change_root_, timer_ ) timer_change_qhead; /* Change timers list */
 
+    /* Buckets indexed by {sec,nsec} for O(1) bucket lookup. */
+    struct timer_bucket_ *bucket_hash[TIMER_BUCKET_HASH_SIZE];
+
+    /* Binary min-heap of buckets ordered by the expiration
+     * of the first timer, such that only expired buckets 
+     * need to be visited by the timer walk. */
+    struct timer_bucket_ **bucket_heap;
+    uint32_t bucket_heap_size; /* # of buckets in heap */
+    uint32_t bucket_heap_len; /* allocated heap slots */
+    uint32_t bucket_heap_reserved; /* slots reserved for walked buckets */
+
     uint32_t buckets; /* # of buckets hanging off */
     uint32_t gc; /* # of timers waiting for GC */
 
+    /* Optional event loop, where the timer walk blocks
+     * on epoll with a timerfd armed for the next expiration
+     * instead of nanosleep, such that registered file 
+     * descriptors are served as soon as they become readable. */
+    bool event;
+    int epoll_fd;
+    int timer_fd;
+    timer_event_s *events;
+
 } timer_root_s;
 
 /* Group each like timers (e.g. all 100ms, 1s, 5s timers) into a timer bucket.
@@ -36,11 +70,15 @@ typedef struct timer_bucket_
     CIRCLEQ_ENTRY(timer_bucket_) timer_bucket_qnode; /* node in bucket list */
 
     struct timer_root_ *timer_root; /* back pointer */
+    struct timer_bucket_ *hash_next; /* next bucket in hash chain */
+    struct timer_bucket_ *walk_next; /* next bucket in timer walk */
 
     time_t sec;
     long nsec;
 
     uint32_t timers; /* # of timers hanging off this bucket */
+    uint32_t heap_index; /* position in heap + 1 (0 if not in heap) */
+    bool walk; /* bucket is processed by timer walk */
 } timer_bucket_s;
 
 /* Timer which hangs off the bucket list. */
@@ -82,12 +120,12 @@ timer_smear_all_buckets(timer_root_s *root);
 void 
 timer_del(timer_s *timer);
 
-void
+bool
 timer_add(timer_root_s *root, timer_s **ptimer, char *name,
           time_t sec, long nsec,
           void *data, void (*cb)(timer_s *));
 
-void
+bool
 timer_add_periodic(timer_root_s *root, timer_s **ptimer, char *name,
                    time_t sec, long nsec, 
                    void *data, void (*cb)(timer_s *));
@@ -98,6 +136,12 @@ timer_walk(timer_root_s *root);
 void
 timer_init_root(timer_root_s *timer_root);
 
+bool
+timer_event_init(timer_root_s *root);
+
+bool
+timer_event_add(timer_root_s *root, int fd, void *data, void (*cb)(timer_event_s *));
+
 void
 timer_flush_root(timer_root_s *timer_root);
 
@@ -34,9 +34,121 @@ test_calculate_fletcher_checksum(void **unused) {
     assert_int_equal(checksum, pdu1_checksum);
 }
 
+/* Scalar reference implementations. */
+
+static uint16_t
+ref_internet_checksum(const uint8_t *buf, size_t len)
+{
+    uint32_t sum = 0;
+    uint16_t word;
+    while(len > 1) {
+        memcpy(&word, buf, sizeof(word));
+        sum += word;
+        buf += 2;
+        len -= 2;
+    }
+    if(len) {
+        sum += *buf;
+    }
+    while(sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return ~sum;
+}
+
+static void
+ref_fletcher_sum(const uint8_t *buf, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    *c0 = 0;
+    *c1 = 0;
+    while(len--) {
+        *c0 += *buf++;
+        *c1 += *c0;
+    }
+}
+
+static uint16_t
+internet_checksum(const uint8_t *buf, size_t len)
+{
+    uint32_t sum = calculate_internet_sum(buf, len);
+    while(sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return ~sum;
+}
+
+static void
+test_checksum_impl(void **unused) {
+    (void) unused;
+
+    static uint8_t buf[70000];
+    uint8_t pdu[2048];
+    uint64_t c0, c1;
+    uint16_t checksum, expected;
+    checksum_impl_t impl;
+    size_t len, offset, i;
+
+    srand(1);
+    for(i = 0; i < sizeof(buf); i++) {
+        buf[i] = rand();
+    }
+
+    assert_true(checksum_impl_supported(CHECKSUM_IMPL_GENERIC));
+    assert_true(checksum_impl_supported(checksum_impl_best()));
+
+    for(impl = CHECKSUM_IMPL_GENERIC; impl < CHECKSUM_IMPL_MAX; impl++) {
+        if(!checksum_impl_set(impl)) {
+            continue;
+        }
+        assert_int_equal(checksum_impl_get(), impl);
+        /* All lengths and alignments for small buffers. */
+        for(offset = 0; offset < 8; offset++) {
+            for(len = 0; len < 600; len++) {
+                assert_int_equal(internet_checksum(buf+offset, len), 
+                                 ref_internet_checksum(buf+offset, len));
+                ref_fletcher_sum(buf+offset, len, &c0, &c1);
+                assert_int_equal(validate_fletcher_checksum(buf+offset, len), 
+                                 (c1 % 255) << 8 | (c0 % 255));
+            }
+        }
+        /* Large buffers, all zero and all ones. */
+        for(len = 1000; len < sizeof(buf)-8; len = len * 3 + 1) {
+            assert_int_equal(internet_checksum(buf+1, len), 
+                             ref_internet_checksum(buf+1, len));
+            ref_fletcher_sum(buf+1, len, &c0, &c1);
+            assert_int_equal(validate_fletcher_checksum(buf+1, len), 
+                             (c1 % 255) << 8 | (c0 % 255));
+        }
+        memset(pdu, 0x00, sizeof(pdu));
+        assert_int_equal(internet_checksum(pdu, sizeof(pdu)), 0xffff);
+        memset(pdu, 0xff, sizeof(pdu));
+        assert_int_equal(internet_checksum(pdu, sizeof(pdu)), 
+                         ref_internet_checksum(pdu, sizeof(pdu)));
+        ref_fletcher_sum(pdu, sizeof(pdu), &c0, &c1);
+        assert_int_equal(validate_fletcher_checksum(pdu, sizeof(pdu)), 
+                         (c1 % 255) << 8 | (c0 % 255));
+
+        /* Fletcher checksum must validate. */
+        for(len = 27; len < sizeof(pdu); len += 97) {
+            memcpy(pdu, buf+len, len);
+            checksum = calculate_fletcher_checksum(pdu, 12, len);
+            pdu[12] = checksum >> 8;
+            pdu[13] = checksum & 0xff;
+            assert_int_equal(validate_fletcher_checksum(pdu, len), 0);
+            if(impl == CHECKSUM_IMPL_GENERIC) continue;
+            checksum_impl_set(CHECKSUM_IMPL_GENERIC);
+            expected = calculate_fletcher_checksum(pdu, 12, len);
+            checksum_impl_set(impl);
+            assert_int_equal(checksum, expected);
+        }
+    }
+    checksum_impl_set(checksum_impl_best());
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_calculate_fletcher_checksum),
+        cmocka_unit_test(test_checksum_impl),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
\ No newline at end of file
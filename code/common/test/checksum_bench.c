@@ -0,0 +1,78 @@
+/*
+ * Common Checksum Benchmark
+ *
+ * Usage: bench-checksum [MB]
+ *
+ * Checksums the given amount of data (default 256MB)
+ * per implementation and packet size and reports the
+ * throughput of the internet and fletcher
+ * checksum for all implementations supported by the 
+ * CPU over typical packet sizes. 
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <checksum.h>
+
+static const size_t bench_sizes[] = {
+    20, 64, 128, 256, 512, 1024, 1500, 4096, 9000, 65535
+};
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char *argv[])
+{
+    static uint8_t buf[65536];
+    volatile uint32_t result = 0;
+    uint64_t bytes = 256*1024*1024;
+    uint64_t iterations, i;
+    checksum_impl_t impl;
+    size_t s, len;
+    double start, internet, fletcher;
+
+    if(argc > 1) bytes = strtoull(argv[1], NULL, 10) * 1024 * 1024;
+    if(!bytes) {
+        fprintf(stderr, "Usage: %s [MB]\n", argv[0]);
+        return 1;
+    }
+
+    for(i = 0; i < sizeof(buf); i++) {
+        buf[i] = i * 7;
+    }
+
+    printf("%-8s %6s %12s %12s\n", "impl", "size", "inet MB/s", "fletch MB/s");
+    for(impl = CHECKSUM_IMPL_GENERIC; impl < CHECKSUM_IMPL_MAX; impl++) {
+        if(!checksum_impl_set(impl)) {
+            printf("%-8s not supported\n", checksum_impl_name(impl));
+            continue;
+        }
+        for(s = 0; s < sizeof(bench_sizes)/sizeof(bench_sizes[0]); s++) {
+            len = bench_sizes[s];
+            iterations = bytes / len;
+
+            start = bench_cpu_time();
+            for(i = 0; i < iterations; i++) {
+                result += calculate_internet_sum(buf, len);
+            }
+            internet = bench_cpu_time() - start;
+
+            start = bench_cpu_time();
+            for(i = 0; i < iterations; i++) {
+                result += calculate_fletcher_checksum(buf, 12, len);
+            }
+            fletcher = bench_cpu_time() - start;
+
+            printf("%-8s %6zu %12.1f %12.1f\n", checksum_impl_name(impl), len,
+                   iterations * len / internet / 1e6,
+                   iterations * len / fletcher / 1e6);
+        }
+    }
+    return result == 0xdeadbeef;
+}
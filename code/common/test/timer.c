@@ -0,0 +1,346 @@
+/*
+ * Common Timer Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <unistd.h>
+#include <timer.h>
+#include <logging.h>
+
+struct keyval_ log_names[] = {
+    { 0, NULL}
+};
+
+typedef struct test_timer_ {
+    timer_s *timer;
+    long interval;
+    uint32_t fired;
+} test_timer_s;
+
+static struct timespec g_last_expire;
+static bool g_realloc_fail;
+static bool g_ordered;
+static bool g_early;
+static uint32_t g_fired;
+
+void *__real_realloc(void *ptr, size_t size);
+
+/* Linked with --wrap=realloc to simulate
+ * timer heap allocation failures. */
+void *
+__wrap_realloc(void *ptr, size_t size)
+{
+    if(g_realloc_fail) {
+        return NULL;
+    }
+    return __real_realloc(ptr, size);
+}
+
+static void
+test_timer_cb(timer_s *timer)
+{
+    test_timer_s *t = timer->data;
+    t->fired++;
+    g_fired++;
+    /* Timers must fire in order of expiration. */
+    if(timer->expire.tv_sec < g_last_expire.tv_sec ||
+       (timer->expire.tv_sec == g_last_expire.tv_sec &&
+        timer->expire.tv_nsec < g_last_expire.tv_nsec)) {
+        g_ordered = false;
+    }
+    g_last_expire = timer->expire;
+    /* Timers must not fire before expiration. */
+    if(timer->timestamp->tv_sec < timer->expire.tv_sec ||
+       (timer->timestamp->tv_sec == timer->expire.tv_sec &&
+        timer->timestamp->tv_nsec < timer->expire.tv_nsec)) {
+        g_early = true;
+    }
+}
+
+static void
+test_timer_order(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    test_timer_s t[3] = {0};
+    long interval[3] = { 3 * MSEC, 1 * MSEC, 2 * MSEC };
+    int i;
+
+    timer_init_root(&root);
+    g_last_expire.tv_sec = 0;
+    g_last_expire.tv_nsec = 0;
+    g_ordered = true;
+    g_fired = 0;
+    for(i = 0; i < 3; i++) {
+        t[i].interval = interval[i];
+        timer_add(&root, &t[i].timer, "test", 0, interval[i], &t[i], &test_timer_cb);
+    }
+    assert_int_equal(root.buckets, 3);
+    while(g_fired < 3) {
+        timer_walk(&root);
+    }
+    assert_true(g_ordered);
+    for(i = 0; i < 3; i++) {
+        assert_int_equal(t[i].fired, 1);
+        assert_null(t[i].timer);
+    }
+    assert_int_equal(root.buckets, 0);
+    timer_flush_root(&root);
+}
+
+static void
+test_timer_periodic(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    test_timer_s t = {0};
+    int i;
+
+    timer_init_root(&root);
+    t.interval = MSEC;
+    timer_add_periodic(&root, &t.timer, "test", 0, MSEC, &t, &test_timer_cb);
+    for(i = 0; i < 10; i++) {
+        timer_walk(&root);
+    }
+    assert_in_range(t.fired, 9, 10);
+    assert_non_null(t.timer);
+    assert_int_equal(root.buckets, 1);
+    timer_del(t.timer);
+    timer_walk(&root);
+    assert_int_equal(root.buckets, 0);
+    timer_flush_root(&root);
+}
+
+static void
+test_timer_delete(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    test_timer_s t[2] = {0};
+
+    timer_init_root(&root);
+    g_fired = 0;
+    timer_add(&root, &t[0].timer, "test", 0, MSEC, &t[0], &test_timer_cb);
+    timer_add(&root, &t[1].timer, "test", 0, 2 * MSEC, &t[1], &test_timer_cb);
+    timer_del(t[0].timer);
+    while(g_fired < 1) {
+        timer_walk(&root);
+    }
+    assert_int_equal(t[0].fired, 0);
+    assert_int_equal(t[1].fired, 1);
+    assert_int_equal(root.buckets, 0);
+    timer_flush_root(&root);
+}
+
+static void
+test_timer_restart(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    test_timer_s t = {0};
+
+    timer_init_root(&root);
+    g_fired = 0;
+    timer_add(&root, &t.timer, "test", 0, MSEC, &t, &test_timer_cb);
+    /* Restart with a different interval moves the timer to another bucket. */
+    timer_add(&root, &t.timer, "test", 0, 2 * MSEC, &t, &test_timer_cb);
+    while(g_fired < 1) {
+        timer_walk(&root);
+    }
+    assert_int_equal(t.fired, 1);
+    assert_int_equal(root.buckets, 0);
+    timer_flush_root(&root);
+}
+
+static void
+test_timer_many_buckets(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    test_timer_s *t;
+    uint32_t count = 10000;
+    uint32_t i;
+
+    t = calloc(count, sizeof(test_timer_s));
+    assert_non_null(t);
+
+    timer_init_root(&root);
+    g_early = false;
+    g_fired = 0;
+    for(i = 0; i < count; i++) {
+        /* 1000 distinct intervals between 1 and 10ms. */
+        t[i].interval = MSEC + ((i * 7919) % 1000) * 9000;
+        timer_add(&root, &t[i].timer, "test", 0, t[i].interval, &t[i], &test_timer_cb);
+    }
+    assert_int_equal(root.buckets, 1000);
+    while(g_fired < count) {
+        timer_walk(&root);
+    }
+    assert_false(g_early);
+    for(i = 0; i < count; i++) {
+        assert_int_equal(t[i].fired, 1);
+    }
+    assert_int_equal(root.buckets, 0);
+    timer_flush_root(&root);
+    free(t);
+}
+
+static void
+test_timer_event_cb(timer_event_s *event)
+{
+    uint8_t buf[8];
+    uint32_t *count = event->data;
+    if(read(event->fd, buf, sizeof(buf)) > 0) {
+        (*count)++;
+    }
+}
+
+static void
+test_timer_event(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    test_timer_s t = {0};
+    test_timer_s p = {0};
+    uint32_t count = 0;
+    int fds[2];
+
+    timer_init_root(&root);
+    assert_true(timer_event_init(&root));
+    assert_int_equal(pipe(fds), 0);
+    assert_true(timer_event_add(&root, fds[0], &count, &test_timer_event_cb));
+
+    /* Readable file descriptor wakes up the timer walk. */
+    timer_add(&root, &t.timer, "test", 3600, 0, &t, &test_timer_cb);
+    assert_int_equal(write(fds[1], "x", 1), 1);
+    timer_walk(&root);
+    assert_int_equal(count, 1);
+    assert_int_equal(t.fired, 0);
+    timer_del(t.timer);
+
+    /* Timers are fired via timerfd. */
+    p.interval = MSEC;
+    timer_add_periodic(&root, &p.timer, "test", 0, MSEC, &p, &test_timer_cb);
+    while(p.fired < 3) {
+        timer_walk(&root);
+    }
+    assert_int_equal(count, 1);
+    assert_int_equal(t.fired, 0);
+    timer_flush_root(&root);
+    assert_false(root.event);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void
+test_timer_no_memory(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    test_timer_s t[66] = {0};
+    int i;
+
+    timer_init_root(&root);
+    /* The initial heap holds 64 buckets. */
+    for(i = 0; i < 64; i++) {
+        t[i].interval = (i+1) * MSEC;
+        assert_true(timer_add(&root, &t[i].timer, "test", 0, t[i].interval, &t[i], &test_timer_cb));
+    }
+    assert_true(timer_add(&root, &t[64].timer, "test", 0, MSEC, &t[64], &test_timer_cb));
+    assert_int_equal(root.buckets, 64);
+
+    /* Growing the heap fails, the timer must not be enqueued. */
+    g_realloc_fail = true;
+    assert_false(timer_add(&root, &t[65].timer, "test", 0, 65 * MSEC, &t[65], &test_timer_cb));
+    assert_null(t[65].timer);
+    assert_int_equal(root.buckets, 64);
+    assert_int_equal(root.gc, 1);
+
+    /* Requeue into a new bucket fails too. */
+    assert_false(timer_add_periodic(&root, &t[64].timer, "test", 0, 66 * MSEC, &t[64], &test_timer_cb));
+    assert_null(t[64].timer);
+    assert_int_equal(root.buckets, 64);
+    assert_int_equal(root.gc, 2);
+
+    /* Existing buckets do not need any allocation. */
+    assert_true(timer_add(&root, &t[64].timer, "test", 0, 2 * MSEC, &t[64], &test_timer_cb));
+    assert_int_equal(root.gc, 1);
+    g_realloc_fail = false;
+    assert_true(timer_add(&root, &t[65].timer, "test", 0, 65 * MSEC, &t[65], &test_timer_cb));
+    assert_int_equal(root.buckets, 65);
+    timer_flush_root(&root);
+}
+
+static timer_root_s *g_walk_root;
+static test_timer_s g_walk_add;
+static bool g_walk_added;
+
+static void
+test_timer_walk_add_cb(timer_s *timer)
+{
+    test_timer_cb(timer);
+    if(timer->periodic && ((test_timer_s*)timer->data)->fired == 1) {
+        /* Add a new bucket while the walked bucket 
+         * is out of the heap and growing fails. */
+        g_realloc_fail = true;
+        g_walk_added = timer_add(g_walk_root, &g_walk_add.timer, "test", 0, 500 * MSEC, 
+                                 &g_walk_add, &test_timer_cb);
+        g_realloc_fail = false;
+    }
+}
+
+static void
+test_timer_walk_no_memory(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    test_timer_s t[63] = {0};
+    test_timer_s p = {0};
+    int i;
+
+    timer_init_root(&root);
+    g_walk_root = &root;
+    /* Fill the initial heap of 64 buckets. */
+    for(i = 0; i < 63; i++) {
+        assert_true(timer_add(&root, &t[i].timer, "test", 3600, i * MSEC, &t[i], &test_timer_cb));
+    }
+    p.interval = MSEC;
+    assert_true(timer_add_periodic(&root, &p.timer, "test", 0, MSEC, &p, &test_timer_walk_add_cb));
+    assert_int_equal(root.buckets, 64);
+
+    /* The slot of the walked bucket stays reserved, such 
+     * that the new bucket fails instead of the walked one. */
+    g_walk_added = true;
+    while(p.fired < 1) {
+        timer_walk(&root);
+    }
+    assert_false(g_walk_added);
+    assert_null(g_walk_add.timer);
+    assert_int_equal(root.bucket_heap_size, 64);
+    assert_int_equal(root.bucket_heap_reserved, 0);
+
+    /* The periodic timer keeps firing. */
+    while(p.fired < 3) {
+        timer_walk(&root);
+    }
+    timer_flush_root(&root);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_timer_order),
+        cmocka_unit_test(test_timer_periodic),
+        cmocka_unit_test(test_timer_delete),
+        cmocka_unit_test(test_timer_restart),
+        cmocka_unit_test(test_timer_many_buckets),
+        cmocka_unit_test(test_timer_event),
+        cmocka_unit_test(test_timer_no_memory),
+        cmocka_unit_test(test_timer_walk_no_memory),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
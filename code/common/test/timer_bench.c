@@ -0,0 +1,85 @@
+/*
+ * Common Timer Benchmark
+ *
+ * Usage: bench-timer [timers] [intervals]
+ *
+ * Adds the given number of timers (default 1M) spread 
+ * over the given number of distinct intervals (default 1000)
+ * and reports the CPU time spent for adding the timers
+ * and walking the timer root until all timers are fired. 
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <timer.h>
+#include <logging.h>
+
+struct keyval_ log_names[] = {
+    { 0, NULL}
+};
+
+static uint32_t g_fired;
+
+static void
+bench_timer_cb(timer_s *timer)
+{
+    (void)timer;
+    g_fired++;
+}
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char *argv[])
+{
+    timer_root_s root = {0};
+    timer_s **timers;
+    uint32_t count = 1000000;
+    uint32_t intervals = 1000;
+    uint32_t walks = 0;
+    uint32_t i;
+    double start, add, walk;
+
+    if(argc > 1) count = strtoul(argv[1], NULL, 10);
+    if(argc > 2) intervals = strtoul(argv[2], NULL, 10);
+    if(!count || !intervals) {
+        fprintf(stderr, "Usage: %s [timers] [intervals]\n", argv[0]);
+        return 1;
+    }
+
+    timers = calloc(count, sizeof(timer_s*));
+    if(!timers) {
+        return 1;
+    }
+    timer_init_root(&root);
+
+    /* Intervals are spread over 100ms up to 1.1s. */
+    start = bench_cpu_time();
+    for(i = 0; i < count; i++) {
+        timer_add(&root, &timers[i], "bench", 0, 
+                  100 * MSEC + (long)(i % intervals) * (SEC / intervals), 
+                  NULL, &bench_timer_cb);
+    }
+    add = bench_cpu_time() - start;
+
+    start = bench_cpu_time();
+    while(g_fired < count) {
+        timer_walk(&root);
+        walks++;
+    }
+    walk = bench_cpu_time() - start;
+
+    printf("timers %u intervals %u\n", count, intervals);
+    printf("add   %.3fs (%.1fns per timer)\n", add, add * 1e9 / count);
+    printf("walk  %.3fs (%.1fns per timer, %u walks)\n", walk, walk * 1e9 / count, walks);
+
+    timer_flush_root(&root);
+    free(timers);
+    return 0;
+}